@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Math.Algos/API.h>
+
+#include <Math.DataStructures/TrianglesOctree.h>
+#include <Math.DataStructures/TrianglesTree.h>
+
+#include <memory>
+#include <vector>
+
+class Point3D;
+class PointLocalizerBVH;
+class PointLocalizerHierarchical;
+class PointLocalizerVoxelized;
+class Triangle;
+class WorkStealingThreadPool;
+
+// Splits a large set of queries into chunks and answers them on a work-stealing thread pool.
+// Engines must be built before and must not be modified while a query is running.
+class MATH_ALGOS_API ParallelLocalizer final
+{
+public:
+    struct Params
+    {
+        size_t m_threads_count = 0; // 0 means all hardware threads
+        size_t m_grain_size = 1024; // queries per task
+    };
+
+    ParallelLocalizer();
+    explicit ParallelLocalizer(const Params& i_params);
+    ~ParallelLocalizer();
+
+    size_t GetThreadsCount() const;
+
+    // o_mesh_indexes[i] is the result of PointLocalizerVoxelized::Localize for i_points[i]
+    void Localize(const PointLocalizerVoxelized& i_localizer, const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes) const;
+
+    // o_mesh_indexes[i] is the result of PointLocalizerBVH::Localize for i_points[i]
+    void Localize(const PointLocalizerBVH& i_localizer, const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes) const;
+
+    // o_mesh_indexes[i] is the result of PointLocalizerHierarchical::Localize for i_points[i]
+    void Localize(const PointLocalizerHierarchical& i_localizer, const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes) const;
+
+    // o_triangles[i] is the result of TrianglesTree::Query for i_points[i]
+    void Localize(const TrianglesTree& i_tree, const std::vector<Point3D>& i_points, std::vector<Triangle*>& o_triangles) const;
+
+    // o_results[i] is the result of TrianglesOcTree::Query for i_points[i]
+    void Localize(const TrianglesOcTree& i_tree, const std::vector<Point3D>& i_points, std::vector<TriangleOcTreeQueryResult>& o_results) const;
+
+private:
+    Params m_params;
+    std::unique_ptr<WorkStealingThreadPool> mp_pool;
+};
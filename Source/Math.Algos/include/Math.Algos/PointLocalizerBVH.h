@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Math.Algos/API.h>
+
+#include <memory>
+#include <vector>
+
+class Point3D;
+class Mesh;
+class TransformMatrix;
+class TrianglesBVH;
+
+// Localizes points by the exact nearest triangle found in a SAH bounding volume hierarchy over all meshes.
+// A point is inside the mesh of the nearest triangle if it lies below or on the plane of that triangle,
+// Classification::RayParity counts the crossings of a ray instead
+class PointLocalizerBVH
+{
+public:
+
+    enum class ReturnCode
+    {
+        Ok,
+        TreeWasNotBuild,
+    };
+
+    // how the mesh that contains a point is decided
+    enum class Classification
+    {
+        NearestTriangle, // below or on the plane of the nearest triangle, wrong near sharp concave edges
+        RayParity,       // odd number of crossings of the ray along +X, doesn't depend on the orientation of triangles
+    };
+
+    struct Params
+    {
+        size_t m_max_triangles_in_leaf = 4;
+        size_t m_bins_count = 16;
+        Classification m_classification = Classification::NearestTriangle;
+    };
+
+    MATH_ALGOS_API PointLocalizerBVH();
+    MATH_ALGOS_API ~PointLocalizerBVH();
+
+    // returns mesh index, the tree has to be built again after adding meshes
+    MATH_ALGOS_API size_t AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transformation);
+
+    MATH_ALGOS_API void Build(const Params& i_params);
+
+    // returns index of mesh or std::numeric_limits<size_t>::max() if point is outside
+    // Localize and LocalizeBatch don't modify the localizer, they can be called from several threads after Build
+    MATH_ALGOS_API size_t Localize(const Point3D& i_point, ReturnCode* op_return_code = nullptr) const;
+
+    // same as Localize for every point, o_mesh_indexes[i] corresponds to i_points[i]
+    MATH_ALGOS_API void LocalizeBatch(const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes, ReturnCode* op_return_code = nullptr) const;
+
+    // nullptr if the tree was not built
+    MATH_ALGOS_API const TrianglesBVH* GetTree() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mp_impl;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Math.Algos/API.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <memory>
+#include <vector>
+
+class Point3D;
+class Mesh;
+class TransformMatrix;
+
+// Two level grid for scenes that mix large and small parts. A coarse top grid covers the whole scene and every
+// non-empty cell of it holds a sub-grid over the triangles of the cell, the resolution of a sub-grid follows the
+// number of triangles in its cell. Localize has the same contract as PointLocalizerVoxelized::Localize, the ray along
+// +X passes through the cells of the top grid and the voxels of their sub-grids
+class PointLocalizerHierarchical
+{
+public:
+
+    enum class ReturnCode
+    {
+        Ok,
+        GridWasNotBuild,
+    };
+
+    // how the mesh that contains a point is decided
+    enum class Classification
+    {
+        // below or on the plane of the nearest triangle of the voxel of the point, points in empty voxels use RayParity.
+        // Cells are coarse, a walk along +X to the first non-empty voxel would often end far from the point
+        NearestTriangle,
+        RayParity, // odd number of crossings of the ray along +X through the cells and their sub-grids
+    };
+
+    struct Params
+    {
+        // size of the cells of the top grid, 0 picks it so that a non-empty cell holds m_triangles_per_cell triangles on average
+        double m_cell_size = 0;
+        double m_triangles_per_cell = 256;
+        // sub-grids aim at m_triangles_per_voxel triangles in a non-empty voxel
+        double m_triangles_per_voxel = 4;
+        size_t m_max_sub_grid_resolution = 64; // voxels along every axis of a sub-grid
+        VoxelGrid::StorageType m_storage_type = VoxelGrid::StorageType::Auto;
+        size_t m_threads_count = 0; // threads used by Build, AddMesh and RemoveMesh, 0 means all hardware threads
+        Classification m_classification = Classification::NearestTriangle;
+        // Build labels the empty cells of the top grid inside or outside, queries in them don't touch triangles
+        bool m_label_empty_cells = true;
+    };
+
+    MATH_ALGOS_API PointLocalizerHierarchical();
+    MATH_ALGOS_API ~PointLocalizerHierarchical();
+
+    // returns mesh index. After Build only the sub-grids of the cells the mesh touches are built again and the cell size
+    // is kept, a mesh that sticks out of the top grid builds everything again with the last params
+    MATH_ALGOS_API size_t AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transformation);
+
+    // returns false if there is no such mesh. After Build only the sub-grids of the cells the mesh touched are built again
+    MATH_ALGOS_API bool RemoveMesh(size_t i_mesh_index);
+
+    MATH_ALGOS_API void Build(const Params& i_params);
+
+    // params of the last Build with the cell size it used
+    MATH_ALGOS_API const Params& GetParams() const;
+
+    // returns index of mesh or std::numeric_limits<size_t>::max() if point is outside
+    // Localize and LocalizeBatch don't modify the localizer, they can be called from several threads after Build
+    MATH_ALGOS_API size_t Localize(const Point3D& i_point, ReturnCode* op_return_code = nullptr) const;
+
+    // same as Localize for every point, o_mesh_indexes[i] corresponds to i_points[i].
+    // Points are grouped by cells, the label and the sub-grid of a cell are looked up once for all its points
+    MATH_ALGOS_API void LocalizeBatch(const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes, ReturnCode* op_return_code = nullptr) const;
+
+    MATH_ALGOS_API std::weak_ptr<VoxelGrid> GetTopGrid() const;
+    MATH_ALGOS_API size_t GetSubGridsCount() const;
+
+    // bytes used by the grids and the other structures of the localizer
+    MATH_ALGOS_API size_t GetMemoryUsage() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mp_impl;
+};
@@ -2,12 +2,15 @@
 
 #include <Math.Algos/API.h>
 
+#include <Math.DataStructures/VoxelGrid.h>
+
 #include <memory>
+#include <vector>
 
 class Point3D;
 class Mesh;
+class QString;
 class TransformMatrix;
-class VoxelGrid;
 
 class PointLocalizerVoxelized
 {
@@ -19,26 +22,72 @@ public:
         VoxelizationWasNotBuild,
     };
 
+    // how the mesh that contains a point is decided
+    enum class Classification
+    {
+        NearestTriangle, // below or on the plane of the nearest triangle of the first non-empty voxel along +X
+        RayParity,       // odd number of crossings of the ray along +X through the voxels of the column
+    };
+
     struct Params
     {
         double m_voxel_size_x = 1;
         double m_voxel_size_y = 1;
         double m_voxel_size_z = 1;
+        VoxelGrid::StorageType m_storage_type = VoxelGrid::StorageType::Auto;
+        size_t m_threads_count = 0; // threads used by Build, 0 means all hardware threads
+        Classification m_classification = Classification::NearestTriangle;
+        // Build labels the empty voxels inside or outside by a flood fill, queries in them don't touch triangles
+        bool m_label_empty_voxels = true;
+        // Build samples the distance to the nearest triangle and the label at the corners of the non-empty voxels.
+        // A query nearer to a corner than its distance gets the label of the corner without touching triangles
+        bool m_use_corner_distances = false;
+        // Build picks the voxel sizes from the triangles instead of m_voxel_size_*, so that a non-empty voxel holds
+        // m_triangles_per_voxel triangles on average. The picked sizes are returned by GetParams
+        bool m_auto_voxel_size = false;
+        double m_triangles_per_voxel = 4;
+        bool m_refine_auto_voxel_size = true; // corrects the estimate by voxelizing random blocks of the grid
     };
 
     MATH_ALGOS_API PointLocalizerVoxelized();
     MATH_ALGOS_API ~PointLocalizerVoxelized();
 
     // returns mesh index
+    // After Build the mesh is inserted into the existing voxelization, only voxels touched by its triangles and the labels
+    // and corner distances around them are updated.
+    // If the mesh doesn't fit into the voxelization, everything is built again with the last params
     MATH_ALGOS_API size_t AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transformation);
+
+    // removes triangles of the mesh from the voxelization, returns false if there is no such mesh
+    MATH_ALGOS_API bool RemoveMesh(size_t i_mesh_index);
     
     MATH_ALGOS_API void Build(const Params& i_params);
 
+    // params of the last Build with the voxel sizes it used
+    MATH_ALGOS_API const Params& GetParams() const;
+
     // returns index of mesh or std::numeric_limits<size_t>::max() if point is outside
-    MATH_ALGOS_API size_t Localize(const Point3D& i_point, ReturnCode* op_return_code = nullptr);
+    // Localize and LocalizeBatch don't modify the localizer, they can be called from several threads after Build
+    MATH_ALGOS_API size_t Localize(const Point3D& i_point, ReturnCode* op_return_code = nullptr) const;
+
+    // same as Localize for every point, o_mesh_indexes[i] corresponds to i_points[i]
+    // queries are grouped by voxel column, so every voxel of a column is visited at most once per call
+    MATH_ALGOS_API void LocalizeBatch(const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes, ReturnCode* op_return_code = nullptr) const;
+    // same for i_count points at ip_points, op_mesh_indexes has room for i_count results. A caller can pass a part of its points without copying them
+    MATH_ALGOS_API void LocalizeBatch(const Point3D* ip_points, size_t i_count, size_t* op_mesh_indexes, ReturnCode* op_return_code = nullptr) const;
 
     MATH_ALGOS_API std::weak_ptr<VoxelGrid> GetCachedGrid() const;
 
+    // bytes used by the structures of the localizer besides the grid
+    MATH_ALGOS_API size_t GetMemoryUsage() const;
+
+    // Saves the transformed triangles, the mesh of every triangle, the params, the voxelization, the labels of empty
+    // voxels and the corner distances into a versioned binary file. Load maps the file and copies every array out of the
+    // mapping, nothing is voxelized, labelled or sampled again and mesh indexes stay the same.
+    // On failure Load returns false and leaves the localizer untouched
+    MATH_ALGOS_API bool Save(const QString& i_file_path) const;
+    MATH_ALGOS_API bool Load(const QString& i_file_path);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> mp_impl;
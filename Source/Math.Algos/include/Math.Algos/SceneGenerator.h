@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Math.Algos/API.h>
+
+#include <Math.Core/BasicPoint3.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class BoundingBox;
+class Mesh;
+class Point3D;
+
+// Procedural scenes for reproducible benchmarks: closed meshes whose inside is known analytically and query points
+// with the expected answers. Every part lies in its own cell of a cubic grid, so parts never intersect.
+// The same params and seed give the same scene on every machine and with any number of threads
+class MATH_ALGOS_API SceneGenerator final
+{
+public:
+    enum class Shape
+    {
+        Sphere,      // UV sphere
+        Torus,       // UV torus around a random axis
+        VoxelBlob,   // boundary of a union of balls rasterized on a grid, at most 512^3 voxels per part
+        Sqrt3Sphere, // icosahedron refined by SQRT3MeshSubdivider and projected on the sphere
+    };
+
+    enum class PointsDistribution
+    {
+        Uniform,   // in the bounding box of the scene grown by 5% on every side
+        Clustered, // gaussian clusters around points of the part surfaces
+    };
+
+    struct Params
+    {
+        Shape m_shape = Shape::Sphere;
+        size_t m_triangles_count = 100000; // approximate, of all parts together
+        size_t m_parts_count = 1;
+        std::uint32_t m_seed = 0;
+    };
+
+    SceneGenerator();
+    ~SceneGenerator();
+
+    // replaces the scene, parts are generated in parallel
+    void Generate(const Params& i_params);
+
+    size_t GetPartsCount() const;
+    size_t GetTrianglesCount() const;
+    BoundingBox GetBoundingBox() const;
+
+    // three indices of GetPartVertices per triangle, triangles are oriented outwards
+    const std::vector<BasicPoint3D>& GetPartVertices(size_t i_part) const;
+    const std::vector<std::uint32_t>& GetPartIndices(size_t i_part) const;
+    // named "part_<index>"
+    void BuildPartMesh(size_t i_part, Mesh& o_mesh) const;
+
+    // Index of the part that contains the point or std::numeric_limits<size_t>::max() if it is outside of all parts.
+    // Returns false if the point is so close to a surface that the tessellation decides, the answer is not known then
+    bool Locate(const Point3D& i_point, size_t& o_part) const;
+
+    // i_count points with known answers of Locate, points with unknown answers are never produced
+    void GeneratePoints(size_t i_count, PointsDistribution i_distribution, std::uint32_t i_seed,
+                        std::vector<Point3D>& o_points, std::vector<size_t>& o_parts) const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mp_impl;
+};
@@ -2,6 +2,7 @@
 
 #include <Math.Algos/API.h>
 
+class IndexedMesh;
 class Mesh;
 
 class MATH_ALGOS_API SQRT3MeshSubdivider final
@@ -16,6 +17,7 @@ public:
 
     void SetParams(const Params& i_params);
     void Subdivide(Mesh& i_mesh) const;
+    void Subdivide(IndexedMesh& io_mesh) const;
 
 private:
     Params m_params;
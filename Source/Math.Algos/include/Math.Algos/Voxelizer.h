@@ -2,13 +2,15 @@
 
 #include <Math.Algos/API.h>
 
+#include <Math.DataStructures/VoxelGrid.h>
+
 #include <memory>
 #include <vector>
 
 class BoundingBox;
 class Mesh;
 class Triangle;
-class VoxelGrid;
+class TriangleSoup;
 
 class MATH_ALGOS_API Voxelizer
 {
@@ -19,12 +21,26 @@ public:
         double m_resolution_y = 10.;
         double m_resolution_z = 10.;
         double m_precision = 1e-7;
+        VoxelGrid::StorageType m_storage_type = VoxelGrid::StorageType::Auto;
+        size_t m_threads_count = 0; // 0 means all hardware threads, 1 voxelizes on the calling thread
     };
 
     void SetParams(const Params& i_params);
     std::unique_ptr<VoxelGrid> Voxelize(const Mesh& i_mesh); 
     std::unique_ptr<VoxelGrid> Voxelize(const std::vector<Triangle*>& i_triangles);
+    // the grid has no triangles table, its indexes are the indexes of the triangles in i_triangles
+    std::unique_ptr<VoxelGrid> Voxelize(const TriangleSoup& i_triangles);
+
+    // pairs (voxel of i_grid, triangle) for all voxels touched by the triangles, sorted by voxel and triangle.
+    // i_triangles[i] gets index i_first_triangle_index + i. Voxel size of the grid is used instead of the resolution
+    std::vector<VoxelGrid::Entry> CollectEntries(const VoxelGrid& i_grid, const std::vector<Triangle*>& i_triangles, std::uint32_t i_first_triangle_index = 0) const;
+    // same for i_count triangles of the soup from i_first_triangle, they keep their indexes in the soup
+    std::vector<VoxelGrid::Entry> CollectEntries(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, std::uint32_t i_first_triangle, size_t i_count) const;
+    // same for the triangles of the soup with indexes i_triangle_indexes
+    std::vector<VoxelGrid::Entry> CollectEntries(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, const std::vector<std::uint32_t>& i_triangle_indexes) const;
 
 private:
+    std::unique_ptr<VoxelGrid> _CreateGrid(const BoundingBox& i_bbox) const;
+
     Params m_params;
 };
@@ -0,0 +1,325 @@
+#include "EmptyVoxelLabels.h"
+
+#include <Math.Core/BinaryStream.h>
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/Point3D.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <numeric>
+
+
+namespace
+{
+    std::uint32_t _FindRoot(std::vector<std::uint32_t>& io_parents, std::uint32_t i_run)
+    {
+        while (io_parents[i_run] != i_run)
+        {
+            io_parents[i_run] = io_parents[io_parents[i_run]];
+            i_run = io_parents[i_run];
+        }
+        return i_run;
+    }
+
+    // the smaller run becomes the root, so a root precedes all runs of its set
+    void _Unite(std::vector<std::uint32_t>& io_parents, std::uint32_t i_run1, std::uint32_t i_run2)
+    {
+        const auto root1 = _FindRoot(io_parents, i_run1);
+        const auto root2 = _FindRoot(io_parents, i_run2);
+        if (root1 < root2)
+            io_parents[root2] = root1;
+        else if (root2 < root1)
+            io_parents[root1] = root2;
+    }
+}
+
+
+void EmptyVoxelLabels::Build(const VoxelGrid& i_grid, const std::function<size_t(const Point3D&)>& i_classify)
+{
+    Clear();
+
+    const auto& num_voxels = i_grid.GetNumVoxels();
+    const auto columns_count = num_voxels[1] * num_voxels[2];
+    m_num_voxels_y = num_voxels[1];
+
+    // non-empty voxels as column * num_voxels_x + x, so they are sorted by column and x
+    std::vector<std::uint64_t> non_empty_voxels;
+    for (const auto& coordinates : i_grid.GetExistingVoxelsCoordinates())
+    {
+        if (!i_grid.GetVoxelTriangles(coordinates).empty())
+            non_empty_voxels.push_back((coordinates[1] + coordinates[2] * num_voxels[1]) * static_cast<std::uint64_t>(num_voxels[0]) + coordinates[0]);
+    }
+    std::sort(non_empty_voxels.begin(), non_empty_voxels.end());
+
+    const auto num_voxels_x = static_cast<std::uint32_t>(num_voxels[0]);
+    m_column_offsets.reserve(columns_count + 1);
+    auto it = non_empty_voxels.begin();
+    for (size_t column = 0; column < columns_count; ++column)
+    {
+        Q_ASSERT(m_runs.size() < OUTSIDE);
+        m_column_offsets.push_back(static_cast<std::uint32_t>(m_runs.size()));
+
+        std::uint32_t begin_x = 0;
+        for (; it != non_empty_voxels.end() && *it / num_voxels_x == column; ++it)
+        {
+            const auto x = static_cast<std::uint32_t>(*it % num_voxels_x);
+            if (x > begin_x)
+                m_runs.push_back({ begin_x, x, NOT_EMPTY });
+            begin_x = x + 1;
+        }
+        if (begin_x < num_voxels_x)
+            m_runs.push_back({ begin_x, num_voxels_x, NOT_EMPTY });
+    }
+    m_column_offsets.push_back(static_cast<std::uint32_t>(m_runs.size()));
+
+    _Label(i_grid, i_classify);
+}
+
+void EmptyVoxelLabels::Update(const VoxelGrid& i_grid, const std::array<size_t, 3>& i_min, const std::array<size_t, 3>& i_max,
+                              const std::function<size_t(const Point3D&)>& i_classify)
+{
+    const auto& num_voxels = i_grid.GetNumVoxels();
+    const auto columns_count = num_voxels[1] * num_voxels[2];
+    Q_ASSERT(m_num_voxels_y == num_voxels[1] && m_column_offsets.size() == columns_count + 1);
+    Q_ASSERT(i_max[0] < num_voxels[0] && i_max[1] < num_voxels[1] && i_max[2] < num_voxels[2]);
+
+    // runs of the columns of the box are cut at the box, the empty voxels of the box become new runs
+    const auto box_begin_x = static_cast<std::uint32_t>(i_min[0]);
+    const auto box_end_x = static_cast<std::uint32_t>(i_max[0] + 1);
+    std::vector<std::uint32_t> column_offsets;
+    std::vector<Run> runs;
+    column_offsets.reserve(columns_count + 1);
+    runs.reserve(m_runs.size());
+    for (size_t column = 0; column < columns_count; ++column)
+    {
+        Q_ASSERT(runs.size() < OUTSIDE);
+        column_offsets.push_back(static_cast<std::uint32_t>(runs.size()));
+
+        const auto p_begin = m_runs.data() + m_column_offsets[column];
+        const auto p_end = m_runs.data() + m_column_offsets[column + 1];
+        const auto y = column % num_voxels[1];
+        const auto z = column / num_voxels[1];
+        if (y < i_min[1] || y > i_max[1] || z < i_min[2] || z > i_max[2])
+        {
+            runs.insert(runs.end(), p_begin, p_end);
+            continue;
+        }
+
+        for (auto p_run = p_begin; p_run != p_end && p_run->m_begin_x < box_begin_x; ++p_run)
+            runs.push_back({ p_run->m_begin_x, std::min(p_run->m_end_x, box_begin_x), p_run->m_label });
+
+        for (auto x = box_begin_x; x < box_end_x; ++x)
+        {
+            if (!i_grid.GetVoxelTriangles({ x, y, z }).empty())
+                continue;
+            if (runs.size() > column_offsets.back() && runs.back().m_end_x == x && runs.back().m_label == NOT_EMPTY)
+                ++runs.back().m_end_x;
+            else
+                runs.push_back({ x, x + 1, NOT_EMPTY });
+        }
+
+        for (auto p_run = p_begin; p_run != p_end; ++p_run)
+        {
+            if (p_run->m_end_x > box_end_x)
+                runs.push_back({ std::max(p_run->m_begin_x, box_end_x), p_run->m_end_x, p_run->m_label });
+        }
+    }
+    column_offsets.push_back(static_cast<std::uint32_t>(runs.size()));
+
+    m_column_offsets = std::move(column_offsets);
+    m_runs = std::move(runs);
+    _Label(i_grid, i_classify);
+}
+
+void EmptyVoxelLabels::_Label(const VoxelGrid& i_grid, const std::function<size_t(const Point3D&)>& i_classify)
+{
+    const auto& num_voxels = i_grid.GetNumVoxels();
+    const auto columns_count = num_voxels[1] * num_voxels[2];
+    const auto num_voxels_x = static_cast<std::uint32_t>(num_voxels[0]);
+
+    // runs of neighbouring columns are connected if they share an x, runs of one column if they touch
+    std::vector<std::uint32_t> parents(m_runs.size());
+    std::iota(parents.begin(), parents.end(), 0u);
+    const auto connect_columns = [&](size_t i_column1, size_t i_column2)
+    {
+        auto run1 = m_column_offsets[i_column1];
+        auto run2 = m_column_offsets[i_column2];
+        while (run1 < m_column_offsets[i_column1 + 1] && run2 < m_column_offsets[i_column2 + 1])
+        {
+            if (m_runs[run1].m_begin_x < m_runs[run2].m_end_x && m_runs[run2].m_begin_x < m_runs[run1].m_end_x)
+                _Unite(parents, run1, run2);
+
+            if (m_runs[run1].m_end_x < m_runs[run2].m_end_x)
+                ++run1;
+            else
+                ++run2;
+        }
+    };
+
+    for (size_t column = 0; column < columns_count; ++column)
+    {
+        for (auto run = m_column_offsets[column] + 1; run < m_column_offsets[column + 1]; ++run)
+        {
+            if (m_runs[run - 1].m_end_x == m_runs[run].m_begin_x)
+                _Unite(parents, run - 1, run);
+        }
+        if (column % num_voxels[1] + 1 < num_voxels[1])
+            connect_columns(column, column + 1);
+        if (column / num_voxels[1] + 1 < num_voxels[2])
+            connect_columns(column, column + num_voxels[1]);
+    }
+
+    // a surface can't pass between a voxel on the border and the outside without a triangle in that voxel
+    std::vector<char> is_outside(m_runs.size(), 0);
+    for (size_t column = 0; column < columns_count; ++column)
+    {
+        const auto y = column % num_voxels[1];
+        const auto z = column / num_voxels[1];
+        const bool is_border_column = y == 0 || y + 1 == num_voxels[1] || z == 0 || z + 1 == num_voxels[2];
+        for (auto run = m_column_offsets[column]; run < m_column_offsets[column + 1]; ++run)
+        {
+            if (is_border_column || m_runs[run].m_begin_x == 0 || m_runs[run].m_end_x == num_voxels_x)
+                is_outside[_FindRoot(parents, run)] = 1;
+        }
+    }
+
+    // A change can't move a voxel outside of its box into another mesh, so a set keeps the label of such voxels.
+    // Sets without them or with different old labels are classified
+    std::vector<std::uint32_t> kept_labels(m_runs.size(), NOT_EMPTY);
+    std::vector<char> has_conflict(m_runs.size(), 0);
+    for (std::uint32_t run = 0; run < m_runs.size(); ++run)
+    {
+        if (m_runs[run].m_label == NOT_EMPTY)
+            continue;
+
+        const auto root = _FindRoot(parents, run);
+        if (kept_labels[root] == NOT_EMPTY)
+            kept_labels[root] = m_runs[run].m_label;
+        else if (kept_labels[root] != m_runs[run].m_label)
+            has_conflict[root] = 1;
+    }
+
+    // roots are labelled before the other runs of their sets
+    for (size_t column = 0; column < columns_count; ++column)
+    {
+        for (auto run = m_column_offsets[column]; run < m_column_offsets[column + 1]; ++run)
+        {
+            const auto root = _FindRoot(parents, run);
+            if (root != run)
+            {
+                m_runs[run].m_label = m_runs[root].m_label;
+                continue;
+            }
+            if (is_outside[run])
+            {
+                m_runs[run].m_label = OUTSIDE;
+                continue;
+            }
+            if (kept_labels[run] != NOT_EMPTY && !has_conflict[run])
+            {
+                m_runs[run].m_label = kept_labels[run];
+                continue;
+            }
+
+            const auto bbox = i_grid.GetVoxelBoundingBox({ m_runs[run].m_begin_x, column % num_voxels[1], column / num_voxels[1] });
+            const auto mesh_index = i_classify((bbox.GetMin() + bbox.GetMax()) / 2);
+            Q_ASSERT(mesh_index == std::numeric_limits<size_t>::max() || mesh_index < NOT_EMPTY);
+            m_runs[run].m_label = mesh_index == std::numeric_limits<size_t>::max() ? OUTSIDE : static_cast<std::uint32_t>(mesh_index);
+        }
+    }
+
+    // touching runs are in one set, they become one run again
+    std::uint32_t runs_count = 0;
+    for (size_t column = 0; column < columns_count; ++column)
+    {
+        const auto column_begin = m_column_offsets[column];
+        const auto column_end = m_column_offsets[column + 1];
+        m_column_offsets[column] = runs_count;
+        for (auto run = column_begin; run < column_end; ++run)
+        {
+            if (runs_count > m_column_offsets[column] && m_runs[runs_count - 1].m_end_x == m_runs[run].m_begin_x)
+                m_runs[runs_count - 1].m_end_x = m_runs[run].m_end_x;
+            else
+                m_runs[runs_count++] = m_runs[run];
+        }
+    }
+    m_column_offsets.back() = runs_count;
+    m_runs.resize(runs_count);
+}
+
+void EmptyVoxelLabels::Clear()
+{
+    m_num_voxels_y = 0;
+    m_column_offsets.clear();
+    m_column_offsets.shrink_to_fit();
+    m_runs.clear();
+    m_runs.shrink_to_fit();
+}
+
+bool EmptyVoxelLabels::IsBuilt() const
+{
+    return !m_column_offsets.empty();
+}
+
+std::uint32_t EmptyVoxelLabels::GetLabel(const std::array<size_t, 3>& i_coordinates) const
+{
+    const auto column = i_coordinates[1] + i_coordinates[2] * m_num_voxels_y;
+    Q_ASSERT(column + 1 < m_column_offsets.size());
+
+    const auto p_begin = m_runs.data() + m_column_offsets[column];
+    const auto p_end = m_runs.data() + m_column_offsets[column + 1];
+    const auto p_run = std::upper_bound(p_begin, p_end, i_coordinates[0], [](size_t i_x, const Run& i_run)
+    {
+        return i_x < i_run.m_begin_x;
+    });
+    if (p_run == p_begin || i_coordinates[0] >= (p_run - 1)->m_end_x)
+        return NOT_EMPTY;
+    return (p_run - 1)->m_label;
+}
+
+size_t EmptyVoxelLabels::GetMemoryUsage() const
+{
+    return m_column_offsets.capacity() * sizeof(std::uint32_t) + m_runs.capacity() * sizeof(Run);
+}
+
+
+void EmptyVoxelLabels::Save(BinaryWriter& io_writer) const
+{
+    io_writer.Write(static_cast<std::uint64_t>(m_num_voxels_y));
+    io_writer.WriteArray(m_column_offsets);
+    io_writer.WriteArray(m_runs);
+}
+
+bool EmptyVoxelLabels::Load(BinaryReader& io_reader, const VoxelGrid& i_grid)
+{
+    Clear();
+
+    // GetLabel trusts the offsets and searches the runs of a column by x
+    const auto& num_voxels = i_grid.GetNumVoxels();
+    std::uint64_t num_voxels_y = 0;
+    if (!io_reader.Read(num_voxels_y) || !io_reader.ReadArray(m_column_offsets) || !io_reader.ReadArray(m_runs))
+        return false;
+    m_num_voxels_y = static_cast<size_t>(num_voxels_y);
+
+    bool is_valid = num_voxels_y == num_voxels[1] && m_column_offsets.size() == num_voxels[1] * num_voxels[2] + 1
+                 && m_column_offsets.front() == 0 && m_column_offsets.back() == m_runs.size()
+                 && std::is_sorted(m_column_offsets.begin(), m_column_offsets.end());
+    for (size_t column = 0; is_valid && column + 1 < m_column_offsets.size(); ++column)
+    {
+        std::uint32_t end_x = 0;
+        for (auto run = m_column_offsets[column]; is_valid && run < m_column_offsets[column + 1]; ++run)
+        {
+            const auto& current_run = m_runs[run];
+            is_valid = (run == m_column_offsets[column] || current_run.m_begin_x > end_x) && current_run.m_begin_x < current_run.m_end_x
+                    && current_run.m_end_x <= num_voxels[0] && current_run.m_label != NOT_EMPTY;
+            end_x = current_run.m_end_x;
+        }
+    }
+
+    if (!is_valid)
+        Clear();
+    return is_valid;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+class BinaryReader;
+class BinaryWriter;
+class Point3D;
+class VoxelGrid;
+
+// Inside/outside labels of the empty voxels of a grid. Empty voxels are kept as runs along X between non-empty voxels
+// and runs of neighbouring columns that overlap are connected, so the flood fill gives every connected set of empty
+// voxels one label without visiting the voxels one by one. Memory is linear in columns and non-empty voxels
+class EmptyVoxelLabels
+{
+public:
+    static constexpr std::uint32_t OUTSIDE = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t NOT_EMPTY = OUTSIDE - 1;
+
+    // Sets that touch the border of the grid are outside, i_classify labels every enclosed set by a point in it.
+    // It returns a mesh index or std::numeric_limits<size_t>::max() for outside
+    void Build(const VoxelGrid& i_grid, const std::function<size_t(const Point3D&)>& i_classify);
+    // Updates the labels after voxels from i_min to i_max gained or lost triangles. Runs are laid out again only in the
+    // columns of the box and a set keeps the label of its voxels outside the box, so only sets inside the box are classified
+    void Update(const VoxelGrid& i_grid, const std::array<size_t, 3>& i_min, const std::array<size_t, 3>& i_max,
+                const std::function<size_t(const Point3D&)>& i_classify);
+    void Clear();
+    bool IsBuilt() const;
+
+    // mesh index, OUTSIDE or NOT_EMPTY if the voxel has triangles
+    std::uint32_t GetLabel(const std::array<size_t, 3>& i_coordinates) const;
+
+    size_t GetMemoryUsage() const;
+
+    void Save(BinaryWriter& io_writer) const;
+    // labels saved for i_grid, returns false for a broken file
+    bool Load(BinaryReader& io_reader, const VoxelGrid& i_grid);
+
+private:
+    struct Run
+    {
+        std::uint32_t m_begin_x;
+        std::uint32_t m_end_x;
+        std::uint32_t m_label;
+    };
+
+    // Connects the runs into sets and labels every set. Runs come with the labels they had before a change, new runs with
+    // NOT_EMPTY. Touching runs of a column are merged
+    void _Label(const VoxelGrid& i_grid, const std::function<size_t(const Point3D&)>& i_classify);
+
+    size_t m_num_voxels_y = 0;
+    std::vector<std::uint32_t> m_column_offsets; // runs of the column y + z * num_voxels_y start at m_column_offsets[column]
+    std::vector<Run> m_runs;                      // sorted by column and x
+};
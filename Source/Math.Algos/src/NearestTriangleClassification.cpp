@@ -0,0 +1,59 @@
+#include "NearestTriangleClassification.h"
+
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/TrianglePack.h>
+#include <Math.Core/TriangleSoup.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <cstdint>
+#include <limits>
+
+
+size_t ClassifyByNearestTriangle(const VoxelTrianglesRange& i_voxel_triangles, const Point3D& i_point, const TriangleSoup& i_triangles)
+{
+    if (i_voxel_triangles.empty())
+        return std::numeric_limits<size_t>::max();
+
+    // triangles of the voxel are packed by four on the stack for the distance kernel. Packs kept for every voxel
+    // would be ~30 times the memory of the grid and are not faster than packing the few triangles of the voxel
+    TrianglePack4 pack;
+    std::uint32_t pack_indexes[TrianglePack4::LANES_COUNT] = {};
+    double distances_sqr[TrianglePack4::LANES_COUNT];
+    size_t lanes_count = 0;
+
+    std::uint32_t nearest_triangle_index = 0;
+    double distance_sqr = std::numeric_limits<double>::max();
+    const auto find_nearest = [&]()
+    {
+        DistanceSqr(i_point, pack, distances_sqr);
+        for (size_t lane = 0; lane < lanes_count; ++lane)
+        {
+            if (distances_sqr[lane] < distance_sqr)
+            {
+                nearest_triangle_index = pack_indexes[lane];
+                distance_sqr = distances_sqr[lane];
+            }
+        }
+        lanes_count = 0;
+    };
+
+    for (auto it = i_voxel_triangles.begin(); it != i_voxel_triangles.end(); ++it)
+    {
+        SetTriangle(pack, lanes_count, i_triangles.GetVertices(it.GetIndex()));
+        pack_indexes[lanes_count++] = it.GetIndex();
+        if (lanes_count == TrianglePack4::LANES_COUNT)
+            find_nearest();
+    }
+    if (lanes_count > 0)
+        find_nearest();
+
+    auto loc_result = GetPointTriangleRelativeLocation(i_triangles.GetTriangle(nearest_triangle_index), i_point);
+    if (loc_result == PointTriangleRelativeLocationResult::Below
+     || loc_result == PointTriangleRelativeLocationResult::OnSamePlane)
+        return i_triangles.GetMeshId(nearest_triangle_index);
+
+    return std::numeric_limits<size_t>::max();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+class Point3D;
+class TriangleSoup;
+class VoxelTrianglesRange;
+
+// The point is inside of the mesh of the nearest triangle of the voxel if it lies below or on the plane of that triangle.
+// Indexes of the voxel are indexes of triangles in i_triangles. Returns index of mesh or std::numeric_limits<size_t>::max()
+// if the point is outside or the voxel is empty
+size_t ClassifyByNearestTriangle(const VoxelTrianglesRange& i_voxel_triangles, const Point3D& i_point, const TriangleSoup& i_triangles);
@@ -0,0 +1,84 @@
+#include "Math.Algos/ParallelLocalizer.h"
+
+#include "Math.Algos/PointLocalizerBVH.h"
+#include "Math.Algos/PointLocalizerHierarchical.h"
+#include "Math.Algos/PointLocalizerVoxelized.h"
+
+#include <Math.Core/Point3D.h>
+#include <Math.Core/WorkStealingThreadPool.h>
+
+#include <algorithm>
+
+
+ParallelLocalizer::ParallelLocalizer()
+    : ParallelLocalizer(Params())
+{
+}
+
+ParallelLocalizer::ParallelLocalizer(const Params& i_params)
+    : m_params(i_params)
+    , mp_pool(std::make_unique<WorkStealingThreadPool>(i_params.m_threads_count))
+{
+}
+
+ParallelLocalizer::~ParallelLocalizer() = default;
+
+size_t ParallelLocalizer::GetThreadsCount() const
+{
+    return mp_pool->GetThreadsCount();
+}
+
+void ParallelLocalizer::Localize(const PointLocalizerVoxelized& i_localizer, const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes) const
+{
+    o_mesh_indexes.resize(i_points.size());
+
+    // every chunk goes through LocalizeBatch to keep the column grouping inside the chunk
+    mp_pool->ParallelFor(i_points.size(), m_params.m_grain_size, [&](size_t i_begin, size_t i_end)
+    {
+        i_localizer.LocalizeBatch(i_points.data() + i_begin, i_end - i_begin, o_mesh_indexes.data() + i_begin);
+    });
+}
+
+void ParallelLocalizer::Localize(const PointLocalizerBVH& i_localizer, const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes) const
+{
+    o_mesh_indexes.resize(i_points.size());
+
+    mp_pool->ParallelFor(i_points.size(), m_params.m_grain_size, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+            o_mesh_indexes[i] = i_localizer.Localize(i_points[i]);
+    });
+}
+
+void ParallelLocalizer::Localize(const PointLocalizerHierarchical& i_localizer, const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes) const
+{
+    o_mesh_indexes.resize(i_points.size());
+
+    mp_pool->ParallelFor(i_points.size(), m_params.m_grain_size, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+            o_mesh_indexes[i] = i_localizer.Localize(i_points[i]);
+    });
+}
+
+void ParallelLocalizer::Localize(const TrianglesTree& i_tree, const std::vector<Point3D>& i_points, std::vector<Triangle*>& o_triangles) const
+{
+    o_triangles.assign(i_points.size(), nullptr);
+
+    mp_pool->ParallelFor(i_points.size(), m_params.m_grain_size, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+            i_tree.Query(o_triangles[i], i_points[i]);
+    });
+}
+
+void ParallelLocalizer::Localize(const TrianglesOcTree& i_tree, const std::vector<Point3D>& i_points, std::vector<TriangleOcTreeQueryResult>& o_results) const
+{
+    o_results.assign(i_points.size(), TriangleOcTreeQueryResult());
+
+    mp_pool->ParallelFor(i_points.size(), m_params.m_grain_size, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+            i_tree.Query(o_results[i], i_points[i]);
+    });
+}
@@ -0,0 +1,113 @@
+#include "Math.Algos/PointLocalizerBVH.h"
+
+#include "RayParityCounter.h"
+
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/TriangleSoup.h>
+
+#include <Math.DataStructures/TrianglesBVH.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+struct PointLocalizerBVH::Impl
+{
+    std::uint32_t m_next_mesh_index = 0;
+    TriangleSoup m_triangles; // transformed triangles of all meshes, mesh ids are the indexes returned by AddMesh
+    std::unique_ptr<TrianglesBVH> mp_tree;
+    Params m_params;
+
+    size_t _LocalizeByNearestTriangle(const Point3D& i_point) const;
+    size_t _LocalizeByRayParity(const Point3D& i_point) const;
+};
+
+size_t PointLocalizerBVH::Impl::_LocalizeByNearestTriangle(const Point3D& i_point) const
+{
+    const auto triangle_index = mp_tree->FindNearestTriangle(i_point);
+    if (triangle_index == TrianglesBVH::NO_TRIANGLE)
+        return std::numeric_limits<size_t>::max();
+
+    const auto index = static_cast<std::uint32_t>(triangle_index);
+    auto loc_result = GetPointTriangleRelativeLocation(m_triangles.GetTriangle(index), i_point);
+    if (loc_result == PointTriangleRelativeLocationResult::Below
+     || loc_result == PointTriangleRelativeLocationResult::OnSamePlane)
+        return m_triangles.GetMeshId(index);
+
+    return std::numeric_limits<size_t>::max();
+}
+
+size_t PointLocalizerBVH::Impl::_LocalizeByRayParity(const Point3D& i_point) const
+{
+    std::vector<size_t> triangles;
+    mp_tree->CollectRayXTriangles(i_point, triangles);
+
+    RayParityCounter counter;
+    for (const auto triangle_index : triangles)
+    {
+        const auto index = static_cast<std::uint32_t>(triangle_index);
+        double x = 0;
+        if (GetRayXCrossing(m_triangles.GetVertices(index), i_point, x))
+            counter.AddCrossing(m_triangles.GetMeshId(index), x);
+    }
+    return counter.GetMeshIndex();
+}
+
+PointLocalizerBVH::PointLocalizerBVH()
+    : mp_impl(std::make_unique<Impl>())
+{
+}
+
+PointLocalizerBVH::~PointLocalizerBVH() = default;
+
+size_t PointLocalizerBVH::AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transformation)
+{
+    mp_impl->mp_tree.reset();
+    mp_impl->m_triangles.AddMesh(i_mesh, i_transformation, mp_impl->m_next_mesh_index);
+    return mp_impl->m_next_mesh_index++;
+}
+
+void PointLocalizerBVH::Build(const Params& i_params)
+{
+    TrianglesBVH::Params params;
+    params.m_max_triangles_in_leaf = i_params.m_max_triangles_in_leaf;
+    params.m_bins_count = i_params.m_bins_count;
+
+    mp_impl->m_params = i_params;
+    mp_impl->mp_tree = std::make_unique<TrianglesBVH>();
+    mp_impl->mp_tree->Build(mp_impl->m_triangles, params);
+}
+
+size_t PointLocalizerBVH::Localize(const Point3D& i_point, ReturnCode* op_return_code) const
+{
+    if (!mp_impl->mp_tree)
+    {
+        if (op_return_code)
+            *op_return_code = ReturnCode::TreeWasNotBuild;
+
+        return std::numeric_limits<size_t>::max();
+    }
+
+    if (op_return_code)
+        *op_return_code = ReturnCode::Ok;
+
+    if (mp_impl->m_params.m_classification == Classification::RayParity)
+        return mp_impl->_LocalizeByRayParity(i_point);
+
+    return mp_impl->_LocalizeByNearestTriangle(i_point);
+}
+
+void PointLocalizerBVH::LocalizeBatch(const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes, ReturnCode* op_return_code) const
+{
+    o_mesh_indexes.resize(i_points.size());
+    for (size_t i = 0; i < i_points.size(); ++i)
+        o_mesh_indexes[i] = Localize(i_points[i], op_return_code);
+}
+
+const TrianglesBVH* PointLocalizerBVH::GetTree() const
+{
+    return mp_impl->mp_tree.get();
+}
@@ -0,0 +1,538 @@
+#include "Math.Algos/PointLocalizerHierarchical.h"
+
+#include "Math.Algos/Voxelizer.h"
+
+#include "EmptyVoxelLabels.h"
+#include "NearestTriangleClassification.h"
+#include "RayParityCounter.h"
+#include "VoxelSizeSelection.h"
+
+#include <Math.Core/BasicPoint3.h>
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/Mesh.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/TransformMatrix.h>
+#include <Math.Core/TriangleSoup.h>
+#include <Math.Core/WorkStealingThreadPool.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+
+namespace
+{
+    constexpr double DEFAULT_EPSILON = EPSILON;
+    constexpr size_t CELLS_PER_TASK = 16;
+
+    struct BatchQuery
+    {
+        size_t m_cell = 0; // voxel index of the cell in the top grid
+        size_t m_point_index = 0;
+    };
+
+    // x coordinate of the voxel that contains i_x, clamped to the grid
+    size_t _GetXCoordinate(const VoxelGrid& i_grid, double i_x)
+    {
+        const auto x = std::floor((i_x - i_grid.GetBoundingBox().GetMin().GetX()) / i_grid.GetVoxelSize()[0]);
+        return static_cast<size_t>(std::min(std::max(x, 0.), static_cast<double>(i_grid.GetNumVoxels()[0] - 1)));
+    }
+}
+
+
+struct PointLocalizerHierarchical::Impl
+{
+    // triangles of a mesh are consecutive in the soup
+    struct MeshRange
+    {
+        std::uint32_t m_first_triangle = 0;
+        std::uint32_t m_triangles_count = 0;
+    };
+
+    std::uint32_t m_next_mesh_index = 0;
+    std::map<size_t, MeshRange> m_meshes;
+    // transformed triangles of all meshes, mesh ids are the indexes returned by AddMesh and all grids index the soup.
+    // Triangles of removed meshes stay until the next Build
+    TriangleSoup m_triangles;
+    std::shared_ptr<VoxelGrid> mp_top_grid;
+    std::vector<std::unique_ptr<VoxelGrid>> m_sub_grids;
+    std::unordered_map<size_t, std::uint32_t> m_cell_sub_grids; // voxel index of a cell of the top grid -> its sub-grid
+    std::vector<size_t> m_sub_grid_cells;                       // sub-grid -> voxel index of its cell
+    EmptyVoxelLabels m_empty_cell_labels;
+    Params m_build_params;
+
+    Voxelizer _CreateVoxelizer() const;
+    const VoxelGrid* _FindSubGrid(const std::array<size_t, 3>& i_cell) const;
+    std::unique_ptr<VoxelGrid> _BuildSubGrid(const std::array<size_t, 3>& i_cell) const;
+    std::vector<std::unique_ptr<VoxelGrid>> _BuildSubGrids(const std::vector<std::array<size_t, 3>>& i_cells) const;
+    // after the top grid gained or lost i_entries only the sub-grids of their cells and the labels around them are built again
+    void _UpdateCells(const std::vector<VoxelGrid::Entry>& i_entries);
+    // the point has to be inside of the top grid, labels of empty cells are not used
+    size_t _LocalizeInGrids(const Point3D& i_point) const;
+    // same for a point of i_cell, ip_sub_grid is the sub-grid of the cell for NearestTriangle and nullptr otherwise
+    size_t _LocalizeInCell(const Point3D& i_point, const std::array<size_t, 3>& i_cell, const VoxelGrid* ip_sub_grid) const;
+};
+
+Voxelizer PointLocalizerHierarchical::Impl::_CreateVoxelizer() const
+{
+    Voxelizer::Params params;
+    params.m_resolution_x = m_build_params.m_cell_size;
+    params.m_resolution_y = m_build_params.m_cell_size;
+    params.m_resolution_z = m_build_params.m_cell_size;
+    params.m_precision = DEFAULT_EPSILON;
+    params.m_storage_type = m_build_params.m_storage_type;
+    params.m_threads_count = m_build_params.m_threads_count;
+    Voxelizer voxelizer;
+    voxelizer.SetParams(params);
+    return voxelizer;
+}
+
+const VoxelGrid* PointLocalizerHierarchical::Impl::_FindSubGrid(const std::array<size_t, 3>& i_cell) const
+{
+    const auto it = m_cell_sub_grids.find(mp_top_grid->GetVoxelIndexFromCoordinates(i_cell));
+    return it == m_cell_sub_grids.end() ? nullptr : m_sub_grids[it->second].get();
+}
+
+std::unique_ptr<VoxelGrid> PointLocalizerHierarchical::Impl::_BuildSubGrid(const std::array<size_t, 3>& i_cell) const
+{
+    std::vector<std::uint32_t> triangle_indexes;
+    const auto cell_triangles = mp_top_grid->GetVoxelTriangles(i_cell);
+    BoundingBox triangles_bbox;
+    for (auto it = cell_triangles.begin(); it != cell_triangles.end(); ++it)
+    {
+        triangle_indexes.push_back(it.GetIndex());
+        const auto p_vertices = m_triangles.GetVertices(it.GetIndex());
+        for (short vertex = 0; vertex < 3; ++vertex)
+            triangles_bbox.AddPoint(ToPoint3D(p_vertices[vertex]));
+    }
+
+    // the sub-grid covers only the part of the cell where its triangles are
+    const auto cell_bbox = mp_top_grid->GetVoxelBoundingBox(i_cell);
+    const Point3D margin(DEFAULT_EPSILON, DEFAULT_EPSILON, DEFAULT_EPSILON);
+    BoundingBox bbox;
+    const auto triangles_min = triangles_bbox.GetMin() - margin;
+    const auto triangles_max = triangles_bbox.GetMax() + margin;
+    bbox.AddPoint(Point3D(std::max(cell_bbox.GetMin().GetX(), triangles_min.GetX()), std::max(cell_bbox.GetMin().GetY(), triangles_min.GetY()), std::max(cell_bbox.GetMin().GetZ(), triangles_min.GetZ())));
+    bbox.AddPoint(Point3D(std::min(cell_bbox.GetMax().GetX(), triangles_max.GetX()), std::min(cell_bbox.GetMax().GetY(), triangles_max.GetY()), std::min(cell_bbox.GetMax().GetZ(), triangles_max.GetZ())));
+
+    // A sheet of triangles that crosses the sub-grid touches about n^2 of its n^3 voxels, so more than
+    // sqrt(triangles / target) voxels along an axis would only add empty voxels, e.g. for triangles larger than the cell
+    const auto triangles_per_voxel = m_build_params.m_triangles_per_voxel;
+    const auto estimated_size = SelectVoxelSize(m_triangles, triangle_indexes, triangles_per_voxel, false);
+    const auto voxel_size = *std::min_element(estimated_size.begin(), estimated_size.end());
+    const auto max_resolution = std::min(static_cast<double>(m_build_params.m_max_sub_grid_resolution),
+                                         std::max(1., std::ceil(std::sqrt(triangle_indexes.size() / triangles_per_voxel))));
+
+    std::array<double, 3> voxel_sizes;
+    std::array<size_t, 3> num_voxels;
+    for (short axis = 0; axis < 3; ++axis)
+    {
+        const auto extent = bbox.GetDelta(axis) + DEFAULT_EPSILON;
+        const auto resolution = std::min(max_resolution, std::max(1., std::round(extent / voxel_size)));
+        num_voxels[axis] = static_cast<size_t>(resolution);
+        voxel_sizes[axis] = extent / resolution;
+    }
+
+    Voxelizer::Params params;
+    params.m_precision = DEFAULT_EPSILON;
+    params.m_threads_count = 1;
+    Voxelizer voxelizer;
+    voxelizer.SetParams(params);
+
+    // the sub-grid has no triangles table, it keeps the indexes of its triangles in the soup
+    auto p_sub_grid = std::make_unique<VoxelGrid>(voxel_sizes, num_voxels, bbox);
+    auto entries = voxelizer.CollectEntries(*p_sub_grid, m_triangles, triangle_indexes);
+    p_sub_grid->Fill(m_triangles.GetTrianglesCount(), entries, m_build_params.m_storage_type);
+    return p_sub_grid;
+}
+
+std::vector<std::unique_ptr<VoxelGrid>> PointLocalizerHierarchical::Impl::_BuildSubGrids(const std::vector<std::array<size_t, 3>>& i_cells) const
+{
+    std::unique_ptr<WorkStealingThreadPool> p_own_pool;
+    if (m_build_params.m_threads_count != 0)
+        p_own_pool = std::make_unique<WorkStealingThreadPool>(m_build_params.m_threads_count);
+    auto& pool = p_own_pool ? *p_own_pool : WorkStealingThreadPool::GetGlobalInstance();
+
+    // cells differ a lot in their triangles count, work stealing balances them
+    std::vector<std::unique_ptr<VoxelGrid>> sub_grids(i_cells.size());
+    pool.ParallelFor(i_cells.size(), CELLS_PER_TASK, [this, &i_cells, &sub_grids](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+            sub_grids[i] = _BuildSubGrid(i_cells[i]);
+    });
+    return sub_grids;
+}
+
+void PointLocalizerHierarchical::Impl::_UpdateCells(const std::vector<VoxelGrid::Entry>& i_entries)
+{
+    Q_ASSERT(mp_top_grid);
+    if (i_entries.empty())
+        return;
+
+    auto& top_grid = *mp_top_grid;
+    std::vector<size_t> voxel_indexes;
+    for (const auto& entry : i_entries)
+        voxel_indexes.push_back(entry.m_voxel_index);
+    std::sort(voxel_indexes.begin(), voxel_indexes.end());
+    voxel_indexes.erase(std::unique(voxel_indexes.begin(), voxel_indexes.end()), voxel_indexes.end());
+
+    // cells that lost all triangles drop their sub-grids, the last sub-grid takes the freed place
+    std::vector<std::array<size_t, 3>> cells;
+    for (const auto voxel_index : voxel_indexes)
+    {
+        const auto cell = top_grid.GetCoordinatesFromVoxelIndex(voxel_index);
+        if (!top_grid.GetVoxelTriangles(cell).empty())
+        {
+            cells.push_back(cell);
+            continue;
+        }
+
+        const auto it = m_cell_sub_grids.find(voxel_index);
+        if (it == m_cell_sub_grids.end())
+            continue;
+
+        const auto sub_grid_index = it->second;
+        m_cell_sub_grids.erase(it);
+        if (sub_grid_index + 1 != m_sub_grids.size())
+        {
+            m_sub_grids[sub_grid_index] = std::move(m_sub_grids.back());
+            m_sub_grid_cells[sub_grid_index] = m_sub_grid_cells.back();
+            m_cell_sub_grids[m_sub_grid_cells[sub_grid_index]] = sub_grid_index;
+        }
+        m_sub_grids.pop_back();
+        m_sub_grid_cells.pop_back();
+    }
+
+    auto sub_grids = _BuildSubGrids(cells);
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        const auto voxel_index = top_grid.GetVoxelIndexFromCoordinates(cells[i]);
+        const auto it = m_cell_sub_grids.find(voxel_index);
+        if (it != m_cell_sub_grids.end())
+        {
+            m_sub_grids[it->second] = std::move(sub_grids[i]);
+        }
+        else
+        {
+            m_cell_sub_grids.emplace(voxel_index, static_cast<std::uint32_t>(m_sub_grids.size()));
+            m_sub_grids.push_back(std::move(sub_grids[i]));
+            m_sub_grid_cells.push_back(voxel_index);
+        }
+    }
+
+    if (!m_empty_cell_labels.IsBuilt())
+        return;
+
+    auto min_coordinates = top_grid.GetCoordinatesFromVoxelIndex(voxel_indexes.front());
+    auto max_coordinates = min_coordinates;
+    for (const auto voxel_index : voxel_indexes)
+    {
+        const auto coordinates = top_grid.GetCoordinatesFromVoxelIndex(voxel_index);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            min_coordinates[i] = std::min(min_coordinates[i], coordinates[i]);
+            max_coordinates[i] = std::max(max_coordinates[i], coordinates[i]);
+        }
+    }
+    m_empty_cell_labels.Update(top_grid, min_coordinates, max_coordinates, [this](const Point3D& i_point)
+    {
+        return _LocalizeInGrids(i_point);
+    });
+}
+
+size_t PointLocalizerHierarchical::Impl::_LocalizeInGrids(const Point3D& i_point) const
+{
+    const auto cell = mp_top_grid->GetCoordinatesForPoint(i_point);
+    return _LocalizeInCell(i_point, cell, m_build_params.m_classification == Classification::NearestTriangle ? _FindSubGrid(cell) : nullptr);
+}
+
+size_t PointLocalizerHierarchical::Impl::_LocalizeInCell(const Point3D& i_point, const std::array<size_t, 3>& i_cell, const VoxelGrid* ip_sub_grid) const
+{
+    const auto& top_grid = *mp_top_grid;
+
+    if (ip_sub_grid && ip_sub_grid->PointInsideVoxelization(i_point))
+    {
+        const auto voxel_triangles = ip_sub_grid->GetVoxelTriangles(ip_sub_grid->GetCoordinatesForPoint(i_point));
+        if (!voxel_triangles.empty())
+            return ClassifyByNearestTriangle(voxel_triangles, i_point, m_triangles);
+    }
+
+    // A triangle is stored in every cell and voxel it touches, so its crossing is counted only in the cell and the
+    // voxel that contain the crossing
+    RayParityCounter counter;
+    for (size_t x_cell = i_cell[0]; x_cell < top_grid.GetNumVoxels()[0]; ++x_cell)
+    {
+        const auto p_sub_grid = _FindSubGrid({ x_cell, i_cell[1], i_cell[2] });
+        if (!p_sub_grid)
+            continue;
+
+        // a ray that misses the sub-grid crosses none of its triangles
+        const auto& grid = *p_sub_grid;
+        const auto min = grid.GetBoundingBox().GetMin();
+        const auto max = grid.GetBoundingBox().GetMax();
+        if (i_point.GetY() < min.GetY() || i_point.GetY() > max.GetY() || i_point.GetZ() < min.GetZ() || i_point.GetZ() > max.GetZ() || i_point.GetX() > max.GetX())
+            continue;
+
+        const auto start = grid.GetCoordinatesForPoint(Point3D(std::max(i_point.GetX(), min.GetX()), i_point.GetY(), i_point.GetZ()));
+        for (size_t x_coord = start[0]; x_coord < grid.GetNumVoxels()[0]; ++x_coord)
+        {
+            const auto voxel_triangles = grid.GetVoxelTriangles({ x_coord, start[1], start[2] });
+            for (auto it = voxel_triangles.begin(); it != voxel_triangles.end(); ++it)
+            {
+                double x = 0;
+                if (GetRayXCrossing(m_triangles.GetVertices(it.GetIndex()), i_point, x) && _GetXCoordinate(top_grid, x) == x_cell && _GetXCoordinate(grid, x) == x_coord)
+                    counter.AddCrossing(m_triangles.GetMeshId(it.GetIndex()), x);
+            }
+        }
+    }
+    return counter.GetMeshIndex();
+}
+
+PointLocalizerHierarchical::PointLocalizerHierarchical()
+    : mp_impl(std::make_unique<Impl>())
+{
+}
+
+PointLocalizerHierarchical::~PointLocalizerHierarchical()
+{
+}
+
+size_t PointLocalizerHierarchical::AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transformation)
+{
+    auto& impl = *mp_impl;
+    const auto mesh_index = impl.m_next_mesh_index++;
+    auto& mesh_range = impl.m_meshes[mesh_index];
+    mesh_range.m_first_triangle = impl.m_triangles.AddMesh(i_mesh, i_transformation, mesh_index);
+    mesh_range.m_triangles_count = static_cast<std::uint32_t>(impl.m_triangles.GetTrianglesCount() - mesh_range.m_first_triangle);
+
+    if (!impl.mp_top_grid)
+        return mesh_index;
+
+    // the top grid can't grow, a mesh that sticks out of it requires a new build
+    auto& top_grid = *impl.mp_top_grid;
+    for (std::uint32_t i = 0; i < mesh_range.m_triangles_count; ++i)
+    {
+        const auto p_vertices = impl.m_triangles.GetVertices(mesh_range.m_first_triangle + i);
+        for (short vertex = 0; vertex < 3; ++vertex)
+        {
+            if (!top_grid.PointInsideVoxelization(ToPoint3D(p_vertices[vertex])))
+            {
+                Build(impl.m_build_params);
+                return mesh_index;
+            }
+        }
+    }
+
+    // the top grid and the soup grow together, so the new triangles get the same indexes in both
+    const auto first_index = top_grid.AddTriangles(mesh_range.m_triangles_count);
+    Q_ASSERT(first_index == mesh_range.m_first_triangle);
+    auto entries = impl._CreateVoxelizer().CollectEntries(top_grid, impl.m_triangles, first_index, mesh_range.m_triangles_count);
+    top_grid.Insert(entries);
+    impl._UpdateCells(entries);
+
+    return mesh_index;
+}
+
+bool PointLocalizerHierarchical::RemoveMesh(size_t i_mesh_index)
+{
+    auto it = mp_impl->m_meshes.find(i_mesh_index);
+    if (it == mp_impl->m_meshes.end())
+        return false;
+
+    std::vector<VoxelGrid::Entry> entries;
+    if (mp_impl->mp_top_grid)
+    {
+        // voxelization is deterministic, so the triangles touch exactly the same cells as when they were inserted
+        auto& top_grid = *mp_impl->mp_top_grid;
+        entries = mp_impl->_CreateVoxelizer().CollectEntries(top_grid, mp_impl->m_triangles, it->second.m_first_triangle, it->second.m_triangles_count);
+        top_grid.Remove(entries);
+    }
+
+    mp_impl->m_meshes.erase(it);
+    if (mp_impl->mp_top_grid)
+        mp_impl->_UpdateCells(entries);
+    return true;
+}
+
+void PointLocalizerHierarchical::Build(const Params& i_params)
+{
+    auto& impl = *mp_impl;
+    impl.m_build_params = i_params;
+
+    // triangles of removed meshes are dropped, the others are moved together
+    TriangleSoup triangles;
+    size_t triangles_count = 0;
+    for (const auto& mesh : impl.m_meshes)
+        triangles_count += mesh.second.m_triangles_count;
+    triangles.Reserve(triangles_count);
+    for (auto& mesh : impl.m_meshes)
+    {
+        const auto first_triangle = static_cast<std::uint32_t>(triangles.GetTrianglesCount());
+        for (std::uint32_t i = 0; i < mesh.second.m_triangles_count; ++i)
+        {
+            const auto p_vertices = impl.m_triangles.GetVertices(mesh.second.m_first_triangle + i);
+            triangles.AddTriangle(ToPoint3D(p_vertices[0]), ToPoint3D(p_vertices[1]), ToPoint3D(p_vertices[2]), static_cast<std::uint32_t>(mesh.first));
+        }
+        mesh.second.m_first_triangle = first_triangle;
+    }
+    impl.m_triangles = std::move(triangles);
+
+    if (i_params.m_cell_size <= 0)
+    {
+        const auto cell_size = SelectVoxelSize(impl.m_triangles, i_params.m_triangles_per_cell, false);
+        impl.m_build_params.m_cell_size = *std::max_element(cell_size.begin(), cell_size.end());
+    }
+
+    impl.mp_top_grid = impl._CreateVoxelizer().Voxelize(impl.m_triangles);
+
+    std::vector<std::array<size_t, 3>> cells;
+    for (const auto& cell : impl.mp_top_grid->GetExistingVoxelsCoordinates())
+    {
+        if (!impl.mp_top_grid->GetVoxelTriangles(cell).empty())
+            cells.push_back(cell);
+    }
+    impl.m_sub_grids = impl._BuildSubGrids(cells);
+
+    impl.m_cell_sub_grids.clear();
+    impl.m_cell_sub_grids.reserve(cells.size());
+    impl.m_sub_grid_cells.clear();
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        impl.m_sub_grid_cells.push_back(impl.mp_top_grid->GetVoxelIndexFromCoordinates(cells[i]));
+        impl.m_cell_sub_grids.emplace(impl.m_sub_grid_cells.back(), static_cast<std::uint32_t>(i));
+    }
+
+    impl.m_empty_cell_labels.Clear();
+    if (i_params.m_label_empty_cells)
+    {
+        impl.m_empty_cell_labels.Build(*impl.mp_top_grid, [&impl](const Point3D& i_point)
+        {
+            return impl._LocalizeInGrids(i_point);
+        });
+    }
+}
+
+const PointLocalizerHierarchical::Params& PointLocalizerHierarchical::GetParams() const
+{
+    return mp_impl->m_build_params;
+}
+
+size_t PointLocalizerHierarchical::Localize(const Point3D& i_point, ReturnCode* op_return_code) const
+{
+    if (!mp_impl->mp_top_grid)
+    {
+        if (op_return_code)
+            *op_return_code = ReturnCode::GridWasNotBuild;
+
+        return std::numeric_limits<size_t>::max();
+    }
+
+    if (op_return_code)
+        *op_return_code = ReturnCode::Ok;
+
+    if (!mp_impl->mp_top_grid->PointInsideVoxelization(i_point))
+        return std::numeric_limits<size_t>::max();
+
+    if (mp_impl->m_empty_cell_labels.IsBuilt())
+    {
+        const auto label = mp_impl->m_empty_cell_labels.GetLabel(mp_impl->mp_top_grid->GetCoordinatesForPoint(i_point));
+        if (label != EmptyVoxelLabels::NOT_EMPTY)
+            return label == EmptyVoxelLabels::OUTSIDE ? std::numeric_limits<size_t>::max() : label;
+    }
+
+    return mp_impl->_LocalizeInGrids(i_point);
+}
+
+void PointLocalizerHierarchical::LocalizeBatch(const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes, ReturnCode* op_return_code) const
+{
+    o_mesh_indexes.assign(i_points.size(), std::numeric_limits<size_t>::max());
+
+    if (!mp_impl->mp_top_grid)
+    {
+        if (op_return_code)
+            *op_return_code = ReturnCode::GridWasNotBuild;
+
+        return;
+    }
+
+    if (op_return_code)
+        *op_return_code = ReturnCode::Ok;
+
+    const auto& impl = *mp_impl;
+    const auto& top_grid = *impl.mp_top_grid;
+    std::vector<BatchQuery> queries;
+    queries.reserve(i_points.size());
+    for (size_t i = 0; i < i_points.size(); ++i)
+    {
+        if (!top_grid.PointInsideVoxelization(i_points[i]))
+            continue;
+
+        BatchQuery query;
+        query.m_cell = top_grid.GetVoxelIndexFromCoordinates(top_grid.GetCoordinatesForPoint(i_points[i]));
+        query.m_point_index = i;
+        queries.emplace_back(query);
+    }
+
+    std::sort(queries.begin(), queries.end(), [](const BatchQuery& i_lhs, const BatchQuery& i_rhs)
+    {
+        if (i_lhs.m_cell != i_rhs.m_cell)
+            return i_lhs.m_cell < i_rhs.m_cell;
+        return i_lhs.m_point_index < i_rhs.m_point_index;
+    });
+
+    // the label and the sub-grid of a cell are looked up once for all its queries, which then run in one sub-grid
+    for (size_t cell_begin = 0; cell_begin < queries.size();)
+    {
+        const auto cell_index = queries[cell_begin].m_cell;
+        const auto cell = top_grid.GetCoordinatesFromVoxelIndex(cell_index);
+        auto label = EmptyVoxelLabels::NOT_EMPTY;
+        if (impl.m_empty_cell_labels.IsBuilt())
+            label = impl.m_empty_cell_labels.GetLabel(cell);
+        const auto p_sub_grid = label == EmptyVoxelLabels::NOT_EMPTY && impl.m_build_params.m_classification == Classification::NearestTriangle
+            ? impl._FindSubGrid(cell) : nullptr;
+
+        size_t i = cell_begin;
+        for (; i < queries.size() && queries[i].m_cell == cell_index; ++i)
+        {
+            const auto point_index = queries[i].m_point_index;
+            if (label == EmptyVoxelLabels::NOT_EMPTY)
+                o_mesh_indexes[point_index] = impl._LocalizeInCell(i_points[point_index], cell, p_sub_grid);
+            else if (label != EmptyVoxelLabels::OUTSIDE)
+                o_mesh_indexes[point_index] = label;
+        }
+
+        cell_begin = i;
+    }
+}
+
+std::weak_ptr<VoxelGrid> PointLocalizerHierarchical::GetTopGrid() const
+{
+    return mp_impl->mp_top_grid;
+}
+
+size_t PointLocalizerHierarchical::GetSubGridsCount() const
+{
+    return mp_impl->m_sub_grids.size();
+}
+
+size_t PointLocalizerHierarchical::GetMemoryUsage() const
+{
+    size_t result = mp_impl->m_triangles.GetMemoryUsage() + mp_impl->m_empty_cell_labels.GetMemoryUsage();
+    if (mp_impl->mp_top_grid)
+        result += mp_impl->mp_top_grid->GetMemoryUsage();
+
+    result += mp_impl->m_sub_grids.capacity() * sizeof(std::unique_ptr<VoxelGrid>) + mp_impl->m_sub_grid_cells.capacity() * sizeof(size_t);
+    for (const auto& p_sub_grid : mp_impl->m_sub_grids)
+        result += p_sub_grid->GetMemoryUsage() + sizeof(VoxelGrid);
+
+    // a node with the key and the value per cell and a bucket pointer
+    result += mp_impl->m_cell_sub_grids.size() * (sizeof(void*) + sizeof(size_t) + sizeof(std::uint32_t)) + mp_impl->m_cell_sub_grids.bucket_count() * sizeof(void*);
+    return result;
+}
@@ -2,34 +2,219 @@
 
 #include "Math.Algos/Voxelizer.h"
 
+#include "EmptyVoxelLabels.h"
+#include "NearestTriangleClassification.h"
+#include "RayParityCounter.h"
+#include "VoxelCornerDistances.h"
+#include "VoxelSizeSelection.h"
+
+#include <Math.Core/BasicPoint3.h>
+#include <Math.Core/BinaryStream.h>
 #include <Math.Core/CommonUtilities.h>
+#include <Math.Core/IndexedMesh.h>
 #include <Math.Core/Mesh.h>
-#include <Math.Core/MeshTriangle.h>
 #include <Math.Core/Point3D.h>
 #include <Math.Core/TransformMatrix.h>
 #include <Math.Core/Triangle.h>
+#include <Math.Core/TriangleSoup.h>
 
 #include <Math.DataStructures/VoxelGrid.h>
 
-#include <list>
+#include <QFile>
+#include <QString>
+
+#include <algorithm>
+#include <cmath>
 #include <limits>
-#include <unordered_map>
+#include <map>
 
 
 namespace
 {
     constexpr double DEFAULT_EPSILON = EPSILON;
+
+    constexpr char LOCALIZER_MAGIC[] = "PL3DSPLV";
+    constexpr std::uint32_t LOCALIZER_VERSION = 1;
+
+    struct BatchQuery
+    {
+        size_t m_column = 0; // y + z * num_voxels_y
+        size_t m_x = 0;
+        size_t m_point_index = 0;
+    };
+
+    // Crossings of the ray along +X are collected in the voxels of the column of the point. A triangle is stored in
+    // every voxel it touches, so its crossing is counted only in the voxel that contains the crossing
+    size_t _LocalizeByRayParity(const VoxelGrid& i_grid, const Point3D& i_point, const TriangleSoup& i_triangles)
+    {
+        const auto coordinates = i_grid.GetCoordinatesForPoint(i_point);
+        const auto min_x = i_grid.GetBoundingBox().GetMin().GetX();
+        const auto voxel_size_x = i_grid.GetVoxelSize()[0];
+        const auto last_x = i_grid.GetNumVoxels()[0] - 1;
+
+        RayParityCounter counter;
+        for (size_t x_coord = coordinates[0]; x_coord <= last_x; ++x_coord)
+        {
+            const auto voxel_triangles = i_grid.GetVoxelTriangles({ x_coord, coordinates[1], coordinates[2] });
+            for (auto it = voxel_triangles.begin(); it != voxel_triangles.end(); ++it)
+            {
+                double x = 0;
+                if (!GetRayXCrossing(i_triangles.GetVertices(it.GetIndex()), i_point, x))
+                    continue;
+
+                const auto crossing_x_coord = std::min(last_x, static_cast<size_t>(std::floor((x - min_x) / voxel_size_x)));
+                if (crossing_x_coord == x_coord)
+                    counter.AddCrossing(i_triangles.GetMeshId(it.GetIndex()), x);
+            }
+        }
+        return counter.GetMeshIndex();
+    }
 }
 
 
 struct PointLocalizerVoxelized::Impl 
 {
-    size_t m_next_mesh_index = 0;
-    std::list<Triangle> m_transformed_triangles;
-    std::unordered_map<Triangle*, size_t> m_triangles_to_mesh_map;
+    // triangles of a mesh are consecutive in the soup
+    struct MeshRange
+    {
+        std::uint32_t m_first_triangle = 0;
+        std::uint32_t m_triangles_count = 0;
+    };
+
+    std::uint32_t m_next_mesh_index = 0;
+    std::map<size_t, MeshRange> m_meshes;
+    // transformed triangles of all meshes, mesh ids are the indexes returned by AddMesh and the grid indexes the soup.
+    // Triangles of removed meshes stay until the next Build
+    TriangleSoup m_triangles;
     std::shared_ptr<VoxelGrid> mp_voxelization;
+    EmptyVoxelLabels m_empty_voxel_labels;
+    VoxelCornerDistances m_corner_distances;
+    Params m_build_params;
+
+    Voxelizer _CreateVoxelizer() const;
+    // the point has to be inside of the voxelization, labels of empty voxels are not used
+    size_t _LocalizeInGrid(const Point3D& i_point) const;
+    // labels of empty voxels and corner distances are derived from the grid
+    void _BuildDerivedData();
+    // after the grid gained or lost i_entries only the labels and the samples around their voxels are updated
+    void _UpdateDerivedData(const std::vector<VoxelGrid::Entry>& i_entries);
+    // Load checks what the lookups trust: meshes lie in the soup without overlapping, their triangles carry their
+    // mesh ids and the grid refers only to triangles of meshes
+    bool _IsValid() const;
 };
 
+Voxelizer PointLocalizerVoxelized::Impl::_CreateVoxelizer() const
+{
+    Voxelizer::Params params;
+    params.m_resolution_x = m_build_params.m_voxel_size_x;
+    params.m_resolution_y = m_build_params.m_voxel_size_y;
+    params.m_resolution_z = m_build_params.m_voxel_size_z;
+    params.m_precision = DEFAULT_EPSILON;
+    params.m_storage_type = m_build_params.m_storage_type;
+    params.m_threads_count = m_build_params.m_threads_count;
+
+    Voxelizer voxelizer;
+    voxelizer.SetParams(params);
+    return voxelizer;
+}
+
+size_t PointLocalizerVoxelized::Impl::_LocalizeInGrid(const Point3D& i_point) const
+{
+    if (m_build_params.m_classification == Classification::RayParity)
+        return _LocalizeByRayParity(*mp_voxelization, i_point, m_triangles);
+
+    const auto coordinates = mp_voxelization->GetCoordinatesForPoint(i_point);
+    for (size_t x_coord = coordinates[0]; x_coord < mp_voxelization->GetNumVoxels()[0]; ++x_coord)
+    {
+        const std::array<size_t, 3> current_coords = { x_coord, coordinates[1], coordinates[2] };
+        const auto voxel_triangles = mp_voxelization->GetVoxelTriangles(current_coords);
+        if (!voxel_triangles.empty())
+            return ClassifyByNearestTriangle(voxel_triangles, i_point, m_triangles);
+    }
+
+    return std::numeric_limits<size_t>::max();
+}
+
+void PointLocalizerVoxelized::Impl::_BuildDerivedData()
+{
+    m_empty_voxel_labels.Clear();
+    m_corner_distances.Clear();
+    if (!mp_voxelization)
+        return;
+
+    const auto classify = [this](const Point3D& i_point)
+    {
+        return _LocalizeInGrid(i_point);
+    };
+    if (m_build_params.m_label_empty_voxels)
+        m_empty_voxel_labels.Build(*mp_voxelization, classify);
+    if (m_build_params.m_use_corner_distances)
+        m_corner_distances.Build(*mp_voxelization, m_triangles, m_build_params.m_threads_count, classify);
+}
+
+void PointLocalizerVoxelized::Impl::_UpdateDerivedData(const std::vector<VoxelGrid::Entry>& i_entries)
+{
+    Q_ASSERT(mp_voxelization);
+    if (i_entries.empty())
+        return;
+
+    const auto& grid = *mp_voxelization;
+    auto min_coordinates = grid.GetCoordinatesFromVoxelIndex(i_entries.front().m_voxel_index);
+    auto max_coordinates = min_coordinates;
+    for (const auto& entry : i_entries)
+    {
+        const auto coordinates = grid.GetCoordinatesFromVoxelIndex(entry.m_voxel_index);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            min_coordinates[i] = std::min(min_coordinates[i], coordinates[i]);
+            max_coordinates[i] = std::max(max_coordinates[i], coordinates[i]);
+        }
+    }
+
+    const auto classify = [this](const Point3D& i_point)
+    {
+        return _LocalizeInGrid(i_point);
+    };
+    if (m_empty_voxel_labels.IsBuilt())
+        m_empty_voxel_labels.Update(grid, min_coordinates, max_coordinates, classify);
+    if (m_corner_distances.IsBuilt())
+        m_corner_distances.Update(grid, m_triangles, min_coordinates, max_coordinates, m_build_params.m_threads_count, classify);
+    else if (m_build_params.m_use_corner_distances)
+        m_corner_distances.Build(grid, m_triangles, m_build_params.m_threads_count, classify);
+}
+
+bool PointLocalizerVoxelized::Impl::_IsValid() const
+{
+    std::vector<bool> is_mesh_triangle(m_triangles.GetTrianglesCount(), false);
+    for (const auto& mesh : m_meshes)
+    {
+        const auto first_triangle = mesh.second.m_first_triangle;
+        if (static_cast<std::uint64_t>(first_triangle) + mesh.second.m_triangles_count > m_triangles.GetTrianglesCount())
+            return false;
+
+        for (auto triangle = first_triangle; triangle < first_triangle + mesh.second.m_triangles_count; ++triangle)
+        {
+            if (is_mesh_triangle[triangle] || m_triangles.GetMeshId(triangle) != mesh.first)
+                return false;
+            is_mesh_triangle[triangle] = true;
+        }
+    }
+
+    if (!mp_voxelization)
+        return true;
+
+    for (const auto& coordinates : mp_voxelization->GetExistingVoxelsCoordinates())
+    {
+        const auto voxel_triangles = mp_voxelization->GetVoxelTriangles(coordinates);
+        for (auto it = voxel_triangles.begin(); it != voxel_triangles.end(); ++it)
+        {
+            if (!is_mesh_triangle[it.GetIndex()])
+                return false;
+        }
+    }
+    return true;
+}
+
 PointLocalizerVoxelized::PointLocalizerVoxelized()
     : mp_impl(std::make_unique<Impl>())
 {
@@ -41,55 +226,101 @@ PointLocalizerVoxelized::~PointLocalizerVoxelized()
 
 size_t PointLocalizerVoxelized::AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transformation)
 {
-    mp_impl->mp_voxelization.reset();
+    auto& impl = *mp_impl;
+    const auto mesh_index = impl.m_next_mesh_index++;
+    auto& mesh_range = impl.m_meshes[mesh_index];
+    mesh_range.m_first_triangle = impl.m_triangles.AddMesh(i_mesh, i_transformation, mesh_index);
+    mesh_range.m_triangles_count = static_cast<std::uint32_t>(impl.m_triangles.GetTrianglesCount() - mesh_range.m_first_triangle);
 
-    const auto triangles_count = i_mesh.GetTrianglesCount();
-    for (size_t i = 0; i < triangles_count; ++i)
+    if (!impl.mp_voxelization)
+        return mesh_index;
+
+    // the grid can't grow, a mesh that sticks out of it requires a new voxelization
+    auto& grid = *impl.mp_voxelization;
+    for (std::uint32_t i = 0; i < mesh_range.m_triangles_count; ++i)
     {
-        if (auto p_triangle = i_mesh.GetTriangle(i).lock())
-        {
-            auto point1 = p_triangle->GetPoint(0);
-            auto point2 = p_triangle->GetPoint(1);
-            auto point3 = p_triangle->GetPoint(2);
-            
-            i_transformation.ApplyTransformation(point1);
-            i_transformation.ApplyTransformation(point2);
-            i_transformation.ApplyTransformation(point3);
-        
-            mp_impl->m_transformed_triangles.emplace_back(point1, point2, point3);
-            mp_impl->m_triangles_to_mesh_map[&mp_impl->m_transformed_triangles.back()] = mp_impl->m_next_mesh_index;
-        }
-        else
+        const auto p_vertices = impl.m_triangles.GetVertices(mesh_range.m_first_triangle + i);
+        for (short vertex = 0; vertex < 3; ++vertex)
         {
-            assert(false);
+            if (!grid.PointInsideVoxelization(ToPoint3D(p_vertices[vertex])))
+            {
+                Build(impl.m_build_params);
+                return mesh_index;
+            }
         }
     }
+
+    // the grid and the soup grow together, so the new triangles get the same indexes in both
+    const auto first_index = grid.AddTriangles(mesh_range.m_triangles_count);
+    Q_ASSERT(first_index == mesh_range.m_first_triangle);
+    auto entries = impl._CreateVoxelizer().CollectEntries(grid, impl.m_triangles, first_index, mesh_range.m_triangles_count);
+    grid.Insert(entries);
+    impl._UpdateDerivedData(entries);
    
-    return mp_impl->m_next_mesh_index++;
+    return mesh_index;
+}
+
+bool PointLocalizerVoxelized::RemoveMesh(size_t i_mesh_index)
+{
+    auto it = mp_impl->m_meshes.find(i_mesh_index);
+    if (it == mp_impl->m_meshes.end())
+        return false;
+
+    std::vector<VoxelGrid::Entry> entries;
+    if (mp_impl->mp_voxelization)
+    {
+        // voxelization is deterministic, so the triangles touch exactly the same voxels as when they were inserted
+        auto& grid = *mp_impl->mp_voxelization;
+        entries = mp_impl->_CreateVoxelizer().CollectEntries(grid, mp_impl->m_triangles, it->second.m_first_triangle, it->second.m_triangles_count);
+        grid.Remove(entries);
+    }
+
+    mp_impl->m_meshes.erase(it);
+    if (mp_impl->mp_voxelization)
+        mp_impl->_UpdateDerivedData(entries);
+    return true;
 }
 
 void PointLocalizerVoxelized::Build(const Params& i_params)
 {
-    Voxelizer::Params params;
-    params.m_resolution_x = i_params.m_voxel_size_x;
-    params.m_resolution_y = i_params.m_voxel_size_y;
-    params.m_resolution_z = i_params.m_voxel_size_z;
-    params.m_precision = DEFAULT_EPSILON;
+    mp_impl->m_build_params = i_params;
 
-    Voxelizer voxelizer;
-    voxelizer.SetParams(params);
+    // triangles of removed meshes are dropped, the others are moved together
+    TriangleSoup triangles;
+    size_t triangles_count = 0;
+    for (const auto& mesh : mp_impl->m_meshes)
+        triangles_count += mesh.second.m_triangles_count;
+    triangles.Reserve(triangles_count);
+    for (auto& mesh : mp_impl->m_meshes)
+    {
+        const auto first_triangle = static_cast<std::uint32_t>(triangles.GetTrianglesCount());
+        for (std::uint32_t i = 0; i < mesh.second.m_triangles_count; ++i)
+        {
+            const auto p_vertices = mp_impl->m_triangles.GetVertices(mesh.second.m_first_triangle + i);
+            triangles.AddTriangle(ToPoint3D(p_vertices[0]), ToPoint3D(p_vertices[1]), ToPoint3D(p_vertices[2]), static_cast<std::uint32_t>(mesh.first));
+        }
+        mesh.second.m_first_triangle = first_triangle;
+    }
+    mp_impl->m_triangles = std::move(triangles);
 
-    std::vector<Triangle*> triangles;
-    triangles.reserve(mp_impl->m_transformed_triangles.size());
-    std::transform(mp_impl->m_transformed_triangles.begin(), mp_impl->m_transformed_triangles.end(), std::back_inserter(triangles), [](auto& i_tr)
+    if (i_params.m_auto_voxel_size && triangles_count > 0)
     {
-        return &i_tr;
-    });
+        const auto voxel_size = SelectVoxelSize(mp_impl->m_triangles, i_params.m_triangles_per_voxel, i_params.m_refine_auto_voxel_size);
+        mp_impl->m_build_params.m_voxel_size_x = voxel_size[0];
+        mp_impl->m_build_params.m_voxel_size_y = voxel_size[1];
+        mp_impl->m_build_params.m_voxel_size_z = voxel_size[2];
+    }
+
+    mp_impl->mp_voxelization = mp_impl->_CreateVoxelizer().Voxelize(mp_impl->m_triangles);
+    mp_impl->_BuildDerivedData();
+}
 
-    mp_impl->mp_voxelization = voxelizer.Voxelize(triangles);
+const PointLocalizerVoxelized::Params& PointLocalizerVoxelized::GetParams() const
+{
+    return mp_impl->m_build_params;
 }
 
-size_t PointLocalizerVoxelized::Localize(const Point3D& i_point, ReturnCode* op_return_code)
+size_t PointLocalizerVoxelized::Localize(const Point3D& i_point, ReturnCode* op_return_code) const
 {
     if (!mp_impl->mp_voxelization)
     {
@@ -105,41 +336,278 @@ size_t PointLocalizerVoxelized::Localize(const Point3D& i_point, ReturnCode* op_
     if(!mp_impl->mp_voxelization->PointInsideVoxelization(i_point))
         return std::numeric_limits<size_t>::max();
 
-    auto coordinates = mp_impl->mp_voxelization->GetCoordinatesForPoint(i_point);
+    const auto coordinates = mp_impl->mp_voxelization->GetCoordinatesForPoint(i_point);
+    if (mp_impl->m_empty_voxel_labels.IsBuilt())
+    {
+        const auto label = mp_impl->m_empty_voxel_labels.GetLabel(coordinates);
+        if (label != EmptyVoxelLabels::NOT_EMPTY)
+            return label == EmptyVoxelLabels::OUTSIDE ? std::numeric_limits<size_t>::max() : label;
+    }
+
+    std::uint32_t corner_label = 0;
+    if (mp_impl->m_corner_distances.IsBuilt() && mp_impl->m_corner_distances.FindLabel(coordinates, i_point, corner_label))
+        return corner_label == VoxelCornerDistances::OUTSIDE ? std::numeric_limits<size_t>::max() : corner_label;
 
-    for (size_t x_coord = coordinates[0]; x_coord <= mp_impl->mp_voxelization->GetNumVoxels()[0]; ++x_coord)
+    return mp_impl->_LocalizeInGrid(i_point);
+}
+
+void PointLocalizerVoxelized::LocalizeBatch(const std::vector<Point3D>& i_points, std::vector<size_t>& o_mesh_indexes, ReturnCode* op_return_code) const
+{
+    o_mesh_indexes.resize(i_points.size());
+    LocalizeBatch(i_points.data(), i_points.size(), o_mesh_indexes.data(), op_return_code);
+}
+
+void PointLocalizerVoxelized::LocalizeBatch(const Point3D* ip_points, size_t i_count, size_t* op_mesh_indexes, ReturnCode* op_return_code) const
+{
+    std::fill_n(op_mesh_indexes, i_count, std::numeric_limits<size_t>::max());
+
+    if (!mp_impl->mp_voxelization)
     {
-        const std::array<size_t, 3> current_coords = { x_coord, coordinates[1], coordinates[2] };
-        if (auto p_voxel = mp_impl->mp_voxelization->GetVoxel(current_coords))
+        if (op_return_code)
+            *op_return_code = ReturnCode::VoxelizationWasNotBuild;
+
+        return;
+    }
+
+    if (op_return_code)
+        *op_return_code = ReturnCode::Ok;
+
+    const auto& grid = *mp_impl->mp_voxelization;
+    const auto& num_voxels = grid.GetNumVoxels();
+
+    // the ray of every point crosses the column to its end, there is nothing to share between the points
+    if (mp_impl->m_build_params.m_classification == Classification::RayParity)
+    {
+        for (size_t i = 0; i < i_count; ++i)
+            op_mesh_indexes[i] = Localize(ip_points[i]);
+        return;
+    }
+
+    std::vector<BatchQuery> queries;
+    queries.reserve(i_count);
+    for (size_t i = 0; i < i_count; ++i)
+    {
+        if (!grid.PointInsideVoxelization(ip_points[i]))
+            continue;
+
+        auto coordinates = grid.GetCoordinatesForPoint(ip_points[i]);
+        if (mp_impl->m_empty_voxel_labels.IsBuilt())
         {
-            Triangle* p_nearest_triangle = nullptr;
-            double distance = std::numeric_limits<double>::max();
-            for (auto p_triangle : p_voxel->GetTriangles())
+            const auto label = mp_impl->m_empty_voxel_labels.GetLabel(coordinates);
+            if (label != EmptyVoxelLabels::NOT_EMPTY)
             {
-                auto current_distance = Distance(i_point, *p_triangle);
-                if (current_distance < distance)
-                {
-                    p_nearest_triangle = p_triangle;
-                    distance = current_distance;
-                }
+                op_mesh_indexes[i] = label == EmptyVoxelLabels::OUTSIDE ? std::numeric_limits<size_t>::max() : label;
+                continue;
             }
+        }
+
+        std::uint32_t corner_label = 0;
+        if (mp_impl->m_corner_distances.IsBuilt() && mp_impl->m_corner_distances.FindLabel(coordinates, ip_points[i], corner_label))
+        {
+            op_mesh_indexes[i] = corner_label == VoxelCornerDistances::OUTSIDE ? std::numeric_limits<size_t>::max() : corner_label;
+            continue;
+        }
+
+        BatchQuery query;
+        query.m_column = coordinates[1] + coordinates[2] * num_voxels[1];
+        query.m_x = coordinates[0];
+        query.m_point_index = i;
+        queries.emplace_back(query);
+    }
+
+    std::sort(queries.begin(), queries.end(), [](const BatchQuery& i_lhs, const BatchQuery& i_rhs)
+    {
+        if (i_lhs.m_column != i_rhs.m_column)
+            return i_lhs.m_column < i_rhs.m_column;
+        if (i_lhs.m_x != i_rhs.m_x)
+            return i_lhs.m_x < i_rhs.m_x;
+        return i_lhs.m_point_index < i_rhs.m_point_index;
+    });
 
-            if (p_nearest_triangle)
+    // queries of one column are sorted by x, so the walk along +X only moves forward:
+    // the first non-empty voxel found for a query is reused by all next queries that are not behind it
+    for (size_t column_begin = 0; column_begin < queries.size();)
+    {
+        const auto column = queries[column_begin].m_column;
+        const std::array<size_t, 2> column_coords = { column % num_voxels[1], column / num_voxels[1] };
+
+        VoxelTrianglesRange found_voxel_triangles;
+        size_t found_x = 0;
+        bool was_scanned = false;
+
+        size_t i = column_begin;
+        for (; i < queries.size() && queries[i].m_column == column; ++i)
+        {
+            const auto& query = queries[i];
+            if (!was_scanned || (!found_voxel_triangles.empty() && found_x < query.m_x))
             {
-                auto loc_result = GetPointTriangleRelativeLocation(*p_nearest_triangle, i_point);
-                if (loc_result == PointTriangleRelativeLocationResult::Below
-                 || loc_result == PointTriangleRelativeLocationResult::OnSamePlane)
-                    return mp_impl->m_triangles_to_mesh_map[p_nearest_triangle];
-                
-                return std::numeric_limits<size_t>::max();
+                found_voxel_triangles = VoxelTrianglesRange();
+                for (size_t x_coord = query.m_x; x_coord < num_voxels[0]; ++x_coord)
+                {
+                    const auto voxel_triangles = grid.GetVoxelTriangles({ x_coord, column_coords[0], column_coords[1] });
+                    if (!voxel_triangles.empty())
+                    {
+                        found_voxel_triangles = voxel_triangles;
+                        found_x = x_coord;
+                        break;
+                    }
+                }
+                was_scanned = true;
             }
+
+            if (!found_voxel_triangles.empty())
+                op_mesh_indexes[query.m_point_index] = ClassifyByNearestTriangle(found_voxel_triangles, ip_points[query.m_point_index], mp_impl->m_triangles);
         }
-    }
 
-    return std::numeric_limits<size_t>::max();
+        column_begin = i;
+    }
 }
 
 std::weak_ptr<VoxelGrid> PointLocalizerVoxelized::GetCachedGrid() const
 {
     return mp_impl->mp_voxelization;
 }
+
+size_t PointLocalizerVoxelized::GetMemoryUsage() const
+{
+    return mp_impl->m_triangles.GetMemoryUsage()
+         + mp_impl->m_empty_voxel_labels.GetMemoryUsage()
+         + mp_impl->m_corner_distances.GetMemoryUsage();
+}
+
+bool PointLocalizerVoxelized::Save(const QString& i_file_path) const
+{
+    QFile file(i_file_path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    BinaryWriter writer(file);
+    writer.WriteHeader(LOCALIZER_MAGIC, LOCALIZER_VERSION);
+
+    const auto& params = mp_impl->m_build_params;
+    writer.Write(params.m_voxel_size_x);
+    writer.Write(params.m_voxel_size_y);
+    writer.Write(params.m_voxel_size_z);
+    writer.Write(static_cast<std::uint32_t>(params.m_storage_type));
+    writer.Write(static_cast<std::uint64_t>(params.m_threads_count));
+    writer.Write(static_cast<std::uint32_t>(params.m_classification));
+    writer.Write(static_cast<std::uint8_t>(params.m_label_empty_voxels ? 1 : 0));
+    writer.Write(static_cast<std::uint8_t>(params.m_use_corner_distances ? 1 : 0));
+    writer.Write(static_cast<std::uint8_t>(params.m_auto_voxel_size ? 1 : 0));
+    writer.Write(params.m_triangles_per_voxel);
+    writer.Write(static_cast<std::uint8_t>(params.m_refine_auto_voxel_size ? 1 : 0));
+
+    writer.Write(static_cast<std::uint64_t>(mp_impl->m_next_mesh_index));
+    writer.Write(static_cast<std::uint64_t>(mp_impl->m_meshes.size()));
+    for (const auto& mesh : mp_impl->m_meshes)
+    {
+        writer.Write(static_cast<std::uint64_t>(mesh.first));
+        writer.Write(mesh.second.m_first_triangle);
+        writer.Write(mesh.second.m_triangles_count);
+    }
+    mp_impl->m_triangles.Save(writer);
+
+    writer.Write(static_cast<std::uint8_t>(mp_impl->mp_voxelization ? 1 : 0));
+    if (mp_impl->mp_voxelization)
+        mp_impl->mp_voxelization->Save(writer);
+
+    writer.Write(static_cast<std::uint8_t>(mp_impl->m_empty_voxel_labels.IsBuilt() ? 1 : 0));
+    if (mp_impl->m_empty_voxel_labels.IsBuilt())
+        mp_impl->m_empty_voxel_labels.Save(writer);
+
+    writer.Write(static_cast<std::uint8_t>(mp_impl->m_corner_distances.IsBuilt() ? 1 : 0));
+    if (mp_impl->m_corner_distances.IsBuilt())
+        mp_impl->m_corner_distances.Save(writer);
+
+    return writer.IsOk();
+}
+
+bool PointLocalizerVoxelized::Load(const QString& i_file_path)
+{
+    QFile file(i_file_path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+        return false;
+
+    const auto p_data = file.map(0, file.size());
+    if (!p_data)
+        return false;
+
+    BinaryReader reader(p_data, static_cast<size_t>(file.size()));
+    auto p_impl = std::make_unique<Impl>();
+    if (!reader.ReadHeader(LOCALIZER_MAGIC, LOCALIZER_VERSION))
+        return false;
+
+    auto& params = p_impl->m_build_params;
+    std::uint32_t storage_type = 0;
+    std::uint64_t threads_count = 0;
+    std::uint32_t classification = 0;
+    std::uint8_t label_empty_voxels = 0;
+    std::uint8_t use_corner_distances = 0;
+    std::uint8_t auto_voxel_size = 0;
+    std::uint8_t refine_auto_voxel_size = 0;
+    reader.Read(params.m_voxel_size_x);
+    reader.Read(params.m_voxel_size_y);
+    reader.Read(params.m_voxel_size_z);
+    reader.Read(storage_type);
+    reader.Read(threads_count);
+    reader.Read(classification);
+    reader.Read(label_empty_voxels);
+    reader.Read(use_corner_distances);
+    reader.Read(auto_voxel_size);
+    reader.Read(params.m_triangles_per_voxel);
+    reader.Read(refine_auto_voxel_size);
+    params.m_storage_type = static_cast<VoxelGrid::StorageType>(storage_type);
+    params.m_threads_count = static_cast<size_t>(threads_count);
+    params.m_classification = static_cast<Classification>(classification);
+    params.m_label_empty_voxels = label_empty_voxels != 0;
+    params.m_use_corner_distances = use_corner_distances != 0;
+    params.m_auto_voxel_size = auto_voxel_size != 0;
+    params.m_refine_auto_voxel_size = refine_auto_voxel_size != 0;
+
+    std::uint64_t next_mesh_index = 0;
+    std::uint64_t meshes_count = 0;
+    reader.Read(next_mesh_index);
+    reader.Read(meshes_count);
+    if (!reader.IsOk() || next_mesh_index > std::numeric_limits<std::uint32_t>::max())
+        return false;
+    p_impl->m_next_mesh_index = static_cast<std::uint32_t>(next_mesh_index);
+
+    for (std::uint64_t i = 0; i < meshes_count && reader.IsOk(); ++i)
+    {
+        std::uint64_t mesh_index = 0;
+        Impl::MeshRange mesh_range;
+        reader.Read(mesh_index);
+        reader.Read(mesh_range.m_first_triangle);
+        reader.Read(mesh_range.m_triangles_count);
+        if (!reader.IsOk() || mesh_index >= next_mesh_index || !p_impl->m_meshes.emplace(static_cast<size_t>(mesh_index), mesh_range).second)
+            return false;
+    }
+    if (!p_impl->m_triangles.Load(reader))
+        return false;
+
+    std::uint8_t has_voxelization = 0;
+    reader.Read(has_voxelization);
+    if (!reader.IsOk())
+        return false;
+
+    if (has_voxelization)
+    {
+        p_impl->mp_voxelization = VoxelGrid::Load(reader, p_impl->m_triangles.GetTrianglesCount());
+        if (!p_impl->mp_voxelization)
+            return false;
+    }
+    if (!p_impl->_IsValid())
+        return false;
+
+    std::uint8_t has_labels = 0;
+    if (!reader.Read(has_labels) || (has_labels && (!p_impl->mp_voxelization || !p_impl->m_empty_voxel_labels.Load(reader, *p_impl->mp_voxelization))))
+        return false;
+
+    std::uint8_t has_corner_distances = 0;
+    if (!reader.Read(has_corner_distances)
+     || (has_corner_distances && (!p_impl->mp_voxelization || !p_impl->m_corner_distances.Load(reader, *p_impl->mp_voxelization))))
+        return false;
+
+    mp_impl = std::move(p_impl);
+    return true;
+}
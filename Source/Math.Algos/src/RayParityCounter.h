@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Crossings of one ray along +X grouped by mesh. A mesh crossed an odd number of times contains the origin of the ray,
+// of several such meshes (nested ones) the mesh with the nearest crossing is the innermost one
+class RayParityCounter
+{
+public:
+    void AddCrossing(size_t i_mesh_index, double i_x)
+    {
+        for (auto& mesh : m_meshes)
+        {
+            if (mesh.m_mesh_index == i_mesh_index)
+            {
+                ++mesh.m_crossings_count;
+                mesh.m_nearest_x = std::min(mesh.m_nearest_x, i_x);
+                return;
+            }
+        }
+        m_meshes.push_back({ i_mesh_index, 1, i_x });
+    }
+
+    // returns index of mesh or std::numeric_limits<size_t>::max() if the origin is outside of all meshes
+    size_t GetMeshIndex() const
+    {
+        auto mesh_index = std::numeric_limits<size_t>::max();
+        auto nearest_x = std::numeric_limits<double>::max();
+        for (const auto& mesh : m_meshes)
+        {
+            if (mesh.m_crossings_count % 2 == 1 && mesh.m_nearest_x < nearest_x)
+            {
+                mesh_index = mesh.m_mesh_index;
+                nearest_x = mesh.m_nearest_x;
+            }
+        }
+        return mesh_index;
+    }
+
+private:
+    struct MeshCrossings
+    {
+        size_t m_mesh_index;
+        size_t m_crossings_count;
+        double m_nearest_x;
+    };
+
+    // a ray crosses few meshes, a linear search is faster than a map
+    std::vector<MeshCrossings> m_meshes;
+};
@@ -0,0 +1,848 @@
+#include "Math.Algos/SceneGenerator.h"
+
+#include "Math.Algos/Sqrt3Subdivision.h"
+
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/IndexedMesh.h>
+#include <Math.Core/Mesh.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/WorkStealingThreadPool.h>
+
+#include <QString>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+
+namespace
+{
+    // every part lies inside its own cube of the scene grid
+    constexpr double CELL_SIZE = 2;
+    constexpr size_t MAX_BLOB_RESOLUTION = 512;
+    constexpr size_t POINTS_CHUNK_SIZE = 1 << 16;
+    constexpr size_t CLUSTERS_COUNT = 16;
+    constexpr size_t OUTSIDE = std::numeric_limits<size_t>::max();
+
+    // std distributions differ between standard libraries, the engine doesn't
+    using Random = std::mt19937_64;
+
+    enum class Location
+    {
+        Inside,
+        Outside,
+        Unknown,
+    };
+
+    struct Ball
+    {
+        std::array<double, 3> m_center;
+        double m_radius;
+    };
+
+    // Voxels of a blob, one bit per voxel, x runs fastest. The border layer is never set, so the boundary of the set
+    // voxels is closed inside the grid
+    struct BlobGrid
+    {
+        size_t m_resolution = 0;
+        std::vector<std::uint64_t> m_bits;
+        // bounds of the set voxels, valid if any voxel is set
+        size_t m_min[3] = { 0, 0, 0 };
+        size_t m_max[3] = { 0, 0, 0 };
+        bool m_is_empty = true;
+
+        void Reset(size_t i_resolution)
+        {
+            m_resolution = i_resolution;
+            m_bits.assign((i_resolution * i_resolution * i_resolution + 63) / 64, 0);
+            m_is_empty = true;
+        }
+
+        bool IsSet(size_t i_x, size_t i_y, size_t i_z) const
+        {
+            const auto index = (i_z * m_resolution + i_y) * m_resolution + i_x;
+            return (m_bits[index / 64] >> (index % 64)) & 1;
+        }
+
+        // false if the voxel was set already
+        bool Set(size_t i_x, size_t i_y, size_t i_z)
+        {
+            Q_ASSERT(i_x > 0 && i_y > 0 && i_z > 0 && i_x + 1 < m_resolution && i_y + 1 < m_resolution && i_z + 1 < m_resolution);
+            const auto index = (i_z * m_resolution + i_y) * m_resolution + i_x;
+            const auto bit = std::uint64_t(1) << (index % 64);
+            if (m_bits[index / 64] & bit)
+                return false;
+
+            m_bits[index / 64] |= bit;
+            const size_t voxel[3] = { i_x, i_y, i_z };
+            for (short i = 0; i < 3; ++i)
+            {
+                m_min[i] = m_is_empty ? voxel[i] : std::min(m_min[i], voxel[i]);
+                m_max[i] = m_is_empty ? voxel[i] : std::max(m_max[i], voxel[i]);
+            }
+            m_is_empty = false;
+            return true;
+        }
+    };
+
+    struct Part
+    {
+        SceneGenerator::Shape m_shape = SceneGenerator::Shape::Sphere;
+        BasicPoint3D m_center = { { 0, 0, 0 } };
+        double m_extent = 0; // half size of the cube around the center that holds the part
+        double m_radius = 0; // sphere radius or torus major radius
+        double m_tube_radius = 0;
+        short m_axis = 2; // torus axis
+        // points closer to the surface than this are not located: the tessellation error of spheres and tori,
+        // distance to the voxel faces of blobs
+        double m_tolerance = 0;
+
+        BlobGrid m_grid; // voxel blob, the grid covers the cube of m_extent
+
+        std::vector<BasicPoint3D> m_vertices;
+        std::vector<std::uint32_t> m_indices;
+    };
+
+    double _Random01(Random& io_random)
+    {
+        return static_cast<double>(io_random() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double _RandomUniform(Random& io_random, double i_min, double i_max)
+    {
+        return i_min + (i_max - i_min) * _Random01(io_random);
+    }
+
+    // Box-Muller
+    double _RandomNormal(Random& io_random)
+    {
+        const auto u = 1 - _Random01(io_random);
+        const auto v = _Random01(io_random);
+        return std::sqrt(-2 * std::log(u)) * std::cos(2 * PI * v);
+    }
+
+    size_t _RandomIndex(Random& io_random, size_t i_count)
+    {
+        return static_cast<size_t>(io_random() % i_count);
+    }
+
+    std::uint32_t _AddVertex(Part& io_part, double i_x, double i_y, double i_z)
+    {
+        io_part.m_vertices.push_back({ { io_part.m_center[0] + i_x, io_part.m_center[1] + i_y, io_part.m_center[2] + i_z } });
+        return static_cast<std::uint32_t>(io_part.m_vertices.size() - 1);
+    }
+
+    void _AddTriangle(Part& io_part, std::uint32_t i_a, std::uint32_t i_b, std::uint32_t i_c)
+    {
+        io_part.m_indices.insert(io_part.m_indices.end(), { i_a, i_b, i_c });
+    }
+
+    std::array<double, 3> _ToLocal(const Part& i_part, const BasicPoint3D& i_point)
+    {
+        return { { i_point[0] - i_part.m_center[0], i_point[1] - i_part.m_center[1], i_point[2] - i_part.m_center[2] } };
+    }
+
+    // All vertices lie on the sphere, so every triangle lies between the sphere and the ball of the distance of its plane
+    // from the center. Points closer to the center than the nearest plane are inside, points outside the sphere are outside
+    double _GetSphereTolerance(const Part& i_part)
+    {
+        double tolerance = 0;
+        for (size_t i = 0; i < i_part.m_indices.size(); i += 3)
+        {
+            const auto a = _ToLocal(i_part, i_part.m_vertices[i_part.m_indices[i]]);
+            const auto b = _ToLocal(i_part, i_part.m_vertices[i_part.m_indices[i + 1]]);
+            const auto c = _ToLocal(i_part, i_part.m_vertices[i_part.m_indices[i + 2]]);
+            const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            const double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            const double normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+            const auto length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length == 0)
+                continue;
+            const auto plane_distance = std::abs(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]) / length;
+            tolerance = std::max(tolerance, i_part.m_radius - plane_distance);
+        }
+        return tolerance + 1e-9 * i_part.m_radius;
+    }
+
+    void _MakeUVSphere(Part& io_part, size_t i_triangles_count)
+    {
+        // 2 * slices * (stacks - 1) triangles
+        const auto stacks = std::max<size_t>(2, static_cast<size_t>(std::lround(std::sqrt(i_triangles_count / 4.))));
+        const auto slices = 2 * stacks;
+        const auto r = io_part.m_radius;
+
+        io_part.m_vertices.reserve(slices * (stacks - 1) + 2);
+        io_part.m_indices.reserve(6 * slices * (stacks - 1));
+
+        const auto north = _AddVertex(io_part, 0, 0, r);
+        for (size_t stack = 1; stack < stacks; ++stack)
+        {
+            const auto theta = PI * stack / stacks;
+            for (size_t slice = 0; slice < slices; ++slice)
+            {
+                const auto phi = 2 * PI * slice / slices;
+                _AddVertex(io_part, r * std::sin(theta) * std::cos(phi), r * std::sin(theta) * std::sin(phi), r * std::cos(theta));
+            }
+        }
+        const auto south = _AddVertex(io_part, 0, 0, -r);
+
+        const auto ring = [slices](size_t i_stack, size_t i_slice)
+        {
+            return static_cast<std::uint32_t>(1 + (i_stack - 1) * slices + i_slice % slices);
+        };
+        for (size_t slice = 0; slice < slices; ++slice)
+        {
+            _AddTriangle(io_part, north, ring(1, slice), ring(1, slice + 1));
+            for (size_t stack = 1; stack + 1 < stacks; ++stack)
+            {
+                _AddTriangle(io_part, ring(stack, slice), ring(stack + 1, slice), ring(stack + 1, slice + 1));
+                _AddTriangle(io_part, ring(stack, slice), ring(stack + 1, slice + 1), ring(stack, slice + 1));
+            }
+            _AddTriangle(io_part, ring(stacks - 1, slice), south, ring(stacks - 1, slice + 1));
+        }
+
+        io_part.m_tolerance = _GetSphereTolerance(io_part);
+    }
+
+    void _MakeSqrt3Sphere(Part& io_part, size_t i_triangles_count)
+    {
+        const auto t = (1 + std::sqrt(5.)) / 2;
+        const double vertices[12][3] = { { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 }, { 0, -1, t }, { 0, 1, t },
+                                         { 0, -1, -t }, { 0, 1, -t }, { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 } };
+        const IndexedMesh::VertexId faces[20][3] = { { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+                                                     { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+                                                     { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+                                                     { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 } };
+
+        const auto r = io_part.m_radius;
+        const auto scale = r / std::sqrt(1 + t * t);
+        IndexedMesh mesh;
+        for (const auto& vertex : vertices)
+            mesh.AddVertex({ { scale * vertex[0], scale * vertex[1], scale * vertex[2] } });
+        for (const auto& face : faces)
+            mesh.AddFace(face[0], face[1], face[2]);
+
+        // Every level splits all faces and triples their number, faces are split while their shortest edge is above the
+        // threshold. The threshold sits between the edges of the levels around the one that covers the sphere with
+        // i_triangles_count equilateral triangles
+        const auto edge_length = std::sqrt(16 * PI * r * r / (std::sqrt(3.) * i_triangles_count));
+        SQRT3MeshSubdivider::Params params;
+        params.m_edge_length_threshold = edge_length / std::pow(3., 0.25);
+        SQRT3MeshSubdivider subdivider;
+        subdivider.SetParams(params);
+        subdivider.Subdivide(mesh);
+
+        // smoothing shrinks the shape, all vertices go back to the sphere
+        io_part.m_vertices.reserve(mesh.GetVerticesCount());
+        for (const auto& vertex : mesh.GetVertices())
+        {
+            const auto length = std::sqrt(vertex[0] * vertex[0] + vertex[1] * vertex[1] + vertex[2] * vertex[2]);
+            _AddVertex(io_part, r * vertex[0] / length, r * vertex[1] / length, r * vertex[2] / length);
+        }
+        io_part.m_indices = mesh.GetCorners();
+
+        io_part.m_tolerance = _GetSphereTolerance(io_part);
+    }
+
+    // distance from the circle in the middle of the tube
+    double _GetTubeDistance(const Part& i_part, const std::array<double, 3>& i_local)
+    {
+        const auto height = i_local[i_part.m_axis];
+        const auto u = i_local[(i_part.m_axis + 1) % 3];
+        const auto v = i_local[(i_part.m_axis + 2) % 3];
+        const auto radial = std::sqrt(u * u + v * v) - i_part.m_radius;
+        return std::sqrt(radial * radial + height * height);
+    }
+
+    void _MakeTorus(Part& io_part, size_t i_triangles_count)
+    {
+        // 2 * rings * sides triangles, rings / sides follows the radii so the quads are about square
+        const auto R = io_part.m_radius;
+        const auto r = io_part.m_tube_radius;
+        const auto sides = std::max<size_t>(3, static_cast<size_t>(std::lround(std::sqrt(i_triangles_count / 2. * r / R))));
+        const auto rings = std::max<size_t>(3, static_cast<size_t>(std::lround(i_triangles_count / (2. * sides))));
+
+        io_part.m_vertices.reserve(rings * sides);
+        io_part.m_indices.reserve(6 * rings * sides);
+
+        const auto u_axis = (io_part.m_axis + 1) % 3;
+        const auto v_axis = (io_part.m_axis + 2) % 3;
+        for (size_t ring = 0; ring < rings; ++ring)
+        {
+            const auto u = 2 * PI * ring / rings;
+            for (size_t side = 0; side < sides; ++side)
+            {
+                const auto v = 2 * PI * side / sides;
+                double local[3];
+                local[u_axis] = (R + r * std::cos(v)) * std::cos(u);
+                local[v_axis] = (R + r * std::cos(v)) * std::sin(u);
+                local[io_part.m_axis] = r * std::sin(v);
+                _AddVertex(io_part, local[0], local[1], local[2]);
+            }
+        }
+
+        // the cyclic order of the axes keeps (d/du, d/dv) pointing outwards
+        const auto vertex = [rings, sides](size_t i_ring, size_t i_side)
+        {
+            return static_cast<std::uint32_t>((i_ring % rings) * sides + i_side % sides);
+        };
+        for (size_t ring = 0; ring < rings; ++ring)
+        {
+            for (size_t side = 0; side < sides; ++side)
+            {
+                _AddTriangle(io_part, vertex(ring, side), vertex(ring + 1, side), vertex(ring + 1, side + 1));
+                _AddTriangle(io_part, vertex(ring, side), vertex(ring + 1, side + 1), vertex(ring, side + 1));
+            }
+        }
+
+        // Chord sags of both circles bound the error of the triangles. They are checked in the middles of the triangles
+        // and their edges as well, the band is twice the largest of them
+        auto tolerance = r * (1 - std::cos(PI / sides)) + (R + r) * (1 - std::cos(PI / rings));
+        for (size_t i = 0; i < io_part.m_indices.size(); i += 3)
+        {
+            const auto a = _ToLocal(io_part, io_part.m_vertices[io_part.m_indices[i]]);
+            const auto b = _ToLocal(io_part, io_part.m_vertices[io_part.m_indices[i + 1]]);
+            const auto c = _ToLocal(io_part, io_part.m_vertices[io_part.m_indices[i + 2]]);
+            const std::array<double, 3> samples[] = {
+                { { (a[0] + b[0] + c[0]) / 3, (a[1] + b[1] + c[1]) / 3, (a[2] + b[2] + c[2]) / 3 } },
+                { { (a[0] + b[0]) / 2, (a[1] + b[1]) / 2, (a[2] + b[2]) / 2 } },
+                { { (b[0] + c[0]) / 2, (b[1] + c[1]) / 2, (b[2] + c[2]) / 2 } },
+                { { (c[0] + a[0]) / 2, (c[1] + a[1]) / 2, (c[2] + a[2]) / 2 } } };
+            for (const auto& sample : samples)
+                tolerance = std::max(tolerance, std::abs(_GetTubeDistance(io_part, sample) - r));
+        }
+        io_part.m_tolerance = 2 * tolerance;
+    }
+
+    using Block = std::array<size_t, 3>;
+
+    // Both the set and the empty voxels of a 2x2x2 block must be face connected inside the block, otherwise voxels
+    // touch by an edge or a corner only and the boundary is not a manifold. Bit x + 2y + 4z is the voxel (x, y, z)
+    const std::array<bool, 256>& _GetManifoldBlocks()
+    {
+        static const auto s_manifold_blocks = []()
+        {
+            const auto is_connected = [](unsigned i_mask)
+            {
+                if (i_mask == 0)
+                    return true;
+                unsigned reached = i_mask & (~i_mask + 1);
+                for (unsigned previous = 0; previous != reached;)
+                {
+                    previous = reached;
+                    for (unsigned bit = 0; bit < 8; ++bit)
+                    {
+                        if ((reached >> bit) & 1)
+                            reached |= i_mask & ((1u << (bit ^ 1)) | (1u << (bit ^ 2)) | (1u << (bit ^ 4)));
+                    }
+                }
+                return reached == i_mask;
+            };
+
+            std::array<bool, 256> manifold_blocks;
+            for (unsigned mask = 0; mask < 256; ++mask)
+                manifold_blocks[mask] = is_connected(mask) && is_connected(~mask & 255u);
+            return manifold_blocks;
+        }();
+        return s_manifold_blocks;
+    }
+
+    // blocks are named by their smallest voxel, only blocks off the border layer are checked
+    void _AddBlocksOfVoxel(const BlobGrid& i_grid, size_t i_x, size_t i_y, size_t i_z, std::vector<Block>& io_blocks)
+    {
+        for (unsigned corner = 0; corner < 8; ++corner)
+        {
+            const Block block = { { i_x - (corner & 1), i_y - ((corner >> 1) & 1), i_z - (corner >> 2) } };
+            if (block[0] >= 1 && block[1] >= 1 && block[2] >= 1 && block[0] + 2 < i_grid.m_resolution && block[1] + 2 < i_grid.m_resolution && block[2] + 2 < i_grid.m_resolution)
+                io_blocks.push_back(block);
+        }
+    }
+
+    // Fills the blocks that break the manifold condition until none is left, filling may break the blocks around.
+    // A block with set and empty voxels has a set voxel next to an empty one, so io_blocks only need the blocks at the boundary
+    void _FillNonManifoldBlocks(BlobGrid& io_grid, std::vector<Block>& io_blocks)
+    {
+        const auto& manifold_blocks = _GetManifoldBlocks();
+        while (!io_blocks.empty())
+        {
+            const auto block = io_blocks.back();
+            io_blocks.pop_back();
+
+            unsigned mask = 0;
+            for (unsigned bit = 0; bit < 8; ++bit)
+                mask |= static_cast<unsigned>(io_grid.IsSet(block[0] + (bit & 1), block[1] + ((bit >> 1) & 1), block[2] + (bit >> 2))) << bit;
+            if (manifold_blocks[mask])
+                continue;
+
+            for (unsigned bit = 0; bit < 8; ++bit)
+            {
+                const size_t voxel[3] = { block[0] + (bit & 1), block[1] + ((bit >> 1) & 1), block[2] + (bit >> 2) };
+                if (io_grid.Set(voxel[0], voxel[1], voxel[2]))
+                    _AddBlocksOfVoxel(io_grid, voxel[0], voxel[1], voxel[2], io_blocks);
+            }
+        }
+    }
+
+    // Sets empty voxels that are not face connected to the outside, blocks around them go to o_blocks.
+    // Everything beyond the bounds of the set voxels is outside, so only the bounds grown by one voxel are searched
+    void _FillCavities(BlobGrid& io_grid, std::vector<Block>& o_blocks)
+    {
+        if (io_grid.m_is_empty)
+            return;
+
+        size_t min[3];
+        size_t size[3];
+        for (short i = 0; i < 3; ++i)
+        {
+            min[i] = io_grid.m_min[i] - 1;
+            size[i] = io_grid.m_max[i] + 2 - min[i];
+        }
+
+        std::vector<char> is_outside(size[0] * size[1] * size[2], 0);
+        std::vector<size_t> stack;
+        const auto visit = [&](size_t i_x, size_t i_y, size_t i_z)
+        {
+            const auto index = (i_z * size[1] + i_y) * size[0] + i_x;
+            if (!is_outside[index] && !io_grid.IsSet(min[0] + i_x, min[1] + i_y, min[2] + i_z))
+            {
+                is_outside[index] = 1;
+                stack.push_back(index);
+            }
+        };
+
+        for (size_t a = 0; a < size[1]; ++a)
+        {
+            for (size_t b = 0; b < size[2]; ++b)
+            {
+                visit(0, a, b);
+                visit(size[0] - 1, a, b);
+            }
+        }
+        for (size_t a = 0; a < size[0]; ++a)
+        {
+            for (size_t b = 0; b < size[2]; ++b)
+            {
+                visit(a, 0, b);
+                visit(a, size[1] - 1, b);
+            }
+            for (size_t b = 0; b < size[1]; ++b)
+            {
+                visit(a, b, 0);
+                visit(a, b, size[2] - 1);
+            }
+        }
+        while (!stack.empty())
+        {
+            const auto index = stack.back();
+            stack.pop_back();
+            const auto x = index % size[0];
+            const auto y = index / size[0] % size[1];
+            const auto z = index / (size[0] * size[1]);
+            if (x > 0) visit(x - 1, y, z);
+            if (x + 1 < size[0]) visit(x + 1, y, z);
+            if (y > 0) visit(x, y - 1, z);
+            if (y + 1 < size[1]) visit(x, y + 1, z);
+            if (z > 0) visit(x, y, z - 1);
+            if (z + 1 < size[2]) visit(x, y, z + 1);
+        }
+
+        for (size_t index = 0; index < is_outside.size(); ++index)
+        {
+            const auto x = min[0] + index % size[0];
+            const auto y = min[1] + index / size[0] % size[1];
+            const auto z = min[2] + index / (size[0] * size[1]);
+            if (!is_outside[index] && io_grid.Set(x, y, z))
+                _AddBlocksOfVoxel(io_grid, x, y, z, o_blocks);
+        }
+    }
+
+    // calls i_function(x, y, z, axis, direction) for every face between a set and an empty voxel
+    template<typename TFunction>
+    void _ForEachBoundaryFace(const BlobGrid& i_grid, TFunction i_function)
+    {
+        if (i_grid.m_is_empty)
+            return;
+
+        for (auto z = i_grid.m_min[2]; z <= i_grid.m_max[2]; ++z)
+        {
+            for (auto y = i_grid.m_min[1]; y <= i_grid.m_max[1]; ++y)
+            {
+                for (auto x = i_grid.m_min[0]; x <= i_grid.m_max[0]; ++x)
+                {
+                    if (!i_grid.IsSet(x, y, z))
+                        continue;
+
+                    for (short axis = 0; axis < 3; ++axis)
+                    {
+                        for (const int direction : { -1, 1 })
+                        {
+                            size_t neighbour[3] = { x, y, z };
+                            neighbour[axis] += direction;
+                            if (!i_grid.IsSet(neighbour[0], neighbour[1], neighbour[2]))
+                                i_function(x, y, z, axis, direction);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void _RasterizeBlob(BlobGrid& o_grid, const std::vector<Ball>& i_balls, size_t i_resolution)
+    {
+        const auto n = i_resolution;
+        o_grid.Reset(n);
+
+        size_t min[3] = { n - 2, n - 2, n - 2 };
+        size_t max[3] = { 1, 1, 1 };
+        for (const auto& ball : i_balls)
+        {
+            for (short i = 0; i < 3; ++i)
+            {
+                min[i] = std::min(min[i], static_cast<size_t>(std::max(1., std::floor((ball.m_center[i] - ball.m_radius) * n))));
+                max[i] = std::max(max[i], static_cast<size_t>(std::min(n - 2., std::ceil((ball.m_center[i] + ball.m_radius) * n))));
+            }
+        }
+
+        for (auto z = min[2]; z <= max[2]; ++z)
+        {
+            for (auto y = min[1]; y <= max[1]; ++y)
+            {
+                for (auto x = min[0]; x <= max[0]; ++x)
+                {
+                    const double center[3] = { (x + 0.5) / n, (y + 0.5) / n, (z + 0.5) / n };
+                    for (const auto& ball : i_balls)
+                    {
+                        const double d[3] = { center[0] - ball.m_center[0], center[1] - ball.m_center[1], center[2] - ball.m_center[2] };
+                        if (d[0] * d[0] + d[1] * d[1] + d[2] * d[2] < ball.m_radius * ball.m_radius)
+                        {
+                            o_grid.Set(x, y, z);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        std::vector<Block> blocks;
+        _ForEachBoundaryFace(o_grid, [&o_grid, &blocks](size_t i_x, size_t i_y, size_t i_z, short, int)
+        {
+            _AddBlocksOfVoxel(o_grid, i_x, i_y, i_z, blocks);
+        });
+        do
+        {
+            _FillNonManifoldBlocks(o_grid, blocks);
+            _FillCavities(o_grid, blocks);
+        } while (!blocks.empty());
+    }
+
+    void _MakeVoxelBlob(Part& io_part, size_t i_triangles_count, Random& io_random)
+    {
+        // balls in the unit cube of the grid, every ball is centered on the surface of the previous one
+        std::vector<Ball> balls = { { { { 0.5, 0.5, 0.5 } }, _RandomUniform(io_random, 0.2, 0.28) } };
+        const auto balls_count = 3 + _RandomIndex(io_random, 4);
+        while (balls.size() < balls_count)
+        {
+            std::array<double, 3> direction = { { _RandomNormal(io_random), _RandomNormal(io_random), _RandomNormal(io_random) } };
+            const auto length = std::max(1e-9, std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]));
+            Ball ball;
+            ball.m_radius = _RandomUniform(io_random, 0.1, 0.2);
+            for (short i = 0; i < 3; ++i)
+            {
+                const auto center = balls.back().m_center[i] + balls.back().m_radius * direction[i] / length;
+                ball.m_center[i] = std::min(std::max(center, ball.m_radius + 0.05), 0.95 - ball.m_radius);
+            }
+            balls.push_back(ball);
+        }
+
+        // boundary faces grow with the square of the resolution, a coarse grid gives the scale
+        const size_t trial_resolution = 32;
+        auto& grid = io_part.m_grid;
+        _RasterizeBlob(grid, balls, trial_resolution);
+        size_t trial_faces_count = 0;
+        _ForEachBoundaryFace(grid, [&trial_faces_count](size_t, size_t, size_t, short, int) { ++trial_faces_count; });
+        const auto resolution = std::min(MAX_BLOB_RESOLUTION, std::max<size_t>(8, static_cast<size_t>(
+            std::lround(trial_resolution * std::sqrt(static_cast<double>(i_triangles_count) / (2 * std::max<size_t>(1, trial_faces_count)))))));
+        if (resolution != trial_resolution)
+            _RasterizeBlob(grid, balls, resolution);
+
+        const auto n = grid.m_resolution;
+        const auto voxel_size = 2 * io_part.m_extent / n;
+        std::unordered_map<std::uint64_t, std::uint32_t> grid_vertices;
+        const auto vertex = [&](size_t i_x, size_t i_y, size_t i_z)
+        {
+            const auto key = (static_cast<std::uint64_t>(i_z) * (n + 1) + i_y) * (n + 1) + i_x;
+            const auto it = grid_vertices.find(key);
+            if (it != grid_vertices.end())
+                return it->second;
+            const auto id = _AddVertex(io_part, i_x * voxel_size - io_part.m_extent, i_y * voxel_size - io_part.m_extent, i_z * voxel_size - io_part.m_extent);
+            grid_vertices.emplace(key, id);
+            return id;
+        };
+
+        // a face normal to the axis spans the next two axes, going around (0, 0), (1, 0), (1, 1), (0, 1) of them
+        // gives the normal along the axis
+        _ForEachBoundaryFace(grid, [&](size_t i_x, size_t i_y, size_t i_z, short i_axis, int i_direction)
+        {
+            const short u_axis = (i_axis + 1) % 3;
+            const short v_axis = (i_axis + 2) % 3;
+            const int corner_offsets[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+            std::uint32_t corners[4];
+            for (size_t i = 0; i < 4; ++i)
+            {
+                size_t corner[3] = { i_x, i_y, i_z };
+                corner[i_axis] += i_direction > 0 ? 1 : 0;
+                corner[u_axis] += corner_offsets[i][0];
+                corner[v_axis] += corner_offsets[i][1];
+                corners[i] = vertex(corner[0], corner[1], corner[2]);
+            }
+            if (i_direction < 0)
+                std::swap(corners[1], corners[3]);
+            _AddTriangle(io_part, corners[0], corners[1], corners[2]);
+            _AddTriangle(io_part, corners[0], corners[2], corners[3]);
+        });
+
+        io_part.m_tolerance = 1e-4 * voxel_size;
+    }
+
+    Location _Locate(const Part& i_part, const Point3D& i_point)
+    {
+        const auto local = _ToLocal(i_part, ToBasicPoint(i_point));
+        switch (i_part.m_shape)
+        {
+        case SceneGenerator::Shape::Sphere:
+        case SceneGenerator::Shape::Sqrt3Sphere:
+        {
+            const auto distance = std::sqrt(local[0] * local[0] + local[1] * local[1] + local[2] * local[2]);
+            if (distance < i_part.m_radius - i_part.m_tolerance)
+                return Location::Inside;
+            return distance > i_part.m_radius + 1e-9 * i_part.m_radius ? Location::Outside : Location::Unknown;
+        }
+        case SceneGenerator::Shape::Torus:
+        {
+            const auto distance = _GetTubeDistance(i_part, local);
+            if (distance < i_part.m_tube_radius - i_part.m_tolerance)
+                return Location::Inside;
+            return distance > i_part.m_tube_radius + i_part.m_tolerance ? Location::Outside : Location::Unknown;
+        }
+        case SceneGenerator::Shape::VoxelBlob:
+        {
+            const auto& grid = i_part.m_grid;
+            const auto voxel_size = 2 * i_part.m_extent / grid.m_resolution;
+            size_t voxel[3];
+            for (short i = 0; i < 3; ++i)
+            {
+                const auto coordinate = (local[i] + i_part.m_extent) / voxel_size;
+                if (coordinate < 0 || coordinate >= static_cast<double>(grid.m_resolution))
+                    return Location::Outside;
+                if (std::abs(coordinate - std::round(coordinate)) * voxel_size < i_part.m_tolerance)
+                    return Location::Unknown;
+                voxel[i] = static_cast<size_t>(coordinate);
+            }
+            return grid.IsSet(voxel[0], voxel[1], voxel[2]) ? Location::Inside : Location::Outside;
+        }
+        }
+        return Location::Unknown;
+    }
+}
+
+
+struct SceneGenerator::Impl
+{
+    std::vector<Part> m_parts;
+    size_t m_cells_per_side = 0;
+    BoundingBox m_bbox;
+
+    Location Locate(const Point3D& i_point, size_t& o_part) const;
+};
+
+Location SceneGenerator::Impl::Locate(const Point3D& i_point, size_t& o_part) const
+{
+    o_part = OUTSIDE;
+    size_t part = 0;
+    for (short i = 2; i >= 0; --i)
+    {
+        const auto cell = std::floor(i_point[i] / CELL_SIZE);
+        if (cell < 0 || cell >= static_cast<double>(m_cells_per_side))
+            return Location::Outside;
+        part = part * m_cells_per_side + static_cast<size_t>(cell);
+    }
+    if (part >= m_parts.size())
+        return Location::Outside;
+
+    const auto location = _Locate(m_parts[part], i_point);
+    if (location == Location::Inside)
+        o_part = part;
+    return location;
+}
+
+
+SceneGenerator::SceneGenerator()
+    : mp_impl(std::make_unique<Impl>())
+{
+}
+
+SceneGenerator::~SceneGenerator() = default;
+
+void SceneGenerator::Generate(const Params& i_params)
+{
+    Q_ASSERT(i_params.m_parts_count > 0);
+
+    auto p_impl = std::make_unique<Impl>();
+    p_impl->m_cells_per_side = 1;
+    while (p_impl->m_cells_per_side * p_impl->m_cells_per_side * p_impl->m_cells_per_side < i_params.m_parts_count)
+        ++p_impl->m_cells_per_side;
+
+    p_impl->m_parts.resize(i_params.m_parts_count);
+    const auto triangles_per_part = std::max<size_t>(20, i_params.m_triangles_count / i_params.m_parts_count);
+    WorkStealingThreadPool::GetGlobalInstance().ParallelFor(i_params.m_parts_count, 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+        {
+            // own seed for every part, so the parts don't depend on the order of generation
+            std::seed_seq seed{ i_params.m_seed, static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(i >> 32) };
+            Random random(seed);
+
+            auto& part = p_impl->m_parts[i];
+            part.m_shape = i_params.m_shape;
+            part.m_extent = CELL_SIZE / 2 * _RandomUniform(random, 0.6, 0.85);
+            const size_t cell[3] = { i % p_impl->m_cells_per_side, i / p_impl->m_cells_per_side % p_impl->m_cells_per_side,
+                                     i / (p_impl->m_cells_per_side * p_impl->m_cells_per_side) };
+            const auto max_shift = 0.95 * CELL_SIZE / 2 - part.m_extent;
+            for (short axis = 0; axis < 3; ++axis)
+                part.m_center[axis] = (cell[axis] + 0.5) * CELL_SIZE + _RandomUniform(random, -max_shift, max_shift);
+
+            switch (part.m_shape)
+            {
+            case Shape::Sphere:
+                part.m_radius = part.m_extent;
+                _MakeUVSphere(part, triangles_per_part);
+                break;
+            case Shape::Sqrt3Sphere:
+                part.m_radius = part.m_extent;
+                _MakeSqrt3Sphere(part, triangles_per_part);
+                break;
+            case Shape::Torus:
+                part.m_tube_radius = part.m_extent * _RandomUniform(random, 0.2, 0.35);
+                part.m_radius = part.m_extent - part.m_tube_radius;
+                part.m_axis = static_cast<short>(_RandomIndex(random, 3));
+                _MakeTorus(part, triangles_per_part);
+                break;
+            case Shape::VoxelBlob:
+                _MakeVoxelBlob(part, triangles_per_part, random);
+                break;
+            }
+        }
+    });
+
+    for (const auto& part : p_impl->m_parts)
+    {
+        for (const auto& vertex : part.m_vertices)
+            p_impl->m_bbox.AddPoint(ToPoint3D(vertex));
+    }
+    mp_impl = std::move(p_impl);
+}
+
+size_t SceneGenerator::GetPartsCount() const
+{
+    return mp_impl->m_parts.size();
+}
+
+size_t SceneGenerator::GetTrianglesCount() const
+{
+    size_t count = 0;
+    for (const auto& part : mp_impl->m_parts)
+        count += part.m_indices.size() / 3;
+    return count;
+}
+
+BoundingBox SceneGenerator::GetBoundingBox() const
+{
+    return mp_impl->m_bbox;
+}
+
+const std::vector<BasicPoint3D>& SceneGenerator::GetPartVertices(size_t i_part) const
+{
+    return mp_impl->m_parts[i_part].m_vertices;
+}
+
+const std::vector<std::uint32_t>& SceneGenerator::GetPartIndices(size_t i_part) const
+{
+    return mp_impl->m_parts[i_part].m_indices;
+}
+
+void SceneGenerator::BuildPartMesh(size_t i_part, Mesh& o_mesh) const
+{
+    o_mesh.BuildFromIndexedArrays(GetPartVertices(i_part), GetPartIndices(i_part));
+    o_mesh.SetName(QString("part_%1").arg(i_part));
+}
+
+bool SceneGenerator::Locate(const Point3D& i_point, size_t& o_part) const
+{
+    return mp_impl->Locate(i_point, o_part) != Location::Unknown;
+}
+
+void SceneGenerator::GeneratePoints(size_t i_count, PointsDistribution i_distribution, std::uint32_t i_seed,
+                                    std::vector<Point3D>& o_points, std::vector<size_t>& o_parts) const
+{
+    o_points.assign(i_count, Point3D());
+    o_parts.assign(i_count, OUTSIDE);
+    if (i_count == 0 || mp_impl->m_parts.empty())
+        return;
+
+    // uniform points fill the bounding box grown by 5% on every side
+    double min[3];
+    double max[3];
+    for (short i = 0; i < 3; ++i)
+    {
+        const auto margin = 0.05 * mp_impl->m_bbox.GetDelta(i);
+        min[i] = mp_impl->m_bbox.GetMin()[i] - margin;
+        max[i] = mp_impl->m_bbox.GetMax()[i] + margin;
+    }
+
+    // clusters are centered on vertices of random parts and are a tenth of the part size wide
+    std::vector<std::pair<BasicPoint3D, double>> clusters;
+    {
+        std::seed_seq seed{ i_seed };
+        Random random(seed);
+        for (size_t i = 0; i < CLUSTERS_COUNT; ++i)
+        {
+            const auto& part = mp_impl->m_parts[_RandomIndex(random, mp_impl->m_parts.size())];
+            clusters.emplace_back(part.m_vertices[_RandomIndex(random, part.m_vertices.size())], 0.1 * part.m_extent);
+        }
+    }
+
+    // every chunk has its own seed, so the points don't depend on the number of threads
+    const auto chunks_count = (i_count + POINTS_CHUNK_SIZE - 1) / POINTS_CHUNK_SIZE;
+    WorkStealingThreadPool::GetGlobalInstance().ParallelFor(chunks_count, 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto chunk = i_begin; chunk < i_end; ++chunk)
+        {
+            std::seed_seq seed{ i_seed, static_cast<std::uint32_t>(chunk) + 1, static_cast<std::uint32_t>(i_distribution) };
+            Random random(seed);
+            for (auto i = chunk * POINTS_CHUNK_SIZE; i < std::min(i_count, (chunk + 1) * POINTS_CHUNK_SIZE); ++i)
+            {
+                Point3D point;
+                do
+                {
+                    if (i_distribution == PointsDistribution::Uniform)
+                    {
+                        for (short axis = 0; axis < 3; ++axis)
+                            point[axis] = _RandomUniform(random, min[axis], max[axis]);
+                    }
+                    else
+                    {
+                        const auto& cluster = clusters[_RandomIndex(random, clusters.size())];
+                        for (short axis = 0; axis < 3; ++axis)
+                            point[axis] = cluster.first[axis] + cluster.second * _RandomNormal(random);
+                    }
+                } while (mp_impl->Locate(point, o_parts[i]) == Location::Unknown);
+                o_points[i] = point;
+            }
+        }
+    });
+}
@@ -1,75 +1,77 @@
 #include "Math.Algos/Sqrt3Subdivision.h"
 
 #include <Math.Core/CommonUtilities.h>
+#include <Math.Core/IndexedMesh.h>
 #include <Math.Core/Mesh.h>
-#include <Math.Core/MeshPoint.h>
-#include <Math.Core/MeshTriangle.h>
-#include <Math.Core/Vector3D.h>
-#include <Math.Core/VectorUtilities.h>
 
-#include <boost/unordered_set.hpp>
+#include <QtGlobal>
 
-#include <cassert>
-#include <map>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 
 namespace
 {
-    inline auto _AddTriangleKeepNormal(Mesh& io_mesh, const Triangle& i_triangle, const Vector3D& i_old_normal)
-    {
-        if (i_triangle.GetNormal() == i_old_normal)
-        {
-            auto res = io_mesh.AddTriangle(i_triangle.GetPoint(0), i_triangle.GetPoint(1), i_triangle.GetPoint(2));
-
-            assert(!io_mesh.GetPoint(i_triangle.GetPoint(0))->GetTriangles().empty());
-            assert(!io_mesh.GetPoint(i_triangle.GetPoint(1))->GetTriangles().empty());
-            assert(!io_mesh.GetPoint(i_triangle.GetPoint(2))->GetTriangles().empty());
-
-            return res;
-        }
-        else
-        {
-            auto res = io_mesh.AddTriangle(i_triangle.GetPoint(2), i_triangle.GetPoint(1), i_triangle.GetPoint(0));
+    using VertexId = IndexedMesh::VertexId;
+    using FaceId = IndexedMesh::FaceId;
 
-            assert(!io_mesh.GetPoint(i_triangle.GetPoint(0))->GetTriangles().empty());
-            assert(!io_mesh.GetPoint(i_triangle.GetPoint(1))->GetTriangles().empty());
-            assert(!io_mesh.GetPoint(i_triangle.GetPoint(2))->GetTriangles().empty());
+    inline double _DistanceSqr(const BasicPoint3D& i_a, const BasicPoint3D& i_b)
+    {
+        const auto dx = i_a[0] - i_b[0];
+        const auto dy = i_a[1] - i_b[1];
+        const auto dz = i_a[2] - i_b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
 
-            return res;
-        }
+    inline double _GetMinEdgeLengthSqr(const IndexedMesh& i_mesh, FaceId i_face)
+    {
+        const auto& point1 = i_mesh.GetVertex(i_mesh.GetFaceVertex(i_face, 0));
+        const auto& point2 = i_mesh.GetVertex(i_mesh.GetFaceVertex(i_face, 1));
+        const auto& point3 = i_mesh.GetVertex(i_mesh.GetFaceVertex(i_face, 2));
+        return std::min(_DistanceSqr(point1, point2), std::min(_DistanceSqr(point2, point3), _DistanceSqr(point3, point1)));
     }
 
-    inline auto _GetMinEdgeLengthSqr(Triangle* ip_triangle)
+    inline std::uint64_t _GetEdgeKey(VertexId i_a, VertexId i_b)
     {
-        auto edge1 = DistanceSqr(ip_triangle->GetPoint(0), ip_triangle->GetPoint(1));
-        auto edge2 = DistanceSqr(ip_triangle->GetPoint(1), ip_triangle->GetPoint(2));
-        auto edge3 = DistanceSqr(ip_triangle->GetPoint(2), ip_triangle->GetPoint(0));
-        return std::min(edge1, std::min(edge2, edge3));
+        return (static_cast<std::uint64_t>(std::min(i_a, i_b)) << 32) | std::max(i_a, i_b);
     }
 
-    void _SmoothOldPoints(Mesh& i_mesh, const boost::unordered_set<Point3D>& i_old_points)
+    // face (a, b, centroid) made from an old face with the edge (a, b)
+    struct EdgeFace
     {
-        std::vector<std::pair<Point3D, Point3D>> points_to_update;
+        FaceId m_face;
+        VertexId m_centroid;
+    };
 
-        for (const auto& old_point : i_old_points)
-        {
-            auto p_mesh_point = i_mesh.GetPoint(old_point);
-            auto neighbours = p_mesh_point->GetNeighbourPointsCount();
-            double alpha = (4.0 - 2.0 * std::cos(2.0 * PI / static_cast<double>(neighbours))) / 9.0;
-
-            Point3D average;
-            for (const auto& neighbour : p_mesh_point->GetPoints())
-                average += neighbour;
-            average /= static_cast<double>(neighbours);
-            
-            points_to_update.emplace_back(old_point, (1.0 - alpha) * old_point + alpha * average);
-        }
+    void _SmoothOldPoints(IndexedMesh& io_mesh, const std::vector<VertexId>& i_old_points)
+    {
+        io_mesh.BuildAdjacency();
 
-        for (const auto& point_to_update : points_to_update)
+        std::vector<BasicPoint3D> new_positions;
+        new_positions.reserve(i_old_points.size());
+        for (const auto old_point : i_old_points)
         {
-            i_mesh.UpdatePointCoordinates(point_to_update.first, point_to_update.second);
+            const auto neighbours = io_mesh.GetVertexNeighbours(old_point);
+            const double alpha = (4.0 - 2.0 * std::cos(2.0 * PI / static_cast<double>(neighbours.size()))) / 9.0;
+
+            BasicPoint3D average = { { 0, 0, 0 } };
+            for (const auto neighbour : neighbours)
+            {
+                for (size_t i = 0; i < 3; ++i)
+                    average[i] += io_mesh.GetVertex(neighbour)[i];
+            }
+
+            const auto& point = io_mesh.GetVertex(old_point);
+            BasicPoint3D new_position;
+            for (size_t i = 0; i < 3; ++i)
+                new_position[i] = (1.0 - alpha) * point[i] + alpha * average[i] / static_cast<double>(neighbours.size());
+            new_positions.push_back(new_position);
         }
+
+        for (size_t i = 0; i < i_old_points.size(); ++i)
+            io_mesh.SetVertex(i_old_points[i], new_positions[i]);
     }
 }
 
@@ -81,93 +83,86 @@ void SQRT3MeshSubdivider::SetParams(const Params& i_params)
 
 void SQRT3MeshSubdivider::Subdivide(Mesh& i_mesh) const
 {
-    std::vector<TriangleHandle> triangles;
-    for (size_t i = 0; i < i_mesh.GetTrianglesCount(); ++i)
-    {
-        if (auto p_triangle = i_mesh.GetTriangle(i).lock())
-        {
-            if (_GetMinEdgeLengthSqr(p_triangle.get()) > m_params.m_edge_length_threshold * m_params.m_edge_length_threshold)
-            {
-                triangles.emplace_back(i_mesh.GetTriangle(i));
-            }
-        }
-    }
+    auto indexed_mesh = i_mesh.GetIndexedMesh();
+    Subdivide(indexed_mesh);
+    i_mesh.Assign(indexed_mesh);
+}
 
-    std::map<std::pair<const MeshPoint*, const MeshPoint*>, std::vector<MeshPoint*>> adjacent_centroids;
-    auto make_edge = [](const MeshPoint* ip_left, const MeshPoint* ip_right)
-    {
-        return *ip_left < *ip_right ? std::make_pair(ip_left, ip_right) : std::make_pair(ip_right, ip_left);
-    };
+void SQRT3MeshSubdivider::Subdivide(IndexedMesh& io_mesh) const
+{
+    const auto threshold_sqr = m_params.m_edge_length_threshold * m_params.m_edge_length_threshold;
 
-    while (!triangles.empty())
+    std::vector<FaceId> faces;
+    for (FaceId face = 0; face < io_mesh.GetFacesCount(); ++face)
     {
-        boost::unordered_set<Point3D> old_points;
-        old_points.reserve(3 * triangles.size());
+        if (_GetMinEdgeLengthSqr(io_mesh, face) > threshold_sqr)
+            faces.push_back(face);
+    }
 
-        for (auto p_trinagle : triangles)
+    std::vector<char> is_old_point;
+    std::unordered_map<std::uint64_t, std::vector<EdgeFace>> edge_faces;
+    while (!faces.empty())
+    {
+        // every face is split in three by its centroid
+        is_old_point.assign(io_mesh.GetVerticesCount(), 0);
+        std::vector<VertexId> old_points;
+        edge_faces.clear();
+        edge_faces.reserve(3 * faces.size());
+        for (const auto face : faces)
         {
-            auto point1 = p_trinagle.lock()->GetPoint(0);
-            auto point2 = p_trinagle.lock()->GetPoint(1);
-            auto point3 = p_trinagle.lock()->GetPoint(2);
-
-            old_points.emplace(point1);
-            old_points.emplace(point2);
-            old_points.emplace(point3);
-
-            auto centroid = (point1 + point2 + point3) / 3;
-            auto p_centroid_mesh_point = i_mesh.AddPoint(centroid);
-
-            auto old_normal = p_trinagle.lock()->GetNormal();
+            const VertexId vertices[3] = { io_mesh.GetFaceVertex(face, 0), io_mesh.GetFaceVertex(face, 1), io_mesh.GetFaceVertex(face, 2) };
 
-            i_mesh.RemoveTriangle(point1, point2, point3);
+            BasicPoint3D centroid;
+            for (size_t i = 0; i < 3; ++i)
+            {
+                centroid[i] = (io_mesh.GetVertex(vertices[0])[i] + io_mesh.GetVertex(vertices[1])[i] + io_mesh.GetVertex(vertices[2])[i]) / 3;
+                if (!is_old_point[vertices[i]])
+                {
+                    is_old_point[vertices[i]] = 1;
+                    old_points.push_back(vertices[i]);
+                }
+            }
+            const auto centroid_id = io_mesh.AddVertex(centroid);
 
-            auto p_new_triangle1 = _AddTriangleKeepNormal(i_mesh, { point1, point2, centroid }, old_normal);
-            auto p_new_triangle2 = _AddTriangleKeepNormal(i_mesh, { point2, point3, centroid }, old_normal);
-            auto p_new_triangle3 = _AddTriangleKeepNormal(i_mesh, { point3, point1, centroid }, old_normal);
+            // the old face keeps its id, new faces keep its orientation
+            io_mesh.SetFace(face, vertices[0], vertices[1], centroid_id);
+            const auto face2 = io_mesh.AddFace(vertices[1], vertices[2], centroid_id);
+            const auto face3 = io_mesh.AddFace(vertices[2], vertices[0], centroid_id);
 
-            adjacent_centroids[make_edge(i_mesh.GetPoint(point1), i_mesh.GetPoint(point2))].push_back(p_centroid_mesh_point);
-            adjacent_centroids[make_edge(i_mesh.GetPoint(point2), i_mesh.GetPoint(point3))].push_back(p_centroid_mesh_point);
-            adjacent_centroids[make_edge(i_mesh.GetPoint(point3), i_mesh.GetPoint(point1))].push_back(p_centroid_mesh_point);
+            edge_faces[_GetEdgeKey(vertices[0], vertices[1])].push_back({ face, centroid_id });
+            edge_faces[_GetEdgeKey(vertices[1], vertices[2])].push_back({ face2, centroid_id });
+            edge_faces[_GetEdgeKey(vertices[2], vertices[0])].push_back({ face3, centroid_id });
         }
 
-        triangles.clear();
-        for (auto old_edge_and_centroids : adjacent_centroids)
+        // old edges between two split faces are flipped to connect the centroids
+        faces.clear();
+        for (const auto& edge_and_faces : edge_faces)
         {
-            auto& old_edge = old_edge_and_centroids.first;
-            auto& centroids = old_edge_and_centroids.second;
-
-            if (centroids.size() != 2)
+            const auto& split_faces = edge_and_faces.second;
+            if (split_faces.size() != 2)
             {
-                Q_ASSERT(centroids.size() == 1);
+                Q_ASSERT(split_faces.size() == 1);
                 continue;
             }
 
-            auto old_triangles = i_mesh.GetTrianglesIncidentToEdge(*old_edge.first, *old_edge.second);
-            if (old_triangles.size() != 2) // ?
-                continue;
-
-            Point3D shared_point1 = *old_edge.first;
-            Point3D shared_point2 = *old_edge.second;
-
-            Point3D centroid1 = *centroids[0];
-            Point3D centroid2 = *centroids[1];
-
-            auto old_normal = old_triangles[0].lock()->GetNormal();
-
-            i_mesh.RemoveTriangle(old_triangles[0].lock()->GetPoint(0), old_triangles[0].lock()->GetPoint(1), old_triangles[0].lock()->GetPoint(2));
-            i_mesh.RemoveTriangle(old_triangles[1].lock()->GetPoint(0), old_triangles[1].lock()->GetPoint(1), old_triangles[1].lock()->GetPoint(2));
-
-            auto p_new_triangle1 = _AddTriangleKeepNormal(i_mesh, { centroid1, centroid2, shared_point1 }, old_normal).lock();
-            auto p_new_triangle2 = _AddTriangleKeepNormal(i_mesh, { centroid1, centroid2, shared_point2 }, old_normal).lock();
-
-            if (_GetMinEdgeLengthSqr(&*p_new_triangle1) > m_params.m_edge_length_threshold * m_params.m_edge_length_threshold)
-                triangles.emplace_back(p_new_triangle1);
-            if (_GetMinEdgeLengthSqr(&*p_new_triangle2) > m_params.m_edge_length_threshold * m_params.m_edge_length_threshold)
-                triangles.emplace_back(p_new_triangle2);
+            // (a, b, centroid1) and (b, a, centroid2) become (a, centroid2, centroid1) and (b, centroid1, centroid2)
+            const auto face1 = split_faces[0].m_face;
+            const auto face2 = split_faces[1].m_face;
+            const auto point1 = io_mesh.GetFaceVertex(face1, 0);
+            const auto point2 = io_mesh.GetFaceVertex(face1, 1);
+            const auto centroid1 = split_faces[0].m_centroid;
+            const auto centroid2 = split_faces[1].m_centroid;
+
+            io_mesh.SetFace(face1, point1, centroid2, centroid1);
+            io_mesh.SetFace(face2, point2, centroid1, centroid2);
+
+            if (_GetMinEdgeLengthSqr(io_mesh, face1) > threshold_sqr)
+                faces.push_back(face1);
+            if (_GetMinEdgeLengthSqr(io_mesh, face2) > threshold_sqr)
+                faces.push_back(face2);
         }
 
-        if(m_params.m_apply_smoothing)
-            _SmoothOldPoints(i_mesh, old_points);
+        if (m_params.m_apply_smoothing)
+            _SmoothOldPoints(io_mesh, old_points);
     }
-
 }
@@ -0,0 +1,397 @@
+#include "VoxelCornerDistances.h"
+
+#include <Math.Core/BasicPoint3.h>
+#include <Math.Core/BinaryStream.h>
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/TriangleSoup.h>
+#include <Math.Core/WorkStealingThreadPool.h>
+
+#include <Math.DataStructures/TrianglesBVH.h>
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+
+namespace
+{
+    constexpr std::uint32_t NO_SAMPLES = std::numeric_limits<std::uint32_t>::max();
+    constexpr size_t CORNERS_PER_TASK = 1024;
+
+    inline size_t _GetSlot(std::uint64_t i_voxel, size_t i_table_shift)
+    {
+        // Fibonacci hashing, neighbouring voxels go to different parts of the table
+        return static_cast<size_t>((i_voxel * 0x9E3779B97F4A7C15ull) >> i_table_shift);
+    }
+
+    float _RoundDown(double i_value)
+    {
+        auto result = static_cast<float>(i_value);
+        if (result > i_value)
+            result = std::nextafter(result, 0.f);
+        return result;
+    }
+}
+
+
+void VoxelCornerDistances::Build(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, size_t i_threads_count, const std::function<size_t(const Point3D&)>& i_classify)
+{
+    Clear();
+    _SetGrid(i_grid);
+
+    std::vector<std::uint64_t> voxels;
+    for (const auto& coordinates : i_grid.GetExistingVoxelsCoordinates())
+    {
+        if (!i_grid.GetVoxelTriangles(coordinates).empty())
+            voxels.push_back(coordinates[0] + (coordinates[1] + coordinates[2] * static_cast<std::uint64_t>(m_num_voxels[1])) * m_num_voxels[0]);
+    }
+    Q_ASSERT(voxels.size() < NO_SAMPLES);
+
+    if (voxels.empty() || i_triangles.GetTrianglesCount() == 0)
+        return;
+
+    m_samples = _SampleVoxels(voxels, i_triangles, i_threads_count, i_classify);
+    _BuildTable(voxels);
+}
+
+void VoxelCornerDistances::Update(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, const std::array<size_t, 3>& i_min, const std::array<size_t, 3>& i_max,
+                                  size_t i_threads_count, const std::function<size_t(const Point3D&)>& i_classify)
+{
+    Q_ASSERT(m_num_voxels == i_grid.GetNumVoxels() && m_voxel_size == i_grid.GetVoxelSize());
+
+    // voxels in the region are sampled again, the nearest triangles of their corners are in the voxels of the search region
+    const auto diagonal = std::sqrt(m_voxel_size[0] * m_voxel_size[0] + m_voxel_size[1] * m_voxel_size[1] + m_voxel_size[2] * m_voxel_size[2]);
+    std::array<size_t, 3> region_min, region_max, search_min, search_max;
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        Q_ASSERT(i_min[axis] <= i_max[axis] && i_max[axis] < m_num_voxels[axis]);
+        const auto reach = static_cast<size_t>(diagonal / m_voxel_size[axis]) + 1;
+        region_min[axis] = i_min[axis] > reach ? i_min[axis] - reach : 0;
+        region_max[axis] = std::min(i_max[axis] + reach, m_num_voxels[axis] - 1);
+        search_min[axis] = region_min[axis] > reach ? region_min[axis] - reach : 0;
+        search_max[axis] = std::min(region_max[axis] + reach, m_num_voxels[axis] - 1);
+    }
+
+    const auto is_in_region = [&](std::uint64_t i_voxel)
+    {
+        const std::array<std::uint64_t, 3> coordinates = { i_voxel % m_num_voxels[0], i_voxel / m_num_voxels[0] % m_num_voxels[1], i_voxel / m_num_voxels[0] / m_num_voxels[1] };
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            if (coordinates[axis] < region_min[axis] || coordinates[axis] > region_max[axis])
+                return false;
+        }
+        return true;
+    };
+
+    // voxels out of the region keep their samples
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> kept_voxels;
+    for (size_t slot = 0; slot < m_table_samples.size(); ++slot)
+    {
+        if (m_table_samples[slot] != NO_SAMPLES && !is_in_region(m_table_voxels[slot]))
+            kept_voxels.emplace_back(m_table_voxels[slot], m_table_samples[slot]);
+    }
+    std::sort(kept_voxels.begin(), kept_voxels.end());
+
+    std::vector<std::uint64_t> new_voxels;
+    std::vector<std::uint32_t> triangle_indexes;
+    for (auto z = search_min[2]; z <= search_max[2]; ++z)
+    {
+        for (auto y = search_min[1]; y <= search_max[1]; ++y)
+        {
+            for (auto x = search_min[0]; x <= search_max[0]; ++x)
+            {
+                const auto voxel_triangles = i_grid.GetVoxelTriangles({ x, y, z });
+                if (voxel_triangles.empty())
+                    continue;
+
+                for (auto it = voxel_triangles.begin(); it != voxel_triangles.end(); ++it)
+                    triangle_indexes.push_back(it.GetIndex());
+                const auto voxel = x + (y + z * static_cast<std::uint64_t>(m_num_voxels[1])) * m_num_voxels[0];
+                if (is_in_region(voxel))
+                    new_voxels.push_back(voxel);
+            }
+        }
+    }
+    std::sort(triangle_indexes.begin(), triangle_indexes.end());
+    triangle_indexes.erase(std::unique(triangle_indexes.begin(), triangle_indexes.end()), triangle_indexes.end());
+
+    std::vector<Sample> new_samples;
+    if (!new_voxels.empty())
+    {
+        TriangleSoup triangles;
+        triangles.Reserve(triangle_indexes.size());
+        for (const auto triangle : triangle_indexes)
+        {
+            const auto p_vertices = i_triangles.GetVertices(triangle);
+            triangles.AddTriangle(ToPoint3D(p_vertices[0]), ToPoint3D(p_vertices[1]), ToPoint3D(p_vertices[2]), i_triangles.GetMeshId(triangle));
+        }
+        new_samples = _SampleVoxels(new_voxels, triangles, i_threads_count, i_classify);
+    }
+
+    // both lists are sorted by voxel, so the merged samples stay in the order Build lays them out
+    std::vector<std::uint64_t> voxels;
+    std::vector<Sample> samples;
+    voxels.reserve(kept_voxels.size() + new_voxels.size());
+    samples.reserve(8 * (kept_voxels.size() + new_voxels.size()));
+    size_t kept = 0;
+    size_t added = 0;
+    while (kept < kept_voxels.size() || added < new_voxels.size())
+    {
+        if (added == new_voxels.size() || (kept < kept_voxels.size() && kept_voxels[kept].first < new_voxels[added]))
+        {
+            voxels.push_back(kept_voxels[kept].first);
+            const auto p_samples = m_samples.data() + 8 * static_cast<size_t>(kept_voxels[kept++].second);
+            samples.insert(samples.end(), p_samples, p_samples + 8);
+        }
+        else
+        {
+            voxels.push_back(new_voxels[added]);
+            samples.insert(samples.end(), new_samples.begin() + 8 * added, new_samples.begin() + 8 * (added + 1));
+            ++added;
+        }
+    }
+    Q_ASSERT(voxels.size() < NO_SAMPLES);
+
+    m_samples = std::move(samples);
+    m_table_voxels.clear();
+    m_table_samples.clear();
+    if (!voxels.empty())
+        _BuildTable(voxels);
+}
+
+void VoxelCornerDistances::_SetGrid(const VoxelGrid& i_grid)
+{
+    m_num_voxels = i_grid.GetNumVoxels();
+    m_voxel_size = i_grid.GetVoxelSize();
+    const auto& grid_min = i_grid.GetBoundingBox().GetMin();
+    m_grid_min = { grid_min.GetX(), grid_min.GetY(), grid_min.GetZ() };
+}
+
+std::vector<VoxelCornerDistances::Sample> VoxelCornerDistances::_SampleVoxels(const std::vector<std::uint64_t>& i_voxels, const TriangleSoup& i_triangles, size_t i_threads_count,
+                                                                             const std::function<size_t(const Point3D&)>& i_classify) const
+{
+    // neighbouring voxels share corners, every corner is computed once
+    const std::uint64_t corners_x = m_num_voxels[0] + 1;
+    const std::uint64_t corners_y = m_num_voxels[1] + 1;
+    std::vector<std::uint64_t> corners;
+    corners.reserve(8 * i_voxels.size());
+    for (const auto voxel : i_voxels)
+    {
+        const auto x = voxel % m_num_voxels[0];
+        const auto y = voxel / m_num_voxels[0] % m_num_voxels[1];
+        const auto z = voxel / m_num_voxels[0] / m_num_voxels[1];
+        for (std::uint64_t corner = 0; corner < 8; ++corner)
+            corners.push_back(x + (corner & 1) + (y + ((corner >> 1) & 1) + (z + (corner >> 2)) * corners_y) * corners_x);
+    }
+    std::sort(corners.begin(), corners.end());
+    corners.erase(std::unique(corners.begin(), corners.end()), corners.end());
+
+    TrianglesBVH bvh;
+    bvh.Build(i_triangles, TrianglesBVH::Params());
+
+    std::unique_ptr<WorkStealingThreadPool> p_own_pool;
+    if (i_threads_count != 0)
+        p_own_pool = std::make_unique<WorkStealingThreadPool>(i_threads_count);
+    auto& pool = p_own_pool ? *p_own_pool : WorkStealingThreadPool::GetGlobalInstance();
+
+    std::vector<Sample> corner_samples(corners.size());
+    pool.ParallelFor(corners.size(), CORNERS_PER_TASK, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+        {
+            const auto x = corners[i] % corners_x;
+            const auto y = corners[i] / corners_x % corners_y;
+            const auto z = corners[i] / corners_x / corners_y;
+            const Point3D corner(m_grid_min[0] + x * m_voxel_size[0], m_grid_min[1] + y * m_voxel_size[1], m_grid_min[2] + z * m_voxel_size[2]);
+
+            double distance = 0;
+            bvh.FindNearestTriangle(corner, &distance);
+            const auto mesh_index = i_classify(corner);
+            Q_ASSERT(mesh_index == std::numeric_limits<size_t>::max() || mesh_index < OUTSIDE);
+            corner_samples[i].m_distance = _RoundDown(distance);
+            corner_samples[i].m_label = mesh_index == std::numeric_limits<size_t>::max() ? OUTSIDE : static_cast<std::uint32_t>(mesh_index);
+        }
+    });
+
+    std::vector<Sample> samples;
+    samples.reserve(8 * i_voxels.size());
+    for (const auto voxel : i_voxels)
+    {
+        const auto x = voxel % m_num_voxels[0];
+        const auto y = voxel / m_num_voxels[0] % m_num_voxels[1];
+        const auto z = voxel / m_num_voxels[0] / m_num_voxels[1];
+        for (std::uint64_t corner = 0; corner < 8; ++corner)
+        {
+            const auto id = x + (corner & 1) + (y + ((corner >> 1) & 1) + (z + (corner >> 2)) * corners_y) * corners_x;
+            samples.push_back(corner_samples[std::lower_bound(corners.begin(), corners.end(), id) - corners.begin()]);
+        }
+    }
+    return samples;
+}
+
+void VoxelCornerDistances::_BuildTable(const std::vector<std::uint64_t>& i_voxels)
+{
+    // load factor is kept below 1/2, so probe sequences stay short
+    size_t table_size_log = 1;
+    while ((size_t(1) << table_size_log) < 2 * i_voxels.size())
+        ++table_size_log;
+    m_table_shift = 64 - table_size_log;
+    m_table_voxels.assign(size_t(1) << table_size_log, 0);
+    m_table_samples.assign(size_t(1) << table_size_log, NO_SAMPLES);
+    const auto mask = m_table_voxels.size() - 1;
+    for (size_t i = 0; i < i_voxels.size(); ++i)
+    {
+        auto slot = _GetSlot(i_voxels[i], m_table_shift);
+        while (m_table_samples[slot] != NO_SAMPLES)
+            slot = (slot + 1) & mask;
+
+        m_table_voxels[slot] = i_voxels[i];
+        m_table_samples[slot] = static_cast<std::uint32_t>(i);
+    }
+}
+
+void VoxelCornerDistances::Clear()
+{
+    m_num_voxels = {};
+    m_table_voxels.clear();
+    m_table_voxels.shrink_to_fit();
+    m_table_samples.clear();
+    m_table_samples.shrink_to_fit();
+    m_table_shift = 0;
+    m_samples.clear();
+    m_samples.shrink_to_fit();
+}
+
+bool VoxelCornerDistances::IsBuilt() const
+{
+    return !m_samples.empty();
+}
+
+const VoxelCornerDistances::Sample* VoxelCornerDistances::_FindSamples(std::uint64_t i_voxel) const
+{
+    if (m_table_voxels.empty())
+        return nullptr;
+
+    const auto mask = m_table_voxels.size() - 1;
+    for (auto slot = _GetSlot(i_voxel, m_table_shift); ; slot = (slot + 1) & mask)
+    {
+        const auto samples = m_table_samples[slot];
+        if (samples == NO_SAMPLES)
+            return nullptr;
+        if (m_table_voxels[slot] == i_voxel)
+            return m_samples.data() + 8 * static_cast<size_t>(samples);
+    }
+}
+
+bool VoxelCornerDistances::FindLabel(const std::array<size_t, 3>& i_coordinates, const Point3D& i_point, std::uint32_t& o_label) const
+{
+    const auto p_samples = _FindSamples(i_coordinates[0] + (i_coordinates[1] + i_coordinates[2] * static_cast<std::uint64_t>(m_num_voxels[1])) * m_num_voxels[0]);
+    if (!p_samples)
+        return false;
+
+    // squared offsets of the point from the lower and the upper corner of the voxel along every axis
+    std::array<std::array<double, 2>, 3> offsets;
+    const double point[3] = { i_point.GetX(), i_point.GetY(), i_point.GetZ() };
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        const auto lower = m_grid_min[axis] + i_coordinates[axis] * m_voxel_size[axis];
+        offsets[axis][0] = (point[axis] - lower) * (point[axis] - lower);
+        const auto upper = m_grid_min[axis] + (i_coordinates[axis] + 1) * m_voxel_size[axis];
+        offsets[axis][1] = (point[axis] - upper) * (point[axis] - upper);
+    }
+
+    for (size_t corner = 0; corner < 8; ++corner)
+    {
+        const double distance = p_samples[corner].m_distance;
+        if (offsets[0][corner & 1] + offsets[1][(corner >> 1) & 1] + offsets[2][corner >> 2] < distance * distance)
+        {
+            o_label = p_samples[corner].m_label;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t VoxelCornerDistances::GetMemoryUsage() const
+{
+    return m_table_voxels.capacity() * sizeof(std::uint64_t) + m_table_samples.capacity() * sizeof(std::uint32_t) + m_samples.capacity() * sizeof(Sample);
+}
+
+
+void VoxelCornerDistances::Save(BinaryWriter& io_writer) const
+{
+    for (size_t axis = 0; axis < 3; ++axis)
+        io_writer.Write(static_cast<std::uint64_t>(m_num_voxels[axis]));
+    for (size_t axis = 0; axis < 3; ++axis)
+        io_writer.Write(m_voxel_size[axis]);
+    for (size_t axis = 0; axis < 3; ++axis)
+        io_writer.Write(m_grid_min[axis]);
+    io_writer.WriteArray(m_table_voxels);
+    io_writer.WriteArray(m_table_samples);
+    io_writer.Write(static_cast<std::uint64_t>(m_table_shift));
+    io_writer.WriteArray(m_samples);
+}
+
+bool VoxelCornerDistances::Load(BinaryReader& io_reader, const VoxelGrid& i_grid)
+{
+    Clear();
+    _SetGrid(i_grid);
+
+    // the samples belong to the grid they were built for
+    bool is_valid = true;
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        std::uint64_t num_voxels = 0;
+        is_valid = io_reader.Read(num_voxels) && is_valid && num_voxels == m_num_voxels[axis];
+    }
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        double voxel_size = 0;
+        is_valid = io_reader.Read(voxel_size) && is_valid && voxel_size == m_voxel_size[axis];
+    }
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        double grid_min = 0;
+        is_valid = io_reader.Read(grid_min) && is_valid && grid_min == m_grid_min[axis];
+    }
+
+    // Lookups trust the table: a table without a free slot makes the lookup of a missing voxel loop forever,
+    // a wrong shift or sample index makes it read out of the arrays
+    std::uint64_t table_shift = 0;
+    is_valid = is_valid && io_reader.ReadArray(m_table_voxels) && io_reader.ReadArray(m_table_samples) && io_reader.Read(table_shift)
+            && io_reader.ReadArray(m_samples) && m_samples.size() % 8 == 0 && m_table_voxels.size() == m_table_samples.size();
+    const auto table_size = m_table_samples.size();
+    if (is_valid && table_size > 0)
+    {
+        is_valid = table_size >= 2 && (table_size & (table_size - 1)) == 0 && table_shift > 0 && table_shift < 64
+                && (std::uint64_t(1) << (64 - table_shift)) == table_size;
+        m_table_shift = static_cast<size_t>(table_shift);
+
+        const auto voxels_count = static_cast<std::uint64_t>(m_num_voxels[0]) * m_num_voxels[1] * m_num_voxels[2];
+        size_t occupied_count = 0;
+        for (size_t slot = 0; is_valid && slot < table_size; ++slot)
+        {
+            if (m_table_samples[slot] == NO_SAMPLES)
+                continue;
+            is_valid = m_table_samples[slot] < m_samples.size() / 8 && m_table_voxels[slot] < voxels_count;
+            ++occupied_count;
+        }
+        is_valid = is_valid && occupied_count < table_size;
+    }
+    else if (is_valid)
+    {
+        is_valid = m_samples.empty();
+    }
+    is_valid = is_valid && std::all_of(m_samples.begin(), m_samples.end(), [](const Sample& i_sample)
+    {
+        return i_sample.m_distance >= 0;
+    });
+
+    if (!is_valid)
+        Clear();
+    return is_valid;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+class BinaryReader;
+class BinaryWriter;
+class Point3D;
+class TriangleSoup;
+class VoxelGrid;
+
+// Distance from every corner of the non-empty voxels to the nearest triangle and the label of the corner.
+// No surface passes closer to a corner than its distance, so a point nearer to the corner than that lies on the
+// same side of all surfaces and gets the label of the corner without touching triangles
+class VoxelCornerDistances
+{
+public:
+    static constexpr std::uint32_t OUTSIDE = std::numeric_limits<std::uint32_t>::max();
+
+    // i_triangles are the triangles the grid indexes, triangles that are no longer in the grid only make the distances
+    // smaller. i_classify labels a corner, it returns a mesh index or std::numeric_limits<size_t>::max() for outside.
+    // It is called from several threads
+    void Build(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, size_t i_threads_count, const std::function<size_t(const Point3D&)>& i_classify);
+    // Updates the samples after voxels from i_min to i_max gained or lost triangles. A corner is nearer than a voxel
+    // diagonal to its nearest triangle, so only voxels within a diagonal of the box are sampled again, against the
+    // triangles of the grid around them
+    void Update(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, const std::array<size_t, 3>& i_min, const std::array<size_t, 3>& i_max,
+                size_t i_threads_count, const std::function<size_t(const Point3D&)>& i_classify);
+    void Clear();
+    bool IsBuilt() const;
+
+    // false if the voxel has no samples or the point is not near enough to any of its corners.
+    // i_coordinates are the coordinates of the voxel that contains the point
+    bool FindLabel(const std::array<size_t, 3>& i_coordinates, const Point3D& i_point, std::uint32_t& o_label) const;
+
+    size_t GetMemoryUsage() const;
+
+    void Save(BinaryWriter& io_writer) const;
+    // samples saved for i_grid, returns false for a broken file
+    bool Load(BinaryReader& io_reader, const VoxelGrid& i_grid);
+
+private:
+    struct Sample
+    {
+        float m_distance; // rounded down, so it never exceeds the exact distance
+        std::uint32_t m_label;
+    };
+
+    void _SetGrid(const VoxelGrid& i_grid);
+    // 8 samples for every voxel, i_voxels are sorted and i_triangles hold the nearest triangles of their corners
+    std::vector<Sample> _SampleVoxels(const std::vector<std::uint64_t>& i_voxels, const TriangleSoup& i_triangles, size_t i_threads_count,
+                                      const std::function<size_t(const Point3D&)>& i_classify) const;
+    // voxel i_voxels[i] gets samples 8 * i
+    void _BuildTable(const std::vector<std::uint64_t>& i_voxels);
+    const Sample* _FindSamples(std::uint64_t i_voxel) const;
+
+    std::array<size_t, 3> m_num_voxels = {};
+    std::array<double, 3> m_voxel_size = {};
+    std::array<double, 3> m_grid_min = {};
+
+    // open addressing with linear probing from voxel x + (y + z * num_voxels_y) * num_voxels_x to its samples
+    std::vector<std::uint64_t> m_table_voxels;
+    std::vector<std::uint32_t> m_table_samples;
+    size_t m_table_shift = 0;
+
+    // 8 consecutive samples per voxel, so a query reads 64 bytes. Corner i is at offset (i & 1, (i >> 1) & 1, i >> 2)
+    std::vector<Sample> m_samples;
+};
@@ -97,11 +97,11 @@ namespace VoxelGrid2MeshConverter
         const auto& num_voxels = i_grid.GetNumVoxels();
         const auto& voxel_size = i_grid.GetVoxelSize();
 
-        const auto voxels = i_grid.GetExistingVoxels();
+        const auto voxels = i_grid.GetExistingVoxelsCoordinates();
 
-        for (const auto p_voxel : voxels)
+        for (const auto& voxel_coords : voxels)
         {
-            auto voxel_coords = p_voxel->GetCoordinates();
+            const auto voxel_bbox = i_grid.GetVoxelBoundingBox(voxel_coords);
 
             std::vector<Quad> required_quads = _GetDefaultRequiredQuads();
             
@@ -111,7 +111,7 @@ namespace VoxelGrid2MeshConverter
                 if (voxel_coords[i] != 0)
                     --prev_vox_coords[i];
 
-                bool was_voxel = voxel_coords[i] != 0 && i_grid.GetVoxel(prev_vox_coords);
+                bool was_voxel = voxel_coords[i] != 0 && i_grid.HasVoxel(prev_vox_coords);
                 if (was_voxel)
                     continue;
 
@@ -122,9 +122,9 @@ namespace VoxelGrid2MeshConverter
             {
                 for (size_t i = 0; i < 2; ++i)
                 {
-                    io_mesh.AddTriangle(_GetVertex(*p_voxel, quad.m_triangles[i].m_i), 
-                                        _GetVertex(*p_voxel, quad.m_triangles[i].m_j), 
-                                        _GetVertex(*p_voxel, quad.m_triangles[i].m_k));
+                    io_mesh.AddTriangle(_GetVertex(voxel_bbox, quad.m_triangles[i].m_i), 
+                                        _GetVertex(voxel_bbox, quad.m_triangles[i].m_j), 
+                                        _GetVertex(voxel_bbox, quad.m_triangles[i].m_k));
                 }
             }
 
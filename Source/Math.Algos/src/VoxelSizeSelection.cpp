@@ -0,0 +1,282 @@
+#include "VoxelSizeSelection.h"
+
+#include "Math.Algos/Voxelizer.h"
+
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/TriangleSoup.h>
+#include <Math.Core/Vector3D.h>
+#include <Math.Core/VectorUtilities.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+
+namespace
+{
+    constexpr double MIN_TRIANGLES_PER_VOXEL = 1.1;
+    constexpr double MAX_VOXELS_COUNT = 1 << 30;
+    constexpr size_t BLOCK_VOXELS_COUNT = 8;
+    constexpr size_t DRAWN_BLOCKS_COUNT = 64;
+    constexpr size_t REFINE_STEPS = 10;
+    constexpr double REFINE_TOLERANCE = 0.05;
+
+    // all triangles of a soup and a part of them are read through the same interface
+    struct SoupTriangles
+    {
+        const TriangleSoup& m_triangles;
+
+        size_t size() const { return m_triangles.GetTrianglesCount(); }
+        Triangle operator[](size_t i_index) const { return m_triangles.GetTriangle(static_cast<std::uint32_t>(i_index)); }
+    };
+
+    struct SoupSubsetTriangles
+    {
+        const TriangleSoup& m_triangles;
+        const std::vector<std::uint32_t>& m_indexes;
+
+        size_t size() const { return m_indexes.size(); }
+        Triangle operator[](size_t i_index) const { return m_triangles.GetTriangle(m_indexes[i_index]); }
+    };
+
+    // Over all orientations a plane touches 1.5 voxels per voxel face of its area and a segment crosses 1.5 voxel faces
+    // per voxel edge of its length. So a triangle touches about 1 + 0.75 * perimeter / s + 1.5 * area / s^2 voxels
+    // and a surface of total area A touches 1.5 * A / s^2 voxels, their ratio is a quadratic equation in 1 / s
+    template<typename Triangles>
+    double _EstimateVoxelSize(const Triangles& i_triangles, double i_triangles_per_voxel)
+    {
+        double area = 0;
+        double perimeter = 0;
+        for (size_t i = 0; i < i_triangles.size(); ++i)
+        {
+            const auto& triangle = i_triangles[i];
+            const Vector3D edge1(triangle.GetPoint(0), triangle.GetPoint(1));
+            const Vector3D edge2(triangle.GetPoint(0), triangle.GetPoint(2));
+            area += Cross(edge1, edge2).Length() / 2;
+            perimeter += edge1.Length() + edge2.Length() + Vector3D(triangle.GetPoint(1), triangle.GetPoint(2)).Length();
+        }
+
+        const auto triangles_count = static_cast<double>(i_triangles.size());
+        const auto excess = i_triangles_per_voxel - 1;
+        if (area > 0)
+            return 3 * area * excess / (0.75 * perimeter + std::sqrt(0.5625 * perimeter * perimeter + 6 * area * excess * triangles_count));
+
+        // degenerate triangles are segments, they touch 1 + 1.5 * length / s voxels of 1.5 * total length / s
+        if (perimeter > 0)
+            return 0.75 * perimeter * excess / triangles_count;
+        return 1;
+    }
+
+    // Blocks of the voxel lattice are voxelized exactly, every block is picked through a random triangle whose centroid
+    // lies in it. Weighting the block by the inverse of its centroids count makes the ratio of entries to non-empty
+    // voxels an estimate for the whole voxelization, not only for its dense parts
+    template<typename Triangles>
+    double _MeasureTrianglesPerVoxel(const Triangles& i_triangles, const std::vector<size_t>& i_drawn_triangles, const BoundingBox& i_bbox, double i_voxel_size)
+    {
+        const auto block_size = BLOCK_VOXELS_COUNT * i_voxel_size;
+        const auto& bbox_min = i_bbox.GetMin();
+        const auto get_block = [&](const Point3D& i_point)
+        {
+            std::array<std::int64_t, 3> block;
+            for (short axis = 0; axis < 3; ++axis)
+                block[axis] = static_cast<std::int64_t>(std::floor((i_point[axis] - bbox_min[axis]) / block_size));
+            return block;
+        };
+        const auto get_centroid = [](const Triangle& i_triangle)
+        {
+            return (i_triangle.GetPoint(0) + i_triangle.GetPoint(1) + i_triangle.GetPoint(2)) / 3;
+        };
+
+        std::vector<std::array<std::int64_t, 3>> blocks;
+        for (const auto triangle : i_drawn_triangles)
+            blocks.push_back(get_block(get_centroid(i_triangles[triangle])));
+        std::sort(blocks.begin(), blocks.end());
+        blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+
+        // one pass over all triangles counts the centroids of every block and collects the triangles that touch it
+        std::vector<size_t> centroids_counts(blocks.size(), 0);
+        std::vector<std::vector<Triangle>> block_triangles(blocks.size());
+        for (size_t triangle_index = 0; triangle_index < i_triangles.size(); ++triangle_index)
+        {
+            const auto& triangle = i_triangles[triangle_index];
+            const auto centroid_block = std::lower_bound(blocks.begin(), blocks.end(), get_block(get_centroid(triangle)));
+            if (centroid_block != blocks.end() && *centroid_block == get_block(get_centroid(triangle)))
+                ++centroids_counts[centroid_block - blocks.begin()];
+
+            BoundingBox triangle_bbox;
+            for (short i = 0; i < 3; ++i)
+                triangle_bbox.AddPoint(triangle.GetPoint(i));
+            const auto min_block = get_block(triangle_bbox.GetMin() - Point3D(EPSILON, EPSILON, EPSILON));
+            const auto max_block = get_block(triangle_bbox.GetMax() + Point3D(EPSILON, EPSILON, EPSILON));
+
+            // blocks are sorted by x, so only the blocks of the x range of the triangle are tested
+            const auto first = std::lower_bound(blocks.begin(), blocks.end(), std::array<std::int64_t, 3>{ min_block[0], std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::min() });
+            for (auto block = first; block != blocks.end() && (*block)[0] <= max_block[0]; ++block)
+            {
+                if (min_block[1] <= (*block)[1] && (*block)[1] <= max_block[1] && min_block[2] <= (*block)[2] && (*block)[2] <= max_block[2])
+                    block_triangles[block - blocks.begin()].push_back(triangle);
+            }
+        }
+
+        Voxelizer::Params params;
+        params.m_precision = EPSILON;
+        params.m_threads_count = 1;
+        Voxelizer voxelizer;
+        voxelizer.SetParams(params);
+
+        double entries_sum = 0;
+        double voxels_sum = 0;
+        for (const auto triangle : i_drawn_triangles)
+        {
+            const auto i = std::lower_bound(blocks.begin(), blocks.end(), get_block(get_centroid(i_triangles[triangle]))) - blocks.begin();
+            BoundingBox block_bbox;
+            block_bbox.AddPoint(bbox_min + Point3D(blocks[i][0] * block_size, blocks[i][1] * block_size, blocks[i][2] * block_size));
+            block_bbox.AddPoint(bbox_min + Point3D((blocks[i][0] + 1) * block_size, (blocks[i][1] + 1) * block_size, (blocks[i][2] + 1) * block_size));
+            const VoxelGrid grid({ i_voxel_size, i_voxel_size, i_voxel_size }, { BLOCK_VOXELS_COUNT, BLOCK_VOXELS_COUNT, BLOCK_VOXELS_COUNT }, block_bbox);
+
+            // entries are sorted by voxel
+            std::vector<Triangle*> triangles;
+            for (auto& block_triangle : block_triangles[i])
+                triangles.push_back(&block_triangle);
+            const auto entries = voxelizer.CollectEntries(grid, triangles);
+            size_t voxels_count = 0;
+            for (size_t entry = 0; entry < entries.size(); ++entry)
+            {
+                if (entry == 0 || entries[entry].m_voxel_index != entries[entry - 1].m_voxel_index)
+                    ++voxels_count;
+            }
+            entries_sum += static_cast<double>(entries.size()) / centroids_counts[i];
+            voxels_sum += static_cast<double>(voxels_count) / centroids_counts[i];
+        }
+        return voxels_sum > 0 ? entries_sum / voxels_sum : 1;
+    }
+
+    // triangles per voxel grow with the voxel size, the bracket is widened until it holds the target and then halved
+    template<typename Triangles>
+    double _RefineVoxelSize(const Triangles& i_triangles, const BoundingBox& i_bbox, double i_voxel_size, double i_triangles_per_voxel)
+    {
+        std::mt19937_64 generator(0);
+        std::uniform_int_distribution<size_t> distribution(0, i_triangles.size() - 1);
+        std::vector<size_t> drawn_triangles(std::min(DRAWN_BLOCKS_COUNT, i_triangles.size()));
+        for (auto& triangle : drawn_triangles)
+            triangle = distribution(generator);
+
+        const auto measure = [&](double i_size)
+        {
+            return _MeasureTrianglesPerVoxel(i_triangles, drawn_triangles, i_bbox, i_size);
+        };
+
+        const auto triangles_per_voxel = measure(i_voxel_size);
+        if (std::abs(triangles_per_voxel / i_triangles_per_voxel - 1) < REFINE_TOLERANCE)
+            return i_voxel_size;
+
+        size_t step = 0;
+        auto low = triangles_per_voxel < i_triangles_per_voxel ? i_voxel_size : i_voxel_size / 2;
+        auto high = triangles_per_voxel < i_triangles_per_voxel ? 2 * i_voxel_size : i_voxel_size;
+        if (triangles_per_voxel < i_triangles_per_voxel)
+        {
+            for (; step < REFINE_STEPS && measure(high) < i_triangles_per_voxel; ++step)
+            {
+                low = high;
+                high *= 2;
+            }
+        }
+        else
+        {
+            for (; step < REFINE_STEPS && measure(low) > i_triangles_per_voxel; ++step)
+            {
+                high = low;
+                low /= 2;
+            }
+        }
+
+        auto voxel_size = std::sqrt(low * high);
+        for (; step < REFINE_STEPS; ++step)
+        {
+            voxel_size = std::sqrt(low * high);
+            const auto current = measure(voxel_size);
+            if (std::abs(current / i_triangles_per_voxel - 1) < REFINE_TOLERANCE)
+                break;
+            if (current < i_triangles_per_voxel)
+                low = voxel_size;
+            else
+                high = voxel_size;
+        }
+        return voxel_size;
+    }
+
+    template<typename Triangles>
+    std::array<double, 3> _SelectVoxelSize(const Triangles& i_triangles, double i_triangles_per_voxel, bool i_refine)
+    {
+        if (i_triangles.size() == 0)
+            return { 1., 1., 1. };
+
+        BoundingBox bbox;
+        for (size_t triangle = 0; triangle < i_triangles.size(); ++triangle)
+        {
+            const auto& current = i_triangles[triangle];
+            for (short i = 0; i < 3; ++i)
+                bbox.AddPoint(current.GetPoint(i));
+        }
+        const std::array<double, 3> extents = { bbox.GetDeltaX() + EPSILON, bbox.GetDeltaY() + EPSILON, bbox.GetDeltaZ() + EPSILON };
+
+        const auto triangles_per_voxel = std::max(MIN_TRIANGLES_PER_VOXEL, i_triangles_per_voxel);
+        auto voxel_size = _EstimateVoxelSize(i_triangles, triangles_per_voxel);
+        if (i_refine)
+            voxel_size = _RefineVoxelSize(i_triangles, bbox, voxel_size, triangles_per_voxel);
+
+        // Tiny triangles in a large box must not produce a grid that doesn't fit into memory. Every axis has at least one
+        // voxel, so a flat or thin box is limited by its wide axes only, their counts fall as 1 / s
+        const auto get_voxels_count = [&extents](double i_voxel_size)
+        {
+            double voxels_count = 1;
+            for (size_t axis = 0; axis < 3; ++axis)
+                voxels_count *= std::max(1., std::ceil(extents[axis] / i_voxel_size));
+            return voxels_count;
+        };
+        while (get_voxels_count(voxel_size) > MAX_VOXELS_COUNT)
+        {
+            double wide_extents = 1;
+            int wide_axes_count = 0;
+            for (size_t axis = 0; axis < 3; ++axis)
+            {
+                if (extents[axis] > voxel_size)
+                {
+                    wide_extents *= extents[axis];
+                    ++wide_axes_count;
+                }
+            }
+            voxel_size = std::max(voxel_size * (1 + 1e-3), std::pow(wide_extents / MAX_VOXELS_COUNT, 1. / wide_axes_count));
+        }
+        // few triangles give one voxel
+        voxel_size = std::min(voxel_size, *std::max_element(extents.begin(), extents.end()));
+
+        // a whole number of voxels along every axis, the margin keeps rounding from adding a voxel
+        std::array<double, 3> voxel_sizes;
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            if (extents[axis] <= voxel_size)
+                voxel_sizes[axis] = voxel_size;
+            else
+                voxel_sizes[axis] = extents[axis] / std::round(extents[axis] / voxel_size) * (1 + 1e-12);
+        }
+        return voxel_sizes;
+    }
+}
+
+
+std::array<double, 3> SelectVoxelSize(const TriangleSoup& i_triangles, double i_triangles_per_voxel, bool i_refine)
+{
+    return _SelectVoxelSize(SoupTriangles{ i_triangles }, i_triangles_per_voxel, i_refine);
+}
+
+std::array<double, 3> SelectVoxelSize(const TriangleSoup& i_triangles, const std::vector<std::uint32_t>& i_triangle_indexes, double i_triangles_per_voxel, bool i_refine)
+{
+    return _SelectVoxelSize(SoupSubsetTriangles{ i_triangles, i_triangle_indexes }, i_triangles_per_voxel, i_refine);
+}
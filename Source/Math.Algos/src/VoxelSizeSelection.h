@@ -0,0 +1,14 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class TriangleSoup;
+
+// Voxel sizes for which a non-empty voxel holds about i_triangles_per_voxel triangles on average. The estimate
+// comes from the count, the area and the edge lengths of the triangles, with i_refine it is corrected by voxelizing
+// random blocks of the grid. Sizes are picked so the voxels tile the bounding box of the triangles
+std::array<double, 3> SelectVoxelSize(const TriangleSoup& i_triangles, double i_triangles_per_voxel, bool i_refine);
+// same for the triangles of the soup with indexes i_triangle_indexes
+std::array<double, 3> SelectVoxelSize(const TriangleSoup& i_triangles, const std::vector<std::uint32_t>& i_triangle_indexes, double i_triangles_per_voxel, bool i_refine);
@@ -7,100 +7,255 @@
 #include <Math.Core/MeshPoint.h>
 #include <Math.Core/MeshTriangle.h>
 #include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/TriangleSoup.h>
+#include <Math.Core/WorkStealingThreadPool.h>
 
 #include <Math.DataStructures/VoxelGrid.h>
 
+#include <QtGlobal>
 
-void Voxelizer::SetParams(const Params& i_params)
-{
-    m_params = i_params;
-}
+#include <algorithm>
 
-std::unique_ptr<VoxelGrid> Voxelizer::Voxelize(const std::vector<Triangle*>& i_triangles)
+
+namespace
 {
-    BoundingBox bbox;
-    for (const auto& p_triangle : i_triangles)
+    constexpr size_t TRIANGLES_PER_TASK = 256;
+
+    bool _EntryLess(const VoxelGrid::Entry& i_lhs, const VoxelGrid::Entry& i_rhs)
     {
-        bbox.AddPoint(p_triangle->GetPoint(0));
-        bbox.AddPoint(p_triangle->GetPoint(1));
-        bbox.AddPoint(p_triangle->GetPoint(2));
+        if (i_lhs.m_voxel_index != i_rhs.m_voxel_index)
+            return i_lhs.m_voxel_index < i_rhs.m_voxel_index;
+        return i_lhs.m_triangle_index < i_rhs.m_triangle_index;
     }
 
-    const auto cnt_x = static_cast<size_t>(std::max(1., std::ceil((bbox.GetDeltaX() + m_params.m_precision) / m_params.m_resolution_x)));
-    const auto cnt_y = static_cast<size_t>(std::max(1., std::ceil((bbox.GetDeltaY() + m_params.m_precision) / m_params.m_resolution_y)));
-    const auto cnt_z = static_cast<size_t>(std::max(1., std::ceil((bbox.GetDeltaZ() + m_params.m_precision) / m_params.m_resolution_z)));
-
-    auto p_voxel_grid = std::make_unique<VoxelGrid>(std::array<double, 3>{ m_params.m_resolution_x, m_params.m_resolution_y, m_params.m_resolution_z },
-                                                    std::array<size_t, 3>{ cnt_x, cnt_y, cnt_z },
-                                                    bbox);
-
-    std::vector<std::vector<std::vector<bool>>> is_present(cnt_x, std::vector<std::vector<bool>>(cnt_y, std::vector<bool>(cnt_z, false)));
+    void _VoxelizeTriangle(const Triangle& i_triangle, std::uint32_t i_triangle_index, const VoxelGrid& i_grid, double i_precision, std::vector<VoxelGrid::Entry>& o_entries)
+    {
+        const auto& bbox = i_grid.GetBoundingBox();
+        const auto& resolution = i_grid.GetVoxelSize();
+        const auto& num_voxels = i_grid.GetNumVoxels();
+        const auto cnt_x = num_voxels[0];
+        const auto cnt_y = num_voxels[1];
+        const auto cnt_z = num_voxels[2];
 
-    const Point3D step(m_params.m_resolution_x, m_params.m_resolution_y, m_params.m_resolution_z);
+        const Point3D step(resolution[0], resolution[1], resolution[2]);
 
-    for (const auto& p_triangle : i_triangles)
-    {
-        auto point1 = p_triangle->GetPoint(0);
-        auto point2 = p_triangle->GetPoint(1);
-        auto point3 = p_triangle->GetPoint(2);
+        auto point1 = i_triangle.GetPoint(0);
+        auto point2 = i_triangle.GetPoint(1);
+        auto point3 = i_triangle.GetPoint(2);
 
         BoundingBox triangle_bbox;
         triangle_bbox.AddPoint(point1);
         triangle_bbox.AddPoint(point2);
         triangle_bbox.AddPoint(point3);
 
+        // every voxel whose box grown by the precision can touch the triangle is tested, otherwise a triangle just
+        // below a face of a voxel would miss the voxel above the face
         auto bbox_min = bbox.GetMin();
-        auto tria_min = triangle_bbox.GetMin();
-        auto tria_max = triangle_bbox.GetMax();
-        auto min_diff = tria_min - bbox_min;
-        auto max_diff = tria_max - bbox_min;
+        const Point3D precision(i_precision, i_precision, i_precision);
+        auto min_diff = triangle_bbox.GetMin() - precision - bbox_min;
+        auto max_diff = triangle_bbox.GetMax() + precision - bbox_min;
 
         auto min_id_x = std::floorl(min_diff[0] / step[0]);
         auto min_id_y = std::floorl(min_diff[1] / step[1]);
         auto min_id_z = std::floorl(min_diff[2] / step[2]);
 
-        if (qFuzzyCompare(min_id_x * m_params.m_resolution_x, min_diff[0]) && min_id_x > 0)
-            --min_id_x;
-        if (qFuzzyCompare(min_id_y * m_params.m_resolution_y, min_diff[1]) && min_id_y > 0)
-            --min_id_y;
-        if (qFuzzyCompare(min_id_z * m_params.m_resolution_z, min_diff[2]) && min_id_z > 0)
-            --min_id_z;
-
         auto max_id_x = std::floorl(max_diff[0] / step[0]);
         auto max_id_y = std::floorl(max_diff[1] / step[1]);
         auto max_id_z = std::floorl(max_diff[2] / step[2]);
 
-        if (qFuzzyCompare(max_id_x * m_params.m_resolution_x, max_diff[0]) && max_id_x < cnt_x)
-            ++max_id_x;
-        if (qFuzzyCompare(max_id_y * m_params.m_resolution_y, max_diff[1]) && max_id_y < cnt_y)
-            ++max_id_y;
-        if (qFuzzyCompare(max_id_z * m_params.m_resolution_z, max_diff[2]) && max_id_z < cnt_z)
-            ++max_id_z;
+        // a voxel outside of the grid would alias with a voxel of the next row
+        min_id_x = std::max<decltype(min_id_x)>(min_id_x, 0);
+        min_id_y = std::max<decltype(min_id_y)>(min_id_y, 0);
+        min_id_z = std::max<decltype(min_id_z)>(min_id_z, 0);
+        max_id_x = std::min<decltype(max_id_x)>(max_id_x, cnt_x - 1);
+        max_id_y = std::min<decltype(max_id_y)>(max_id_y, cnt_y - 1);
+        max_id_z = std::min<decltype(max_id_z)>(max_id_z, cnt_z - 1);
 
-        // probably can be done faster with bfs
+        // a row of voxels along z is tested by packs of four, the voxel boxes are the extruded cells of the grid
+        const auto last_z = static_cast<size_t>(max_id_z);
         for (size_t x = min_id_x; x <= max_id_x; ++x)
         {
             for (size_t y = min_id_y; y <= max_id_y; ++y)
             {
-                for (size_t z = min_id_z; z <= max_id_z; ++z)
+                for (size_t z = min_id_z; z <= last_z; z += 4)
                 {
-                    BoundingBox voxel;
-                    voxel.AddPoint(Point3D(x * m_params.m_resolution_x, y * m_params.m_resolution_y, z * m_params.m_resolution_z) + bbox.GetMin());
-                    voxel.AddPoint(Point3D((x + 1) * m_params.m_resolution_x, (y + 1) * m_params.m_resolution_y, (z + 1) * m_params.m_resolution_z) + bbox.GetMin());
-                    ExtrudeInplace(voxel, m_params.m_precision);
-                    if (TriangleWithBBoxIntersection(*p_triangle, voxel))
+                    const auto voxels_count = std::min<size_t>(4, last_z + 1 - z);
+
+                    BoundingBoxPack4 voxels;
+                    for (size_t i = 0; i < voxels_count; ++i)
+                    {
+                        const size_t coordinates[3] = { x, y, z + i };
+                        for (short axis = 0; axis < 3; ++axis)
+                        {
+                            voxels.m_min[axis][i] = (coordinates[axis] * resolution[axis] + bbox_min[axis]) - i_precision;
+                            voxels.m_max[axis][i] = ((coordinates[axis] + 1) * resolution[axis] + bbox_min[axis]) + i_precision;
+                        }
+                    }
+
+                    const auto intersections = TriangleWithBBoxesIntersection(i_triangle, voxels);
+                    for (size_t i = 0; i < voxels_count; ++i)
                     {
-                        auto p_voxel = p_voxel_grid->GetOrCreateVoxel(std::array<size_t, 3>{ x, y, z });
-                        p_voxel->AddTriangle(p_triangle);
+                        if (intersections & (1u << i))
+                        {
+                            VoxelGrid::Entry entry;
+                            entry.m_voxel_index = i_grid.GetVoxelIndexFromCoordinates({ x, y, z + i });
+                            entry.m_triangle_index = i_triangle_index;
+                            o_entries.emplace_back(entry);
+                        }
                     }
                 }
             }
         }
     }
 
+    // every buffer is sorted on its own, then the buffers are merged pairwise, every round of merges runs in parallel
+    std::vector<VoxelGrid::Entry> _SortAndMerge(WorkStealingThreadPool& i_pool, std::vector<std::vector<VoxelGrid::Entry>>& io_buffers)
+    {
+        if (io_buffers.empty())
+            return {};
+
+        i_pool.ParallelFor(io_buffers.size(), 1, [&io_buffers](size_t i_begin, size_t i_end)
+        {
+            for (auto i = i_begin; i < i_end; ++i)
+                std::sort(io_buffers[i].begin(), io_buffers[i].end(), _EntryLess);
+        });
+
+        while (io_buffers.size() > 1)
+        {
+            std::vector<std::vector<VoxelGrid::Entry>> merged((io_buffers.size() + 1) / 2);
+            i_pool.ParallelFor(merged.size(), 1, [&io_buffers, &merged](size_t i_begin, size_t i_end)
+            {
+                for (auto i = i_begin; i < i_end; ++i)
+                {
+                    auto& first = io_buffers[2 * i];
+                    if (2 * i + 1 == io_buffers.size())
+                    {
+                        merged[i] = std::move(first);
+                        continue;
+                    }
+
+                    auto& second = io_buffers[2 * i + 1];
+                    merged[i].resize(first.size() + second.size());
+                    std::merge(first.begin(), first.end(), second.begin(), second.end(), merged[i].begin(), _EntryLess);
+                    std::vector<VoxelGrid::Entry>().swap(first);
+                    std::vector<VoxelGrid::Entry>().swap(second);
+                }
+            });
+            io_buffers.swap(merged);
+        }
+
+        return std::move(io_buffers.front());
+    }
+
+    // i_get_triangle(i, o_index) returns the i-th triangle and sets the index it gets in the grid
+    template<typename GetTriangle>
+    std::vector<VoxelGrid::Entry> _CollectEntries(const Voxelizer::Params& i_params, const VoxelGrid& i_grid, size_t i_count, const GetTriangle& i_get_triangle)
+    {
+        std::unique_ptr<WorkStealingThreadPool> p_own_pool;
+        if (i_params.m_threads_count != 0)
+            p_own_pool = std::make_unique<WorkStealingThreadPool>(i_params.m_threads_count);
+        auto& pool = p_own_pool ? *p_own_pool : WorkStealingThreadPool::GetGlobalInstance();
+
+        // every task has its own buffer, after sorting the result doesn't depend on the order in which tasks were run
+        const auto tasks_count = (i_count + TRIANGLES_PER_TASK - 1) / TRIANGLES_PER_TASK;
+        std::vector<std::vector<VoxelGrid::Entry>> buffers(tasks_count);
+        pool.ParallelFor(i_count, TRIANGLES_PER_TASK, [&](size_t i_begin, size_t i_end)
+        {
+            auto& buffer = buffers[i_begin / TRIANGLES_PER_TASK];
+            for (auto i = i_begin; i < i_end; ++i)
+            {
+                std::uint32_t index = 0;
+                const auto& triangle = i_get_triangle(i, index);
+                _VoxelizeTriangle(triangle, index, i_grid, i_params.m_precision, buffer);
+            }
+        });
+
+        return _SortAndMerge(pool, buffers);
+    }
+}
+
+
+void Voxelizer::SetParams(const Params& i_params)
+{
+    m_params = i_params;
+}
+
+std::unique_ptr<VoxelGrid> Voxelizer::_CreateGrid(const BoundingBox& i_bbox) const
+{
+    const auto cnt_x = static_cast<size_t>(std::max(1., std::ceil((i_bbox.GetDeltaX() + m_params.m_precision) / m_params.m_resolution_x)));
+    const auto cnt_y = static_cast<size_t>(std::max(1., std::ceil((i_bbox.GetDeltaY() + m_params.m_precision) / m_params.m_resolution_y)));
+    const auto cnt_z = static_cast<size_t>(std::max(1., std::ceil((i_bbox.GetDeltaZ() + m_params.m_precision) / m_params.m_resolution_z)));
+
+    return std::make_unique<VoxelGrid>(std::array<double, 3>{ m_params.m_resolution_x, m_params.m_resolution_y, m_params.m_resolution_z },
+                                       std::array<size_t, 3>{ cnt_x, cnt_y, cnt_z },
+                                       i_bbox);
+}
+
+std::unique_ptr<VoxelGrid> Voxelizer::Voxelize(const std::vector<Triangle*>& i_triangles)
+{
+    BoundingBox bbox;
+    for (const auto& p_triangle : i_triangles)
+    {
+        bbox.AddPoint(p_triangle->GetPoint(0));
+        bbox.AddPoint(p_triangle->GetPoint(1));
+        bbox.AddPoint(p_triangle->GetPoint(2));
+    }
+    auto p_voxel_grid = _CreateGrid(bbox);
+
+    // pairs (voxel, triangle) are collected first, so the grid can lay out every voxel in one go
+    auto entries = CollectEntries(*p_voxel_grid, i_triangles);
+    p_voxel_grid->Fill(i_triangles, entries, m_params.m_storage_type);
+
     return std::move(p_voxel_grid);
 }
 
+std::unique_ptr<VoxelGrid> Voxelizer::Voxelize(const TriangleSoup& i_triangles)
+{
+    BoundingBox bbox;
+    for (std::uint32_t i = 0; i < i_triangles.GetTrianglesCount(); ++i)
+    {
+        const auto p_vertices = i_triangles.GetVertices(i);
+        for (short vertex = 0; vertex < 3; ++vertex)
+            bbox.AddPoint(ToPoint3D(p_vertices[vertex]));
+    }
+    auto p_voxel_grid = _CreateGrid(bbox);
+
+    auto entries = CollectEntries(*p_voxel_grid, i_triangles, 0, i_triangles.GetTrianglesCount());
+    p_voxel_grid->Fill(i_triangles.GetTrianglesCount(), entries, m_params.m_storage_type);
+
+    return std::move(p_voxel_grid);
+}
+
+std::vector<VoxelGrid::Entry> Voxelizer::CollectEntries(const VoxelGrid& i_grid, const std::vector<Triangle*>& i_triangles, std::uint32_t i_first_triangle_index) const
+{
+    return _CollectEntries(m_params, i_grid, i_triangles.size(), [&i_triangles, i_first_triangle_index](size_t i, std::uint32_t& o_index) -> const Triangle&
+    {
+        o_index = static_cast<std::uint32_t>(i_first_triangle_index + i);
+        return *i_triangles[i];
+    });
+}
+
+std::vector<VoxelGrid::Entry> Voxelizer::CollectEntries(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, std::uint32_t i_first_triangle, size_t i_count) const
+{
+    Q_ASSERT(i_first_triangle + i_count <= i_triangles.GetTrianglesCount());
+    return _CollectEntries(m_params, i_grid, i_count, [&i_triangles, i_first_triangle](size_t i, std::uint32_t& o_index)
+    {
+        o_index = static_cast<std::uint32_t>(i_first_triangle + i);
+        return i_triangles.GetTriangle(o_index);
+    });
+}
+
+std::vector<VoxelGrid::Entry> Voxelizer::CollectEntries(const VoxelGrid& i_grid, const TriangleSoup& i_triangles, const std::vector<std::uint32_t>& i_triangle_indexes) const
+{
+    return _CollectEntries(m_params, i_grid, i_triangle_indexes.size(), [&i_triangles, &i_triangle_indexes](size_t i, std::uint32_t& o_index)
+    {
+        o_index = i_triangle_indexes[i];
+        Q_ASSERT(o_index < i_triangles.GetTrianglesCount());
+        return i_triangles.GetTriangle(o_index);
+    });
+}
+
 std::unique_ptr<VoxelGrid> Voxelizer::Voxelize(const Mesh& i_mesh)
 {
     std::vector<Triangle*> triangles;
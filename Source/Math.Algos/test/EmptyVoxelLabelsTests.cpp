@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include "EmptyVoxelLabels.h"
+
+#include <Math.Core/BoundingBox.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include "TestScenes.h"
+
+#include <limits>
+
+using namespace ::testing;
+
+namespace
+{
+    std::uint32_t _GetExpectedLabel(const TestBoxes& i_boxes, const VoxelGrid& i_grid, const std::array<size_t, 3>& i_coordinates,
+                                    const std::vector<std::uint32_t>& i_present_boxes)
+    {
+        if (i_grid.HasVoxel(i_coordinates))
+            return EmptyVoxelLabels::NOT_EMPTY;
+        const auto voxel_box = i_grid.GetVoxelBoundingBox(i_coordinates);
+        const auto box = i_boxes.Classify((voxel_box.GetMin() + voxel_box.GetMax()) / 2, i_present_boxes);
+        return box == std::numeric_limits<size_t>::max() ? EmptyVoxelLabels::OUTSIDE : static_cast<std::uint32_t>(box);
+    }
+
+    // calls i_check for every voxel of the grid until it fails
+    template<typename TCheck>
+    void _ForEachVoxel(const VoxelGrid& i_grid, TCheck i_check)
+    {
+        const auto& num_voxels = i_grid.GetNumVoxels();
+        for (size_t z = 0; z < num_voxels[2]; ++z)
+            for (size_t y = 0; y < num_voxels[1]; ++y)
+                for (size_t x = 0; x < num_voxels[0]; ++x)
+                {
+                    i_check({ x, y, z });
+                    if (Test::HasFailure())
+                        return;
+                }
+    }
+
+    void _ExpectEqualLabels(const VoxelGrid& i_grid, const EmptyVoxelLabels& i_updated, const EmptyVoxelLabels& i_built)
+    {
+        _ForEachVoxel(i_grid, [&](const std::array<size_t, 3>& i_coordinates)
+        {
+            EXPECT_EQ(i_built.GetLabel(i_coordinates), i_updated.GetLabel(i_coordinates))
+                << "voxel " << i_coordinates[0] << " " << i_coordinates[1] << " " << i_coordinates[2];
+        });
+    }
+
+    auto _MakeClassify(const TestBoxes& i_boxes, const std::vector<std::uint32_t>& i_present_boxes)
+    {
+        return [&i_boxes, i_present_boxes](const Point3D& i_point) { return i_boxes.Classify(i_point, i_present_boxes); };
+    }
+
+    class EmptyVoxelLabelsTests : public TestWithParam<VoxelGrid::StorageType>
+    {
+    protected:
+        TestBoxes m_boxes = TestBoxes(0.7);
+    };
+}
+
+TEST_P(EmptyVoxelLabelsTests, BuildLabelsInsideAndOutsideOfClosedBoxes)
+{
+    const std::vector<std::uint32_t> present_boxes = { 0, 1, 2 };
+    const auto p_grid = m_boxes.MakeGrid(present_boxes, GetParam());
+
+    EmptyVoxelLabels labels;
+    EXPECT_FALSE(labels.IsBuilt());
+    labels.Build(*p_grid, _MakeClassify(m_boxes, present_boxes));
+    ASSERT_TRUE(labels.IsBuilt());
+
+    size_t counts[3] = {};
+    _ForEachVoxel(*p_grid, [&](const std::array<size_t, 3>& i_coordinates)
+    {
+        const auto label = labels.GetLabel(i_coordinates);
+        EXPECT_EQ(_GetExpectedLabel(m_boxes, *p_grid, i_coordinates, present_boxes), label)
+            << "voxel " << i_coordinates[0] << " " << i_coordinates[1] << " " << i_coordinates[2];
+        if (label < 3)
+            ++counts[label];
+    });
+    // every box has empty voxels inside, box 0 around box 1
+    EXPECT_GT(counts[0], 0u);
+    EXPECT_GT(counts[1], 0u);
+    EXPECT_GT(counts[2], 0u);
+
+    labels.Clear();
+    EXPECT_FALSE(labels.IsBuilt());
+}
+
+TEST_P(EmptyVoxelLabelsTests, UpdateAfterAddingBoxEqualsBuild)
+{
+    for (const std::uint32_t added_box : { 1u, 2u })
+    {
+        std::vector<std::uint32_t> present_boxes = { 0, 1, 2 };
+        present_boxes.erase(present_boxes.begin() + added_box);
+        const auto p_grid = m_boxes.MakeGrid(present_boxes, GetParam());
+        EmptyVoxelLabels updated;
+        updated.Build(*p_grid, _MakeClassify(m_boxes, present_boxes));
+
+        auto entries = m_boxes.CollectEntries(*p_grid, added_box);
+        p_grid->Insert(entries);
+        present_boxes.push_back(added_box);
+        std::array<size_t, 3> min, max;
+        m_boxes.GetBoxVoxels(*p_grid, added_box, min, max);
+        updated.Update(*p_grid, min, max, _MakeClassify(m_boxes, present_boxes));
+
+        EmptyVoxelLabels built;
+        built.Build(*p_grid, _MakeClassify(m_boxes, present_boxes));
+        SCOPED_TRACE(added_box);
+        _ExpectEqualLabels(*p_grid, updated, built);
+        _ForEachVoxel(*p_grid, [&](const std::array<size_t, 3>& i_coordinates)
+        {
+            EXPECT_EQ(_GetExpectedLabel(m_boxes, *p_grid, i_coordinates, present_boxes), updated.GetLabel(i_coordinates));
+        });
+    }
+}
+
+TEST_P(EmptyVoxelLabelsTests, UpdateAfterRemovingBoxEqualsBuild)
+{
+    for (const std::uint32_t removed_box : { 1u, 2u })
+    {
+        std::vector<std::uint32_t> present_boxes = { 0, 1, 2 };
+        const auto p_grid = m_boxes.MakeGrid(present_boxes, GetParam());
+        EmptyVoxelLabels updated;
+        updated.Build(*p_grid, _MakeClassify(m_boxes, present_boxes));
+
+        auto entries = m_boxes.CollectEntries(*p_grid, removed_box);
+        p_grid->Remove(entries);
+        present_boxes.erase(present_boxes.begin() + removed_box);
+        std::array<size_t, 3> min, max;
+        m_boxes.GetBoxVoxels(*p_grid, removed_box, min, max);
+        updated.Update(*p_grid, min, max, _MakeClassify(m_boxes, present_boxes));
+
+        EmptyVoxelLabels built;
+        built.Build(*p_grid, _MakeClassify(m_boxes, present_boxes));
+        SCOPED_TRACE(removed_box);
+        _ExpectEqualLabels(*p_grid, updated, built);
+        _ForEachVoxel(*p_grid, [&](const std::array<size_t, 3>& i_coordinates)
+        {
+            EXPECT_EQ(_GetExpectedLabel(m_boxes, *p_grid, i_coordinates, present_boxes), updated.GetLabel(i_coordinates));
+        });
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(StorageTypes, EmptyVoxelLabelsTests,
+                        Values(VoxelGrid::StorageType::Dense, VoxelGrid::StorageType::Sparse, VoxelGrid::StorageType::Bricks));
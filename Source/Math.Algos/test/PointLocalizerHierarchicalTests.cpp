@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <Math.Algos/PointLocalizerHierarchical.h>
+#include <Math.Algos/PointLocalizerVoxelized.h>
+
+#include <Math.Core/TransformMatrix.h>
+
+#include "TestScenes.h"
+
+#include <tuple>
+
+using namespace ::testing;
+
+namespace
+{
+    // parts are cells of a 2x2x2 grid, so the corner parts 0 and 7 span the top grid of the whole scene
+    const TestScene& _GetScene()
+    {
+        static const TestScene scene(SceneGenerator::Shape::Sphere, 8, 8000, 3000, 13);
+        return scene;
+    }
+
+    PointLocalizerHierarchical::Params _GetParams(PointLocalizerHierarchical::Classification i_classification, bool i_label_empty_cells)
+    {
+        PointLocalizerHierarchical::Params params;
+        params.m_classification = i_classification;
+        params.m_label_empty_cells = i_label_empty_cells;
+        params.m_threads_count = 2;
+        return params;
+    }
+
+    // answers of the voxelized localizer built from scratch over i_parts
+    std::vector<size_t> _LocalizeVoxelized(const std::vector<size_t>& i_parts)
+    {
+        const auto& scene = _GetScene();
+        PointLocalizerVoxelized::Params params;
+        params.m_voxel_size_x = params.m_voxel_size_y = params.m_voxel_size_z = 0.15;
+        params.m_threads_count = 2;
+        PointLocalizerVoxelized localizer;
+        for (const auto part : i_parts)
+            localizer.AddMesh(*scene.m_meshes[part], TransformMatrix{});
+        localizer.Build(params);
+        return LocalizeParts(localizer, scene.m_points, i_parts);
+    }
+
+    // LocalizeBatch must give the answers of Localize, returns them translated to parts
+    std::vector<size_t> _LocalizeHierarchical(const PointLocalizerHierarchical& i_localizer, const std::vector<size_t>& i_mesh_parts)
+    {
+        const auto& scene = _GetScene();
+        auto parts = LocalizeParts(i_localizer, scene.m_points, i_mesh_parts);
+
+        std::vector<size_t> batch_meshes;
+        PointLocalizerHierarchical::ReturnCode return_code = PointLocalizerHierarchical::ReturnCode::GridWasNotBuild;
+        i_localizer.LocalizeBatch(scene.m_points, batch_meshes, &return_code);
+        EXPECT_EQ(PointLocalizerHierarchical::ReturnCode::Ok, return_code);
+        for (auto& mesh : batch_meshes)
+            mesh = mesh < i_mesh_parts.size() ? i_mesh_parts[mesh] : mesh;
+        EXPECT_EQ(parts, batch_meshes);
+        return parts;
+    }
+}
+
+class PointLocalizerHierarchicalTest : public TestWithParam<std::tuple<PointLocalizerHierarchical::Classification, bool>>
+{
+};
+
+TEST_P(PointLocalizerHierarchicalTest, SameAnswersAsVoxelizedAfterRemoveAndAddMesh)
+{
+    const auto& scene = _GetScene();
+    const auto params = _GetParams(std::get<0>(GetParam()), std::get<1>(GetParam()));
+
+    std::vector<size_t> mesh_parts;
+    PointLocalizerHierarchical localizer;
+    std::vector<size_t> not_built_meshes;
+    PointLocalizerHierarchical::ReturnCode return_code = PointLocalizerHierarchical::ReturnCode::Ok;
+    localizer.LocalizeBatch(scene.m_points, not_built_meshes, &return_code);
+    EXPECT_EQ(PointLocalizerHierarchical::ReturnCode::GridWasNotBuild, return_code);
+
+    for (size_t part = 0; part < scene.m_meshes.size(); ++part)
+    {
+        EXPECT_EQ(localizer.AddMesh(*scene.m_meshes[part], TransformMatrix{}), part);
+        mesh_parts.push_back(part);
+    }
+    localizer.Build(params);
+    auto answers = _LocalizeHierarchical(localizer, mesh_parts);
+    EXPECT_EQ(answers, _LocalizeVoxelized(mesh_parts));
+    EXPECT_EQ(answers, scene.m_parts);
+
+    ASSERT_TRUE(localizer.RemoveMesh(2));
+    ASSERT_TRUE(localizer.RemoveMesh(5));
+    EXPECT_FALSE(localizer.RemoveMesh(5));
+    answers = _LocalizeHierarchical(localizer, mesh_parts);
+    EXPECT_EQ(answers, _LocalizeVoxelized({ 0, 1, 3, 4, 6, 7 }));
+
+    // the part fits into the top grid, only the sub-grids of its cells are built again
+    const auto top_grid = localizer.GetTopGrid().lock();
+    mesh_parts.push_back(5);
+    EXPECT_EQ(localizer.AddMesh(*scene.m_meshes[5], TransformMatrix{}), mesh_parts.size() - 1);
+    EXPECT_EQ(localizer.GetTopGrid().lock(), top_grid);
+    answers = _LocalizeHierarchical(localizer, mesh_parts);
+    EXPECT_EQ(answers, _LocalizeVoxelized({ 0, 1, 3, 4, 5, 6, 7 }));
+}
+
+INSTANTIATE_TEST_CASE_P(Classifications, PointLocalizerHierarchicalTest,
+                        Combine(Values(PointLocalizerHierarchical::Classification::NearestTriangle, PointLocalizerHierarchical::Classification::RayParity),
+                                Bool()));
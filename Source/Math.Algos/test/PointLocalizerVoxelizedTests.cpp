@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <Math.Algos/PointLocalizerVoxelized.h>
+
+#include <Math.Core/TransformMatrix.h>
+
+#include "TestScenes.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+using namespace ::testing;
+
+namespace
+{
+    // parts are cells of a 2x2x2 grid, so the corner parts 0 and 7 span the voxelization of the whole scene
+    const TestScene& _GetScene()
+    {
+        static const TestScene scene(SceneGenerator::Shape::Sphere, 8, 8000, 3000, 11);
+        return scene;
+    }
+
+    PointLocalizerVoxelized::Params _GetParams(VoxelGrid::StorageType i_storage_type, PointLocalizerVoxelized::Classification i_classification)
+    {
+        PointLocalizerVoxelized::Params params;
+        params.m_voxel_size_x = params.m_voxel_size_y = params.m_voxel_size_z = 0.15;
+        params.m_storage_type = i_storage_type;
+        params.m_classification = i_classification;
+        params.m_use_corner_distances = true;
+        params.m_threads_count = 2;
+        return params;
+    }
+
+    // answers of a localizer built from scratch over i_parts
+    std::vector<size_t> _LocalizeWithFullBuild(const std::vector<size_t>& i_parts, const PointLocalizerVoxelized::Params& i_params)
+    {
+        const auto& scene = _GetScene();
+        PointLocalizerVoxelized localizer;
+        for (const auto part : i_parts)
+            localizer.AddMesh(*scene.m_meshes[part], TransformMatrix{});
+        localizer.Build(i_params);
+        return LocalizeParts(localizer, scene.m_points, i_parts);
+    }
+
+    // known answers of the scene when only i_parts are present
+    std::vector<size_t> _GetExpectedParts(const std::vector<size_t>& i_parts)
+    {
+        auto result = _GetScene().m_parts;
+        for (auto& part : result)
+        {
+            if (std::find(i_parts.begin(), i_parts.end(), part) == i_parts.end())
+                part = std::numeric_limits<size_t>::max();
+        }
+        return result;
+    }
+}
+
+class PointLocalizerVoxelizedEditTest : public TestWithParam<std::tuple<VoxelGrid::StorageType, PointLocalizerVoxelized::Classification>>
+{
+};
+
+TEST_P(PointLocalizerVoxelizedEditTest, RemoveAndAddMeshGiveSameAnswersAsBuild)
+{
+    const auto& scene = _GetScene();
+    const auto params = _GetParams(std::get<0>(GetParam()), std::get<1>(GetParam()));
+
+    std::vector<size_t> mesh_parts;
+    PointLocalizerVoxelized localizer;
+    for (size_t part = 0; part < scene.m_meshes.size(); ++part)
+    {
+        EXPECT_EQ(localizer.AddMesh(*scene.m_meshes[part], TransformMatrix{}), part);
+        mesh_parts.push_back(part);
+    }
+    localizer.Build(params);
+    EXPECT_EQ(LocalizeParts(localizer, scene.m_points, mesh_parts), scene.m_parts);
+
+    ASSERT_TRUE(localizer.RemoveMesh(2));
+    ASSERT_TRUE(localizer.RemoveMesh(5));
+    const std::vector<size_t> remaining_parts = { 0, 1, 3, 4, 6, 7 };
+    auto answers = LocalizeParts(localizer, scene.m_points, mesh_parts);
+    EXPECT_EQ(answers, _LocalizeWithFullBuild(remaining_parts, params));
+    EXPECT_EQ(answers, _GetExpectedParts(remaining_parts));
+
+    // the part fits into the voxelization, it is inserted without a new Build
+    const auto grid = localizer.GetCachedGrid().lock();
+    mesh_parts.push_back(5);
+    EXPECT_EQ(localizer.AddMesh(*scene.m_meshes[5], TransformMatrix{}), mesh_parts.size() - 1);
+    EXPECT_EQ(localizer.GetCachedGrid().lock(), grid);
+    const std::vector<size_t> parts = { 0, 1, 3, 4, 5, 6, 7 };
+    answers = LocalizeParts(localizer, scene.m_points, mesh_parts);
+    EXPECT_EQ(answers, _LocalizeWithFullBuild(parts, params));
+    EXPECT_EQ(answers, _GetExpectedParts(parts));
+}
+
+INSTANTIATE_TEST_CASE_P(Storages, PointLocalizerVoxelizedEditTest,
+                        Combine(Values(VoxelGrid::StorageType::Sparse, VoxelGrid::StorageType::Dense, VoxelGrid::StorageType::Bricks),
+                                Values(PointLocalizerVoxelized::Classification::NearestTriangle, PointLocalizerVoxelized::Classification::RayParity)));
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <Math.Algos/PointLocalizerBVH.h>
+#include <Math.Algos/PointLocalizerVoxelized.h>
+
+#include <Math.Core/BasicPoint3.h>
+#include <Math.Core/Mesh.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/TransformMatrix.h>
+
+#include <limits>
+#include <tuple>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+    constexpr auto OUTSIDE = std::numeric_limits<size_t>::max();
+
+    struct Query
+    {
+        Point3D m_point;
+        size_t m_mesh_index;
+    };
+
+    // cube [0, 2]^3 of 12 triangles, the diagonals of the sides pass through their centers
+    void _BuildCube(Mesh& o_mesh)
+    {
+        std::vector<BasicPoint3D> nodes;
+        for (auto i = 0u; i < 8; ++i)
+            nodes.push_back({ { (i & 1) ? 2. : 0., (i & 2) ? 2. : 0., (i & 4) ? 2. : 0. } });
+        const std::vector<std::uint32_t> faces = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                                                   2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+        o_mesh.BuildFromIndexedArrays(nodes, faces);
+    }
+
+    // octahedron |x| + |y| + |z| <= 1 moved by i_offset along x
+    void _BuildOctahedron(Mesh& o_mesh, double i_offset)
+    {
+        const std::vector<BasicPoint3D> nodes = { { { i_offset + 1, 0, 0 } }, { { i_offset - 1, 0, 0 } }, { { i_offset, 1, 0 } },
+                                                  { { i_offset, -1, 0 } }, { { i_offset, 0, 1 } }, { { i_offset, 0, -1 } } };
+        const std::vector<std::uint32_t> faces = { 0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5 };
+        o_mesh.BuildFromIndexedArrays(nodes, faces);
+    }
+
+    // Rays of the queries pass through vertices, edges and diagonals of the sides. A point on a side is classified as if
+    // it were moved by an infinitely small offset towards +y and +z, like the crossings are
+    std::vector<Query> _GetQueries()
+    {
+        std::vector<Query> queries;
+        for (const auto x : { -0.5, 0.5, 1.5, 2.5 })
+        {
+            for (auto y = -1; y <= 3; ++y)
+            {
+                for (auto z = -1; z <= 3; ++z)
+                {
+                    const bool is_inside = x > 0 && x < 2 && y >= 0 && y < 2 && z >= 0 && z < 2;
+                    queries.push_back({ Point3D(x, y, z), is_inside ? 0 : OUTSIDE });
+                }
+            }
+        }
+
+        // the octahedron is behind the cube along +X, rays to it pass through its vertices and edges and often through the cube
+        const double offset = 5;
+        queries.push_back({ Point3D(offset - 0.5, 0, 0), 1 });
+        queries.push_back({ Point3D(offset + 0.9, 0, 0), 1 });
+        queries.push_back({ Point3D(offset + 0.25, 0.25, 0), 1 });
+        queries.push_back({ Point3D(offset - 0.2, 0, 0.5), 1 });
+        queries.push_back({ Point3D(offset - 0.2, 0.3, -0.3), 1 });
+        queries.push_back({ Point3D(offset - 2, 0, 0), OUTSIDE });
+        queries.push_back({ Point3D(offset - 2, 0.25, 0), OUTSIDE });
+        queries.push_back({ Point3D(offset - 2, 0, 0.5), OUTSIDE });
+        queries.push_back({ Point3D(offset + 0.6, 0.6, 0), OUTSIDE });
+        queries.push_back({ Point3D(offset + 2, 0, 0), OUTSIDE });
+        queries.push_back({ Point3D(1, 1, 0.5), 0 });
+        queries.push_back({ Point3D(-1, 0.5, 0.5), OUTSIDE });
+        return queries;
+    }
+
+    template<typename TLocalizer>
+    void _AddMeshes(TLocalizer& io_localizer)
+    {
+        Mesh cube;
+        _BuildCube(cube);
+        Mesh octahedron;
+        _BuildOctahedron(octahedron, 5);
+        EXPECT_EQ(io_localizer.AddMesh(cube, TransformMatrix{}), 0u);
+        EXPECT_EQ(io_localizer.AddMesh(octahedron, TransformMatrix{}), 1u);
+    }
+
+    template<typename TLocalizer>
+    void _ExpectQueries(const TLocalizer& i_localizer)
+    {
+        for (const auto& query : _GetQueries())
+        {
+            EXPECT_EQ(i_localizer.Localize(query.m_point), query.m_mesh_index)
+                << query.m_point.GetX() << " " << query.m_point.GetY() << " " << query.m_point.GetZ();
+        }
+    }
+}
+
+TEST(RayParity, BVHCountsCrossingsThroughEdgesAndVertices)
+{
+    PointLocalizerBVH localizer;
+    _AddMeshes(localizer);
+    PointLocalizerBVH::Params params;
+    params.m_classification = PointLocalizerBVH::Classification::RayParity;
+    localizer.Build(params);
+    _ExpectQueries(localizer);
+}
+
+class RayParityVoxelizedTest : public TestWithParam<std::tuple<double, bool>>
+{
+};
+
+// voxel size 0.25 puts the vertices and the edges on the faces of the voxels, 0.3 puts them inside the voxels
+TEST_P(RayParityVoxelizedTest, VoxelColumnCountsCrossingsThroughEdgesAndVertices)
+{
+    PointLocalizerVoxelized localizer;
+    _AddMeshes(localizer);
+    PointLocalizerVoxelized::Params params;
+    params.m_voxel_size_x = params.m_voxel_size_y = params.m_voxel_size_z = std::get<0>(GetParam());
+    params.m_classification = PointLocalizerVoxelized::Classification::RayParity;
+    params.m_label_empty_voxels = std::get<1>(GetParam());
+    localizer.Build(params);
+    _ExpectQueries(localizer);
+
+    std::vector<Point3D> points;
+    std::vector<size_t> expected;
+    for (const auto& query : _GetQueries())
+    {
+        points.push_back(query.m_point);
+        expected.push_back(query.m_mesh_index);
+    }
+    std::vector<size_t> mesh_indexes;
+    localizer.LocalizeBatch(points, mesh_indexes);
+    EXPECT_EQ(mesh_indexes, expected);
+}
+
+INSTANTIATE_TEST_CASE_P(VoxelSizes, RayParityVoxelizedTest, Combine(Values(0.25, 0.3), Bool()));
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <Math.Algos/PointLocalizerBVH.h>
+#include <Math.Algos/PointLocalizerVoxelized.h>
+#include <Math.Algos/SceneGenerator.h>
+
+#include <Math.Core/TransformMatrix.h>
+
+#include "TestScenes.h"
+
+#include <limits>
+#include <numeric>
+
+using namespace ::testing;
+
+namespace
+{
+    const size_t PARTS_COUNT = 8;
+    const size_t POINTS_COUNT = 2000;
+    const std::uint32_t SEED = 21;
+
+    std::vector<size_t> _GetMeshParts()
+    {
+        std::vector<size_t> result(PARTS_COUNT);
+        std::iota(result.begin(), result.end(), 0);
+        return result;
+    }
+}
+
+class SceneGeneratorTest : public TestWithParam<SceneGenerator::Shape>
+{
+protected:
+    TestScene m_scene = TestScene(GetParam(), PARTS_COUNT, 6000, POINTS_COUNT, SEED);
+};
+
+TEST_P(SceneGeneratorTest, SameSeedGivesSameScene)
+{
+    const TestScene scene(GetParam(), PARTS_COUNT, 6000, POINTS_COUNT, SEED);
+    ASSERT_EQ(m_scene.m_generator.GetPartsCount(), scene.m_generator.GetPartsCount());
+    for (size_t part = 0; part < scene.m_generator.GetPartsCount(); ++part)
+    {
+        EXPECT_EQ(m_scene.m_generator.GetPartVertices(part), scene.m_generator.GetPartVertices(part));
+        EXPECT_EQ(m_scene.m_generator.GetPartIndices(part), scene.m_generator.GetPartIndices(part));
+    }
+    EXPECT_EQ(m_scene.m_points, scene.m_points);
+    EXPECT_EQ(m_scene.m_parts, scene.m_parts);
+}
+
+TEST_P(SceneGeneratorTest, GroundTruthMatchesLocalizers)
+{
+    ASSERT_EQ(PARTS_COUNT, m_scene.m_generator.GetPartsCount());
+    ASSERT_EQ(POINTS_COUNT, m_scene.m_points.size());
+
+    // both inside and outside points are produced
+    size_t inside_count = 0;
+    for (size_t i = 0; i < m_scene.m_points.size(); ++i)
+    {
+        size_t part = 0;
+        ASSERT_TRUE(m_scene.m_generator.Locate(m_scene.m_points[i], part));
+        EXPECT_EQ(m_scene.m_parts[i], part);
+        inside_count += part != std::numeric_limits<size_t>::max();
+    }
+    EXPECT_GT(inside_count, 0u);
+    EXPECT_LT(inside_count, m_scene.m_points.size());
+
+    PointLocalizerBVH::Params bvh_params;
+    bvh_params.m_classification = PointLocalizerBVH::Classification::RayParity;
+    PointLocalizerBVH bvh_localizer;
+    PointLocalizerVoxelized voxelized_localizer;
+    for (const auto& p_mesh : m_scene.m_meshes)
+    {
+        bvh_localizer.AddMesh(*p_mesh, TransformMatrix{});
+        voxelized_localizer.AddMesh(*p_mesh, TransformMatrix{});
+    }
+    bvh_localizer.Build(bvh_params);
+    PointLocalizerVoxelized::Params voxelized_params;
+    voxelized_params.m_auto_voxel_size = true;
+    voxelized_params.m_threads_count = 2;
+    voxelized_localizer.Build(voxelized_params);
+
+    EXPECT_EQ(m_scene.m_parts, LocalizeParts(bvh_localizer, m_scene.m_points, _GetMeshParts()));
+    EXPECT_EQ(m_scene.m_parts, LocalizeParts(voxelized_localizer, m_scene.m_points, _GetMeshParts()));
+}
+
+INSTANTIATE_TEST_CASE_P(Shapes, SceneGeneratorTest,
+                        Values(SceneGenerator::Shape::Sphere, SceneGenerator::Shape::Torus, SceneGenerator::Shape::VoxelBlob,
+                               SceneGenerator::Shape::Sqrt3Sphere));
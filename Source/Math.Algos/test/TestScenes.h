@@ -0,0 +1,139 @@
+#pragma once
+
+#include <Math.Algos/SceneGenerator.h>
+#include <Math.Algos/Voxelizer.h>
+
+#include <Math.Core/Mesh.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/TriangleSoup.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// closed meshes of a generated scene with query points whose answers are known
+struct TestScene
+{
+    SceneGenerator m_generator;
+    std::vector<std::unique_ptr<Mesh>> m_meshes; // m_meshes[i] is part i
+    std::vector<Point3D> m_points;
+    std::vector<size_t> m_parts; // part of m_points[i], std::numeric_limits<size_t>::max() outside
+
+    TestScene(SceneGenerator::Shape i_shape, size_t i_parts_count, size_t i_triangles_count, size_t i_points_count, std::uint32_t i_seed)
+    {
+        SceneGenerator::Params params;
+        params.m_shape = i_shape;
+        params.m_parts_count = i_parts_count;
+        params.m_triangles_count = i_triangles_count;
+        params.m_seed = i_seed;
+        m_generator.Generate(params);
+
+        for (size_t i = 0; i < m_generator.GetPartsCount(); ++i)
+        {
+            m_meshes.push_back(std::make_unique<Mesh>());
+            m_generator.BuildPartMesh(i, *m_meshes.back());
+        }
+        m_generator.GeneratePoints(i_points_count, SceneGenerator::PointsDistribution::Clustered, i_seed + 1, m_points, m_parts);
+    }
+};
+
+// answers of a localizer translated to parts, i_mesh_parts[i] is the part of mesh i of the localizer
+template<typename TLocalizer>
+std::vector<size_t> LocalizeParts(const TLocalizer& i_localizer, const std::vector<Point3D>& i_points, const std::vector<size_t>& i_mesh_parts)
+{
+    std::vector<size_t> parts;
+    parts.reserve(i_points.size());
+    for (const auto& point : i_points)
+    {
+        const auto mesh = i_localizer.Localize(point);
+        parts.push_back(mesh < i_mesh_parts.size() ? i_mesh_parts[mesh] : mesh);
+    }
+    return parts;
+}
+
+// Three closed boxes of 12 triangles in one soup, box i is mesh i and starts at triangle 12 * i:
+// box 1 is nested in box 0 and box 2 stands apart. Tests voxelize any subset of them into the grid of all three
+struct TestBoxes
+{
+    static constexpr std::uint32_t TRIANGLES_PER_BOX = 12;
+
+    TriangleSoup m_triangles;
+    std::vector<std::array<Point3D, 2>> m_boxes = { { Point3D(0, 0, 0), Point3D(10, 10, 10) },
+                                                    { Point3D(3, 3, 3), Point3D(6, 6, 6) },
+                                                    { Point3D(12, 1, 1), Point3D(15, 4, 4) } };
+    std::unique_ptr<VoxelGrid> mp_all_boxes_grid;
+
+    explicit TestBoxes(double i_voxel_size)
+    {
+        for (std::uint32_t box = 0; box < m_boxes.size(); ++box)
+        {
+            std::vector<Point3D> corners;
+            for (auto i = 0u; i < 8; ++i)
+                corners.emplace_back(m_boxes[box][i & 1].GetX(), m_boxes[box][(i >> 1) & 1].GetY(), m_boxes[box][i >> 2].GetZ());
+            const int faces[12][3] = { { 0, 2, 1 }, { 1, 2, 3 }, { 4, 5, 6 }, { 5, 7, 6 }, { 0, 1, 4 }, { 1, 5, 4 },
+                                       { 2, 6, 3 }, { 3, 6, 7 }, { 0, 4, 2 }, { 2, 4, 6 }, { 1, 3, 5 }, { 3, 7, 5 } };
+            for (const auto& face : faces)
+                m_triangles.AddTriangle(corners[face[0]], corners[face[1]], corners[face[2]], box);
+        }
+
+        Voxelizer::Params params;
+        params.m_resolution_x = params.m_resolution_y = params.m_resolution_z = i_voxel_size;
+        Voxelizer voxelizer;
+        voxelizer.SetParams(params);
+        mp_all_boxes_grid = voxelizer.Voxelize(m_triangles);
+    }
+
+    std::vector<VoxelGrid::Entry> CollectEntries(const VoxelGrid& i_grid, std::uint32_t i_box) const
+    {
+        return Voxelizer().CollectEntries(i_grid, m_triangles, i_box * TRIANGLES_PER_BOX, TRIANGLES_PER_BOX);
+    }
+
+    // grid of all boxes with the triangles of i_present_boxes only
+    std::unique_ptr<VoxelGrid> MakeGrid(const std::vector<std::uint32_t>& i_present_boxes, VoxelGrid::StorageType i_storage_type) const
+    {
+        auto p_grid = std::make_unique<VoxelGrid>(mp_all_boxes_grid->GetVoxelSize(), mp_all_boxes_grid->GetNumVoxels(), mp_all_boxes_grid->GetBoundingBox());
+        std::vector<VoxelGrid::Entry> entries;
+        for (const auto box : i_present_boxes)
+        {
+            const auto box_entries = CollectEntries(*p_grid, box);
+            entries.insert(entries.end(), box_entries.begin(), box_entries.end());
+        }
+        p_grid->Fill(m_triangles.GetTrianglesCount(), entries, i_storage_type);
+        return p_grid;
+    }
+
+    // innermost of i_present_boxes that contains the point or std::numeric_limits<size_t>::max()
+    size_t Classify(const Point3D& i_point, const std::vector<std::uint32_t>& i_present_boxes) const
+    {
+        auto result = std::numeric_limits<size_t>::max();
+        for (const auto box : i_present_boxes)
+        {
+            bool is_inside = true;
+            for (short axis = 0; axis < 3; ++axis)
+                is_inside = is_inside && m_boxes[box][0][axis] < i_point[axis] && i_point[axis] < m_boxes[box][1][axis];
+            if (is_inside && (result == std::numeric_limits<size_t>::max() || box == 1))
+                result = box;
+        }
+        return result;
+    }
+
+    // voxels of the grid that the triangles of the box touch
+    void GetBoxVoxels(const VoxelGrid& i_grid, std::uint32_t i_box, std::array<size_t, 3>& o_min, std::array<size_t, 3>& o_max) const
+    {
+        o_min = { std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max() };
+        o_max = { 0, 0, 0 };
+        for (const auto& entry : CollectEntries(i_grid, i_box))
+        {
+            const auto coordinates = i_grid.GetCoordinatesFromVoxelIndex(entry.m_voxel_index);
+            for (size_t axis = 0; axis < 3; ++axis)
+            {
+                o_min[axis] = std::min(o_min[axis], coordinates[axis]);
+                o_max[axis] = std::max(o_max[axis], coordinates[axis]);
+            }
+        }
+    }
+};
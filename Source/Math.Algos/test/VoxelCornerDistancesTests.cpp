@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include "VoxelCornerDistances.h"
+
+#include <Math.Core/BoundingBox.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include "TestScenes.h"
+
+#include <limits>
+#include <random>
+
+using namespace ::testing;
+
+namespace
+{
+    constexpr size_t THREADS_COUNT = 2;
+
+    // random points in the non-empty voxels of the grid with the voxels that contain them
+    void _GeneratePoints(const VoxelGrid& i_grid, std::vector<Point3D>& o_points, std::vector<std::array<size_t, 3>>& o_coordinates)
+    {
+        std::mt19937 generator(7);
+        const auto voxels = i_grid.GetExistingVoxelsCoordinates();
+        for (const auto& coordinates : voxels)
+        {
+            const auto voxel_box = i_grid.GetVoxelBoundingBox(coordinates);
+            for (auto i = 0; i < 4; ++i)
+            {
+                Point3D point;
+                for (short axis = 0; axis < 3; ++axis)
+                    point[axis] = std::uniform_real_distribution<double>(voxel_box.GetMin()[axis], voxel_box.GetMax()[axis])(generator);
+                o_points.push_back(point);
+                o_coordinates.push_back(coordinates);
+            }
+        }
+    }
+
+    // labels found near the corners agree with the boxes, returns the number of points that got a label
+    size_t _ExpectCorrectLabels(const TestBoxes& i_boxes, const VoxelGrid& i_grid, const VoxelCornerDistances& i_distances,
+                                const std::vector<std::uint32_t>& i_present_boxes)
+    {
+        std::vector<Point3D> points;
+        std::vector<std::array<size_t, 3>> coordinates;
+        _GeneratePoints(i_grid, points, coordinates);
+        size_t found_count = 0;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            std::uint32_t label = 0;
+            if (!i_distances.FindLabel(coordinates[i], points[i], label))
+                continue;
+            ++found_count;
+            const auto box = i_boxes.Classify(points[i], i_present_boxes);
+            EXPECT_EQ(box == std::numeric_limits<size_t>::max() ? VoxelCornerDistances::OUTSIDE : static_cast<std::uint32_t>(box), label)
+                << "point " << points[i].GetX() << " " << points[i].GetY() << " " << points[i].GetZ();
+            if (Test::HasFailure())
+                break;
+        }
+        return found_count;
+    }
+
+    void _ExpectEqualLabels(const VoxelGrid& i_grid, const VoxelCornerDistances& i_updated, const VoxelCornerDistances& i_built)
+    {
+        std::vector<Point3D> points;
+        std::vector<std::array<size_t, 3>> coordinates;
+        _GeneratePoints(i_grid, points, coordinates);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            std::uint32_t updated_label = 0, built_label = 0;
+            const auto updated_found = i_updated.FindLabel(coordinates[i], points[i], updated_label);
+            ASSERT_EQ(i_built.FindLabel(coordinates[i], points[i], built_label), updated_found)
+                << "point " << points[i].GetX() << " " << points[i].GetY() << " " << points[i].GetZ();
+            if (updated_found)
+                ASSERT_EQ(built_label, updated_label);
+        }
+    }
+
+    auto _MakeClassify(const TestBoxes& i_boxes, const std::vector<std::uint32_t>& i_present_boxes)
+    {
+        return [&i_boxes, i_present_boxes](const Point3D& i_point) { return i_boxes.Classify(i_point, i_present_boxes); };
+    }
+
+    class VoxelCornerDistancesTests : public TestWithParam<VoxelGrid::StorageType>
+    {
+    protected:
+        TestBoxes m_boxes = TestBoxes(0.7);
+    };
+}
+
+TEST_P(VoxelCornerDistancesTests, BuildLabelsInsideAndOutsideOfClosedBoxes)
+{
+    const std::vector<std::uint32_t> present_boxes = { 0, 1, 2 };
+    const auto p_grid = m_boxes.MakeGrid(present_boxes, GetParam());
+
+    VoxelCornerDistances distances;
+    EXPECT_FALSE(distances.IsBuilt());
+    distances.Build(*p_grid, m_boxes.m_triangles, THREADS_COUNT, _MakeClassify(m_boxes, present_boxes));
+    ASSERT_TRUE(distances.IsBuilt());
+
+    // the boxes stand at least a voxel apart, so most points of the non-empty voxels are near enough to a corner
+    const auto points_count = 4 * p_grid->GetExistingVoxelsCount();
+    EXPECT_GT(_ExpectCorrectLabels(m_boxes, *p_grid, distances, present_boxes), points_count / 4);
+
+    // no samples for empty voxels
+    std::uint32_t label = 0;
+    EXPECT_FALSE(distances.FindLabel(p_grid->GetCoordinatesForPoint(Point3D(11, 5, 5)), Point3D(11, 5, 5), label));
+
+    distances.Clear();
+    EXPECT_FALSE(distances.IsBuilt());
+}
+
+TEST_P(VoxelCornerDistancesTests, UpdateAfterAddingBoxEqualsBuild)
+{
+    for (const std::uint32_t added_box : { 1u, 2u })
+    {
+        std::vector<std::uint32_t> present_boxes = { 0, 1, 2 };
+        present_boxes.erase(present_boxes.begin() + added_box);
+        const auto p_grid = m_boxes.MakeGrid(present_boxes, GetParam());
+        VoxelCornerDistances updated;
+        updated.Build(*p_grid, m_boxes.m_triangles, THREADS_COUNT, _MakeClassify(m_boxes, present_boxes));
+
+        auto entries = m_boxes.CollectEntries(*p_grid, added_box);
+        p_grid->Insert(entries);
+        present_boxes.push_back(added_box);
+        std::array<size_t, 3> min, max;
+        m_boxes.GetBoxVoxels(*p_grid, added_box, min, max);
+        updated.Update(*p_grid, m_boxes.m_triangles, min, max, THREADS_COUNT, _MakeClassify(m_boxes, present_boxes));
+
+        VoxelCornerDistances built;
+        built.Build(*p_grid, m_boxes.m_triangles, THREADS_COUNT, _MakeClassify(m_boxes, present_boxes));
+        SCOPED_TRACE(added_box);
+        _ExpectEqualLabels(*p_grid, updated, built);
+        EXPECT_GT(_ExpectCorrectLabels(m_boxes, *p_grid, updated, present_boxes), 0u);
+    }
+}
+
+TEST_P(VoxelCornerDistancesTests, UpdateAfterRemovingBoxEqualsBuild)
+{
+    for (const std::uint32_t removed_box : { 1u, 2u })
+    {
+        std::vector<std::uint32_t> present_boxes = { 0, 1, 2 };
+        const auto p_grid = m_boxes.MakeGrid(present_boxes, GetParam());
+        VoxelCornerDistances updated;
+        updated.Build(*p_grid, m_boxes.m_triangles, THREADS_COUNT, _MakeClassify(m_boxes, present_boxes));
+
+        auto entries = m_boxes.CollectEntries(*p_grid, removed_box);
+        p_grid->Remove(entries);
+        present_boxes.erase(present_boxes.begin() + removed_box);
+        std::array<size_t, 3> min, max;
+        m_boxes.GetBoxVoxels(*p_grid, removed_box, min, max);
+        updated.Update(*p_grid, m_boxes.m_triangles, min, max, THREADS_COUNT, _MakeClassify(m_boxes, present_boxes));
+
+        VoxelCornerDistances built;
+        built.Build(*p_grid, m_boxes.m_triangles, THREADS_COUNT, _MakeClassify(m_boxes, present_boxes));
+        SCOPED_TRACE(removed_box);
+        _ExpectEqualLabels(*p_grid, updated, built);
+        EXPECT_GT(_ExpectCorrectLabels(m_boxes, *p_grid, updated, present_boxes), 0u);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(StorageTypes, VoxelCornerDistancesTests,
+                        Values(VoxelGrid::StorageType::Dense, VoxelGrid::StorageType::Sparse, VoxelGrid::StorageType::Bricks));
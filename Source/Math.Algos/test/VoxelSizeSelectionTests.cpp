@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include "VoxelSizeSelection.h"
+
+#include <Math.Algos/Voxelizer.h>
+
+#include <Math.Core/TransformMatrix.h>
+#include <Math.Core/TriangleSoup.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include "TestScenes.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace ::testing;
+
+namespace
+{
+    // the limit of SelectVoxelSize
+    constexpr double MAX_VOXELS_COUNT = 1 << 30;
+
+    double _GetVoxelsCount(const TriangleSoup& i_triangles, const std::array<double, 3>& i_voxel_size)
+    {
+        Point3D min(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+        Point3D max(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+        for (std::uint32_t triangle = 0; triangle < i_triangles.GetTrianglesCount(); ++triangle)
+        {
+            const auto p_vertices = i_triangles.GetVertices(triangle);
+            for (short i = 0; i < 3; ++i)
+            {
+                for (short axis = 0; axis < 3; ++axis)
+                {
+                    min[axis] = std::min(min[axis], p_vertices[i][axis]);
+                    max[axis] = std::max(max[axis], p_vertices[i][axis]);
+                }
+            }
+        }
+
+        double count = 1;
+        for (short axis = 0; axis < 3; ++axis)
+            count *= std::max(1., std::ceil((max[axis] - min[axis]) / i_voxel_size[axis]));
+        return count;
+    }
+
+    // average number of triangles in the non-empty voxels of the grid with the voxel size
+    double _GetTrianglesPerVoxel(const TriangleSoup& i_triangles, const std::array<double, 3>& i_voxel_size)
+    {
+        Voxelizer::Params params;
+        params.m_resolution_x = i_voxel_size[0];
+        params.m_resolution_y = i_voxel_size[1];
+        params.m_resolution_z = i_voxel_size[2];
+        Voxelizer voxelizer;
+        voxelizer.SetParams(params);
+        const auto p_grid = voxelizer.Voxelize(i_triangles);
+
+        double entries_count = 0;
+        const auto voxels = p_grid->GetExistingVoxelsCoordinates();
+        for (const auto& voxel : voxels)
+            entries_count += p_grid->GetVoxelTriangles(voxel).size();
+        return entries_count / voxels.size();
+    }
+}
+
+TEST(SelectVoxelSize, CapsVoxelsCountOfLongThinInput)
+{
+    // a strip of tiny triangles in the plane z = 0 and one more triangle far along x, the estimate alone gives ~10^10 voxels
+    TriangleSoup triangles;
+    for (int i = 0; i < 2000; ++i)
+    {
+        const double x = (i / 2) * 1e-3;
+        if (i % 2 == 0)
+            triangles.AddTriangle(Point3D(x, 0, 0), Point3D(x + 1e-3, 0, 0), Point3D(x, 1e-3, 0), 0);
+        else
+            triangles.AddTriangle(Point3D(x + 1e-3, 0, 0), Point3D(x + 1e-3, 1e-3, 0), Point3D(x, 1e-3, 0), 0);
+    }
+    triangles.AddTriangle(Point3D(1e7, 0, 0), Point3D(1e7 + 1e-3, 0, 0), Point3D(1e7, 1e-3, 0), 0);
+
+    for (const auto refine : { false, true })
+    {
+        const auto voxel_size = SelectVoxelSize(triangles, 4, refine);
+        const auto voxels_count = _GetVoxelsCount(triangles, voxel_size);
+        EXPECT_LE(voxels_count, MAX_VOXELS_COUNT);
+        // the thin axes have one voxel, so the long one gets all of the limit
+        EXPECT_GE(voxels_count, MAX_VOXELS_COUNT / 2);
+    }
+}
+
+TEST(SelectVoxelSize, MeetsTrianglesPerVoxelTarget)
+{
+    const TestScene scene(SceneGenerator::Shape::Sphere, 8, 40000, 0, 3);
+    TriangleSoup triangles;
+    for (size_t i = 0; i < scene.m_meshes.size(); ++i)
+        triangles.AddMesh(*scene.m_meshes[i], TransformMatrix{}, static_cast<std::uint32_t>(i));
+
+    for (const auto target : { 2., 4., 16. })
+    {
+        // the estimate is within a factor of two, voxelized blocks correct it further
+        const auto estimated = _GetTrianglesPerVoxel(triangles, SelectVoxelSize(triangles, target, false));
+        EXPECT_GT(estimated, target / 2) << target;
+        EXPECT_LT(estimated, target * 2) << target;
+
+        const auto refined = _GetTrianglesPerVoxel(triangles, SelectVoxelSize(triangles, target, true));
+        EXPECT_NEAR(refined, target, 0.25 * target) << target;
+    }
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <Math.Algos/Voxelizer.h>
+
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/TriangleSoup.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+    // voxels of a 4x4x4 grid of unit voxels from the origin that the voxelizer gives to i_triangle
+    std::vector<std::array<size_t, 3>> _GetVoxels(const Triangle& i_triangle, double i_precision)
+    {
+        BoundingBox bbox;
+        bbox.AddPoint(Point3D(0, 0, 0));
+        bbox.AddPoint(Point3D(4, 4, 4));
+        const VoxelGrid grid({ 1., 1., 1. }, { 4, 4, 4 }, bbox);
+
+        Voxelizer::Params params;
+        params.m_precision = i_precision;
+        params.m_threads_count = 1;
+        Voxelizer voxelizer;
+        voxelizer.SetParams(params);
+
+        std::vector<std::array<size_t, 3>> voxels;
+        for (const auto& entry : voxelizer.CollectEntries(grid, std::vector<Triangle*>{ const_cast<Triangle*>(&i_triangle) }))
+            voxels.push_back(grid.GetCoordinatesFromVoxelIndex(entry.m_voxel_index));
+        return voxels;
+    }
+
+    // triangle in the plane i_axis = i_level over the lowest voxel of the other axes
+    Triangle _MakeAxisTriangle(size_t i_axis, double i_level)
+    {
+        std::array<Point3D, 3> points;
+        const double offsets[3][2] = { { 0.2, 0.2 }, { 0.8, 0.2 }, { 0.2, 0.8 } };
+        for (size_t i = 0; i < 3; ++i)
+        {
+            double coordinates[3];
+            coordinates[i_axis] = i_level;
+            coordinates[(i_axis + 1) % 3] = offsets[i][0];
+            coordinates[(i_axis + 2) % 3] = offsets[i][1];
+            points[i] = Point3D(coordinates[0], coordinates[1], coordinates[2]);
+        }
+        return Triangle(points[0], points[1], points[2]);
+    }
+
+    bool _Contains(const std::vector<std::array<size_t, 3>>& i_voxels, const std::array<size_t, 3>& i_voxel)
+    {
+        return std::find(i_voxels.begin(), i_voxels.end(), i_voxel) != i_voxels.end();
+    }
+}
+
+TEST(Voxelizer, FindsTrianglesWithinPrecisionBelowAFace)
+{
+    // the voxel above the face at 2 grown by the precision touches the triangle, ray parity counts its crossings there
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        const auto voxels = _GetVoxels(_MakeAxisTriangle(axis, 2 - 1e-9), 1e-7);
+        std::array<size_t, 3> below = { 0, 0, 0 };
+        std::array<size_t, 3> above = { 0, 0, 0 };
+        below[axis] = 1;
+        above[axis] = 2;
+        EXPECT_TRUE(_Contains(voxels, below)) << axis;
+        EXPECT_TRUE(_Contains(voxels, above)) << axis;
+    }
+}
+
+TEST(Voxelizer, FindsTrianglesWithinPrecisionAboveAFace)
+{
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        const auto voxels = _GetVoxels(_MakeAxisTriangle(axis, 2 + 1e-9), 1e-7);
+        std::array<size_t, 3> below = { 0, 0, 0 };
+        std::array<size_t, 3> above = { 0, 0, 0 };
+        below[axis] = 1;
+        above[axis] = 2;
+        EXPECT_TRUE(_Contains(voxels, below)) << axis;
+        EXPECT_TRUE(_Contains(voxels, above)) << axis;
+    }
+}
+
+TEST(Voxelizer, SkipsVoxelsFartherThanPrecision)
+{
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        const auto voxels = _GetVoxels(_MakeAxisTriangle(axis, 2 - 1e-3), 1e-7);
+        std::array<size_t, 3> below = { 0, 0, 0 };
+        below[axis] = 1;
+        EXPECT_EQ(voxels, (std::vector<std::array<size_t, 3>>{ below })) << axis;
+    }
+}
+
+TEST(Voxelizer, KeepsSoupIndexesOfListedTriangles)
+{
+    TriangleSoup soup;
+    for (int i = 0; i < 4; ++i)
+        soup.AddTriangle({ 0.2, 0.2, i + 0.5 }, { 3.8, 0.2, i + 0.5 }, { 0.2, 3.8, i + 0.5 }, 0);
+
+    BoundingBox bbox;
+    bbox.AddPoint(Point3D(0, 0, 0));
+    bbox.AddPoint(Point3D(4, 4, 4));
+    const VoxelGrid grid({ 1., 1., 1. }, { 4, 4, 4 }, bbox);
+    Voxelizer voxelizer;
+
+    // the listed triangles touch the same voxels as when the range of the soup with them is voxelized
+    auto expected = voxelizer.CollectEntries(grid, soup, 1, 3);
+    expected.erase(std::remove_if(expected.begin(), expected.end(), [](const VoxelGrid::Entry& i_entry) { return i_entry.m_triangle_index == 2; }), expected.end());
+    const auto entries = voxelizer.CollectEntries(grid, soup, std::vector<std::uint32_t>{ 3, 1 });
+    ASSERT_EQ(entries.size(), expected.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        EXPECT_EQ(entries[i].m_voxel_index, expected[i].m_voxel_index);
+        EXPECT_EQ(entries[i].m_triangle_index, expected[i].m_triangle_index);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Math.Core/Point3D.h>
+
+#include <cstddef>
+#include <type_traits>
+
+// Point without virtual functions and base classes: three coordinates and nothing else.
+// Meant for dense arrays that are copied with memcpy and read by vectorized loops. Point3D and the classes
+// derived from it (Vector3D, MeshPoint) are converted with ToBasicPoint and ToPoint3D
+template<typename T>
+struct BasicPoint3
+{
+    static_assert(std::is_floating_point<T>::value, "BasicPoint3 coordinates must be floating point");
+
+    using ValueType = T;
+
+    T m_coordinates[3];
+
+    T  operator[](size_t i_index) const { return m_coordinates[i_index]; }
+    T& operator[](size_t i_index) { return m_coordinates[i_index]; }
+
+    bool operator==(const BasicPoint3& i_other) const
+    {
+        return m_coordinates[0] == i_other.m_coordinates[0]
+            && m_coordinates[1] == i_other.m_coordinates[1]
+            && m_coordinates[2] == i_other.m_coordinates[2];
+    }
+
+    bool operator!=(const BasicPoint3& i_other) const { return !(*this == i_other); }
+};
+
+using BasicPoint3D = BasicPoint3<double>;
+using BasicPoint3F = BasicPoint3<float>;
+
+static_assert(std::is_trivially_copyable<BasicPoint3D>::value && std::is_standard_layout<BasicPoint3D>::value, "BasicPoint3D must stay plain data");
+static_assert(std::is_trivially_copyable<BasicPoint3F>::value && std::is_standard_layout<BasicPoint3F>::value, "BasicPoint3F must stay plain data");
+static_assert(sizeof(BasicPoint3D) == 3 * sizeof(double), "BasicPoint3D must have no padding");
+static_assert(sizeof(BasicPoint3F) == 3 * sizeof(float), "BasicPoint3F must have no padding");
+
+// only the coordinates are taken, e.g. the triangles of a MeshPoint stay with the MeshPoint
+template<typename T = double, typename TPoint>
+BasicPoint3<T> ToBasicPoint(const TPoint& i_point)
+{
+    static_assert(std::is_base_of<Point3D, TPoint>::value, "ToBasicPoint accepts Point3D and its descendants");
+    return { { static_cast<T>(i_point.GetX()), static_cast<T>(i_point.GetY()), static_cast<T>(i_point.GetZ()) } };
+}
+
+template<typename T>
+Point3D ToPoint3D(const BasicPoint3<T>& i_point)
+{
+    return Point3D(i_point[0], i_point[1], i_point[2]);
+}
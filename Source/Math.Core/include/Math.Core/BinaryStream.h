@@ -0,0 +1,143 @@
+#pragma once
+
+#include <Math.Core/API.h>
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+class BoundingBox;
+class QIODevice;
+
+// Versioned binary format of the built structures. Every structure starts with a header: 8 bytes of magic, format version
+// and byte order mark. Values are stored as they are in memory, arrays are prefixed with their size and aligned to 8 bytes
+// from the start of the file, so a mapped file can be read in place with BinaryReader::ViewArray
+class MATH_CORE_API BinaryWriter
+{
+public:
+    explicit BinaryWriter(QIODevice& io_device);
+
+    // i_magic is 8 characters long
+    void WriteHeader(const char* i_magic, std::uint32_t i_version);
+
+    template<typename T>
+    void Write(const T& i_value);
+
+    template<typename T>
+    void WriteArray(const T* ip_values, size_t i_count);
+
+    template<typename T>
+    void WriteArray(const std::vector<T>& i_values) { WriteArray(i_values.data(), i_values.size()); }
+
+    void WriteBoundingBox(const BoundingBox& i_bbox);
+
+    // false if the device failed to write
+    bool IsOk() const;
+
+private:
+    void _WriteBytes(const void* ip_data, size_t i_size);
+    void _Align();
+
+    QIODevice& m_device;
+    std::uint64_t m_position = 0;
+    bool m_is_ok = true;
+};
+
+// Reads data written by BinaryWriter from memory, usually a mapped file. A read past the end or a wrong header
+// makes the reader fail, all later reads fail as well
+class MATH_CORE_API BinaryReader
+{
+public:
+    BinaryReader(const void* ip_data, size_t i_size);
+
+    // false if the magic or the byte order differs or the version is newer than i_max_version
+    bool ReadHeader(const char* i_magic, std::uint32_t i_max_version, std::uint32_t* op_version = nullptr);
+
+    template<typename T>
+    bool Read(T& o_value);
+
+    template<typename T>
+    bool ReadArray(std::vector<T>& o_values);
+
+    // points into the data and stays valid while the data does, nullptr for empty arrays and failures
+    template<typename T>
+    const T* ViewArray(size_t& o_count);
+
+    bool ReadBoundingBox(BoundingBox& o_bbox);
+
+    bool IsOk() const;
+    // marks data that was read but makes no sense, e.g. an index out of range
+    void SetFailed();
+
+private:
+    const void* _ReadBytes(size_t i_size);
+    bool _Align();
+
+    const char* mp_data;
+    size_t m_size;
+    size_t m_position = 0;
+    bool m_is_ok = true;
+};
+
+
+template<typename T>
+void BinaryWriter::Write(const T& i_value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain data can be written");
+    _WriteBytes(&i_value, sizeof(T));
+}
+
+template<typename T>
+void BinaryWriter::WriteArray(const T* ip_values, size_t i_count)
+{
+    static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= 8, "only plain data can be written");
+    Write(static_cast<std::uint64_t>(i_count));
+    _Align();
+    _WriteBytes(ip_values, i_count * sizeof(T));
+}
+
+template<typename T>
+bool BinaryReader::Read(T& o_value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain data can be read");
+    const auto p_data = _ReadBytes(sizeof(T));
+    if (p_data)
+        std::memcpy(&o_value, p_data, sizeof(T));
+    return p_data != nullptr;
+}
+
+template<typename T>
+bool BinaryReader::ReadArray(std::vector<T>& o_values)
+{
+    size_t count = 0;
+    const auto p_values = ViewArray<T>(count);
+    if (!m_is_ok)
+        return false;
+
+    o_values.resize(count);
+    if (count > 0)
+        std::memcpy(o_values.data(), p_values, count * sizeof(T));
+    return true;
+}
+
+template<typename T>
+const T* BinaryReader::ViewArray(size_t& o_count)
+{
+    static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= 8, "only plain data can be read");
+    o_count = 0;
+
+    std::uint64_t count = 0;
+    if (!Read(count) || !_Align() || count > (m_size - m_position) / sizeof(T))
+    {
+        m_is_ok = false;
+        return nullptr;
+    }
+
+    const auto p_values = static_cast<const T*>(_ReadBytes(static_cast<size_t>(count) * sizeof(T)));
+    Q_ASSERT(reinterpret_cast<std::uintptr_t>(p_values) % alignof(T) == 0);
+    o_count = static_cast<size_t>(count);
+    return count > 0 ? p_values : nullptr;
+}
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "Math.Core/API.h"
+#include "Math.Core/BasicPoint3.h"
+
+#include <cfloat>
+#include <cstddef>
 
 class BoundingBox;
 class Point3D;
@@ -10,13 +14,28 @@ class Triangle;
 #define PI (3.141592653589793238462643383279502884)
 #define PHI (0.618033988749895) // 1/golden_ratio
 
+// four boxes in structure of arrays layout, m_min[axis][box]. Unused boxes keep the invalid default and are infinitely far
+struct BoundingBoxPack4
+{
+    alignas(16) double m_min[3][4] = { { DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX }, { DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX }, { DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX } };
+    alignas(16) double m_max[3][4] = { { -DBL_MAX, -DBL_MAX, -DBL_MAX, -DBL_MAX }, { -DBL_MAX, -DBL_MAX, -DBL_MAX, -DBL_MAX }, { -DBL_MAX, -DBL_MAX, -DBL_MAX, -DBL_MAX } };
+};
+
+MATH_CORE_API void SetBoundingBox(BoundingBoxPack4& io_pack, size_t i_index, const BoundingBox& i_bbox);
+
 MATH_CORE_API double DistanceSqr(const Point3D& i_point1, const Point3D& i_point2);
+// 0 for points inside the box
+MATH_CORE_API double DistanceSqr(const Point3D& i_point, const BoundingBox& i_bbox);
+// squared distances to all four boxes of the pack, uses SSE2 when available
+MATH_CORE_API void DistanceSqr(const Point3D& i_point, const BoundingBoxPack4& i_boxes, double o_distances_sqr[4]);
 
 MATH_CORE_API double Distance(const Point3D& i_point, const BoundingBox& i_bbox);
 MATH_CORE_API double Distance(const Point3D& i_point, const Triangle& i_triangle);
 MATH_CORE_API double Distance(const Point3D& i_point1, const Point3D& i_point2);
 
 MATH_CORE_API bool TriangleWithBBoxIntersection(const Triangle& i_triangle, const BoundingBox& i_bbox);
+// the same test against four boxes at once, bit i of the result is set if the triangle intersects box i. Unused boxes give 0
+MATH_CORE_API unsigned TriangleWithBBoxesIntersection(const Triangle& i_triangle, const BoundingBoxPack4& i_boxes);
 
 MATH_CORE_API void ExtrudeInplace(BoundingBox& i_bbox, double i_offset);
 
@@ -29,6 +48,13 @@ enum class PointTriangleRelativeLocationResult
 
 MATH_CORE_API PointTriangleRelativeLocationResult GetPointTriangleRelativeLocation(const Triangle& i_triangle, const Point3D& i_point);
 
+// True if the ray from i_origin along +X crosses the triangle beyond the origin, o_x is the x of the crossing.
+// Ties are decided as if the ray were moved by an infinitely small offset in y and z, so a ray through a shared edge
+// or vertex crosses exactly one of the triangles around it and the parity of the crossings of a closed mesh is exact
+MATH_CORE_API bool GetRayXCrossing(const Triangle& i_triangle, const Point3D& i_origin, double& o_x);
+// ip_vertices points to the three vertices of the triangle
+MATH_CORE_API bool GetRayXCrossing(const BasicPoint3D* ip_vertices, const Point3D& i_origin, double& o_x);
+
 template<typename T>
 class ScopedStateRestorer final
 {
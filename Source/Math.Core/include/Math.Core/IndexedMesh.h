@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Math.Core/API.h>
+#include <Math.Core/BasicPoint3.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class WorkStealingThreadPool;
+
+// Triangle mesh as a corner table: vertices and faces are 32-bit ids, corner 3 * face + i is the i-th vertex of the face.
+// Adjacency is the opposite corner of every corner (corner of the neighbour face across the edge facing it) and
+// the faces around every vertex. It is built by BuildAdjacency or on first use and dropped by any change of the faces,
+// so concurrent readers have to build it first
+class MATH_CORE_API IndexedMesh
+{
+public:
+    using VertexId = std::uint32_t;
+    using FaceId = std::uint32_t;
+    using CornerId = std::uint32_t;
+
+    static constexpr std::uint32_t INVALID_ID = std::numeric_limits<std::uint32_t>::max();
+
+    void Clear();
+    void Reserve(size_t i_vertices_count, size_t i_faces_count);
+
+    // vertices are not welded, every call adds a new one
+    VertexId AddVertex(const BasicPoint3D& i_point);
+    void SetVertex(VertexId i_vertex, const BasicPoint3D& i_point);
+    FaceId AddFace(VertexId i_a, VertexId i_b, VertexId i_c);
+    void SetFace(FaceId i_face, VertexId i_a, VertexId i_b, VertexId i_c);
+
+    size_t GetVerticesCount() const;
+    size_t GetFacesCount() const;
+
+    const BasicPoint3D& GetVertex(VertexId i_vertex) const;
+    VertexId GetFaceVertex(FaceId i_face, short i_index) const;
+    VertexId GetCornerVertex(CornerId i_corner) const;
+
+    // three vertex ids per face
+    const std::vector<VertexId>& GetCorners() const;
+    const std::vector<BasicPoint3D>& GetVertices() const;
+
+    static FaceId GetFace(CornerId i_corner) { return i_corner / 3; }
+    static CornerId GetNext(CornerId i_corner) { return i_corner % 3 == 2 ? i_corner - 2 : i_corner + 1; }
+    static CornerId GetPrevious(CornerId i_corner) { return i_corner % 3 == 0 ? i_corner + 2 : i_corner - 1; }
+
+    // edges are matched regardless of the orientation of the faces, edges of more than two faces get no opposites
+    void BuildAdjacency() const;
+    bool HasAdjacency() const;
+
+    // INVALID_ID for boundary and non-manifold edges
+    CornerId GetOpposite(CornerId i_corner) const;
+    // faces that use the vertex
+    size_t GetVertexFacesCount(VertexId i_vertex) const;
+    const FaceId* GetVertexFaces(VertexId i_vertex) const;
+    // distinct vertices connected to the vertex by an edge
+    std::vector<VertexId> GetVertexNeighbours(VertexId i_vertex) const;
+
+    size_t GetMemoryUsage() const;
+
+private:
+    void _ResetAdjacency();
+
+private:
+#pragma warning(push)
+#pragma warning(disable: 4251)
+    std::vector<BasicPoint3D> m_vertices;
+    std::vector<VertexId> m_corners;
+    mutable std::vector<CornerId> m_opposites;
+    mutable std::vector<std::uint32_t> m_vertex_faces_offsets; // faces of vertex v are [offsets[v], offsets[v + 1]) of m_vertex_faces
+    mutable std::vector<FaceId> m_vertex_faces;
+#pragma warning(pop)
+};
+
+// Merges vertices with equal coordinates. o_ids[i] is the id of i_vertices[i] in o_welded,
+// welded vertices keep the order of their first occurrence. Vertices are spread over hash partitions that are
+// sorted in parallel on i_pool, the global pool by default; the result does not depend on the threads count
+MATH_CORE_API void WeldVertices(const std::vector<BasicPoint3D>& i_vertices, std::vector<BasicPoint3D>& o_welded, std::vector<std::uint32_t>& o_ids);
+MATH_CORE_API void WeldVertices(const std::vector<BasicPoint3D>& i_vertices, std::vector<BasicPoint3D>& o_welded, std::vector<std::uint32_t>& o_ids, WorkStealingThreadPool& i_pool);
@@ -1,13 +1,16 @@
 #pragma once
 
 #include <Math.Core/API.h>
+#include <Math.Core/BasicPoint3.h>
 
 #include <QObject>
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 class BoundingBox;
+class IndexedMesh;
 class MeshPoint;
 class MeshTriangle;
 class Point3D;
@@ -59,7 +62,18 @@ public:
 
     const BoundingBox& GetBoundingBox() const;
 
+    // same mesh with integer vertex and face ids: vertex i is GetPoint(i), face i is GetTriangle(i).
+    // Built on first call and kept until the mesh changes
+    const IndexedMesh& GetIndexedMesh() const;
+    // replaces points and triangles, the name stays
+    void Assign(const IndexedMesh& i_mesh);
+    // Replaces points and triangles by three indices of i_vertices per triangle. Equal vertices are welded and repeated
+    // triangles dropped. MeshPoint and MeshTriangle objects with their neighbours are created on first use of the
+    // functions that return them, counts, bounding box and GetIndexedMesh work without them
+    void BuildFromIndexedArrays(const std::vector<BasicPoint3D>& i_vertices, const std::vector<std::uint32_t>& i_indices);
+
 private:
+    void _EnsureObjects() const;
     void _InvalidateCache();
 
 private:
@@ -2,6 +2,7 @@
 
 #include <Math.Core/API.h>
 
+#include <Math.Core/BasicPoint3.h>
 #include <Math.Core/Point3D.h>
 
 #include <array>
@@ -47,6 +48,6 @@ private:
 #pragma warning(disable: 4251)
     mutable boost::optional<size_t> m_hash_cache;
 
-	std::array<Point3D, 3> m_points;
+	std::array<BasicPoint3D, 3> m_points; // plain coordinates, GetPoint converts them to Point3D
 #pragma warning(pop)
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Math.Core/API.h>
+#include <Math.Core/BasicPoint3.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class Point3D;
+class Triangle;
+
+// Four triangles in structure of arrays layout, m_origin[axis][lane], with the values the distance kernel needs precomputed.
+// Lanes that were not set are zero and must be ignored by the caller
+struct TrianglePack4
+{
+    static constexpr size_t LANES_COUNT = 4;
+
+    double m_origin[3][4] = {};
+    double m_edge1[3][4] = {};   // point 1 - point 0
+    double m_edge2[3][4] = {};   // point 2 - point 0
+    double m_a00[4] = {};        // |edge1|^2
+    double m_a01[4] = {};        // edge1 * edge2
+    double m_a11[4] = {};        // |edge2|^2
+    double m_inv_a00[4] = {};    // inverse squared lengths of the edges, 0 for zero length
+    double m_inv_a11[4] = {};
+    double m_inv_a22[4] = {};    // edge2 - edge1
+    double m_inv_det[4] = {};    // 0 for degenerate triangles
+};
+
+MATH_CORE_API void SetTriangle(TrianglePack4& io_pack, size_t i_lane, const Triangle& i_triangle);
+// ip_vertices points to the three vertices of the triangle
+MATH_CORE_API void SetTriangle(TrianglePack4& io_pack, size_t i_lane, const BasicPoint3D* ip_vertices);
+
+// squared distances from the point to the four triangles of the pack, uses AVX when the build enables it and SSE2 otherwise
+MATH_CORE_API void DistanceSqr(const Point3D& i_point, const TrianglePack4& i_pack, double o_distances_sqr[4]);
+
+// Triangles packed by four for the distance kernel. Every packed triangle keeps an index given by the caller,
+// usually its position in the caller's triangles list
+class MATH_CORE_API PackedTriangles
+{
+public:
+    static constexpr size_t NO_TRIANGLE = std::numeric_limits<size_t>::max();
+
+    void Clear();
+    void Reserve(size_t i_triangles_count);
+
+    // appends the triangle, returns its position
+    size_t Add(const Triangle& i_triangle, std::uint32_t i_index);
+    size_t Add(const BasicPoint3D* ip_vertices, std::uint32_t i_index);
+    // the next added triangle starts a new pack, lets ranges that start here be processed without a partial first pack
+    void AlignToPack();
+
+    // number of positions including the ones skipped by AlignToPack
+    size_t GetSize() const;
+    std::uint32_t GetIndex(size_t i_position) const;
+
+    // position of the nearest triangle of [i_begin, i_end) if it is nearer than sqrt(io_distance_sqr), NO_TRIANGLE otherwise.
+    // io_distance_sqr is updated with the found distance
+    size_t FindNearest(const Point3D& i_point, double& io_distance_sqr, size_t i_begin, size_t i_end) const;
+
+    size_t GetMemoryUsage() const;
+
+private:
+#pragma warning(push)
+#pragma warning(disable: 4251)
+    std::vector<TrianglePack4> m_packs;
+    std::vector<std::uint32_t> m_indexes;
+#pragma warning(pop)
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Math.Core/API.h>
+#include <Math.Core/BasicPoint3.h>
+
+#include <cstdint>
+#include <vector>
+
+class BinaryReader;
+class BinaryWriter;
+class Mesh;
+class Point3D;
+class TransformMatrix;
+class Triangle;
+
+// Triangles of several meshes in two flat arrays: three vertices per triangle and the id of the mesh it came from.
+// Triangles are addressed by 32-bit indexes, so the mesh of a found triangle is one array read
+class MATH_CORE_API TriangleSoup
+{
+public:
+    void Clear();
+    void Reserve(size_t i_triangles_count);
+
+    // appends the triangles of the mesh transformed by i_transform, returns the index of the first one
+    std::uint32_t AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transform, std::uint32_t i_mesh_id);
+    std::uint32_t AddTriangle(const Point3D& i_a, const Point3D& i_b, const Point3D& i_c, std::uint32_t i_mesh_id);
+
+    size_t GetTrianglesCount() const;
+    // the three vertices of the triangle
+    const BasicPoint3D* GetVertices(std::uint32_t i_triangle) const;
+    std::uint32_t GetMeshId(std::uint32_t i_triangle) const;
+    // copy of the triangle for the code that works with Triangle
+    Triangle GetTriangle(std::uint32_t i_triangle) const;
+
+    size_t GetMemoryUsage() const;
+
+    // the two arrays as they are, Load replaces the triangles and returns false for a broken file
+    void Save(BinaryWriter& io_writer) const;
+    bool Load(BinaryReader& io_reader);
+
+private:
+#pragma warning(push)
+#pragma warning(disable: 4251)
+    std::vector<BasicPoint3D> m_vertices;
+    std::vector<std::uint32_t> m_mesh_ids;
+#pragma warning(pop)
+};
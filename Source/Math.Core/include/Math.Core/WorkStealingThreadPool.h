@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Math.Core/API.h>
+
+#include <functional>
+#include <memory>
+
+// Fixed set of worker threads, every worker owns a deque of tasks. A worker takes tasks from the back of its own
+// deque and, when it is empty, steals from the front of the others, so uneven chunks are balanced automatically.
+class MATH_CORE_API WorkStealingThreadPool final
+{
+public:
+    // i_threads_count is the total number of threads that run tasks, including the thread that calls ParallelFor.
+    // 0 means std::thread::hardware_concurrency()
+    explicit WorkStealingThreadPool(size_t i_threads_count = 0);
+    ~WorkStealingThreadPool();
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    size_t GetThreadsCount() const;
+
+    // splits [0, i_count) into chunks of at most i_grain_size elements and calls i_task(begin, end) for every chunk.
+    // Blocks until all chunks are processed, the calling thread takes part in the work.
+    // Can be called from inside a task, the first exception thrown by a task is rethrown here.
+    void ParallelFor(size_t i_count, size_t i_grain_size, const std::function<void(size_t, size_t)>& i_task);
+
+    // shared pool with hardware_concurrency threads
+    static WorkStealingThreadPool& GetGlobalInstance();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mp_impl;
+};
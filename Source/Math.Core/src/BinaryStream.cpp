@@ -0,0 +1,132 @@
+#include "Math.Core/BinaryStream.h"
+
+#include "Math.Core/BoundingBox.h"
+#include "Math.Core/Point3D.h"
+
+#include <QIODevice>
+
+
+namespace
+{
+    constexpr size_t MAGIC_SIZE = 8;
+    constexpr size_t ALIGNMENT = 8;
+    constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+}
+
+
+BinaryWriter::BinaryWriter(QIODevice& io_device)
+    : m_device(io_device)
+{
+}
+
+void BinaryWriter::WriteHeader(const char* i_magic, std::uint32_t i_version)
+{
+    Q_ASSERT(std::strlen(i_magic) == MAGIC_SIZE);
+    _WriteBytes(i_magic, MAGIC_SIZE);
+    Write(i_version);
+    Write(BYTE_ORDER_MARK);
+}
+
+void BinaryWriter::WriteBoundingBox(const BoundingBox& i_bbox)
+{
+    const auto min = i_bbox.GetMin();
+    const auto max = i_bbox.GetMax();
+    for (const auto& corner : { min, max })
+    {
+        Write(corner.GetX());
+        Write(corner.GetY());
+        Write(corner.GetZ());
+    }
+}
+
+bool BinaryWriter::IsOk() const
+{
+    return m_is_ok;
+}
+
+void BinaryWriter::_WriteBytes(const void* ip_data, size_t i_size)
+{
+    if (!m_is_ok || i_size == 0)
+        return;
+
+    m_is_ok = m_device.write(static_cast<const char*>(ip_data), static_cast<qint64>(i_size)) == static_cast<qint64>(i_size);
+    m_position += i_size;
+}
+
+void BinaryWriter::_Align()
+{
+    static const char s_padding[ALIGNMENT] = {};
+    _WriteBytes(s_padding, (ALIGNMENT - m_position % ALIGNMENT) % ALIGNMENT);
+}
+
+
+BinaryReader::BinaryReader(const void* ip_data, size_t i_size)
+    : mp_data(static_cast<const char*>(ip_data))
+    , m_size(i_size)
+{
+}
+
+bool BinaryReader::ReadHeader(const char* i_magic, std::uint32_t i_max_version, std::uint32_t* op_version)
+{
+    Q_ASSERT(std::strlen(i_magic) == MAGIC_SIZE);
+
+    const auto p_magic = _ReadBytes(MAGIC_SIZE);
+    std::uint32_t version = 0;
+    std::uint32_t byte_order_mark = 0;
+    if (!p_magic || !Read(version) || !Read(byte_order_mark))
+        return false;
+
+    if (std::memcmp(p_magic, i_magic, MAGIC_SIZE) != 0 || byte_order_mark != BYTE_ORDER_MARK || version == 0 || version > i_max_version)
+    {
+        m_is_ok = false;
+        return false;
+    }
+
+    if (op_version)
+        *op_version = version;
+    return true;
+}
+
+bool BinaryReader::ReadBoundingBox(BoundingBox& o_bbox)
+{
+    double coordinates[6] = {};
+    for (auto& coordinate : coordinates)
+        Read(coordinate);
+
+    // an invalid bbox keeps its min above its max and stays invalid
+    o_bbox = BoundingBox();
+    if (m_is_ok && coordinates[0] <= coordinates[3] && coordinates[1] <= coordinates[4] && coordinates[2] <= coordinates[5])
+    {
+        o_bbox.AddPoint(Point3D(coordinates[0], coordinates[1], coordinates[2]));
+        o_bbox.AddPoint(Point3D(coordinates[3], coordinates[4], coordinates[5]));
+    }
+    return m_is_ok;
+}
+
+bool BinaryReader::IsOk() const
+{
+    return m_is_ok;
+}
+
+void BinaryReader::SetFailed()
+{
+    m_is_ok = false;
+}
+
+const void* BinaryReader::_ReadBytes(size_t i_size)
+{
+    if (!m_is_ok || i_size > m_size - m_position)
+    {
+        m_is_ok = false;
+        return nullptr;
+    }
+
+    const auto p_data = mp_data + m_position;
+    m_position += i_size;
+    return p_data;
+}
+
+bool BinaryReader::_Align()
+{
+    return _ReadBytes((ALIGNMENT - m_position % ALIGNMENT) % ALIGNMENT) != nullptr;
+}
@@ -7,12 +7,18 @@
 #include "Math.Core/Vector3D.h"
 #include "Math.Core/VectorUtilities.h"
 
+#include "SimdRegister.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
 #include <cmath>
 #include <tuple>
 #include <utility>
 #include <vector>
 
 
+
 namespace
 {
     inline void _UpdateMinMax(double i_x0, double i_x1, double i_x2, double& o_min, double& o_max)
@@ -105,6 +111,175 @@ namespace
             return true;
         return false;
     }
+
+    // Lanes of the TriangleWithBBoxesIntersection kernel hold boxes, the triangle is the same for all of them.
+    // Every test repeats the operations of its scalar counterpart above, so both give the same answers
+    template<typename S>
+    struct _TriangleBoxesTester
+    {
+        using Register = typename S::Register;
+
+        // a * p_a[i1] - b * p_a[i2] for both points; rad = |a| * h[j1] + |b| * h[j2]. i_negate_first flips the sign of the first product
+        static Register AxisTest(Register i_a, Register i_b, const Register* ip_p0, const Register* ip_p1, const Register* ip_half_delta,
+                                 short i_first, short i_second, bool i_negate_first)
+        {
+            auto projection = [&](const Register* ip_point)
+            {
+                return i_negate_first ? S::Add(S::Mul(S::Negate(i_a), ip_point[i_first]), S::Mul(i_b, ip_point[i_second]))
+                                      : S::Sub(S::Mul(i_a, ip_point[i_first]), S::Mul(i_b, ip_point[i_second]));
+            };
+            const auto p1 = projection(ip_p0);
+            const auto p2 = projection(ip_p1);
+            const auto min = S::Min(p1, p2);
+            const auto max = S::Max(p1, p2);
+            const auto rad = S::Add(S::Mul(S::Abs(i_a), ip_half_delta[i_first]), S::Mul(S::Abs(i_b), ip_half_delta[i_second]));
+            const auto eps = S::Set(DBL_EPSILON);
+
+            const auto separated = S::Or(S::Greater(min, S::Add(rad, eps)), S::Greater(S::Negate(rad), S::Add(max, eps)));
+            return separated;
+        }
+
+        static Register AxisTestX(Register i_a, Register i_b, const Register* ip_p0, const Register* ip_p1, const Register* ip_half_delta)
+        {
+            return AxisTest(i_a, i_b, ip_p0, ip_p1, ip_half_delta, 1, 2, false);
+        }
+
+        static Register AxisTestY(Register i_a, Register i_b, const Register* ip_p0, const Register* ip_p1, const Register* ip_half_delta)
+        {
+            return AxisTest(i_a, i_b, ip_p0, ip_p1, ip_half_delta, 0, 2, true);
+        }
+
+        static Register AxisTestZ(Register i_a, Register i_b, const Register* ip_p0, const Register* ip_p1, const Register* ip_half_delta)
+        {
+            return AxisTest(i_a, i_b, ip_p0, ip_p1, ip_half_delta, 0, 1, false);
+        }
+
+        // bit i of the result is set if the triangle intersects the box of lane i_lane + i
+        static unsigned Test(const Point3D* ip_points, const BoundingBoxPack4& i_boxes, size_t i_lane)
+        {
+            Register min[3], max[3], center[3], half_delta[3];
+            for (short axis = 0; axis < 3; ++axis)
+            {
+                min[axis] = S::Load(&i_boxes.m_min[axis][i_lane]);
+                max[axis] = S::Load(&i_boxes.m_max[axis][i_lane]);
+                center[axis] = S::Div(S::Add(min[axis], max[axis]), S::Set(2.));
+                half_delta[axis] = S::Div(S::Sub(max[axis], min[axis]), S::Set(2.));
+            }
+
+            auto valid = S::GreaterOrEqual(max[0], min[0]);
+            auto contains = S::Zero();
+            Register points[3][3];
+            for (short k = 0; k < 3; ++k)
+            {
+                auto inside = valid;
+                for (short axis = 0; axis < 3; ++axis)
+                {
+                    const auto coordinate = S::Set(ip_points[k].Get(axis));
+                    inside = S::And(inside, S::And(S::GreaterOrEqual(coordinate, min[axis]), S::GreaterOrEqual(max[axis], coordinate)));
+                    points[k][axis] = S::Sub(coordinate, center[axis]);
+                }
+                contains = S::Or(contains, inside);
+            }
+
+            Register edges[3][3];
+            for (short axis = 0; axis < 3; ++axis)
+            {
+                edges[0][axis] = S::Sub(points[1][axis], points[0][axis]);
+                edges[1][axis] = S::Sub(points[2][axis], points[1][axis]);
+                edges[2][axis] = S::Sub(points[0][axis], points[2][axis]);
+            }
+
+            auto separated = AxisTestX(edges[0][2], edges[0][1], points[0], points[2], half_delta);
+            separated = S::Or(separated, AxisTestY(edges[0][2], edges[0][0], points[0], points[2], half_delta));
+            separated = S::Or(separated, AxisTestZ(edges[0][1], edges[0][0], points[1], points[2], half_delta));
+
+            separated = S::Or(separated, AxisTestX(edges[1][2], edges[1][1], points[0], points[2], half_delta));
+            separated = S::Or(separated, AxisTestY(edges[1][2], edges[1][0], points[0], points[2], half_delta));
+            separated = S::Or(separated, AxisTestZ(edges[1][1], edges[1][0], points[0], points[1], half_delta));
+
+            separated = S::Or(separated, AxisTestX(edges[2][2], edges[2][1], points[0], points[1], half_delta));
+            separated = S::Or(separated, AxisTestY(edges[2][2], edges[2][0], points[0], points[1], half_delta));
+            separated = S::Or(separated, AxisTestZ(edges[2][1], edges[2][0], points[1], points[2], half_delta));
+
+            const auto eps = S::Set(DBL_EPSILON);
+            for (short axis = 0; axis < 3; ++axis)
+            {
+                const auto triangle_min = S::Sub(S::Min(S::Min(points[0][axis], points[1][axis]), points[2][axis]), eps);
+                const auto triangle_max = S::Add(S::Max(S::Max(points[0][axis], points[1][axis]), points[2][axis]), eps);
+                separated = S::Or(separated, S::Or(S::Greater(triangle_min, half_delta[axis]), S::Greater(S::Negate(half_delta[axis]), triangle_max)));
+            }
+
+            const Register normal[3] =
+            {
+                S::Sub(S::Mul(edges[0][1], edges[1][2]), S::Mul(edges[0][2], edges[1][1])),
+                S::Sub(S::Mul(edges[0][2], edges[1][0]), S::Mul(edges[0][0], edges[1][2])),
+                S::Sub(S::Mul(edges[0][0], edges[1][1]), S::Mul(edges[0][1], edges[1][0]))
+            };
+            Register dot_min = S::Zero();
+            Register dot_max = S::Zero();
+            for (short axis = 0; axis < 3; ++axis)
+            {
+                const auto positive = S::Greater(normal[axis], S::Zero());
+                const auto low = S::Sub(S::Negate(half_delta[axis]), points[0][axis]);
+                const auto high = S::Sub(half_delta[axis], points[0][axis]);
+                const auto plane_min = S::Mul(normal[axis], S::Select(positive, low, high));
+                const auto plane_max = S::Mul(normal[axis], S::Select(positive, high, low));
+                dot_min = axis == 0 ? plane_min : S::Add(dot_min, plane_min);
+                dot_max = axis == 0 ? plane_max : S::Add(dot_max, plane_max);
+            }
+            separated = S::Or(separated, S::Or(S::Greater(dot_min, eps), S::Greater(S::Negate(eps), dot_max)));
+
+            return S::GetMask(S::Or(contains, S::AndNot(separated, valid)));
+        }
+    };
+
+    // Edge function of the edge from ip_a to ip_b of a triangle projected along X, the ends are (y, z) relative to the ray.
+    // The ends are sorted before evaluation, so the two triangles of a shared edge get exactly opposite values.
+    // o_sign is never 0 for an edge of non-zero length: a zero value is decided for the ray moved by (d, d^2), d -> +0
+    double _GetEdgeFunction(const double* ip_a, const double* ip_b, int& o_sign)
+    {
+        const bool is_swapped = ip_b[0] < ip_a[0] || (ip_b[0] == ip_a[0] && ip_b[1] < ip_a[1]);
+        const auto p_first = is_swapped ? ip_b : ip_a;
+        const auto p_second = is_swapped ? ip_a : ip_b;
+
+        const auto value = p_first[0] * p_second[1] - p_first[1] * p_second[0];
+        int sign = value > 0 ? 1 : (value < 0 ? -1 : 0);
+        if (sign == 0)
+        {
+            // cross(a - s, b - s) = cross(a, b) + d * (a - b).z - d^2 * (a - b).y
+            const auto dz = p_first[1] - p_second[1];
+            const auto dy = p_first[0] - p_second[0];
+            sign = dz > 0 ? 1 : (dz < 0 ? -1 : (dy < 0 ? 1 : (dy > 0 ? -1 : 0)));
+        }
+
+        o_sign = is_swapped ? -sign : sign;
+        return is_swapped ? -value : value;
+    }
+
+    bool _GetRayXCrossing(const double i_vertices[3][3], const Point3D& i_origin, double& o_x)
+    {
+        double projected[3][2];
+        for (short i = 0; i < 3; ++i)
+        {
+            projected[i][0] = i_vertices[i][1] - i_origin.GetY();
+            projected[i][1] = i_vertices[i][2] - i_origin.GetZ();
+        }
+
+        // weight of a vertex is the edge function of the opposite edge
+        double weights[3];
+        int signs[3];
+        for (short i = 0; i < 3; ++i)
+            weights[i] = _GetEdgeFunction(projected[(i + 1) % 3], projected[(i + 2) % 3], signs[i]);
+        if (signs[0] == 0 || signs[0] != signs[1] || signs[0] != signs[2])
+            return false;
+
+        const auto weights_sum = weights[0] + weights[1] + weights[2];
+        if (weights_sum == 0)
+            return false;
+
+        o_x = (weights[0] * i_vertices[0][0] + weights[1] * i_vertices[1][0] + weights[2] * i_vertices[2][0]) / weights_sum;
+        return o_x > i_origin.GetX();
+    }
 }
 
 
@@ -114,55 +289,53 @@ double DistanceSqr(const Point3D& i_point1, const Point3D& i_point2)
     return tmp.Get(0) * tmp.Get(0) + tmp.Get(1) * tmp.Get(1) + tmp.Get(2) * tmp.Get(2);
 }
 
-double Distance(const Point3D& i_point, const BoundingBox& i_bbox)
+double DistanceSqr(const Point3D& i_point, const BoundingBox& i_bbox)
 {
-    if (i_bbox.ContainsPoint(i_point))
-        return 0;
-
-    std::vector<Point3D> nodes;
-    
-    auto min_point = i_bbox.GetMin();
-    auto max_point = i_bbox.GetMax();
+    const auto min_point = i_bbox.GetMin();
+    const auto max_point = i_bbox.GetMax();
 
-    for (auto i = 0u; i < 8; ++i)
+    double result = 0;
+    for (short i = 0; i < 3; ++i)
     {
-        nodes.emplace_back(
-            (i & 1) ? max_point.Get(0) : min_point.Get(0),
-            (i & 2) ? max_point.Get(1) : min_point.Get(1),
-            (i & 4) ? max_point.Get(2) : min_point.Get(2)
-        );
+        // at most one of the differences is positive, max/min compile to branch-free instructions
+        const auto delta = std::max(std::max(min_point.Get(i) - i_point.Get(i), i_point.Get(i) - max_point.Get(i)), 0.);
+        result += delta * delta;
     }
+    return result;
+}
+
+void SetBoundingBox(BoundingBoxPack4& io_pack, size_t i_index, const BoundingBox& i_bbox)
+{
+    Q_ASSERT(i_index < 4);
 
-    static std::vector<std::tuple<int,int,int>> triangles = // xyz ordered indexes 
+    const auto min_point = i_bbox.GetMin();
+    const auto max_point = i_bbox.GetMax();
+    for (short axis = 0; axis < 3; ++axis)
     {
-        // bottom face
-        {0, 1, 2},
-        {1, 2, 3},
-        // front face
-        {0, 1, 5},
-        {0, 5, 4},
-        // left face
-        {0, 2, 6},
-        {0, 6, 4},
-        // right face
-        {1, 3, 7},
-        {1, 7, 5},
-        // back face
-        {2, 3, 7},
-        {2, 7, 6},
-        // top face
-        {4, 5, 7},
-        {4, 7, 6}
-    };
+        io_pack.m_min[axis][i_index] = min_point.Get(axis);
+        io_pack.m_max[axis][i_index] = max_point.Get(axis);
+    }
+}
 
-    auto distance = std::numeric_limits<double>::max();
-    for (auto indexes : triangles)
+void DistanceSqr(const Point3D& i_point, const BoundingBoxPack4& i_boxes, double o_distances_sqr[4])
+{
+    using S = Simd::Native;
+    for (size_t lane = 0; lane < 4; lane += S::WIDTH)
     {
-        Triangle triangle(nodes[std::get<0>(indexes)], nodes[std::get<1>(indexes)], nodes[std::get<2>(indexes)]);
-        distance = std::min(distance, Distance(i_point, triangle));
+        auto result = S::Zero();
+        for (short axis = 0; axis < 3; ++axis)
+        {
+            const auto coordinate = S::Set(i_point.Get(axis));
+            const auto delta = S::Max(S::Max(S::Sub(S::Load(&i_boxes.m_min[axis][lane]), coordinate), S::Sub(coordinate, S::Load(&i_boxes.m_max[axis][lane]))), S::Zero());
+            result = S::Add(result, S::Mul(delta, delta));
+        }
+        S::Store(o_distances_sqr + lane, result);
     }
+}
 
-    return distance;
+double Distance(const Point3D& i_point, const BoundingBox& i_bbox)
+{
+    return std::sqrt(DistanceSqr(i_point, i_bbox));
 }
 
 double Distance(const Point3D& i_point, const Triangle& i_triangle)
@@ -219,7 +392,7 @@ double Distance(const Point3D& i_point, const Triangle& i_triangle)
             }
             else
             {
-                auto h1 = (point2.second - point1.second) * (a01 * point1.first + a11 * point1.second + b1);
+                auto h1 = (point2.second - point1.second) * (a01 * point2.first + a11 * point2.second + b1);
                 point = h1 <= 0 ? get_min_edge12() : get_min_inside(point1, point2, h0, h1);
             }
         }
@@ -360,6 +533,17 @@ bool TriangleWithBBoxIntersection(const Triangle& i_triangle, const BoundingBox&
     return true;
 }
 
+unsigned TriangleWithBBoxesIntersection(const Triangle& i_triangle, const BoundingBoxPack4& i_boxes)
+{
+    using S = Simd::Native;
+    const Point3D points[3] = { i_triangle.GetPoint(0), i_triangle.GetPoint(1), i_triangle.GetPoint(2) };
+
+    unsigned result = 0;
+    for (size_t lane = 0; lane < 4; lane += S::WIDTH)
+        result |= _TriangleBoxesTester<S>::Test(points, i_boxes, lane) << lane;
+    return result;
+}
+
 void ExtrudeInplace(BoundingBox& i_bbox, double i_offset)
 {
     assert(i_offset >= 0);
@@ -388,3 +572,26 @@ PointTriangleRelativeLocationResult GetPointTriangleRelativeLocation(const Trian
     
     return PointTriangleRelativeLocationResult::Above;
 }
+
+bool GetRayXCrossing(const Triangle& i_triangle, const Point3D& i_origin, double& o_x)
+{
+    double vertices[3][3];
+    for (short i = 0; i < 3; ++i)
+    {
+        const auto point = i_triangle.GetPoint(i);
+        for (short axis = 0; axis < 3; ++axis)
+            vertices[i][axis] = point[axis];
+    }
+    return _GetRayXCrossing(vertices, i_origin, o_x);
+}
+
+bool GetRayXCrossing(const BasicPoint3D* ip_vertices, const Point3D& i_origin, double& o_x)
+{
+    double vertices[3][3];
+    for (short i = 0; i < 3; ++i)
+    {
+        for (short axis = 0; axis < 3; ++axis)
+            vertices[i][axis] = ip_vertices[i][axis];
+    }
+    return _GetRayXCrossing(vertices, i_origin, o_x);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Math.Core/WorkStealingThreadPool.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Finds equal items among i_count items in parallel: o[i] is the smallest index of the items equal to item i, so
+// o[i] == i marks the first occurrence. Items are spread over partitions by i_hash, then every partition is sorted
+// by i_less on its own. i_hash must give equal items the same value and i_less must be consistent with i_equal.
+// The result does not depend on the number of threads
+template<typename THash, typename TLess, typename TEqual>
+std::vector<std::uint32_t> FindFirstOccurrences(WorkStealingThreadPool& i_pool, size_t i_count, const THash& i_hash, const TLess& i_less, const TEqual& i_equal)
+{
+    Q_ASSERT(i_count < std::numeric_limits<std::uint32_t>::max());
+
+    constexpr size_t PARTITIONS_COUNT = 256;
+    constexpr size_t CHUNK_SIZE = 1 << 16;
+    const auto chunks_count = (i_count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    // partition of every item and the size of every partition within every chunk
+    std::vector<std::uint8_t> partitions(i_count);
+    std::vector<std::array<std::uint32_t, PARTITIONS_COUNT>> chunk_offsets(chunks_count);
+    i_pool.ParallelFor(chunks_count, 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto chunk = i_begin; chunk < i_end; ++chunk)
+        {
+            auto& counts = chunk_offsets[chunk];
+            counts.fill(0);
+            for (auto i = chunk * CHUNK_SIZE; i < std::min(i_count, (chunk + 1) * CHUNK_SIZE); ++i)
+            {
+                const auto hash = static_cast<std::uint64_t>(i_hash(i));
+                partitions[i] = static_cast<std::uint8_t>((hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 32)) % PARTITIONS_COUNT);
+                ++counts[partitions[i]];
+            }
+        }
+    });
+
+    // partitions follow each other, chunks follow each other within a partition, so indices grow within a partition
+    std::array<std::uint32_t, PARTITIONS_COUNT + 1> partition_offsets;
+    std::uint32_t offset = 0;
+    for (size_t partition = 0; partition < PARTITIONS_COUNT; ++partition)
+    {
+        partition_offsets[partition] = offset;
+        for (auto& counts : chunk_offsets)
+        {
+            const auto count = counts[partition];
+            counts[partition] = offset;
+            offset += count;
+        }
+    }
+    partition_offsets[PARTITIONS_COUNT] = offset;
+
+    std::vector<std::uint32_t> order(i_count);
+    i_pool.ParallelFor(chunks_count, 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto chunk = i_begin; chunk < i_end; ++chunk)
+        {
+            auto& positions = chunk_offsets[chunk];
+            for (auto i = chunk * CHUNK_SIZE; i < std::min(i_count, (chunk + 1) * CHUNK_SIZE); ++i)
+                order[positions[partitions[i]]++] = static_cast<std::uint32_t>(i);
+        }
+    });
+
+    // stable sort keeps the smallest index first in every run of equal items
+    std::vector<std::uint32_t> first_occurrences(i_count);
+    i_pool.ParallelFor(PARTITIONS_COUNT, 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto partition = i_begin; partition < i_end; ++partition)
+        {
+            const auto begin = order.begin() + partition_offsets[partition];
+            const auto end = order.begin() + partition_offsets[partition + 1];
+            std::stable_sort(begin, end, i_less);
+            for (auto it = begin; it != end; ++it)
+                first_occurrences[*it] = it != begin && i_equal(*(it - 1), *it) ? first_occurrences[*(it - 1)] : *it;
+        }
+    });
+
+    return first_occurrences;
+}
@@ -0,0 +1,285 @@
+#include "Math.Core/IndexedMesh.h"
+
+#include "FirstOccurrences.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+#include <boost/functional/hash.hpp>
+
+
+namespace
+{
+    // non-oriented edge in the high and low halves, the smaller vertex id first
+    inline std::uint64_t _GetEdgeKey(IndexedMesh::VertexId i_a, IndexedMesh::VertexId i_b)
+    {
+        return (static_cast<std::uint64_t>(std::min(i_a, i_b)) << 32) | std::max(i_a, i_b);
+    }
+}
+
+
+constexpr std::uint32_t IndexedMesh::INVALID_ID;
+
+void IndexedMesh::Clear()
+{
+    m_vertices.clear();
+    m_corners.clear();
+    _ResetAdjacency();
+}
+
+void IndexedMesh::Reserve(size_t i_vertices_count, size_t i_faces_count)
+{
+    m_vertices.reserve(i_vertices_count);
+    m_corners.reserve(3 * i_faces_count);
+}
+
+IndexedMesh::VertexId IndexedMesh::AddVertex(const BasicPoint3D& i_point)
+{
+    Q_ASSERT(m_vertices.size() < INVALID_ID);
+    m_vertices.push_back(i_point);
+    _ResetAdjacency();
+    return static_cast<VertexId>(m_vertices.size() - 1);
+}
+
+void IndexedMesh::SetVertex(VertexId i_vertex, const BasicPoint3D& i_point)
+{
+    Q_ASSERT(i_vertex < m_vertices.size());
+    m_vertices[i_vertex] = i_point;
+}
+
+IndexedMesh::FaceId IndexedMesh::AddFace(VertexId i_a, VertexId i_b, VertexId i_c)
+{
+    Q_ASSERT(i_a < m_vertices.size() && i_b < m_vertices.size() && i_c < m_vertices.size());
+    Q_ASSERT(m_corners.size() / 3 < INVALID_ID);
+
+    m_corners.push_back(i_a);
+    m_corners.push_back(i_b);
+    m_corners.push_back(i_c);
+    _ResetAdjacency();
+    return static_cast<FaceId>(m_corners.size() / 3 - 1);
+}
+
+void IndexedMesh::SetFace(FaceId i_face, VertexId i_a, VertexId i_b, VertexId i_c)
+{
+    Q_ASSERT(i_face < GetFacesCount());
+    Q_ASSERT(i_a < m_vertices.size() && i_b < m_vertices.size() && i_c < m_vertices.size());
+
+    m_corners[3 * static_cast<size_t>(i_face)] = i_a;
+    m_corners[3 * static_cast<size_t>(i_face) + 1] = i_b;
+    m_corners[3 * static_cast<size_t>(i_face) + 2] = i_c;
+    _ResetAdjacency();
+}
+
+size_t IndexedMesh::GetVerticesCount() const
+{
+    return m_vertices.size();
+}
+
+size_t IndexedMesh::GetFacesCount() const
+{
+    return m_corners.size() / 3;
+}
+
+const BasicPoint3D& IndexedMesh::GetVertex(VertexId i_vertex) const
+{
+    Q_ASSERT(i_vertex < m_vertices.size());
+    return m_vertices[i_vertex];
+}
+
+IndexedMesh::VertexId IndexedMesh::GetFaceVertex(FaceId i_face, short i_index) const
+{
+    Q_ASSERT(i_index >= 0 && i_index < 3);
+    return GetCornerVertex(3 * i_face + i_index);
+}
+
+IndexedMesh::VertexId IndexedMesh::GetCornerVertex(CornerId i_corner) const
+{
+    Q_ASSERT(i_corner < m_corners.size());
+    return m_corners[i_corner];
+}
+
+const std::vector<IndexedMesh::VertexId>& IndexedMesh::GetCorners() const
+{
+    return m_corners;
+}
+
+const std::vector<BasicPoint3D>& IndexedMesh::GetVertices() const
+{
+    return m_vertices;
+}
+
+void IndexedMesh::BuildAdjacency() const
+{
+    const auto corners_count = m_corners.size();
+
+    // corners sorted by the edge they face, corners of one edge become neighbours
+    std::vector<std::pair<std::uint64_t, CornerId>> edges(corners_count);
+    for (CornerId corner = 0; corner < corners_count; ++corner)
+        edges[corner] = { _GetEdgeKey(m_corners[GetNext(corner)], m_corners[GetPrevious(corner)]), corner };
+    std::sort(edges.begin(), edges.end());
+
+    m_opposites.assign(corners_count, INVALID_ID);
+    for (size_t begin = 0, end = 0; begin < corners_count; begin = end)
+    {
+        end = begin + 1;
+        while (end < corners_count && edges[end].first == edges[begin].first)
+            ++end;
+
+        if (end - begin == 2)
+        {
+            m_opposites[edges[begin].second] = edges[begin + 1].second;
+            m_opposites[edges[begin + 1].second] = edges[begin].second;
+        }
+    }
+
+    // faces around vertices by counting sort
+    m_vertex_faces_offsets.assign(m_vertices.size() + 1, 0);
+    for (const auto vertex : m_corners)
+        ++m_vertex_faces_offsets[vertex + 1];
+    for (size_t i = 1; i < m_vertex_faces_offsets.size(); ++i)
+        m_vertex_faces_offsets[i] += m_vertex_faces_offsets[i - 1];
+
+    m_vertex_faces.resize(corners_count);
+    std::vector<std::uint32_t> positions(m_vertex_faces_offsets.begin(), m_vertex_faces_offsets.end() - 1);
+    for (CornerId corner = 0; corner < corners_count; ++corner)
+        m_vertex_faces[positions[m_corners[corner]]++] = GetFace(corner);
+}
+
+bool IndexedMesh::HasAdjacency() const
+{
+    return m_opposites.size() == m_corners.size() && m_vertex_faces_offsets.size() == m_vertices.size() + 1;
+}
+
+IndexedMesh::CornerId IndexedMesh::GetOpposite(CornerId i_corner) const
+{
+    if (!HasAdjacency())
+        BuildAdjacency();
+    return m_opposites[i_corner];
+}
+
+size_t IndexedMesh::GetVertexFacesCount(VertexId i_vertex) const
+{
+    if (!HasAdjacency())
+        BuildAdjacency();
+    return m_vertex_faces_offsets[i_vertex + 1] - m_vertex_faces_offsets[i_vertex];
+}
+
+const IndexedMesh::FaceId* IndexedMesh::GetVertexFaces(VertexId i_vertex) const
+{
+    if (!HasAdjacency())
+        BuildAdjacency();
+    return m_vertex_faces.data() + m_vertex_faces_offsets[i_vertex];
+}
+
+std::vector<IndexedMesh::VertexId> IndexedMesh::GetVertexNeighbours(VertexId i_vertex) const
+{
+    std::vector<VertexId> neighbours;
+
+    const auto p_faces = GetVertexFaces(i_vertex);
+    const auto faces_count = GetVertexFacesCount(i_vertex);
+    neighbours.reserve(2 * faces_count);
+    for (size_t i = 0; i < faces_count; ++i)
+    {
+        for (short j = 0; j < 3; ++j)
+        {
+            const auto vertex = GetFaceVertex(p_faces[i], j);
+            if (vertex != i_vertex)
+                neighbours.push_back(vertex);
+        }
+    }
+
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    return neighbours;
+}
+
+size_t IndexedMesh::GetMemoryUsage() const
+{
+    return m_vertices.capacity() * sizeof(BasicPoint3D)
+         + m_corners.capacity() * sizeof(VertexId)
+         + m_opposites.capacity() * sizeof(CornerId)
+         + m_vertex_faces_offsets.capacity() * sizeof(std::uint32_t)
+         + m_vertex_faces.capacity() * sizeof(FaceId);
+}
+
+void IndexedMesh::_ResetAdjacency()
+{
+    m_opposites.clear();
+    m_vertex_faces_offsets.clear();
+    m_vertex_faces.clear();
+}
+
+void WeldVertices(const std::vector<BasicPoint3D>& i_vertices, std::vector<BasicPoint3D>& o_welded, std::vector<std::uint32_t>& o_ids)
+{
+    WeldVertices(i_vertices, o_welded, o_ids, WorkStealingThreadPool::GetGlobalInstance());
+}
+
+void WeldVertices(const std::vector<BasicPoint3D>& i_vertices, std::vector<BasicPoint3D>& o_welded, std::vector<std::uint32_t>& o_ids, WorkStealingThreadPool& i_pool)
+{
+    Q_ASSERT(i_vertices.size() < IndexedMesh::INVALID_ID);
+
+    const auto first_occurrences = FindFirstOccurrences(i_pool, i_vertices.size(),
+        [&i_vertices](size_t i_index)
+        {
+            size_t hash = 0;
+            for (const auto coordinate : i_vertices[i_index].m_coordinates)
+                boost::hash_combine(hash, coordinate + 0.0); // -0.0 and 0.0 are equal and must get the same hash
+            return hash;
+        },
+        [&i_vertices](std::uint32_t i_lhs, std::uint32_t i_rhs)
+        {
+            const auto& lhs = i_vertices[i_lhs];
+            const auto& rhs = i_vertices[i_rhs];
+            return std::tie(lhs.m_coordinates[0], lhs.m_coordinates[1], lhs.m_coordinates[2]) < std::tie(rhs.m_coordinates[0], rhs.m_coordinates[1], rhs.m_coordinates[2]);
+        },
+        [&i_vertices](std::uint32_t i_lhs, std::uint32_t i_rhs)
+        {
+            return i_vertices[i_lhs] == i_vertices[i_rhs];
+        });
+
+    // welded ids are given in the order of first occurrences: every chunk counts its first occurrences, then
+    // numbers them from the total of the chunks before it
+    constexpr size_t CHUNK_SIZE = 1 << 16;
+    const auto chunks_count = (i_vertices.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::uint32_t> chunk_offsets(chunks_count + 1, 0);
+    i_pool.ParallelFor(chunks_count, 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto chunk = i_begin; chunk < i_end; ++chunk)
+        {
+            for (auto i = chunk * CHUNK_SIZE; i < std::min(i_vertices.size(), (chunk + 1) * CHUNK_SIZE); ++i)
+                chunk_offsets[chunk + 1] += first_occurrences[i] == i ? 1 : 0;
+        }
+    });
+    std::partial_sum(chunk_offsets.begin(), chunk_offsets.end(), chunk_offsets.begin());
+
+    o_welded.resize(chunk_offsets.back());
+    o_ids.resize(i_vertices.size());
+    i_pool.ParallelFor(chunks_count, 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto chunk = i_begin; chunk < i_end; ++chunk)
+        {
+            auto id = chunk_offsets[chunk];
+            for (auto i = chunk * CHUNK_SIZE; i < std::min(i_vertices.size(), (chunk + 1) * CHUNK_SIZE); ++i)
+            {
+                if (first_occurrences[i] == i)
+                {
+                    o_welded[id] = i_vertices[i];
+                    o_ids[i] = id++;
+                }
+            }
+        }
+    });
+    // repeated vertices take the id of their first occurrence, which may lie in another chunk
+    i_pool.ParallelFor(i_vertices.size(), CHUNK_SIZE, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+        {
+            if (first_occurrences[i] != i)
+                o_ids[i] = o_ids[first_occurrences[i]];
+        }
+    });
+}
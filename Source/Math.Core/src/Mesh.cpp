@@ -1,14 +1,22 @@
 #include "Math.Core/Mesh.h"
 
 #include "Math.Core/BoundingBox.h"
+#include "Math.Core/IndexedMesh.h"
 #include "Math.Core/MeshPoint.h"
 #include "Math.Core/MeshTriangle.h"
+#include "Math.Core/WorkStealingThreadPool.h"
 
+#include "FirstOccurrences.h"
+
+#include <algorithm>
+#include <array>
 #include <vector>
 
+#include <boost/functional/hash.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/random_access_index.hpp>
+#include <boost/unordered_map.hpp>
 
 ////////////////////////////////////////////////////
 
@@ -389,6 +397,11 @@ struct Mesh::Impl
     QString m_name;
 
     std::unique_ptr<BoundingBox> mp_bbox_cache;
+    std::unique_ptr<IndexedMesh> mp_indexed_mesh_cache;
+
+    // set by BuildFromIndexedArrays: mp_indexed_mesh_cache holds the mesh and
+    // the points and triangles above are created on first use
+    bool m_objects_pending = false;
 };
 
 
@@ -407,6 +420,8 @@ Mesh::~Mesh() = default;
 
 MeshPoint* Mesh::AddPoint(const Point3D& i_point)
 {
+    _EnsureObjects();
+
     if (auto p_point = GetPoint(i_point))
         return p_point;
 
@@ -423,6 +438,8 @@ MeshPoint* Mesh::AddPoint(double i_x, double i_y, double i_z)
 
 TriangleHandle Mesh::AddTriangle(const Point3D& i_a, const Point3D& i_b, const Point3D& i_c)
 {
+    _EnsureObjects();
+
     auto p_pnt1 = AddPoint(i_a);
     auto p_pnt2 = AddPoint(i_b);
     auto p_pnt3 = AddPoint(i_c);
@@ -443,6 +460,8 @@ TriangleHandle Mesh::AddTriangle(const Point3D& i_a, const Point3D& i_b, const P
 
 MeshPoint* Mesh::GetPoint(const Point3D& i_point) const
 {
+    _EnsureObjects();
+
     return mp_impl->m_points.GetPoint(i_point);
 }
 
@@ -453,12 +472,16 @@ MeshPoint* Mesh::GetPoint(double i_x, double i_y, double i_z) const
 
 MeshPoint* Mesh::GetPoint(size_t i_index) const
 {
+    _EnsureObjects();
+
     Q_ASSERT(i_index >= 0 && i_index < GetPointsCount());
     return mp_impl->m_points.GetPointAt(i_index);
 }
 
 TriangleHandle Mesh::GetTriangleOrientationDependent(const Point3D& i_a, const Point3D& i_b, const Point3D& i_c) const
 {
+    _EnsureObjects();
+
     return mp_impl->m_triangles.GetTriangle({ i_a, i_b, i_c });
 }
 
@@ -471,17 +494,23 @@ TriangleHandle Mesh::GetTriangleOrientationIndependent(const Point3D& i_a, const
 
 TriangleHandle Mesh::GetTriangle(size_t i_index) const
 {
+    _EnsureObjects();
+
     Q_ASSERT(i_index >= 0 && i_index < GetTrianglesCount());
     return mp_impl->m_triangles.GetTriangleAt(i_index);
 }
 
 TriangleHandle Mesh::GetTriangle(const Triangle& i_triangle) const
 {
+    _EnsureObjects();
+
     return mp_impl->m_triangles.GetTriangle(i_triangle);
 }
 
 std::vector<TriangleHandle> Mesh::GetTrianglesIncidentToEdge(const Point3D& i_a, const Point3D& i_b) const
 {
+    _EnsureObjects();
+
     return mp_impl->m_triangles.GetTrianglesIncidentToEdge(i_a, i_b);
 }
 
@@ -512,6 +541,8 @@ void Mesh::UpdatePointCoordinates(const Point3D& i_old_coordinates, const Point3
 
 void Mesh::RemovePoint(const Point3D& i_point)
 {
+    _EnsureObjects();
+
     mp_impl->m_triangles.RemoveTrianglesWithVertex(i_point);
     mp_impl->m_points.RemovePoint(i_point);
 
@@ -538,11 +569,15 @@ void Mesh::RemoveTriangle(const Point3D& i_a, const Point3D& i_b, const Point3D&
 
 size_t Mesh::GetPointsCount() const
 {
+    if (mp_impl->m_objects_pending)
+        return mp_impl->mp_indexed_mesh_cache->GetVerticesCount();
     return mp_impl->m_points.GetPointsCount();
 }
 
 size_t Mesh::GetTrianglesCount() const
 {
+    if (mp_impl->m_objects_pending)
+        return mp_impl->mp_indexed_mesh_cache->GetFacesCount();
     return mp_impl->m_triangles.GetTrianglesCount();
 }
 
@@ -562,16 +597,140 @@ const BoundingBox& Mesh::GetBoundingBox() const
     {
         mp_impl->mp_bbox_cache = std::make_unique<BoundingBox>();
 
-        for (size_t i = 0; i < GetPointsCount(); ++i)
+        if (mp_impl->m_objects_pending)
+        {
+            for (const auto& vertex : mp_impl->mp_indexed_mesh_cache->GetVertices())
+                mp_impl->mp_bbox_cache->AddPoint(ToPoint3D(vertex));
+        }
+        else
         {
-            mp_impl->mp_bbox_cache->AddPoint(*GetPoint(i));
+            for (size_t i = 0; i < GetPointsCount(); ++i)
+                mp_impl->mp_bbox_cache->AddPoint(*GetPoint(i));
         }
     }
 
     return *mp_impl->mp_bbox_cache;
 }
 
+const IndexedMesh& Mesh::GetIndexedMesh() const
+{
+    if (!mp_impl->mp_indexed_mesh_cache)
+    {
+        auto p_indexed_mesh = std::make_unique<IndexedMesh>();
+        p_indexed_mesh->Reserve(GetPointsCount(), GetTrianglesCount());
+
+        boost::unordered_map<Point3D, IndexedMesh::VertexId> point_ids;
+        point_ids.reserve(GetPointsCount());
+        for (size_t i = 0; i < GetPointsCount(); ++i)
+        {
+            const auto& point = *GetPoint(i);
+            point_ids.emplace(point, p_indexed_mesh->AddVertex(ToBasicPoint(point)));
+        }
+
+        for (size_t i = 0; i < GetTrianglesCount(); ++i)
+        {
+            const auto p_triangle = GetTriangle(i).lock();
+            Q_ASSERT(p_triangle);
+            p_indexed_mesh->AddFace(point_ids.at(p_triangle->GetPoint(0)), point_ids.at(p_triangle->GetPoint(1)), point_ids.at(p_triangle->GetPoint(2)));
+        }
+
+        mp_impl->mp_indexed_mesh_cache = std::move(p_indexed_mesh);
+    }
+
+    return *mp_impl->mp_indexed_mesh_cache;
+}
+
+void Mesh::Assign(const IndexedMesh& i_mesh)
+{
+    BuildFromIndexedArrays(i_mesh.GetVertices(), i_mesh.GetCorners());
+}
+
+void Mesh::BuildFromIndexedArrays(const std::vector<BasicPoint3D>& i_vertices, const std::vector<std::uint32_t>& i_indices)
+{
+    Q_ASSERT(i_indices.size() % 3 == 0);
+
+    auto p_impl = std::make_unique<Impl>();
+    p_impl->m_name = mp_impl->m_name;
+    mp_impl = std::move(p_impl);
+
+    std::vector<BasicPoint3D> vertices;
+    std::vector<std::uint32_t> vertex_ids;
+    WeldVertices(i_vertices, vertices, vertex_ids);
+
+    // faces are keyed by their vertices starting from the smallest id, so a face repeated with another first vertex
+    // is found as well. Repeated faces are dropped like AddTriangle does, the first one stays
+    const auto faces_count = i_indices.size() / 3;
+    Q_ASSERT(faces_count < IndexedMesh::INVALID_ID);
+    auto& pool = WorkStealingThreadPool::GetGlobalInstance();
+    std::vector<std::array<std::uint32_t, 3>> face_keys(faces_count);
+    pool.ParallelFor(faces_count, 1 << 16, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto face = i_begin; face < i_end; ++face)
+        {
+            const std::array<std::uint32_t, 3> face_vertices = { vertex_ids[i_indices[3 * face]], vertex_ids[i_indices[3 * face + 1]], vertex_ids[i_indices[3 * face + 2]] };
+            const auto first = std::min_element(face_vertices.begin(), face_vertices.end()) - face_vertices.begin();
+            face_keys[face] = { face_vertices[first], face_vertices[(first + 1) % 3], face_vertices[(first + 2) % 3] };
+        }
+    });
+
+    const auto first_occurrences = FindFirstOccurrences(pool, faces_count,
+        [&face_keys](size_t i_face)
+        {
+            return boost::hash_range(face_keys[i_face].begin(), face_keys[i_face].end());
+        },
+        [&face_keys](std::uint32_t i_lhs, std::uint32_t i_rhs)
+        {
+            return face_keys[i_lhs] < face_keys[i_rhs];
+        },
+        [&face_keys](std::uint32_t i_lhs, std::uint32_t i_rhs)
+        {
+            return face_keys[i_lhs] == face_keys[i_rhs];
+        });
+    std::vector<std::array<std::uint32_t, 3>>().swap(face_keys);
+
+    auto p_indexed_mesh = std::make_unique<IndexedMesh>();
+    p_indexed_mesh->Reserve(vertices.size(), faces_count);
+    for (const auto& vertex : vertices)
+        p_indexed_mesh->AddVertex(vertex);
+    for (size_t face = 0; face < faces_count; ++face)
+    {
+        if (first_occurrences[face] == face)
+            p_indexed_mesh->AddFace(vertex_ids[i_indices[3 * face]], vertex_ids[i_indices[3 * face + 1]], vertex_ids[i_indices[3 * face + 2]]);
+    }
+
+    mp_impl->mp_indexed_mesh_cache = std::move(p_indexed_mesh);
+    mp_impl->m_objects_pending = true;
+}
+
+void Mesh::_EnsureObjects() const
+{
+    if (!mp_impl->m_objects_pending)
+        return;
+    mp_impl->m_objects_pending = false;
+
+    const auto& indexed_mesh = *mp_impl->mp_indexed_mesh_cache;
+
+    std::vector<MeshPoint*> points;
+    points.reserve(indexed_mesh.GetVerticesCount());
+    for (const auto& vertex : indexed_mesh.GetVertices())
+        points.push_back(mp_impl->m_points.AddPoint(ToPoint3D(vertex)));
+
+    for (IndexedMesh::FaceId face = 0; face < indexed_mesh.GetFacesCount(); ++face)
+    {
+        auto p_point1 = points[indexed_mesh.GetFaceVertex(face, 0)];
+        auto p_point2 = points[indexed_mesh.GetFaceVertex(face, 1)];
+        auto p_point3 = points[indexed_mesh.GetFaceVertex(face, 2)];
+
+        auto p_triangle = mp_impl->m_triangles.AddTriangle(Triangle{ *p_point1, *p_point2, *p_point3 });
+        p_point1->AddTriangle(p_triangle);
+        p_point2->AddTriangle(p_triangle);
+        p_point3->AddTriangle(p_triangle);
+    }
+}
+
 void Mesh::_InvalidateCache()
 {
+    Q_ASSERT(!mp_impl->m_objects_pending);
     mp_impl->mp_bbox_cache.reset();
+    mp_impl->mp_indexed_mesh_cache.reset();
 }
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Thin wrappers over double precision registers, so the kernels of Math.Core are written once.
+// Simd::Native is AVX when the build enables it (/arch:AVX, -mavx), SSE2 on x64 and scalar code otherwise.
+// Comparisons return lane masks that are only meant for And/Or/AndNot/Select/GetMask
+namespace Simd
+{
+#if defined(__AVX__)
+    struct Avx
+    {
+        using Register = __m256d;
+        static constexpr size_t WIDTH = 4;
+
+        static Register Load(const double* ip_values) { return _mm256_loadu_pd(ip_values); }
+        static void Store(double* op_values, Register i_value) { _mm256_storeu_pd(op_values, i_value); }
+        static Register Set(double i_value) { return _mm256_set1_pd(i_value); }
+        static Register Zero() { return _mm256_setzero_pd(); }
+
+        static Register Add(Register i_lhs, Register i_rhs) { return _mm256_add_pd(i_lhs, i_rhs); }
+        static Register Sub(Register i_lhs, Register i_rhs) { return _mm256_sub_pd(i_lhs, i_rhs); }
+        static Register Mul(Register i_lhs, Register i_rhs) { return _mm256_mul_pd(i_lhs, i_rhs); }
+        static Register Div(Register i_lhs, Register i_rhs) { return _mm256_div_pd(i_lhs, i_rhs); }
+        static Register Min(Register i_lhs, Register i_rhs) { return _mm256_min_pd(i_lhs, i_rhs); }
+        static Register Max(Register i_lhs, Register i_rhs) { return _mm256_max_pd(i_lhs, i_rhs); }
+        static Register Negate(Register i_value) { return _mm256_xor_pd(i_value, _mm256_set1_pd(-0.)); }
+        static Register Abs(Register i_value) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), i_value); }
+
+        static Register Greater(Register i_lhs, Register i_rhs) { return _mm256_cmp_pd(i_lhs, i_rhs, _CMP_GT_OQ); }
+        static Register GreaterOrEqual(Register i_lhs, Register i_rhs) { return _mm256_cmp_pd(i_lhs, i_rhs, _CMP_GE_OQ); }
+        static Register NotEqual(Register i_lhs, Register i_rhs) { return _mm256_cmp_pd(i_lhs, i_rhs, _CMP_NEQ_OQ); }
+        static Register And(Register i_lhs, Register i_rhs) { return _mm256_and_pd(i_lhs, i_rhs); }
+        static Register Or(Register i_lhs, Register i_rhs) { return _mm256_or_pd(i_lhs, i_rhs); }
+        static Register AndNot(Register i_mask, Register i_value) { return _mm256_andnot_pd(i_mask, i_value); }
+        static Register Select(Register i_mask, Register i_true, Register i_false) { return _mm256_blendv_pd(i_false, i_true, i_mask); }
+        // bit i is set if lane i of the mask is set
+        static unsigned GetMask(Register i_mask) { return static_cast<unsigned>(_mm256_movemask_pd(i_mask)); }
+    };
+    using Native = Avx;
+#elif defined(_M_X64) || defined(__SSE2__)
+    struct Sse2
+    {
+        using Register = __m128d;
+        static constexpr size_t WIDTH = 2;
+
+        static Register Load(const double* ip_values) { return _mm_loadu_pd(ip_values); }
+        static void Store(double* op_values, Register i_value) { _mm_storeu_pd(op_values, i_value); }
+        static Register Set(double i_value) { return _mm_set1_pd(i_value); }
+        static Register Zero() { return _mm_setzero_pd(); }
+
+        static Register Add(Register i_lhs, Register i_rhs) { return _mm_add_pd(i_lhs, i_rhs); }
+        static Register Sub(Register i_lhs, Register i_rhs) { return _mm_sub_pd(i_lhs, i_rhs); }
+        static Register Mul(Register i_lhs, Register i_rhs) { return _mm_mul_pd(i_lhs, i_rhs); }
+        static Register Div(Register i_lhs, Register i_rhs) { return _mm_div_pd(i_lhs, i_rhs); }
+        static Register Min(Register i_lhs, Register i_rhs) { return _mm_min_pd(i_lhs, i_rhs); }
+        static Register Max(Register i_lhs, Register i_rhs) { return _mm_max_pd(i_lhs, i_rhs); }
+        static Register Negate(Register i_value) { return _mm_xor_pd(i_value, _mm_set1_pd(-0.)); }
+        static Register Abs(Register i_value) { return _mm_andnot_pd(_mm_set1_pd(-0.), i_value); }
+
+        static Register Greater(Register i_lhs, Register i_rhs) { return _mm_cmpgt_pd(i_lhs, i_rhs); }
+        static Register GreaterOrEqual(Register i_lhs, Register i_rhs) { return _mm_cmpge_pd(i_lhs, i_rhs); }
+        static Register NotEqual(Register i_lhs, Register i_rhs) { return _mm_cmpneq_pd(i_lhs, i_rhs); }
+        static Register And(Register i_lhs, Register i_rhs) { return _mm_and_pd(i_lhs, i_rhs); }
+        static Register Or(Register i_lhs, Register i_rhs) { return _mm_or_pd(i_lhs, i_rhs); }
+        static Register AndNot(Register i_mask, Register i_value) { return _mm_andnot_pd(i_mask, i_value); }
+        static Register Select(Register i_mask, Register i_true, Register i_false) { return _mm_or_pd(_mm_and_pd(i_mask, i_true), _mm_andnot_pd(i_mask, i_false)); }
+        static unsigned GetMask(Register i_mask) { return static_cast<unsigned>(_mm_movemask_pd(i_mask)); }
+    };
+    using Native = Sse2;
+#else
+    // masks are 1 or 0
+    struct Scalar
+    {
+        using Register = double;
+        static constexpr size_t WIDTH = 1;
+
+        static Register Load(const double* ip_values) { return *ip_values; }
+        static void Store(double* op_values, Register i_value) { *op_values = i_value; }
+        static Register Set(double i_value) { return i_value; }
+        static Register Zero() { return 0; }
+
+        static Register Add(Register i_lhs, Register i_rhs) { return i_lhs + i_rhs; }
+        static Register Sub(Register i_lhs, Register i_rhs) { return i_lhs - i_rhs; }
+        static Register Mul(Register i_lhs, Register i_rhs) { return i_lhs * i_rhs; }
+        static Register Div(Register i_lhs, Register i_rhs) { return i_lhs / i_rhs; }
+        static Register Min(Register i_lhs, Register i_rhs) { return std::min(i_lhs, i_rhs); }
+        static Register Max(Register i_lhs, Register i_rhs) { return std::max(i_lhs, i_rhs); }
+        static Register Negate(Register i_value) { return -i_value; }
+        static Register Abs(Register i_value) { return std::abs(i_value); }
+
+        static Register Greater(Register i_lhs, Register i_rhs) { return i_lhs > i_rhs ? 1. : 0.; }
+        static Register GreaterOrEqual(Register i_lhs, Register i_rhs) { return i_lhs >= i_rhs ? 1. : 0.; }
+        static Register NotEqual(Register i_lhs, Register i_rhs) { return i_lhs != i_rhs ? 1. : 0.; }
+        static Register And(Register i_lhs, Register i_rhs) { return i_lhs != 0 && i_rhs != 0 ? 1. : 0.; }
+        static Register Or(Register i_lhs, Register i_rhs) { return i_lhs != 0 || i_rhs != 0 ? 1. : 0.; }
+        static Register AndNot(Register i_mask, Register i_value) { return i_mask == 0 && i_value != 0 ? 1. : 0.; }
+        static Register Select(Register i_mask, Register i_true, Register i_false) { return i_mask != 0 ? i_true : i_false; }
+        static unsigned GetMask(Register i_mask) { return i_mask != 0 ? 1u : 0u; }
+    };
+    using Native = Scalar;
+#endif
+}
@@ -33,9 +33,9 @@ namespace
 
 Triangle::Triangle(const Point3D& i_point1, const Point3D& i_point2, const Point3D& i_point3)
 {
-    m_points[0] = i_point1;
-    m_points[1] = i_point2;
-    m_points[2] = i_point3;
+    m_points[0] = ToBasicPoint(i_point1);
+    m_points[1] = ToBasicPoint(i_point2);
+    m_points[2] = ToBasicPoint(i_point3);
     _InvalidateHash();
 	//if (m_neighbors[0])
 	//	m_neighbors[0]->_SetNeighborForEdge(m_points[1], m_points[0], this);
@@ -69,21 +69,22 @@ Triangle::~Triangle()
 Point3D Triangle::GetPoint(short i_index) const
 {
 	Q_ASSERT(i_index >= 0 && i_index < 3);
-	return m_points[i_index];
+	return ToPoint3D(m_points[i_index]);
 }
 
 void Triangle::SetPoint(short i_index, const Point3D& i_new_point)
 {
-    if (m_points[i_index] != i_new_point)
+    const auto new_point = ToBasicPoint(i_new_point);
+    if (m_points[i_index] != new_point)
     {
-        m_points[i_index] = i_new_point;
+        m_points[i_index] = new_point;
         _InvalidateHash();
     }
 }
 
 Vector3D Triangle::GetNormal() const
 {
-	return Cross({ m_points[0], m_points[1] }, { m_points[0], m_points[2] }).Normalized();
+	return Cross({ GetPoint(0), GetPoint(1) }, { GetPoint(0), GetPoint(2) }).Normalized();
 }
 
 Triangle& Triangle::Flip()
@@ -97,7 +98,7 @@ Triangle& Triangle::operator=(const Triangle& i_other)
 {
     if (this != &i_other)
     {
-        std::copy(std::begin(i_other.m_points), std::end(i_other.m_points), std::begin(m_points));
+        m_points = i_other.m_points;
         m_hash_cache = i_other.m_hash_cache;
     }
     return *this;
@@ -0,0 +1,216 @@
+#include "Math.Core/TrianglePack.h"
+
+#include "Math.Core/Point3D.h"
+#include "Math.Core/Triangle.h"
+
+#include "SimdRegister.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+
+namespace
+{
+    constexpr double DEGENERATE_TRIANGLE_THRESHOLD = 1e-12; // relative to a00 * a11
+
+    inline double _Inverse(double i_value)
+    {
+        return i_value > 0 ? 1 / i_value : 0;
+    }
+
+    template<typename S>
+    inline typename S::Register _Clamp01(typename S::Register i_value)
+    {
+        return S::Min(S::Max(i_value, S::Zero()), S::Set(1.));
+    }
+
+    template<typename S>
+    inline typename S::Register _LengthSqr(const typename S::Register* ip_vector)
+    {
+        return S::Add(S::Add(S::Mul(ip_vector[0], ip_vector[0]), S::Mul(ip_vector[1], ip_vector[1])), S::Mul(ip_vector[2], ip_vector[2]));
+    }
+
+    template<typename S>
+    inline typename S::Register _Dot(const typename S::Register* ip_lhs, const typename S::Register* ip_rhs)
+    {
+        return S::Add(S::Add(S::Mul(ip_lhs[0], ip_rhs[0]), S::Mul(ip_lhs[1], ip_rhs[1])), S::Mul(ip_lhs[2], ip_rhs[2]));
+    }
+
+    // squared distance from the point to the segment origin + u * direction, u in [0, 1]
+    template<typename S>
+    inline typename S::Register _SegmentDistanceSqr(const typename S::Register* ip_diff, const typename S::Register* ip_direction, typename S::Register i_inv_length_sqr)
+    {
+        const auto u = _Clamp01<S>(S::Mul(_Dot<S>(ip_diff, ip_direction), i_inv_length_sqr));
+        typename S::Register rest[3];
+        for (size_t i = 0; i < 3; ++i)
+            rest[i] = S::Sub(ip_diff[i], S::Mul(u, ip_direction[i]));
+        return _LengthSqr<S>(rest);
+    }
+
+    // distance to the plane if the projection is inside the triangle, distance to the nearest edge otherwise.
+    // Both are evaluated and blended, so there are no branches
+    template<typename S>
+    inline typename S::Register _DistanceSqr(const double* ip_point, const TrianglePack4& i_pack, size_t i_lane)
+    {
+        using Register = typename S::Register;
+
+        Register diff[3], edge1[3], edge2[3], edge3[3], diff1[3];
+        for (size_t i = 0; i < 3; ++i)
+        {
+            diff[i] = S::Sub(S::Set(ip_point[i]), S::Load(&i_pack.m_origin[i][i_lane]));
+            edge1[i] = S::Load(&i_pack.m_edge1[i][i_lane]);
+            edge2[i] = S::Load(&i_pack.m_edge2[i][i_lane]);
+            edge3[i] = S::Sub(edge2[i], edge1[i]);
+            diff1[i] = S::Sub(diff[i], edge1[i]);
+        }
+
+        const auto a00 = S::Load(&i_pack.m_a00[i_lane]);
+        const auto a01 = S::Load(&i_pack.m_a01[i_lane]);
+        const auto a11 = S::Load(&i_pack.m_a11[i_lane]);
+        const auto inv_det = S::Load(&i_pack.m_inv_det[i_lane]);
+
+        const auto b0 = _Dot<S>(diff, edge1);
+        const auto b1 = _Dot<S>(diff, edge2);
+        const auto s = S::Mul(S::Sub(S::Mul(a11, b0), S::Mul(a01, b1)), inv_det);
+        const auto t = S::Mul(S::Sub(S::Mul(a00, b1), S::Mul(a01, b0)), inv_det);
+
+        Register rest[3];
+        for (size_t i = 0; i < 3; ++i)
+            rest[i] = S::Sub(S::Sub(diff[i], S::Mul(s, edge1[i])), S::Mul(t, edge2[i]));
+        const auto plane_distance_sqr = _LengthSqr<S>(rest);
+
+        const auto inside = S::And(S::And(S::GreaterOrEqual(s, S::Zero()), S::GreaterOrEqual(t, S::Zero())),
+                                   S::And(S::GreaterOrEqual(S::Set(1.), S::Add(s, t)), S::NotEqual(inv_det, S::Zero())));
+
+        const auto edges_distance_sqr = S::Min(S::Min(_SegmentDistanceSqr<S>(diff, edge1, S::Load(&i_pack.m_inv_a00[i_lane])),
+                                                      _SegmentDistanceSqr<S>(diff, edge2, S::Load(&i_pack.m_inv_a11[i_lane]))),
+                                               _SegmentDistanceSqr<S>(diff1, edge3, S::Load(&i_pack.m_inv_a22[i_lane])));
+
+        return S::Select(inside, plane_distance_sqr, edges_distance_sqr);
+    }
+}
+
+
+constexpr size_t TrianglePack4::LANES_COUNT;
+constexpr size_t PackedTriangles::NO_TRIANGLE;
+
+void SetTriangle(TrianglePack4& io_pack, size_t i_lane, const Triangle& i_triangle)
+{
+    const BasicPoint3D vertices[3] = { ToBasicPoint(i_triangle.GetPoint(0)), ToBasicPoint(i_triangle.GetPoint(1)), ToBasicPoint(i_triangle.GetPoint(2)) };
+    SetTriangle(io_pack, i_lane, vertices);
+}
+
+void SetTriangle(TrianglePack4& io_pack, size_t i_lane, const BasicPoint3D* ip_vertices)
+{
+    Q_ASSERT(i_lane < TrianglePack4::LANES_COUNT);
+
+    const auto& point0 = ip_vertices[0];
+    const auto& point1 = ip_vertices[1];
+    const auto& point2 = ip_vertices[2];
+
+    double edge1[3], edge2[3];
+    for (short i = 0; i < 3; ++i)
+    {
+        edge1[i] = point1[i] - point0[i];
+        edge2[i] = point2[i] - point0[i];
+        io_pack.m_origin[i][i_lane] = point0[i];
+        io_pack.m_edge1[i][i_lane] = edge1[i];
+        io_pack.m_edge2[i][i_lane] = edge2[i];
+    }
+
+    const auto a00 = edge1[0] * edge1[0] + edge1[1] * edge1[1] + edge1[2] * edge1[2];
+    const auto a01 = edge1[0] * edge2[0] + edge1[1] * edge2[1] + edge1[2] * edge2[2];
+    const auto a11 = edge2[0] * edge2[0] + edge2[1] * edge2[1] + edge2[2] * edge2[2];
+    const auto det = a00 * a11 - a01 * a01;
+
+    io_pack.m_a00[i_lane] = a00;
+    io_pack.m_a01[i_lane] = a01;
+    io_pack.m_a11[i_lane] = a11;
+    io_pack.m_inv_a00[i_lane] = _Inverse(a00);
+    io_pack.m_inv_a11[i_lane] = _Inverse(a11);
+    io_pack.m_inv_a22[i_lane] = _Inverse(a00 - 2 * a01 + a11);
+    io_pack.m_inv_det[i_lane] = det > DEGENERATE_TRIANGLE_THRESHOLD * a00 * a11 ? 1 / det : 0;
+}
+
+void DistanceSqr(const Point3D& i_point, const TrianglePack4& i_pack, double o_distances_sqr[4])
+{
+    const double point[3] = { i_point.GetX(), i_point.GetY(), i_point.GetZ() };
+    for (size_t lane = 0; lane < TrianglePack4::LANES_COUNT; lane += Simd::Native::WIDTH)
+        Simd::Native::Store(o_distances_sqr + lane, _DistanceSqr<Simd::Native>(point, i_pack, lane));
+}
+
+void PackedTriangles::Clear()
+{
+    m_packs.clear();
+    m_indexes.clear();
+}
+
+void PackedTriangles::Reserve(size_t i_triangles_count)
+{
+    m_packs.reserve((i_triangles_count + TrianglePack4::LANES_COUNT - 1) / TrianglePack4::LANES_COUNT);
+    m_indexes.reserve(i_triangles_count);
+}
+
+size_t PackedTriangles::Add(const Triangle& i_triangle, std::uint32_t i_index)
+{
+    const BasicPoint3D vertices[3] = { ToBasicPoint(i_triangle.GetPoint(0)), ToBasicPoint(i_triangle.GetPoint(1)), ToBasicPoint(i_triangle.GetPoint(2)) };
+    return Add(vertices, i_index);
+}
+
+size_t PackedTriangles::Add(const BasicPoint3D* ip_vertices, std::uint32_t i_index)
+{
+    const auto position = m_indexes.size();
+    if (position % TrianglePack4::LANES_COUNT == 0)
+        m_packs.emplace_back();
+
+    SetTriangle(m_packs.back(), position % TrianglePack4::LANES_COUNT, ip_vertices);
+    m_indexes.push_back(i_index);
+    return position;
+}
+
+void PackedTriangles::AlignToPack()
+{
+    m_indexes.resize(m_packs.size() * TrianglePack4::LANES_COUNT, 0);
+}
+
+size_t PackedTriangles::GetSize() const
+{
+    return m_indexes.size();
+}
+
+std::uint32_t PackedTriangles::GetIndex(size_t i_position) const
+{
+    return m_indexes[i_position];
+}
+
+size_t PackedTriangles::FindNearest(const Point3D& i_point, double& io_distance_sqr, size_t i_begin, size_t i_end) const
+{
+    Q_ASSERT(i_begin <= i_end && i_end <= m_indexes.size());
+
+    size_t nearest = NO_TRIANGLE;
+    double distances_sqr[TrianglePack4::LANES_COUNT];
+    for (auto pack = i_begin / TrianglePack4::LANES_COUNT; pack * TrianglePack4::LANES_COUNT < i_end; ++pack)
+    {
+        DistanceSqr(i_point, m_packs[pack], distances_sqr);
+
+        const auto first = pack * TrianglePack4::LANES_COUNT;
+        const auto lanes_begin = std::max(i_begin, first) - first;
+        const auto lanes_end = std::min(i_end - first, TrianglePack4::LANES_COUNT);
+        for (auto lane = lanes_begin; lane < lanes_end; ++lane)
+        {
+            if (distances_sqr[lane] < io_distance_sqr)
+            {
+                io_distance_sqr = distances_sqr[lane];
+                nearest = first + lane;
+            }
+        }
+    }
+
+    return nearest;
+}
+
+size_t PackedTriangles::GetMemoryUsage() const
+{
+    return m_packs.capacity() * sizeof(TrianglePack4) + m_indexes.capacity() * sizeof(std::uint32_t);
+}
@@ -0,0 +1,111 @@
+#include "Math.Core/TriangleSoup.h"
+
+#include "Math.Core/BinaryStream.h"
+#include "Math.Core/IndexedMesh.h"
+#include "Math.Core/Mesh.h"
+#include "Math.Core/Point3D.h"
+#include "Math.Core/TransformMatrix.h"
+#include "Math.Core/Triangle.h"
+
+#include <QtGlobal>
+
+#include <limits>
+
+
+void TriangleSoup::Clear()
+{
+    m_vertices.clear();
+    m_mesh_ids.clear();
+}
+
+void TriangleSoup::Reserve(size_t i_triangles_count)
+{
+    m_vertices.reserve(3 * i_triangles_count);
+    m_mesh_ids.reserve(i_triangles_count);
+}
+
+std::uint32_t TriangleSoup::AddMesh(const Mesh& i_mesh, const TransformMatrix& i_transform, std::uint32_t i_mesh_id)
+{
+    const auto first = static_cast<std::uint32_t>(m_mesh_ids.size());
+
+    // shared vertices are transformed once
+    const auto& indexed_mesh = i_mesh.GetIndexedMesh();
+    std::vector<BasicPoint3D> vertices;
+    vertices.reserve(indexed_mesh.GetVerticesCount());
+    for (const auto& vertex : indexed_mesh.GetVertices())
+    {
+        auto point = ToPoint3D(vertex);
+        i_transform.ApplyTransformation(point);
+        vertices.push_back(ToBasicPoint(point));
+    }
+
+    for (const auto vertex : indexed_mesh.GetCorners())
+        m_vertices.push_back(vertices[vertex]);
+    m_mesh_ids.resize(m_mesh_ids.size() + indexed_mesh.GetFacesCount(), i_mesh_id);
+    Q_ASSERT(m_mesh_ids.size() <= std::numeric_limits<std::uint32_t>::max());
+
+    return first;
+}
+
+std::uint32_t TriangleSoup::AddTriangle(const Point3D& i_a, const Point3D& i_b, const Point3D& i_c, std::uint32_t i_mesh_id)
+{
+    Q_ASSERT(m_mesh_ids.size() < std::numeric_limits<std::uint32_t>::max());
+
+    m_vertices.push_back(ToBasicPoint(i_a));
+    m_vertices.push_back(ToBasicPoint(i_b));
+    m_vertices.push_back(ToBasicPoint(i_c));
+    m_mesh_ids.push_back(i_mesh_id);
+    return static_cast<std::uint32_t>(m_mesh_ids.size() - 1);
+}
+
+size_t TriangleSoup::GetTrianglesCount() const
+{
+    return m_mesh_ids.size();
+}
+
+const BasicPoint3D* TriangleSoup::GetVertices(std::uint32_t i_triangle) const
+{
+    Q_ASSERT(i_triangle < m_mesh_ids.size());
+    return m_vertices.data() + 3 * static_cast<size_t>(i_triangle);
+}
+
+std::uint32_t TriangleSoup::GetMeshId(std::uint32_t i_triangle) const
+{
+    Q_ASSERT(i_triangle < m_mesh_ids.size());
+    return m_mesh_ids[i_triangle];
+}
+
+Triangle TriangleSoup::GetTriangle(std::uint32_t i_triangle) const
+{
+    const auto p_vertices = GetVertices(i_triangle);
+    return Triangle(ToPoint3D(p_vertices[0]), ToPoint3D(p_vertices[1]), ToPoint3D(p_vertices[2]));
+}
+
+size_t TriangleSoup::GetMemoryUsage() const
+{
+    return m_vertices.capacity() * sizeof(BasicPoint3D) + m_mesh_ids.capacity() * sizeof(std::uint32_t);
+}
+
+void TriangleSoup::Save(BinaryWriter& io_writer) const
+{
+    io_writer.WriteArray(m_vertices);
+    io_writer.WriteArray(m_mesh_ids);
+}
+
+bool TriangleSoup::Load(BinaryReader& io_reader)
+{
+    std::vector<BasicPoint3D> vertices;
+    std::vector<std::uint32_t> mesh_ids;
+    if (!io_reader.ReadArray(vertices) || !io_reader.ReadArray(mesh_ids))
+        return false;
+
+    if (vertices.size() != 3 * mesh_ids.size() || mesh_ids.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        io_reader.SetFailed();
+        return false;
+    }
+
+    m_vertices = std::move(vertices);
+    m_mesh_ids = std::move(mesh_ids);
+    return true;
+}
@@ -0,0 +1,243 @@
+#include "Math.Core/WorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    constexpr size_t NOT_A_WORKER = std::numeric_limits<size_t>::max();
+
+    struct Job
+    {
+        const std::function<void(size_t, size_t)>* mp_task = nullptr;
+
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+        std::atomic<size_t> m_pending_tasks{ 0 };
+        std::exception_ptr m_exception;
+    };
+
+    struct Task
+    {
+        Job* mp_job = nullptr;
+        size_t m_begin = 0;
+        size_t m_end = 0;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex m_mutex;
+        std::deque<Task> m_tasks;
+    };
+}
+
+struct WorkStealingThreadPool::Impl
+{
+    std::vector<std::unique_ptr<TaskQueue>> m_queues; // one per worker
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake_up;
+    std::atomic<size_t> m_queued_tasks{ 0 };
+    bool m_stop = false;
+
+    bool _TryPop(size_t i_own_queue, Task& o_task);
+    void _Execute(const Task& i_task);
+    void _WorkerLoop(size_t i_queue_index);
+    size_t _GetCurrentWorkerIndex() const;
+
+    static thread_local const Impl* sp_current_pool;
+    static thread_local size_t s_current_worker_index;
+};
+
+thread_local const WorkStealingThreadPool::Impl* WorkStealingThreadPool::Impl::sp_current_pool = nullptr;
+thread_local size_t WorkStealingThreadPool::Impl::s_current_worker_index = NOT_A_WORKER;
+
+bool WorkStealingThreadPool::Impl::_TryPop(size_t i_own_queue, Task& o_task)
+{
+    if (i_own_queue != NOT_A_WORKER)
+    {
+        auto& queue = *m_queues[i_own_queue];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if (!queue.m_tasks.empty())
+        {
+            o_task = queue.m_tasks.back();
+            queue.m_tasks.pop_back();
+            --m_queued_tasks;
+            return true;
+        }
+    }
+
+    const auto first_victim = i_own_queue == NOT_A_WORKER ? 0 : i_own_queue + 1;
+    for (size_t i = 0; i < m_queues.size(); ++i)
+    {
+        auto& queue = *m_queues[(first_victim + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if (!queue.m_tasks.empty())
+        {
+            o_task = queue.m_tasks.front();
+            queue.m_tasks.pop_front();
+            --m_queued_tasks;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingThreadPool::Impl::_Execute(const Task& i_task)
+{
+    auto& job = *i_task.mp_job;
+
+    std::exception_ptr p_exception;
+    try
+    {
+        (*job.mp_task)(i_task.m_begin, i_task.m_end);
+    }
+    catch (...)
+    {
+        p_exception = std::current_exception();
+    }
+
+    // the job lives on the stack of ParallelFor caller, it must not be touched after the lock is released
+    std::lock_guard<std::mutex> lock(job.m_mutex);
+    if (p_exception && !job.m_exception)
+        job.m_exception = p_exception;
+    if (--job.m_pending_tasks == 0)
+        job.m_done.notify_all();
+}
+
+void WorkStealingThreadPool::Impl::_WorkerLoop(size_t i_queue_index)
+{
+    sp_current_pool = this;
+    s_current_worker_index = i_queue_index;
+
+    while (true)
+    {
+        Task task;
+        if (_TryPop(i_queue_index, task))
+        {
+            _Execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wake_up.wait(lock, [this] { return m_stop || m_queued_tasks > 0; });
+        if (m_stop && m_queued_tasks == 0)
+            return;
+    }
+}
+
+size_t WorkStealingThreadPool::Impl::_GetCurrentWorkerIndex() const
+{
+    return sp_current_pool == this ? s_current_worker_index : NOT_A_WORKER;
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t i_threads_count)
+    : mp_impl(std::make_unique<Impl>())
+{
+    if (i_threads_count == 0)
+        i_threads_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    const auto workers_count = i_threads_count - 1;
+    for (size_t i = 0; i < workers_count; ++i)
+        mp_impl->m_queues.emplace_back(std::make_unique<TaskQueue>());
+
+    for (size_t i = 0; i < workers_count; ++i)
+        mp_impl->m_workers.emplace_back(&Impl::_WorkerLoop, mp_impl.get(), i);
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mp_impl->m_sleep_mutex);
+        mp_impl->m_stop = true;
+    }
+    mp_impl->m_wake_up.notify_all();
+
+    for (auto& worker : mp_impl->m_workers)
+        worker.join();
+}
+
+size_t WorkStealingThreadPool::GetThreadsCount() const
+{
+    return mp_impl->m_workers.size() + 1;
+}
+
+void WorkStealingThreadPool::ParallelFor(size_t i_count, size_t i_grain_size, const std::function<void(size_t, size_t)>& i_task)
+{
+    if (i_count == 0)
+        return;
+
+    i_grain_size = std::max<size_t>(1, i_grain_size);
+    const auto chunks_count = (i_count + i_grain_size - 1) / i_grain_size;
+
+    if (mp_impl->m_workers.empty() || chunks_count == 1)
+    {
+        for (size_t begin = 0; begin < i_count; begin += i_grain_size)
+            i_task(begin, std::min(i_count, begin + i_grain_size));
+        return;
+    }
+
+    Job job;
+    job.mp_task = &i_task;
+    job.m_pending_tasks = chunks_count;
+
+    // counted before the tasks become visible, so a thief never sees more tasks than counted
+    {
+        std::lock_guard<std::mutex> lock(mp_impl->m_sleep_mutex);
+        mp_impl->m_queued_tasks += chunks_count;
+    }
+
+    // every queue gets a contiguous range of chunks, so neighbouring elements are processed by the same thread
+    // unless they are stolen
+    const auto queues_count = mp_impl->m_queues.size();
+    for (size_t queue_index = 0; queue_index < queues_count; ++queue_index)
+    {
+        const auto first_chunk = chunks_count * queue_index / queues_count;
+        const auto last_chunk = chunks_count * (queue_index + 1) / queues_count;
+
+        auto& queue = *mp_impl->m_queues[queue_index];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        for (auto chunk = first_chunk; chunk < last_chunk; ++chunk)
+        {
+            Task task;
+            task.mp_job = &job;
+            task.m_begin = chunk * i_grain_size;
+            task.m_end = std::min(i_count, task.m_begin + i_grain_size);
+            queue.m_tasks.emplace_back(task);
+        }
+    }
+
+    mp_impl->m_wake_up.notify_all();
+
+    const auto own_queue = mp_impl->_GetCurrentWorkerIndex();
+    while (job.m_pending_tasks > 0)
+    {
+        Task task;
+        if (!mp_impl->_TryPop(own_queue, task))
+            break;
+        mp_impl->_Execute(task);
+    }
+
+    // remaining tasks of the job are already taken by other threads
+    std::unique_lock<std::mutex> lock(job.m_mutex);
+    job.m_done.wait(lock, [&job] { return job.m_pending_tasks == 0; });
+
+    if (job.m_exception)
+        std::rethrow_exception(job.m_exception);
+}
+
+WorkStealingThreadPool& WorkStealingThreadPool::GetGlobalInstance()
+{
+    static WorkStealingThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <Math.Core/BasicPoint3.h>
+
+#include <Math.Core/MeshPoint.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/Vector3D.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace ::testing;
+
+TEST(BasicPoint3, IsSmallerThanPoint3D)
+{
+    EXPECT_EQ(sizeof(BasicPoint3D), 24u);
+    EXPECT_EQ(sizeof(BasicPoint3F), 12u);
+    EXPECT_LT(sizeof(BasicPoint3D), sizeof(Point3D));
+}
+
+TEST(BasicPoint3, ConversionKeepsCoordinates)
+{
+    const Point3D point(1.5, -2.25, 1e10);
+    const auto basic_point = ToBasicPoint(point);
+    EXPECT_EQ(basic_point[0], 1.5);
+    EXPECT_EQ(basic_point[1], -2.25);
+    EXPECT_EQ(basic_point[2], 1e10);
+    EXPECT_EQ(ToPoint3D(basic_point), point);
+
+    const auto float_point = ToBasicPoint<float>(point);
+    EXPECT_EQ(ToPoint3D(float_point), Point3D(1.5, -2.25, 1e10f));
+}
+
+TEST(BasicPoint3, DerivedPointsAreConverted)
+{
+    const MeshPoint mesh_point(1, 2, 3);
+    EXPECT_EQ(ToBasicPoint(mesh_point), (BasicPoint3D{ { 1, 2, 3 } }));
+
+    const Vector3D vector(-1, 0, 4);
+    EXPECT_EQ(ToBasicPoint(vector), (BasicPoint3D{ { -1, 0, 4 } }));
+}
+
+TEST(BasicPoint3, ArraysCanBeCopiedAsBytes)
+{
+    const std::vector<BasicPoint3D> points = { { { 1, 2, 3 } }, { { 4, 5, 6 } } };
+    std::vector<BasicPoint3D> copy(points.size());
+    std::memcpy(copy.data(), points.data(), points.size() * sizeof(BasicPoint3D));
+    EXPECT_EQ(copy, points);
+}
+
+TEST(BasicPoint3, TriangleReturnsStoredPoints)
+{
+    Triangle triangle(Point3D(0, 0, 0), Point3D(1, 0, 0), Point3D(0, 1, 0));
+    EXPECT_EQ(triangle.GetPoint(1), Point3D(1, 0, 0));
+
+    const auto hash = triangle.GetHash();
+    triangle.SetPoint(1, Point3D(2, 0, 0));
+    EXPECT_EQ(triangle.GetPoint(1), Point3D(2, 0, 0));
+    EXPECT_NE(triangle.GetHash(), hash);
+}
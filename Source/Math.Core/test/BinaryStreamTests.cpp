@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <Math.Core/BinaryStream.h>
+
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/Point3D.h>
+
+#include <QBuffer>
+
+using namespace ::testing;
+
+namespace
+{
+    QByteArray _WriteSample()
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        BinaryWriter writer(buffer);
+        writer.WriteHeader("TESTDATA", 2);
+        writer.Write(static_cast<std::uint8_t>(7));
+        writer.WriteArray(std::vector<double>{ 1.5, -2.5, 3.25 });
+        BoundingBox bbox;
+        bbox.AddPoint(Point3D(-1, -2, -3));
+        bbox.AddPoint(Point3D(4, 5, 6));
+        writer.WriteBoundingBox(bbox);
+        EXPECT_TRUE(writer.IsOk());
+        return buffer.data();
+    }
+}
+
+TEST(BinaryStream, ReadsWhatWasWritten)
+{
+    const auto data = _WriteSample();
+    BinaryReader reader(data.data(), static_cast<size_t>(data.size()));
+
+    std::uint32_t version = 0;
+    ASSERT_TRUE(reader.ReadHeader("TESTDATA", 2, &version));
+    EXPECT_EQ(version, 2u);
+
+    std::uint8_t value = 0;
+    ASSERT_TRUE(reader.Read(value));
+    EXPECT_EQ(value, 7);
+
+    size_t count = 0;
+    const auto p_values = reader.ViewArray<double>(count);
+    ASSERT_EQ(count, 3u);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p_values) - reinterpret_cast<std::uintptr_t>(data.data()), 32u);
+    EXPECT_EQ(p_values[1], -2.5);
+
+    BoundingBox bbox;
+    ASSERT_TRUE(reader.ReadBoundingBox(bbox));
+    EXPECT_EQ(bbox.GetMin(), Point3D(-1, -2, -3));
+    EXPECT_EQ(bbox.GetMax(), Point3D(4, 5, 6));
+}
+
+TEST(BinaryStream, RejectsOtherMagicAndNewerVersion)
+{
+    const auto data = _WriteSample();
+    BinaryReader other_magic(data.data(), static_cast<size_t>(data.size()));
+    EXPECT_FALSE(other_magic.ReadHeader("OTHERDAT", 2));
+
+    BinaryReader newer_version(data.data(), static_cast<size_t>(data.size()));
+    EXPECT_FALSE(newer_version.ReadHeader("TESTDATA", 1));
+    EXPECT_FALSE(newer_version.IsOk());
+}
+
+TEST(BinaryStream, FailsOnTruncatedData)
+{
+    const auto data = _WriteSample();
+    BinaryReader reader(data.data(), static_cast<size_t>(data.size()) - 1);
+    std::uint8_t value = 0;
+    std::vector<double> values;
+    BoundingBox bbox;
+    EXPECT_TRUE(reader.ReadHeader("TESTDATA", 2));
+    EXPECT_TRUE(reader.Read(value));
+    EXPECT_TRUE(reader.ReadArray(values));
+    EXPECT_FALSE(reader.ReadBoundingBox(bbox));
+    EXPECT_FALSE(reader.IsOk());
+    EXPECT_FALSE(reader.Read(value));
+}
@@ -2,13 +2,53 @@
 
 #include <Math.Core/CommonUtilities.h>
 
+#include <Math.Core/BoundingBox.h>
 #include <Math.Core/Point3D.h>
 #include <Math.Core/Triangle.h>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
 
 using namespace ::testing;
 
+namespace
+{
+    // previous implementation: distance to the nearest of 12 triangles covering the box faces
+    double _ReferenceDistance(const Point3D& i_point, const BoundingBox& i_bbox)
+    {
+        if (i_bbox.ContainsPoint(i_point))
+            return 0;
+
+        const auto min_point = i_bbox.GetMin();
+        const auto max_point = i_bbox.GetMax();
+        std::vector<Point3D> nodes;
+        for (auto i = 0u; i < 8; ++i)
+        {
+            nodes.emplace_back((i & 1) ? max_point.Get(0) : min_point.Get(0),
+                               (i & 2) ? max_point.Get(1) : min_point.Get(1),
+                               (i & 4) ? max_point.Get(2) : min_point.Get(2));
+        }
+
+        const int faces[12][3] = { {0, 1, 2}, {1, 2, 3}, {0, 1, 5}, {0, 5, 4}, {0, 2, 6}, {0, 6, 4},
+                                   {1, 3, 7}, {1, 7, 5}, {2, 3, 7}, {2, 7, 6}, {4, 5, 7}, {4, 7, 6} };
+        auto distance = std::numeric_limits<double>::max();
+        for (const auto& face : faces)
+            distance = std::min(distance, Distance(i_point, Triangle(nodes[face[0]], nodes[face[1]], nodes[face[2]])));
+        return distance;
+    }
+
+    BoundingBox _MakeBox(const Point3D& i_min, const Point3D& i_max)
+    {
+        BoundingBox bbox;
+        bbox.AddPoint(i_min);
+        bbox.AddPoint(i_max);
+        return bbox;
+    }
+}
+
 TEST(Distance, PointIsInsideTriangle)
 {
     Point3D triangle_points[3] = { {0, 0, 0}, {2, 0, 0}, {0, 2, 0} };
@@ -29,6 +69,16 @@ TEST(Distance, ProjectionIsInsideTriangle)
     EXPECT_DOUBLE_EQ(Distance(point, triangle), 3.2514);
 }
 
+TEST(Distance, PointIsInsideObtuseTriangle)
+{
+    Point3D triangle_points[3] = { {0, 0, 0}, {2, -2, 0}, {1, 2, 0} };
+    Triangle triangle(triangle_points[0], triangle_points[1], triangle_points[2]);
+
+    Point3D point(1, 1, 0);
+
+    EXPECT_DOUBLE_EQ(Distance(point, triangle), 0);
+}
+
 TEST(Distance, PointAndTriangleAreOnSamePlaneAndPerpendicularIsOnEdge)
 {
     Point3D triangle_points[3] = { {0, 0, 0}, {2, 0, 0}, {0, 2, 0} };
@@ -94,3 +144,156 @@ TEST(Distance, PointAndTriangleAreNotOnSamePlaneAndPerpendicularIsNotOnEdge_Shou
     EXPECT_DOUBLE_EQ(Distance(point_to_2, triangle), std::sqrt(11));
 }
 
+
+TEST(DistanceToBoundingBox, PointInsideOrOnBoundary)
+{
+    const auto bbox = _MakeBox({ -1, -2, -3 }, { 1, 2, 3 });
+
+    EXPECT_EQ(Distance(Point3D(0, 0, 0), bbox), 0);
+    EXPECT_EQ(Distance(Point3D(1, 2, 3), bbox), 0);
+    EXPECT_EQ(DistanceSqr(Point3D(-1, 0, 3), bbox), 0);
+}
+
+TEST(DistanceToBoundingBox, FaceEdgeAndCornerRegions)
+{
+    const auto bbox = _MakeBox({ 0, 0, 0 }, { 1, 1, 1 });
+
+    EXPECT_DOUBLE_EQ(Distance(Point3D(0.5, 0.5, 3), bbox), 2);
+    EXPECT_DOUBLE_EQ(Distance(Point3D(2, 0.5, 2), bbox), std::sqrt(2));
+    EXPECT_DOUBLE_EQ(DistanceSqr(Point3D(-1, -2, 3), bbox), 1 + 4 + 4);
+}
+
+TEST(DistanceToBoundingBox, MatchesTrianglesBasedReference)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        const Point3D corner1(coordinate(generator), coordinate(generator), coordinate(generator));
+        const Point3D corner2(coordinate(generator), coordinate(generator), coordinate(generator));
+        const auto bbox = _MakeBox(corner1, corner2);
+        const Point3D point(coordinate(generator), coordinate(generator), coordinate(generator));
+
+        const auto expected = _ReferenceDistance(point, bbox);
+        EXPECT_NEAR(Distance(point, bbox), expected, 1e-9);
+        EXPECT_NEAR(DistanceSqr(point, bbox), expected * expected, 1e-9);
+    }
+}
+
+TEST(DistanceToBoundingBox, PackMatchesSingleBoxes)
+{
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        const auto boxes_count = i % 4 + 1;
+        BoundingBoxPack4 pack;
+        std::vector<BoundingBox> boxes;
+        for (size_t k = 0; k < boxes_count; ++k)
+        {
+            boxes.push_back(_MakeBox({ coordinate(generator), coordinate(generator), coordinate(generator) },
+                                     { coordinate(generator), coordinate(generator), coordinate(generator) }));
+            SetBoundingBox(pack, k, boxes.back());
+        }
+        const Point3D point(coordinate(generator), coordinate(generator), coordinate(generator));
+
+        double distances_sqr[4];
+        DistanceSqr(point, pack, distances_sqr);
+        for (size_t k = 0; k < 4; ++k)
+        {
+            if (k < boxes_count)
+                EXPECT_DOUBLE_EQ(distances_sqr[k], DistanceSqr(point, boxes[k]));
+            else
+                EXPECT_GT(distances_sqr[k], 1e100);
+        }
+    }
+}
+
+TEST(TriangleWithBBoxesIntersection, MatchesSingleBoxTest)
+{
+    std::mt19937 generator(13);
+    std::uniform_real_distribution<double> coordinate(-3, 3);
+    std::uniform_int_distribution<int> grid_coordinate(-2, 2);
+
+    size_t intersections = 0;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        // every other case is snapped to a grid, so triangles touch boxes by vertices, edges and faces
+        const bool snapped = i % 2 == 0;
+        auto random_point = [&]()
+        {
+            return snapped ? Point3D(grid_coordinate(generator), grid_coordinate(generator), grid_coordinate(generator))
+                           : Point3D(coordinate(generator), coordinate(generator), coordinate(generator));
+        };
+
+        const Triangle triangle(random_point(), random_point(), random_point());
+        const auto boxes_count = i % 4 + 1;
+        BoundingBoxPack4 pack;
+        unsigned expected = 0;
+        for (size_t k = 0; k < boxes_count; ++k)
+        {
+            const auto bbox = _MakeBox(random_point(), random_point());
+            SetBoundingBox(pack, k, bbox);
+            if (TriangleWithBBoxIntersection(triangle, bbox))
+                expected |= 1u << k;
+        }
+
+        EXPECT_EQ(TriangleWithBBoxesIntersection(triangle, pack), expected);
+        intersections += expected != 0;
+    }
+
+    // both outcomes are covered
+    EXPECT_GT(intersections, 100u);
+    EXPECT_LT(intersections, 1900u);
+}
+
+TEST(GetRayXCrossing, CrossingBeyondOrigin)
+{
+    const Triangle triangle(Point3D(1, -1, -1), Point3D(1, 1, -1), Point3D(3, 0, 1));
+    double x = 0;
+    ASSERT_TRUE(GetRayXCrossing(triangle, Point3D(0, 0, 0), x));
+    EXPECT_NEAR(x, 2, 1e-12);
+    EXPECT_FALSE(GetRayXCrossing(triangle, Point3D(2.5, 0, 0), x));
+    EXPECT_FALSE(GetRayXCrossing(triangle, Point3D(0, 0, 2), x));
+}
+
+TEST(GetRayXCrossing, RaysThroughEdgesAndVerticesKeepParity)
+{
+    // cube [0, 2]^3 of 12 triangles, the rays start on the grid, so they often pass through edges and vertices
+    std::vector<Point3D> nodes;
+    for (auto i = 0u; i < 8; ++i)
+        nodes.emplace_back((i & 1) ? 2 : 0, (i & 2) ? 2 : 0, (i & 4) ? 2 : 0);
+    const int faces[12][3] = { {0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6}, {0, 1, 4}, {1, 5, 4},
+                               {2, 6, 3}, {3, 6, 7}, {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5} };
+    std::vector<BasicPoint3D> vertices;
+    for (const auto& face : faces)
+    {
+        for (const auto node : face)
+            vertices.push_back(ToBasicPoint(nodes[node]));
+    }
+
+    for (const auto x : { -0.5, 0.5, 1.5, 2.5 })
+    {
+        for (auto y = -1; y <= 3; ++y)
+        {
+            for (auto z = -1; z <= 3; ++z)
+            {
+                const Point3D origin(x, y, z);
+                size_t crossings_count = 0;
+                for (size_t triangle = 0; triangle < 12; ++triangle)
+                {
+                    double crossing_x = 0;
+                    crossings_count += GetRayXCrossing(&vertices[3 * triangle], origin, crossing_x) ? 1 : 0;
+                }
+
+                // ties move the ray towards +y and +z
+                const bool is_inside = x > 0 && x < 2 && y >= 0 && y < 2 && z >= 0 && z < 2;
+                EXPECT_EQ(crossings_count % 2 == 1, is_inside) << x << " " << y << " " << z;
+                // the diagonal of a side doesn't add crossings
+                EXPECT_LE(crossings_count, 2u);
+            }
+        }
+    }
+}
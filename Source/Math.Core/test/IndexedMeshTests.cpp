@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <Math.Core/IndexedMesh.h>
+
+#include <Math.Core/Mesh.h>
+#include <Math.Core/MeshTriangle.h>
+#include <Math.Core/WorkStealingThreadPool.h>
+
+using namespace ::testing;
+
+namespace
+{
+    IndexedMesh _MakeTetrahedron()
+    {
+        IndexedMesh mesh;
+        const auto a = mesh.AddVertex({ { 0, 0, 0 } });
+        const auto b = mesh.AddVertex({ { 1, 0, 0 } });
+        const auto c = mesh.AddVertex({ { 0, 1, 0 } });
+        const auto d = mesh.AddVertex({ { 0, 0, 1 } });
+        mesh.AddFace(a, c, b);
+        mesh.AddFace(a, b, d);
+        mesh.AddFace(b, c, d);
+        mesh.AddFace(c, a, d);
+        return mesh;
+    }
+}
+
+TEST(IndexedMesh, ClosedMeshHasAllOpposites)
+{
+    auto mesh = _MakeTetrahedron();
+    EXPECT_FALSE(mesh.HasAdjacency());
+    mesh.BuildAdjacency();
+    ASSERT_TRUE(mesh.HasAdjacency());
+
+    for (IndexedMesh::CornerId corner = 0; corner < 3 * mesh.GetFacesCount(); ++corner)
+    {
+        const auto opposite = mesh.GetOpposite(corner);
+        ASSERT_NE(opposite, IndexedMesh::INVALID_ID);
+        EXPECT_NE(IndexedMesh::GetFace(opposite), IndexedMesh::GetFace(corner));
+        EXPECT_EQ(mesh.GetOpposite(opposite), corner);
+
+        // the corners face the same edge
+        const auto edge_a = mesh.GetCornerVertex(IndexedMesh::GetNext(corner));
+        const auto edge_b = mesh.GetCornerVertex(IndexedMesh::GetPrevious(corner));
+        const auto opposite_a = mesh.GetCornerVertex(IndexedMesh::GetNext(opposite));
+        const auto opposite_b = mesh.GetCornerVertex(IndexedMesh::GetPrevious(opposite));
+        EXPECT_TRUE((edge_a == opposite_b && edge_b == opposite_a) || (edge_a == opposite_a && edge_b == opposite_b));
+    }
+
+    for (IndexedMesh::VertexId vertex = 0; vertex < mesh.GetVerticesCount(); ++vertex)
+    {
+        EXPECT_EQ(mesh.GetVertexFacesCount(vertex), 3u);
+        EXPECT_EQ(mesh.GetVertexNeighbours(vertex).size(), 3u);
+    }
+}
+
+TEST(IndexedMesh, BoundaryEdgesHaveNoOpposite)
+{
+    IndexedMesh mesh;
+    const auto a = mesh.AddVertex({ { 0, 0, 0 } });
+    const auto b = mesh.AddVertex({ { 1, 0, 0 } });
+    const auto c = mesh.AddVertex({ { 0, 1, 0 } });
+    const auto d = mesh.AddVertex({ { 1, 1, 0 } });
+    mesh.AddFace(a, b, c);
+    mesh.AddFace(b, d, c);
+    mesh.BuildAdjacency();
+
+    // only the diagonal b-c is shared, it faces corner 0 (vertex a) and corner 4 (vertex d)
+    EXPECT_EQ(mesh.GetOpposite(0), 4u);
+    EXPECT_EQ(mesh.GetOpposite(4), 0u);
+    for (IndexedMesh::CornerId corner : { 1u, 2u, 3u, 5u })
+        EXPECT_EQ(mesh.GetOpposite(corner), IndexedMesh::INVALID_ID);
+
+    EXPECT_EQ(mesh.GetVertexFacesCount(a), 1u);
+    EXPECT_EQ(mesh.GetVertexFacesCount(b), 2u);
+}
+
+TEST(IndexedMesh, AdjacencyIsBuiltOnFirstUse)
+{
+    const auto mesh = _MakeTetrahedron();
+    EXPECT_FALSE(mesh.HasAdjacency());
+    EXPECT_NE(mesh.GetOpposite(0), IndexedMesh::INVALID_ID);
+    EXPECT_TRUE(mesh.HasAdjacency());
+}
+
+TEST(IndexedMesh, ChangingFacesDropsAdjacency)
+{
+    auto mesh = _MakeTetrahedron();
+    mesh.BuildAdjacency();
+    mesh.SetFace(0, 0, 1, 2);
+    EXPECT_FALSE(mesh.HasAdjacency());
+}
+
+TEST(IndexedMesh, MatchesMesh)
+{
+    Mesh mesh;
+    mesh.AddTriangle({ 0, 0, 0 }, { 0, 1, 0 }, { 1, 0, 0 });
+    mesh.AddTriangle({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 0, 1 });
+    mesh.AddTriangle({ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 });
+    mesh.AddTriangle({ 0, 1, 0 }, { 0, 0, 0 }, { 0, 0, 1 });
+
+    const auto& indexed_mesh = mesh.GetIndexedMesh();
+    ASSERT_EQ(indexed_mesh.GetVerticesCount(), mesh.GetPointsCount());
+    ASSERT_EQ(indexed_mesh.GetFacesCount(), mesh.GetTrianglesCount());
+
+    for (IndexedMesh::FaceId face = 0; face < indexed_mesh.GetFacesCount(); ++face)
+    {
+        const auto p_triangle = mesh.GetTriangle(face).lock();
+        for (short i = 0; i < 3; ++i)
+            EXPECT_EQ(ToPoint3D(indexed_mesh.GetVertex(indexed_mesh.GetFaceVertex(face, i))), p_triangle->GetPoint(i));
+    }
+
+    Mesh copy;
+    copy.Assign(indexed_mesh);
+    EXPECT_EQ(copy.GetPointsCount(), mesh.GetPointsCount());
+    EXPECT_EQ(copy.GetTrianglesCount(), mesh.GetTrianglesCount());
+    EXPECT_EQ(copy.GetTrianglesIncidentToEdge({ 0, 0, 0 }, { 0, 0, 1 }).size(), 2u);
+}
+
+TEST(IndexedMesh, WeldVerticesKeepsFirstOccurrenceOrder)
+{
+    const std::vector<BasicPoint3D> vertices = { { { 1, 0, 0 } }, { { 0, 0, 0 } }, { { 1, 0, 0 } }, { { 0, 0, -0. } }, { { 2, 0, 0 } } };
+
+    std::vector<BasicPoint3D> welded;
+    std::vector<std::uint32_t> ids;
+    WeldVertices(vertices, welded, ids);
+
+    ASSERT_EQ(welded.size(), 3u);
+    EXPECT_EQ(welded[0], vertices[0]);
+    EXPECT_EQ(welded[1], vertices[1]);
+    EXPECT_EQ(welded[2], vertices[4]);
+    EXPECT_EQ(ids, (std::vector<std::uint32_t>{ 0, 1, 0, 1, 2 }));
+}
+
+TEST(IndexedMesh, WeldVerticesDoesNotDependOnThreadsCount)
+{
+    // enough vertices for several chunks, every point repeats in a scattered order
+    std::vector<BasicPoint3D> vertices;
+    for (std::uint32_t i = 0; i < 300000; ++i)
+    {
+        const auto key = (i * 7919u) % 50000u;
+        vertices.push_back({ { static_cast<double>(key % 50), static_cast<double>(key / 50 % 40), -static_cast<double>(key / 2000) } });
+    }
+
+    std::vector<BasicPoint3D> welded1, welded4;
+    std::vector<std::uint32_t> ids1, ids4;
+    WorkStealingThreadPool pool1(1), pool4(4);
+    WeldVertices(vertices, welded1, ids1, pool1);
+    WeldVertices(vertices, welded4, ids4, pool4);
+
+    ASSERT_EQ(welded1.size(), 50000u);
+    EXPECT_EQ(welded1, welded4);
+    EXPECT_EQ(ids1, ids4);
+    for (size_t i = 0; i < vertices.size(); ++i)
+        ASSERT_EQ(welded4[ids4[i]], vertices[i]);
+}
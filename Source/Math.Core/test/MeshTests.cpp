@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <Math.Core/Mesh.h>
+
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/IndexedMesh.h>
+#include <Math.Core/MeshPoint.h>
+#include <Math.Core/MeshTriangle.h>
+
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+    // tetrahedron as a triangle soup, three vertices per face
+    std::vector<BasicPoint3D> _GetTetrahedronSoup()
+    {
+        const BasicPoint3D a = { { 0, 0, 0 } }, b = { { 1, 0, 0 } }, c = { { 0, 1, 0 } }, d = { { 0, 0, 1 } };
+        return { a, c, b, a, b, d, b, c, d, c, a, d };
+    }
+
+    std::vector<std::uint32_t> _GetSoupIndices(size_t i_vertices_count)
+    {
+        std::vector<std::uint32_t> indices(i_vertices_count);
+        for (size_t i = 0; i < indices.size(); ++i)
+            indices[i] = static_cast<std::uint32_t>(i);
+        return indices;
+    }
+}
+
+TEST(Mesh, BuildFromIndexedArraysWeldsVertices)
+{
+    const auto vertices = _GetTetrahedronSoup();
+
+    Mesh mesh;
+    mesh.BuildFromIndexedArrays(vertices, _GetSoupIndices(vertices.size()));
+    EXPECT_EQ(mesh.GetPointsCount(), 4u);
+    EXPECT_EQ(mesh.GetTrianglesCount(), 4u);
+    EXPECT_EQ(mesh.GetBoundingBox().GetMax(), Point3D(1, 1, 1));
+
+    const auto& indexed_mesh = mesh.GetIndexedMesh();
+    for (IndexedMesh::CornerId corner = 0; corner < 12; ++corner)
+        EXPECT_NE(indexed_mesh.GetOpposite(corner), IndexedMesh::INVALID_ID);
+}
+
+TEST(Mesh, BuildFromIndexedArraysMatchesAddTriangle)
+{
+    const auto vertices = _GetTetrahedronSoup();
+
+    Mesh bulk_mesh;
+    bulk_mesh.BuildFromIndexedArrays(vertices, _GetSoupIndices(vertices.size()));
+
+    Mesh mesh;
+    for (size_t i = 0; i < vertices.size(); i += 3)
+        mesh.AddTriangle(ToPoint3D(vertices[i]), ToPoint3D(vertices[i + 1]), ToPoint3D(vertices[i + 2]));
+
+    ASSERT_EQ(bulk_mesh.GetPointsCount(), mesh.GetPointsCount());
+    ASSERT_EQ(bulk_mesh.GetTrianglesCount(), mesh.GetTrianglesCount());
+    for (size_t i = 0; i < mesh.GetPointsCount(); ++i)
+    {
+        EXPECT_EQ(*bulk_mesh.GetPoint(i), *mesh.GetPoint(i));
+        EXPECT_EQ(bulk_mesh.GetPoint(i)->GetTriangles().size(), mesh.GetPoint(i)->GetTriangles().size());
+    }
+    for (size_t i = 0; i < mesh.GetTrianglesCount(); ++i)
+    {
+        const auto p_bulk_triangle = bulk_mesh.GetTriangle(i).lock();
+        const auto p_triangle = mesh.GetTriangle(i).lock();
+        EXPECT_EQ(*p_bulk_triangle, *p_triangle);
+        for (short j = 0; j < 3; ++j)
+            EXPECT_EQ(p_bulk_triangle->GetNeighbours(j).size(), p_triangle->GetNeighbours(j).size());
+    }
+
+    // objects created on first use can be modified
+    bulk_mesh.AddTriangle({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 0, -1 });
+    EXPECT_EQ(bulk_mesh.GetTrianglesCount(), 5u);
+    EXPECT_EQ(bulk_mesh.GetIndexedMesh().GetFacesCount(), 5u);
+}
+
+TEST(Mesh, BuildFromIndexedArraysDropsRepeatedTriangles)
+{
+    const std::vector<BasicPoint3D> vertices = { { { 0, 0, 0 } }, { { 1, 0, 0 } }, { { 0, 1, 0 } } };
+
+    Mesh mesh;
+    mesh.BuildFromIndexedArrays(vertices, { 0, 1, 2, 1, 2, 0, 0, 2, 1 });
+    ASSERT_EQ(mesh.GetTrianglesCount(), 2u);
+    EXPECT_EQ(mesh.GetIndexedMesh().GetFaceVertex(1, 0), 0u);
+    EXPECT_EQ(mesh.GetIndexedMesh().GetFaceVertex(1, 1), 2u);
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <Math.Core/TrianglePack.h>
+
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+    std::vector<Triangle> _GenerateTriangles(size_t i_count, std::mt19937& io_generator)
+    {
+        std::uniform_real_distribution<double> coordinate(-5, 5);
+        auto random_point = [&]() { return Point3D(coordinate(io_generator), coordinate(io_generator), coordinate(io_generator)); };
+
+        std::vector<Triangle> triangles;
+        for (size_t i = 0; i < i_count; ++i)
+        {
+            const auto point0 = random_point();
+            const auto point1 = random_point();
+            switch (i % 8)
+            {
+            case 6: // segment
+                triangles.emplace_back(point0, point1, (point0 + point1) / 2);
+                break;
+            case 7: // point
+                triangles.emplace_back(point0, point0, point0);
+                break;
+            default:
+                triangles.emplace_back(point0, point1, random_point());
+            }
+        }
+        return triangles;
+    }
+}
+
+TEST(TrianglePack, MatchesScalarDistance)
+{
+    std::mt19937 generator(3);
+    const auto triangles = _GenerateTriangles(400, generator);
+    std::uniform_real_distribution<double> coordinate(-8, 8);
+
+    for (size_t i = 0; i < triangles.size(); i += TrianglePack4::LANES_COUNT)
+    {
+        TrianglePack4 pack;
+        for (size_t lane = 0; lane < TrianglePack4::LANES_COUNT; ++lane)
+            SetTriangle(pack, lane, triangles[i + lane]);
+
+        for (size_t k = 0; k < 20; ++k)
+        {
+            const Point3D point(coordinate(generator), coordinate(generator), coordinate(generator));
+            double distances_sqr[TrianglePack4::LANES_COUNT];
+            DistanceSqr(point, pack, distances_sqr);
+
+            for (size_t lane = 0; lane < TrianglePack4::LANES_COUNT; ++lane)
+                EXPECT_NEAR(std::sqrt(distances_sqr[lane]), Distance(point, triangles[i + lane]), 1e-9);
+        }
+    }
+}
+
+TEST(PackedTriangles, FindNearestInRange)
+{
+    std::mt19937 generator(5);
+    const auto triangles = _GenerateTriangles(37, generator);
+
+    PackedTriangles packed;
+    for (size_t i = 0; i < 5; ++i)
+        packed.Add(triangles[i], static_cast<std::uint32_t>(i));
+    packed.AlignToPack();
+    EXPECT_EQ(packed.GetSize(), 8);
+    const size_t begin = packed.GetSize();
+    for (size_t i = 5; i < triangles.size(); ++i)
+        packed.Add(triangles[i], static_cast<std::uint32_t>(i));
+
+    const Point3D point(0.5, -1, 2);
+    for (auto range : { std::make_pair(size_t(0), size_t(5)), std::make_pair(begin, packed.GetSize()), std::make_pair(begin + 3, begin + 10) })
+    {
+        size_t expected = PackedTriangles::NO_TRIANGLE;
+        double expected_distance = std::numeric_limits<double>::max();
+        for (auto position = range.first; position < range.second; ++position)
+        {
+            const auto distance = Distance(point, triangles[packed.GetIndex(position)]);
+            if (distance < expected_distance)
+            {
+                expected_distance = distance;
+                expected = position;
+            }
+        }
+
+        double distance_sqr = std::numeric_limits<double>::max();
+        EXPECT_EQ(packed.FindNearest(point, distance_sqr, range.first, range.second), expected);
+        EXPECT_NEAR(std::sqrt(distance_sqr), expected_distance, 1e-9);
+
+        // nothing is nearer than the current best
+        EXPECT_EQ(packed.FindNearest(point, distance_sqr, range.first, range.second), PackedTriangles::NO_TRIANGLE);
+    }
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <Math.Core/TriangleSoup.h>
+
+#include <Math.Core/BinaryStream.h>
+#include <Math.Core/Mesh.h>
+#include <Math.Core/TransformMatrix.h>
+#include <Math.Core/Triangle.h>
+
+#include <QBuffer>
+
+using namespace ::testing;
+
+TEST(TriangleSoup, KeepsMeshIdsOfTriangles)
+{
+    TriangleSoup soup;
+    EXPECT_EQ(soup.AddTriangle({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, 7), 0u);
+    EXPECT_EQ(soup.AddTriangle({ 0, 0, 1 }, { 1, 0, 1 }, { 0, 1, 1 }, 3), 1u);
+
+    ASSERT_EQ(soup.GetTrianglesCount(), 2u);
+    EXPECT_EQ(soup.GetMeshId(0), 7u);
+    EXPECT_EQ(soup.GetMeshId(1), 3u);
+
+    const auto p_vertices = soup.GetVertices(1);
+    EXPECT_EQ(p_vertices[0], (BasicPoint3D{ { 0, 0, 1 } }));
+    EXPECT_EQ(p_vertices[1], (BasicPoint3D{ { 1, 0, 1 } }));
+    EXPECT_EQ(p_vertices[2], (BasicPoint3D{ { 0, 1, 1 } }));
+}
+
+TEST(TriangleSoup, AddMeshAppliesTransform)
+{
+    Mesh mesh;
+    mesh.AddTriangle({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 });
+    mesh.AddTriangle({ 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 });
+
+    TransformMatrix transform;
+    transform.Translate(0, 0, 5);
+
+    TriangleSoup soup;
+    soup.AddTriangle({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, 0);
+    EXPECT_EQ(soup.AddMesh(mesh, transform, 1), 1u);
+    ASSERT_EQ(soup.GetTrianglesCount(), 3u);
+
+    for (std::uint32_t i = 1; i < 3; ++i)
+    {
+        EXPECT_EQ(soup.GetMeshId(i), 1u);
+        const auto triangle = soup.GetTriangle(i);
+        for (short j = 0; j < 3; ++j)
+            EXPECT_EQ(triangle.GetPoint(j).GetZ(), 5);
+    }
+}
+
+TEST(TriangleSoup, IsSmallerThanTriangles)
+{
+    TriangleSoup soup;
+    soup.Reserve(1000);
+    for (int i = 0; i < 1000; ++i)
+        soup.AddTriangle({ 0, 0, double(i) }, { 1, 0, double(i) }, { 0, 1, double(i) }, 0);
+
+    EXPECT_EQ(soup.GetMemoryUsage(), 1000 * (3 * sizeof(BasicPoint3D) + sizeof(std::uint32_t)));
+    EXPECT_LT(soup.GetMemoryUsage(), 1000 * sizeof(Triangle));
+}
+
+TEST(TriangleSoup, LoadsWhatWasSaved)
+{
+    TriangleSoup soup;
+    soup.AddTriangle({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, 7);
+    soup.AddTriangle({ 0, 0, 1 }, { 1, 0, 1 }, { 0, 1, 1 }, 3);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    BinaryWriter writer(buffer);
+    soup.Save(writer);
+    writer.WriteArray(std::vector<BasicPoint3D>(2));
+    writer.WriteArray(std::vector<std::uint32_t>(1));
+    ASSERT_TRUE(writer.IsOk());
+
+    const auto data = buffer.data();
+    BinaryReader reader(data.data(), static_cast<size_t>(data.size()));
+    TriangleSoup loaded;
+    ASSERT_TRUE(loaded.Load(reader));
+    ASSERT_EQ(loaded.GetTrianglesCount(), 2u);
+    EXPECT_EQ(loaded.GetMeshId(0), 7u);
+    EXPECT_EQ(loaded.GetVertices(1)[2], (BasicPoint3D{ { 0, 1, 1 } }));
+
+    // two vertices can't make a triangle
+    EXPECT_FALSE(loaded.Load(reader));
+    EXPECT_EQ(loaded.GetTrianglesCount(), 2u);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <Math.Core/WorkStealingThreadPool.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace ::testing;
+
+TEST(WorkStealingThreadPool, EveryElementIsProcessedOnce)
+{
+    WorkStealingThreadPool pool(4);
+
+    std::vector<int> visits(1000, 0);
+    pool.ParallelFor(visits.size(), 7, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+            ++visits[i];
+    });
+
+    for (auto count : visits)
+        EXPECT_EQ(count, 1);
+}
+
+TEST(WorkStealingThreadPool, SingleThreadRunsOnCaller)
+{
+    WorkStealingThreadPool pool(1);
+    EXPECT_EQ(pool.GetThreadsCount(), 1);
+
+    size_t sum = 0;
+    pool.ParallelFor(10, 3, [&](size_t i_begin, size_t i_end)
+    {
+        sum += i_end - i_begin;
+    });
+
+    EXPECT_EQ(sum, 10);
+}
+
+TEST(WorkStealingThreadPool, NestedParallelFor)
+{
+    WorkStealingThreadPool pool(4);
+
+    std::atomic<size_t> sum{ 0 };
+    pool.ParallelFor(20, 1, [&](size_t, size_t)
+    {
+        pool.ParallelFor(30, 4, [&](size_t i_begin, size_t i_end)
+        {
+            sum += i_end - i_begin;
+        });
+    });
+
+    EXPECT_EQ(sum.load(), 20 * 30);
+}
+
+TEST(WorkStealingThreadPool, ExceptionIsRethrownToCaller)
+{
+    WorkStealingThreadPool pool(4);
+
+    EXPECT_THROW(pool.ParallelFor(100, 1, [](size_t i_begin, size_t)
+    {
+        if (i_begin == 42)
+            throw std::runtime_error("task failed");
+    }), std::runtime_error);
+}
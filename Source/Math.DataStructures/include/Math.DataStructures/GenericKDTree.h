@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <functional>
 #include <memory>
 
@@ -12,9 +13,14 @@ public:
     KDTreeNode()  = default;
     ~KDTreeNode() = default;
 
+    // creates the child if it doesn't exist
     NodeType& GetLeftChild();
     NodeType& GetRightChild();
 
+    // the child must exist
+    const NodeType& GetLeftChild() const;
+    const NodeType& GetRightChild() const;
+
     bool HasLeftChild() const;
     bool HasRightChild() const;
 
@@ -40,12 +46,16 @@ public:
     template<typename... Args>
     void Build(Args&&... i_args);
 
+    // const and doesn't modify the tree, so it can be called from several threads at once
     template<typename Result, typename... Args>
-    void Query(Result& o_result, Args&&... i_args);
+    void Query(Result& o_result, Args&&... i_args) const;
 
     NodeType& GetRoot() { return m_root; }
+    const NodeType& GetRoot() const { return m_root; }
 
     bool WasBuild() const { return m_was_build; }
+    // for loaders that fill the nodes through GetRoot instead of Build
+    void SetWasBuild(bool i_was_build) { m_was_build = i_was_build; }
 
 private:
     NodeType m_root;
@@ -72,6 +82,20 @@ inline typename KDTreeNode<Info>::NodeType& KDTreeNode<Info>::GetRightChild()
     return *mp_right_child;
 }
 
+template<typename Info>
+inline const typename KDTreeNode<Info>::NodeType& KDTreeNode<Info>::GetLeftChild() const
+{
+    assert(HasLeftChild());
+    return *mp_left_child;
+}
+
+template<typename Info>
+inline const typename KDTreeNode<Info>::NodeType& KDTreeNode<Info>::GetRightChild() const
+{
+    assert(HasRightChild());
+    return *mp_right_child;
+}
+
 template<typename Info>
 inline bool KDTreeNode<Info>::HasLeftChild() const
 {
@@ -106,7 +130,7 @@ inline void GenericKDTree<Info, BuildFunctor, QueryFunctor>::Build(Args&&... i_a
 
 template<typename Info, typename BuildFunctor, typename QueryFunctor>
 template<typename Result, typename... Args>
-inline void GenericKDTree<Info, BuildFunctor, QueryFunctor>::Query(Result& o_result, Args&&... i_args)
+inline void GenericKDTree<Info, BuildFunctor, QueryFunctor>::Query(Result& o_result, Args&&... i_args) const
 {
     std::invoke(QueryFunctor{}, m_root, o_result, std::forward<Args>(i_args)...);
 }
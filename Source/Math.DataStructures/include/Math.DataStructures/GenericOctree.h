@@ -54,12 +54,16 @@ public:
     template<typename... Args>
     void Build(Args&&... i_args);
 
+    // const and doesn't modify the tree, so it can be called from several threads at once
     template<typename Result, typename... Args>
-    void Query(Result& o_result, Args&&... i_args);
+    void Query(Result& o_result, Args&&... i_args) const;
 
     NodeType& GetRoot() { return *mp_root; }
+    const NodeType& GetRoot() const { return *mp_root; }
 
     bool WasBuild() const { return mp_root != nullptr; }
+    // drops all nodes, for loaders that fill the nodes themselves instead of Build
+    NodeType& ResetRoot(const BoundingBox& i_bbox);
 
 private:
     std::unique_ptr<NodeType> mp_root;
@@ -148,14 +152,19 @@ inline void GenericOcTree<Info, BuildFunctor, QueryFunctor, BBoxUpdater>::Build(
     BBoxUpdater updater;
     updater(bbox, i_args...);
 
-    mp_root = std::make_unique<NodeType>(bbox);
+    std::invoke(BuildFunctor{}, ResetRoot(bbox), std::forward<Args>(i_args)...);
+}
 
-    std::invoke(BuildFunctor{}, *mp_root, std::forward<Args>(i_args)...);
+template<typename Info, typename BuildFunctor, typename QueryFunctor, typename BBoxUpdater>
+inline typename GenericOcTree<Info, BuildFunctor, QueryFunctor, BBoxUpdater>::NodeType& GenericOcTree<Info, BuildFunctor, QueryFunctor, BBoxUpdater>::ResetRoot(const BoundingBox& i_bbox)
+{
+    mp_root = std::make_unique<NodeType>(i_bbox);
+    return *mp_root;
 }
 
 template<typename Info, typename BuildFunctor, typename QueryFunctor, typename BBoxUpdater>
 template<typename Result, typename ...Args>
-inline void GenericOcTree<Info, BuildFunctor, QueryFunctor, BBoxUpdater>::Query(Result& o_result, Args&& ...i_args)
+inline void GenericOcTree<Info, BuildFunctor, QueryFunctor, BBoxUpdater>::Query(Result& o_result, Args&& ...i_args) const
 {
     if (!WasBuild())
     {
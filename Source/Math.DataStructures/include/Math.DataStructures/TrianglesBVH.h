@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Math.DataStructures/API.h>
+
+#include <Math.Core/TrianglePack.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class Point3D;
+class Triangle;
+class TriangleSoup;
+
+// Bounding volume hierarchy over triangles built with the surface area heuristic.
+// Nodes are stored in one array in depth first order: the left child of a node follows it, the right child is referenced by index.
+class MATH_DATASTRUCTURES_API TrianglesBVH
+{
+public:
+    struct Params
+    {
+        size_t m_max_triangles_in_leaf = 4;
+        size_t m_bins_count = 16; // candidate split planes per axis
+    };
+
+    struct Node
+    {
+        double m_min[3];
+        double m_max[3];
+        std::uint32_t m_offset = 0; // first packed triangle of a leaf or the right child of an inner node
+        std::uint32_t m_count = 0;  // triangles of a leaf, 0 for inner nodes
+    };
+
+    static constexpr size_t NO_TRIANGLE = std::numeric_limits<size_t>::max();
+
+    void Build(const std::vector<Triangle*>& i_triangles, const Params& i_params);
+    // triangle indexes of the tree are the indexes of the soup
+    void Build(const TriangleSoup& i_triangles, const Params& i_params);
+    bool WasBuild() const;
+
+    // exact nearest triangle, returns its index in the vector passed to Build or NO_TRIANGLE if the tree is empty.
+    // Subtrees are visited nearest first and skipped if their box is farther than the best triangle found so far
+    size_t FindNearestTriangle(const Point3D& i_point, double* op_distance = nullptr) const;
+
+    // appends the indexes of the triangles of all leaves whose boxes the ray from i_origin along +X passes through,
+    // every triangle the ray crosses is among them
+    void CollectRayXTriangles(const Point3D& i_origin, std::vector<size_t>& io_triangles) const;
+
+    const std::vector<Node>& GetNodes() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    // ip_vertices holds three vertices per triangle
+    void _Build(const BasicPoint3D* ip_vertices, size_t i_triangles_count, const Params& i_params);
+
+private:
+    bool m_was_build = false;
+#pragma warning(push)
+#pragma warning(disable: 4251)
+    std::vector<Node> m_nodes;
+#pragma warning(pop)
+    PackedTriangles m_packed_triangles; // leaves reference ranges starting at a pack boundary
+};
@@ -9,11 +9,16 @@
 #include <Math.Core/Point3D.h>
 #include <Math.Core/Triangle.h>
 
+#include <QString>
 #include <QStringView>
 
+#include <memory>
 #include <utility>
 #include <vector>
 
+class BinaryReader;
+class BinaryWriter;
+
 using TriangleWithMeshTag = std::pair<Triangle*, QStringView>;
 
 struct TrianglesOcTreeInfo
@@ -71,9 +76,12 @@ namespace Details
         std::vector<TrianglesOcTreeNode*> m_empty_nodes_to_fill_in;
     };
 
+    // Empty leaves answer by their labels, the others by the nearest triangle. There is no ray parity mode: a triangle
+    // is copied to every octant it touches, so a ray walk would count it several times, and the labels of the empty
+    // leaves come from the nearest triangle too. PointLocalizerBVH and the voxel localizers count ray crossings
     struct MATH_DATASTRUCTURES_API TrianglesOcTreeQueryFunctor
     {
-        void operator()(const TrianglesOcTreeNode& i_root, TriangleOcTreeQueryResult& o_result, const Point3D& i_point);
+        void operator()(const TrianglesOcTreeNode& i_root, TriangleOcTreeQueryResult& o_result, const Point3D& i_point) const;
     };
 }
 
@@ -82,3 +90,9 @@ using TrianglesOcTree = GenericOcTree<TrianglesOcTreeInfo,
                                       Details::TrianglesOcTreeQueryFunctor,
                                       Details::TrianglesOcTreeBoundingBoxUpdater
                                      >;
+
+// The tree keeps pointers into i_triangles and views of the mesh names, they are saved as indexes together with
+// the triangles and the names themselves. Nodes are stored flat in preorder
+MATH_DATASTRUCTURES_API void SaveTrianglesOcTree(BinaryWriter& io_writer, const TrianglesOcTree& i_tree, const std::vector<Triangle>& i_triangles);
+// the tree points into o_triangles and o_mesh_names, so they must not be changed while it is used. Returns nullptr for a broken file
+MATH_DATASTRUCTURES_API std::unique_ptr<TrianglesOcTree> LoadTrianglesOcTree(BinaryReader& io_reader, std::vector<Triangle>& o_triangles, std::vector<QString>& o_mesh_names);
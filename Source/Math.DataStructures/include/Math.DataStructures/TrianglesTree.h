@@ -8,14 +8,21 @@
 #include <Math.Core/CommonUtilities.h>
 #include <Math.Core/Point3D.h>
 #include <Math.Core/Triangle.h>
+#include <Math.Core/TrianglePack.h>
 
 #include <QtGlobal>
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+class BinaryReader;
+class BinaryWriter;
+
 struct TrianglesTreeInfo
 {
     std::vector<Triangle*> m_triangles;
+    PackedTriangles m_packed_triangles; // leaves only, packed indexes refer to m_triangles
     BoundingBox m_bbox;
 };
 
@@ -28,9 +35,29 @@ struct MATH_DATASTRUCTURES_API BuildTrianglesTreeFunctor
     void operator()(TrianglesTreeNode& i_root, std::vector<Triangle*> i_triangles);
 };
 
+// searches only leaves containing the point, finds nothing for points outside the root bbox
 struct MATH_DATASTRUCTURES_API NearestTriangleApproximationFunctor
 {
-    void operator()(TrianglesTreeNode& i_root, Triangle*& io_triangle, const Point3D& i_point);
+    void operator()(const TrianglesTreeNode& i_root, Triangle*& io_triangle, const Point3D& i_point) const;
+};
+
+// exact nearest triangle. Nodes are visited in order of Distance(point, bbox),
+// the search stops when the nearest node left is farther than the best triangle found so far
+struct MATH_DATASTRUCTURES_API NearestTriangleFunctor
+{
+    void operator()(const TrianglesTreeNode& i_root, Triangle*& o_triangle, const Point3D& i_point) const;
 };
 
-using TrianglesTree = GenericKDTree<TrianglesTreeInfo, BuildTrianglesTreeFunctor, NearestTriangleApproximationFunctor>;
+// Both trees answer by the nearest triangle only, ray parity is left to PointLocalizerBVH and the voxel localizers.
+// A triangle is copied to both children it touches, so a ray walk would count it several times, and the tree
+// keeps no mesh of its triangles to count the crossings by
+using TrianglesTree = GenericKDTree<TrianglesTreeInfo, BuildTrianglesTreeFunctor, NearestTriangleFunctor>;
+using TrianglesTreeApproximation = GenericKDTree<TrianglesTreeInfo, BuildTrianglesTreeFunctor, NearestTriangleApproximationFunctor>;
+
+// The tree keeps pointers into i_triangles, they are saved as indexes together with the triangles themselves and
+// the mesh of every triangle. Nodes are stored flat in preorder
+MATH_DATASTRUCTURES_API void SaveTrianglesTree(BinaryWriter& io_writer, const TrianglesTree& i_tree,
+                                               const std::vector<Triangle>& i_triangles, const std::vector<std::uint32_t>& i_triangles_mesh_indexes);
+// the tree points into o_triangles, so they must not be resized while it is used. Returns nullptr for a broken file
+MATH_DATASTRUCTURES_API std::unique_ptr<TrianglesTree> LoadTrianglesTree(BinaryReader& io_reader, std::vector<Triangle>& o_triangles,
+                                                                         std::vector<std::uint32_t>& o_triangles_mesh_indexes);
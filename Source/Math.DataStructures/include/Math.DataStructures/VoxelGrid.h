@@ -5,53 +5,147 @@
 #include <Math.Core/BoundingBox.h>
 
 #include <array>
+#include <cstdint>
+#include <iterator>
+#include <memory>
 #include <vector>
-#include <unordered_map>
 
+class BinaryReader;
+class BinaryWriter;
 class Point3D;
 class Triangle;
 
-class MATH_DATASTRUCTURES_API Voxel : public BoundingBox
+// Triangles of one voxel. Voxels keep indexes into the triangles table of the grid, the range resolves them to pointers.
+// A grid filled by a triangles count has no table, its ranges give only the indexes. Stays valid while the grid is not modified.
+class VoxelTrianglesRange
 {
 public:
-    Voxel(const std::array<size_t, 3>& i_coords, const Point3D& i_min_corner, const Point3D& i_max_corner);
-    ~Voxel() = default;
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Triangle*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Triangle* const*;
+        using reference = Triangle*;
 
-    void AddTriangle(Triangle* ip_triangle);
-    const std::vector<Triangle*>& GetTriangles() const;
+        Iterator(const std::uint32_t* ip_index, Triangle* const* ip_triangles) : mp_index(ip_index), mp_triangles(ip_triangles) {}
+
+        Triangle* operator*() const { return mp_triangles[*mp_index]; }
+        Iterator& operator++() { ++mp_index; return *this; }
+        Iterator operator++(int) { auto copy = *this; ++mp_index; return copy; }
+        bool operator==(const Iterator& i_other) const { return mp_index == i_other.mp_index; }
+        bool operator!=(const Iterator& i_other) const { return mp_index != i_other.mp_index; }
+
+        // index of the triangle in VoxelGrid::GetTriangles() or in the storage of the owner of the grid
+        std::uint32_t GetIndex() const { return *mp_index; }
 
-    const std::array<size_t, 3>& GetCoordinates() const;
+    private:
+        const std::uint32_t* mp_index;
+        Triangle* const* mp_triangles;
+    };
+
+    VoxelTrianglesRange() = default;
+    VoxelTrianglesRange(const std::uint32_t* ip_begin, const std::uint32_t* ip_end, Triangle* const* ip_triangles)
+        : mp_begin(ip_begin), mp_end(ip_end), mp_triangles(ip_triangles) {}
+
+    Iterator begin() const { return Iterator(mp_begin, mp_triangles); }
+    Iterator end() const { return Iterator(mp_end, mp_triangles); }
+    size_t size() const { return static_cast<size_t>(mp_end - mp_begin); }
+    bool empty() const { return mp_begin == mp_end; }
 
 private:
-#pragma warning(push)
-#pragma warning(disable: 4251)
-    std::array<size_t, 3> m_coordinates;
-    std::vector<Triangle*> m_triangles;
-#pragma warning(pop)
+    const std::uint32_t* mp_begin = nullptr;
+    const std::uint32_t* mp_end = nullptr;
+    Triangle* const* mp_triangles = nullptr;
 };
 
 class MATH_DATASTRUCTURES_API VoxelGrid
 {
 public:
+    enum class StorageType
+    {
+        Auto,   // Dense if enough voxels are occupied, Bricks otherwise
+        Sparse, // hash map from voxel index to the list of its triangles
+        Dense,  // offsets for every voxel of the grid and one pool of triangle indexes
+        Bricks, // 8x8x8 bricks with occupancy bitmask in an open addressing table, offsets only for occupied voxels
+    };
+
+    // voxel i_voxel_index contains triangle i_triangle_index
+    struct Entry
+    {
+        size_t m_voxel_index = 0;
+        std::uint32_t m_triangle_index = 0;
+    };
+
     VoxelGrid(const std::array<double, 3>& i_voxel_size, const std::array<size_t, 3>& i_num_voxels, const BoundingBox& i_bbox);
+    ~VoxelGrid();
+
+    VoxelGrid(const VoxelGrid&) = delete;
+    VoxelGrid& operator=(const VoxelGrid&) = delete;
+
+    // replaces content of the grid, entries are sorted and duplicates are removed
+    void Fill(const std::vector<Triangle*>& i_triangles, std::vector<Entry>& io_entries, StorageType i_storage_type = StorageType::Auto);
+    // same without the triangles table, the owner keeps i_triangles_count triangles and resolves the indexes itself
+    void Fill(size_t i_triangles_count, std::vector<Entry>& io_entries, StorageType i_storage_type = StorageType::Auto);
+
+    // appends triangles to the triangles table, returns index of the first one
+    std::uint32_t AddTriangles(const std::vector<Triangle*>& i_triangles);
+    // reserves indexes for i_count triangles of a grid without the table, returns index of the first one
+    std::uint32_t AddTriangles(size_t i_count);
+    // Insert and Remove keep the storage type and edit it in place. Compact storages move the voxels
+    // after each changed one once, bricks that lose their last voxel are dropped
+    void Insert(std::vector<Entry>& io_entries);
+    // triangles of removed entries are released from the triangles table, their indexes are not reused
+    void Remove(std::vector<Entry>& io_entries);
 
     const std::array<double, 3>& GetVoxelSize() const;
     const std::array<size_t, 3>& GetNumVoxels() const;
-    Voxel* GetOrCreateVoxel(const std::array<size_t, 3>& i_coordinates);
-    const Voxel* GetVoxel(const std::array<size_t, 3>& i_coordinates) const;
-    std::vector<const Voxel*> GetExistingVoxels() const;
+    const BoundingBox& GetBoundingBox() const;
+    StorageType GetStorageType() const;
+
+    bool HasVoxel(const std::array<size_t, 3>& i_coordinates) const;
+    VoxelTrianglesRange GetVoxelTriangles(const std::array<size_t, 3>& i_coordinates) const;
+    BoundingBox GetVoxelBoundingBox(const std::array<size_t, 3>& i_coordinates) const;
+
+    // sorted by voxel index
+    std::vector<std::array<size_t, 3>> GetExistingVoxelsCoordinates() const;
+    size_t GetExistingVoxelsCount() const;
+
+    // empty for a grid without the triangles table
+    const std::vector<Triangle*>& GetTriangles() const;
+    size_t GetTrianglesCount() const;
+
+    // approximate number of bytes used by voxels
+    size_t GetMemoryUsage() const;
+
     bool PointInsideVoxelization(const Point3D& i_point) const;
-    
+
     std::array<size_t, 3> GetCoordinatesForPoint(const Point3D& i_point) const;
 
     size_t GetVoxelIndexFromCoordinates(const std::array<size_t, 3>& i_coordinates) const;
+    std::array<size_t, 3> GetCoordinatesFromVoxelIndex(size_t i_index) const;
+
+    // saves the voxels as they are laid out now, the triangles are saved by their owner
+    void Save(BinaryWriter& io_writer) const;
+    // i_triangles is the triangles table in the saved order, nullptr for removed triangles.
+    // Compact storages are read with one copy per array, nothing is voxelized again. Returns nullptr for a broken file
+    static std::unique_ptr<VoxelGrid> Load(BinaryReader& io_reader, std::vector<Triangle*> i_triangles);
+    // loads a grid without the triangles table that was saved with i_triangles_count triangles
+    static std::unique_ptr<VoxelGrid> Load(BinaryReader& io_reader, size_t i_triangles_count);
 
 private:
+    static std::unique_ptr<VoxelGrid> _Load(BinaryReader& io_reader, std::vector<Triangle*> i_triangles, size_t i_triangles_count);
+    void _Layout(std::vector<Triangle*> i_triangles, size_t i_triangles_count, const std::vector<Entry>& i_sorted_entries, StorageType i_storage_type);
+    std::vector<Entry> _GetEntries() const;
+
+    struct Impl;
+
     BoundingBox m_bbox;
 #pragma warning(push)
 #pragma warning(disable: 4251)
     std::array<double, 3> m_voxel_size;
     std::array<size_t, 3> m_num_voxels;
-    std::unordered_map<size_t, Voxel> m_voxels;
+    std::unique_ptr<Impl> mp_impl;
 #pragma warning(pop)
 };
@@ -0,0 +1,401 @@
+#include "Math.DataStructures/TrianglesBVH.h"
+
+#include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/TriangleSoup.h>
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+namespace
+{
+    constexpr size_t MAX_DEPTH = 64;
+    constexpr size_t STACK_SIZE = 2 * MAX_DEPTH;
+    constexpr double TRAVERSAL_COST = 1.; // relative to the cost of one point-triangle distance
+
+    struct Bounds
+    {
+        double m_min[3] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+        double m_max[3] = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+
+        void Grow(const double* ip_min, const double* ip_max)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                m_min[i] = std::min(m_min[i], ip_min[i]);
+                m_max[i] = std::max(m_max[i], ip_max[i]);
+            }
+        }
+
+        void Grow(const Bounds& i_other)
+        {
+            Grow(i_other.m_min, i_other.m_max);
+        }
+
+        double GetArea() const
+        {
+            if (m_min[0] > m_max[0])
+                return 0;
+
+            const double dx = m_max[0] - m_min[0];
+            const double dy = m_max[1] - m_min[1];
+            const double dz = m_max[2] - m_min[2];
+            return 2 * (dx * dy + dy * dz + dz * dx);
+        }
+    };
+
+    struct Primitive
+    {
+        double m_min[3];
+        double m_max[3];
+        double m_centroid[3];
+    };
+
+    class Builder
+    {
+    public:
+        Builder(const std::vector<Primitive>& i_primitives, const TrianglesBVH::Params& i_params, std::vector<std::uint32_t>& io_indexes, std::vector<TrianglesBVH::Node>& o_nodes)
+            : m_primitives(i_primitives)
+            , m_params(i_params)
+            , m_indexes(io_indexes)
+            , m_nodes(o_nodes)
+        {
+        }
+
+        void Build(size_t i_begin, size_t i_end, size_t i_depth)
+        {
+            const auto node_index = m_nodes.size();
+            m_nodes.emplace_back();
+
+            Bounds bounds;
+            Bounds centroid_bounds;
+            for (auto i = i_begin; i < i_end; ++i)
+            {
+                const auto& primitive = m_primitives[m_indexes[i]];
+                bounds.Grow(primitive.m_min, primitive.m_max);
+                centroid_bounds.Grow(primitive.m_centroid, primitive.m_centroid);
+            }
+            std::copy(bounds.m_min, bounds.m_min + 3, m_nodes[node_index].m_min);
+            std::copy(bounds.m_max, bounds.m_max + 3, m_nodes[node_index].m_max);
+
+            const auto count = i_end - i_begin;
+            const auto split = _FindSplit(i_begin, i_end, bounds, centroid_bounds);
+            const bool make_leaf = count == 1
+                                || i_depth + 1 >= MAX_DEPTH
+                                || (count <= m_params.m_max_triangles_in_leaf && split.m_cost >= count * bounds.GetArea());
+            if (make_leaf)
+            {
+                m_nodes[node_index].m_offset = static_cast<std::uint32_t>(i_begin);
+                m_nodes[node_index].m_count = static_cast<std::uint32_t>(count);
+                return;
+            }
+
+            auto middle = i_begin;
+            if (split.m_axis < 3)
+            {
+                auto it = std::partition(m_indexes.begin() + i_begin, m_indexes.begin() + i_end, [&](std::uint32_t i_index)
+                {
+                    return _GetBin(m_primitives[i_index].m_centroid[split.m_axis], split.m_axis, centroid_bounds) < split.m_bin;
+                });
+                middle = static_cast<size_t>(it - m_indexes.begin());
+            }
+
+            // all centroids are in one bin, triangles are split in halves by centroid along the longest axis
+            if (middle == i_begin || middle == i_end)
+            {
+                size_t axis = 0;
+                for (size_t i = 1; i < 3; ++i)
+                {
+                    if (centroid_bounds.m_max[i] - centroid_bounds.m_min[i] > centroid_bounds.m_max[axis] - centroid_bounds.m_min[axis])
+                        axis = i;
+                }
+
+                middle = i_begin + count / 2;
+                std::nth_element(m_indexes.begin() + i_begin, m_indexes.begin() + middle, m_indexes.begin() + i_end, [&](std::uint32_t i_lhs, std::uint32_t i_rhs)
+                {
+                    return m_primitives[i_lhs].m_centroid[axis] < m_primitives[i_rhs].m_centroid[axis];
+                });
+            }
+
+            Build(i_begin, middle, i_depth + 1);
+            m_nodes[node_index].m_offset = static_cast<std::uint32_t>(m_nodes.size());
+            Build(middle, i_end, i_depth + 1);
+        }
+
+    private:
+        struct Split
+        {
+            size_t m_axis = 3; // 3 means no split was found
+            size_t m_bin = 0;  // primitives of bins [0, m_bin) go to the left child
+            double m_cost = std::numeric_limits<double>::max();
+        };
+
+        size_t _GetBin(double i_centroid, size_t i_axis, const Bounds& i_centroid_bounds) const
+        {
+            const auto extent = i_centroid_bounds.m_max[i_axis] - i_centroid_bounds.m_min[i_axis];
+            const auto bin = static_cast<size_t>((i_centroid - i_centroid_bounds.m_min[i_axis]) / extent * m_params.m_bins_count);
+            return std::min(bin, m_params.m_bins_count - 1);
+        }
+
+        Split _FindSplit(size_t i_begin, size_t i_end, const Bounds& i_bounds, const Bounds& i_centroid_bounds) const
+        {
+            const auto bins_count = m_params.m_bins_count;
+
+            Split result;
+            for (size_t axis = 0; axis < 3; ++axis)
+            {
+                if (!(i_centroid_bounds.m_max[axis] > i_centroid_bounds.m_min[axis]))
+                    continue;
+
+                std::vector<Bounds> bins(bins_count);
+                std::vector<size_t> counts(bins_count, 0);
+                for (auto i = i_begin; i < i_end; ++i)
+                {
+                    const auto& primitive = m_primitives[m_indexes[i]];
+                    const auto bin = _GetBin(primitive.m_centroid[axis], axis, i_centroid_bounds);
+                    bins[bin].Grow(primitive.m_min, primitive.m_max);
+                    ++counts[bin];
+                }
+
+                // right_areas[i] and right_counts[i] describe bins [i, bins_count)
+                std::vector<double> right_areas(bins_count, 0);
+                std::vector<size_t> right_counts(bins_count, 0);
+                Bounds right;
+                size_t right_count = 0;
+                for (size_t i = bins_count; i-- > 1;)
+                {
+                    right.Grow(bins[i]);
+                    right_count += counts[i];
+                    right_areas[i] = right.GetArea();
+                    right_counts[i] = right_count;
+                }
+
+                Bounds left;
+                size_t left_count = 0;
+                for (size_t i = 1; i < bins_count; ++i)
+                {
+                    left.Grow(bins[i - 1]);
+                    left_count += counts[i - 1];
+                    if (left_count == 0 || right_counts[i] == 0)
+                        continue;
+
+                    const auto cost = TRAVERSAL_COST * i_bounds.GetArea() + left.GetArea() * left_count + right_areas[i] * right_counts[i];
+                    if (cost < result.m_cost)
+                    {
+                        result.m_axis = axis;
+                        result.m_bin = i;
+                        result.m_cost = cost;
+                    }
+                }
+            }
+
+            return result;
+        }
+
+        const std::vector<Primitive>& m_primitives;
+        const TrianglesBVH::Params& m_params;
+        std::vector<std::uint32_t>& m_indexes;
+        std::vector<TrianglesBVH::Node>& m_nodes;
+    };
+
+    inline double _DistanceSqr(const double* ip_point, const TrianglesBVH::Node& i_node)
+    {
+        double result = 0;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const auto delta = std::max(std::max(i_node.m_min[i] - ip_point[i], ip_point[i] - i_node.m_max[i]), 0.);
+            result += delta * delta;
+        }
+        return result;
+    }
+}
+
+
+constexpr size_t TrianglesBVH::NO_TRIANGLE;
+
+void TrianglesBVH::Build(const std::vector<Triangle*>& i_triangles, const Params& i_params)
+{
+    std::vector<BasicPoint3D> vertices;
+    vertices.reserve(3 * i_triangles.size());
+    for (const auto p_triangle : i_triangles)
+    {
+        for (short i = 0; i < 3; ++i)
+            vertices.push_back(ToBasicPoint(p_triangle->GetPoint(i)));
+    }
+
+    _Build(vertices.data(), i_triangles.size(), i_params);
+}
+
+void TrianglesBVH::Build(const TriangleSoup& i_triangles, const Params& i_params)
+{
+    const auto triangles_count = i_triangles.GetTrianglesCount();
+    _Build(triangles_count > 0 ? i_triangles.GetVertices(0) : nullptr, triangles_count, i_params);
+}
+
+void TrianglesBVH::_Build(const BasicPoint3D* ip_vertices, size_t i_triangles_count, const Params& i_params)
+{
+    Q_ASSERT(i_params.m_bins_count >= 2);
+    Q_ASSERT(i_triangles_count <= std::numeric_limits<std::uint32_t>::max());
+
+    m_nodes.clear();
+    m_packed_triangles.Clear();
+
+    std::vector<std::uint32_t> triangle_indexes(i_triangles_count);
+    std::iota(triangle_indexes.begin(), triangle_indexes.end(), 0);
+
+    std::vector<Primitive> primitives(i_triangles_count);
+    for (size_t i = 0; i < i_triangles_count; ++i)
+    {
+        const auto p_vertices = ip_vertices + 3 * i;
+        auto& primitive = primitives[i];
+        for (short axis = 0; axis < 3; ++axis)
+        {
+            const auto coord1 = p_vertices[0][axis];
+            const auto coord2 = p_vertices[1][axis];
+            const auto coord3 = p_vertices[2][axis];
+            primitive.m_min[axis] = std::min({ coord1, coord2, coord3 });
+            primitive.m_max[axis] = std::max({ coord1, coord2, coord3 });
+            primitive.m_centroid[axis] = (primitive.m_min[axis] + primitive.m_max[axis]) / 2;
+        }
+    }
+
+    if (!primitives.empty())
+    {
+        m_nodes.reserve(2 * primitives.size());
+        Builder builder(primitives, i_params, triangle_indexes, m_nodes);
+        builder.Build(0, primitives.size(), 0);
+        m_nodes.shrink_to_fit();
+    }
+
+    // triangles of every leaf start a new pack, so small leaves are processed by one kernel call
+    m_packed_triangles.Reserve(i_triangles_count + 3 * m_nodes.size() / 2);
+    for (auto& node : m_nodes)
+    {
+        if (node.m_count == 0)
+            continue;
+
+        m_packed_triangles.AlignToPack();
+        const auto first = m_packed_triangles.GetSize();
+        for (auto i = node.m_offset; i < node.m_offset + node.m_count; ++i)
+            m_packed_triangles.Add(ip_vertices + 3 * static_cast<size_t>(triangle_indexes[i]), triangle_indexes[i]);
+        node.m_offset = static_cast<std::uint32_t>(first);
+    }
+
+    m_was_build = true;
+}
+
+bool TrianglesBVH::WasBuild() const
+{
+    return m_was_build;
+}
+
+size_t TrianglesBVH::FindNearestTriangle(const Point3D& i_point, double* op_distance) const
+{
+    if (m_nodes.empty())
+        return NO_TRIANGLE;
+
+    struct StackItem
+    {
+        std::uint32_t m_node;
+        double m_distance_sqr;
+    };
+
+    const double point[3] = { i_point.GetX(), i_point.GetY(), i_point.GetZ() };
+
+    StackItem stack[STACK_SIZE];
+    size_t stack_size = 0;
+    stack[stack_size++] = { 0, _DistanceSqr(point, m_nodes[0]) };
+
+    size_t nearest_triangle = NO_TRIANGLE;
+    double best_distance_sqr = std::numeric_limits<double>::max();
+
+    while (stack_size > 0)
+    {
+        const auto item = stack[--stack_size];
+        if (item.m_distance_sqr >= best_distance_sqr)
+            continue;
+
+        const auto& node = m_nodes[item.m_node];
+        if (node.m_count > 0)
+        {
+            const auto position = m_packed_triangles.FindNearest(i_point, best_distance_sqr, node.m_offset, node.m_offset + node.m_count);
+            if (position != PackedTriangles::NO_TRIANGLE)
+                nearest_triangle = m_packed_triangles.GetIndex(position);
+            continue;
+        }
+
+        const auto left = item.m_node + 1;
+        const auto right = node.m_offset;
+        const auto left_distance_sqr = _DistanceSqr(point, m_nodes[left]);
+        const auto right_distance_sqr = _DistanceSqr(point, m_nodes[right]);
+
+        // the nearer child is pushed last, so it is visited first
+        const bool is_left_nearer = left_distance_sqr <= right_distance_sqr;
+        const StackItem nearer = { is_left_nearer ? left : right, is_left_nearer ? left_distance_sqr : right_distance_sqr };
+        const StackItem farther = { is_left_nearer ? right : left, is_left_nearer ? right_distance_sqr : left_distance_sqr };
+
+        Q_ASSERT(stack_size + 2 <= STACK_SIZE);
+        if (farther.m_distance_sqr < best_distance_sqr)
+            stack[stack_size++] = farther;
+        if (nearer.m_distance_sqr < best_distance_sqr)
+            stack[stack_size++] = nearer;
+    }
+
+    if (op_distance)
+        *op_distance = std::sqrt(best_distance_sqr);
+
+    return nearest_triangle;
+}
+
+void TrianglesBVH::CollectRayXTriangles(const Point3D& i_origin, std::vector<size_t>& io_triangles) const
+{
+    if (m_nodes.empty())
+        return;
+
+    const double origin[3] = { i_origin.GetX(), i_origin.GetY(), i_origin.GetZ() };
+    const auto is_hit = [&origin](const Node& i_node)
+    {
+        return i_node.m_max[0] >= origin[0]
+            && i_node.m_min[1] <= origin[1] && origin[1] <= i_node.m_max[1]
+            && i_node.m_min[2] <= origin[2] && origin[2] <= i_node.m_max[2];
+    };
+
+    std::uint32_t stack[STACK_SIZE];
+    size_t stack_size = 0;
+    if (is_hit(m_nodes[0]))
+        stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const auto node_index = stack[--stack_size];
+        const auto& node = m_nodes[node_index];
+        if (node.m_count > 0)
+        {
+            for (auto position = node.m_offset; position < node.m_offset + node.m_count; ++position)
+                io_triangles.push_back(m_packed_triangles.GetIndex(position));
+            continue;
+        }
+
+        const auto left = node_index + 1;
+        Q_ASSERT(stack_size + 2 <= STACK_SIZE);
+        if (is_hit(m_nodes[left]))
+            stack[stack_size++] = left;
+        if (is_hit(m_nodes[node.m_offset]))
+            stack[stack_size++] = node.m_offset;
+    }
+}
+
+const std::vector<TrianglesBVH::Node>& TrianglesBVH::GetNodes() const
+{
+    return m_nodes;
+}
+
+size_t TrianglesBVH::GetMemoryUsage() const
+{
+    return m_nodes.capacity() * sizeof(Node)
+         + m_packed_triangles.GetMemoryUsage();
+}
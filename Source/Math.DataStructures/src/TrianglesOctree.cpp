@@ -1,9 +1,128 @@
 #include "Math.DataStructures/TrianglesOctree.h"
 
+#include <Math.Core/BinaryStream.h>
+
+#include <map>
+
 #include <boost/optional.hpp>
 
 namespace
 {
+    constexpr char OCTREE_MAGIC[] = "PL3DSOCT";
+    constexpr std::uint32_t OCTREE_VERSION = 1;
+    constexpr std::uint32_t NO_MESH = std::numeric_limits<std::uint32_t>::max();
+
+    // preorder arrays of the nodes, triangles of node i are m_triangles[m_offsets[i]] .. m_triangles[m_offsets[i + 1]]
+    struct FlatOcTree
+    {
+        struct Triangle
+        {
+            std::uint32_t m_index = 0;
+            std::uint32_t m_mesh = 0;
+        };
+
+        std::vector<std::uint8_t> m_children;     // bit i is set if the node has child i
+        std::vector<std::uint8_t> m_is_empty_leaf;
+        std::vector<std::uint32_t> m_fully_inside_mesh;
+        std::vector<double> m_triangles_bboxes;   // min and max corners, 6 values per node
+        std::vector<std::uint32_t> m_offsets;
+        std::vector<Triangle> m_triangles;
+    };
+
+    class MeshNames
+    {
+    public:
+        std::uint32_t GetIndex(QStringView i_name)
+        {
+            if (i_name.isNull())
+                return NO_MESH;
+            // triangles of one mesh mostly go one after another
+            if (m_last_index != NO_MESH && i_name == m_last_name)
+                return m_last_index;
+
+            auto it = m_indexes.emplace(i_name.toString(), static_cast<std::uint32_t>(m_names.size())).first;
+            if (it->second == m_names.size())
+                m_names.push_back(i_name.toUtf8());
+            m_last_name = i_name;
+            m_last_index = it->second;
+            return it->second;
+        }
+
+        const std::vector<QByteArray>& GetNames() const { return m_names; }
+
+    private:
+        std::map<QString, std::uint32_t> m_indexes;
+        std::vector<QByteArray> m_names;
+        QStringView m_last_name;
+        std::uint32_t m_last_index = NO_MESH;
+    };
+
+    void _Flatten(const TrianglesOcTreeNode& i_node, const ::Triangle* ip_triangles, size_t i_triangles_count, MeshNames& io_names, FlatOcTree& io_flat)
+    {
+        const auto& info = i_node.GetInfo();
+        std::uint8_t children = 0;
+        for (size_t i = 0; i < 8; ++i)
+            children |= i_node.GetChild(i) ? static_cast<std::uint8_t>(1u << i) : 0;
+
+        io_flat.m_children.push_back(children);
+        io_flat.m_is_empty_leaf.push_back(info.m_is_empty_leaf ? 1 : 0);
+        io_flat.m_fully_inside_mesh.push_back(io_names.GetIndex(info.m_fully_inside_mesh));
+        for (const auto& corner : { info.m_triangles_bbox.GetMin(), info.m_triangles_bbox.GetMax() })
+            io_flat.m_triangles_bboxes.insert(io_flat.m_triangles_bboxes.end(), { corner.GetX(), corner.GetY(), corner.GetZ() });
+
+        io_flat.m_offsets.push_back(static_cast<std::uint32_t>(io_flat.m_triangles.size()));
+        for (const auto& triangle : info.m_triangles)
+        {
+            Q_ASSERT(triangle.first >= ip_triangles && triangle.first < ip_triangles + i_triangles_count);
+            FlatOcTree::Triangle flat_triangle;
+            flat_triangle.m_index = static_cast<std::uint32_t>(triangle.first - ip_triangles);
+            flat_triangle.m_mesh = io_names.GetIndex(triangle.second);
+            io_flat.m_triangles.push_back(flat_triangle);
+        }
+
+        for (size_t i = 0; i < 8; ++i)
+        {
+            if (auto p_child = i_node.GetChild(i))
+                _Flatten(*p_child, ip_triangles, i_triangles_count, io_names, io_flat);
+        }
+    }
+
+    // io_node_index is the preorder index of io_node, it is moved past its subtree.
+    // Bounding boxes of the children are derived from the parent exactly like Build does
+    bool _Unflatten(const FlatOcTree& i_flat, std::vector<::Triangle>& io_triangles, const std::vector<QString>& i_names, size_t& io_node_index, TrianglesOcTreeNode& io_node)
+    {
+        if (io_node_index >= i_flat.m_children.size())
+            return false;
+
+        const auto node_index = io_node_index++;
+        auto& info = io_node.GetInfo();
+        info.m_is_empty_leaf = i_flat.m_is_empty_leaf[node_index] != 0;
+        const auto fully_inside_mesh = i_flat.m_fully_inside_mesh[node_index];
+        if (fully_inside_mesh != NO_MESH)
+            info.m_fully_inside_mesh = QStringView(i_names[fully_inside_mesh]);
+
+        const auto p_bbox = i_flat.m_triangles_bboxes.data() + 6 * node_index;
+        if (p_bbox[0] <= p_bbox[3] && p_bbox[1] <= p_bbox[4] && p_bbox[2] <= p_bbox[5])
+        {
+            info.m_triangles_bbox.AddPoint(Point3D(p_bbox[0], p_bbox[1], p_bbox[2]));
+            info.m_triangles_bbox.AddPoint(Point3D(p_bbox[3], p_bbox[4], p_bbox[5]));
+        }
+
+        info.m_triangles.reserve(i_flat.m_offsets[node_index + 1] - i_flat.m_offsets[node_index]);
+        for (auto i = i_flat.m_offsets[node_index]; i < i_flat.m_offsets[node_index + 1]; ++i)
+        {
+            const auto& triangle = i_flat.m_triangles[i];
+            info.m_triangles.emplace_back(&io_triangles[triangle.m_index], triangle.m_mesh != NO_MESH ? QStringView(i_names[triangle.m_mesh]) : QStringView());
+        }
+
+        for (size_t i = 0; i < 8; ++i)
+        {
+            if ((i_flat.m_children[node_index] & (1u << i)) && !_Unflatten(i_flat, io_triangles, i_names, io_node_index, *io_node.GetOrCreateChild(i)))
+                return false;
+        }
+        return true;
+    }
+
     std::vector<TriangleWithMeshTag> _CollectNodesTriangles(const TrianglesOcTreeNode* ip_node)
     {
         if (!ip_node->GetChild(0)) // if it's a leaf (of any kind)
@@ -53,17 +172,21 @@ void Details::TrianglesOcTreeBuildFunctor::operator()(TrianglesOcTreeNode& io_ro
 
     std::vector<TriangleWithMeshTag> child_triangles[8];
     std::vector<BoundingBox> child_bboxes;
+    BoundingBoxPack4 child_bboxes_packs[2];
     for (size_t i = 0; i < 8; ++i)
     {
-        auto child_bbox = io_root.GetPotentialChildBBox(i);
-        child_bboxes.emplace_back(child_bbox);
+        child_bboxes.emplace_back(io_root.GetPotentialChildBBox(i));
+        SetBoundingBox(child_bboxes_packs[i / 4], i % 4, child_bboxes.back());
+    }
 
-        for (size_t j = 0; j < i_triangles.size(); ++j)
+    for (size_t j = 0; j < i_triangles.size(); ++j)
+    {
+        const auto intersections = TriangleWithBBoxesIntersection(*i_triangles[j].first, child_bboxes_packs[0])
+                                 | TriangleWithBBoxesIntersection(*i_triangles[j].first, child_bboxes_packs[1]) << 4;
+        for (size_t i = 0; i < 8; ++i)
         {
-            if (TriangleWithBBoxIntersection(*i_triangles[j].first, child_bbox))
-            {
+            if (intersections & (1u << i))
                 child_triangles[i].emplace_back(i_triangles[j]);
-            }
         }
     }
 
@@ -136,7 +259,7 @@ void Details::TrianglesOcTreeBuildFunctor::operator()(TrianglesOcTreeNode& io_ro
     }
 }
 
-void Details::TrianglesOcTreeQueryFunctor::operator()(const TrianglesOcTreeNode& i_root, TriangleOcTreeQueryResult& o_result, const Point3D& i_point)
+void Details::TrianglesOcTreeQueryFunctor::operator()(const TrianglesOcTreeNode& i_root, TriangleOcTreeQueryResult& o_result, const Point3D& i_point) const
 {
     auto& info = i_root.GetInfo();
     if (!i_root.GetBoundingBox().ContainsPoint(i_point))
@@ -211,3 +334,107 @@ void Details::TrianglesOcTreeQueryFunctor::operator()(const TrianglesOcTreeNode&
 
     this->operator()(*i_root.GetChild(child_index), o_result, i_point);
 }
+
+void SaveTrianglesOcTree(BinaryWriter& io_writer, const TrianglesOcTree& i_tree, const std::vector<Triangle>& i_triangles)
+{
+    std::vector<BasicPoint3D> vertices;
+    vertices.reserve(3 * i_triangles.size());
+    for (const auto& triangle : i_triangles)
+    {
+        for (short i = 0; i < 3; ++i)
+            vertices.push_back(ToBasicPoint(triangle.GetPoint(i)));
+    }
+
+    MeshNames names;
+    FlatOcTree flat;
+    if (i_tree.WasBuild())
+        _Flatten(i_tree.GetRoot(), i_triangles.data(), i_triangles.size(), names, flat);
+    flat.m_offsets.push_back(static_cast<std::uint32_t>(flat.m_triangles.size()));
+
+    io_writer.WriteHeader(OCTREE_MAGIC, OCTREE_VERSION);
+    io_writer.WriteArray(vertices);
+    io_writer.Write(static_cast<std::uint64_t>(names.GetNames().size()));
+    for (const auto& name : names.GetNames())
+        io_writer.WriteArray(name.data(), static_cast<size_t>(name.size()));
+
+    io_writer.Write(static_cast<std::uint8_t>(i_tree.WasBuild() ? 1 : 0));
+    if (i_tree.WasBuild())
+        io_writer.WriteBoundingBox(i_tree.GetRoot().GetBoundingBox());
+    io_writer.WriteArray(flat.m_children);
+    io_writer.WriteArray(flat.m_is_empty_leaf);
+    io_writer.WriteArray(flat.m_fully_inside_mesh);
+    io_writer.WriteArray(flat.m_triangles_bboxes);
+    io_writer.WriteArray(flat.m_offsets);
+    io_writer.WriteArray(flat.m_triangles);
+}
+
+std::unique_ptr<TrianglesOcTree> LoadTrianglesOcTree(BinaryReader& io_reader, std::vector<Triangle>& o_triangles, std::vector<QString>& o_mesh_names)
+{
+    if (!io_reader.ReadHeader(OCTREE_MAGIC, OCTREE_VERSION))
+        return nullptr;
+
+    size_t vertices_count = 0;
+    const auto p_vertices = io_reader.ViewArray<BasicPoint3D>(vertices_count);
+
+    std::uint64_t names_count = 0;
+    std::vector<QString> names;
+    io_reader.Read(names_count);
+    for (std::uint64_t i = 0; i < names_count && io_reader.IsOk(); ++i)
+    {
+        size_t size = 0;
+        const auto p_name = io_reader.ViewArray<char>(size);
+        names.push_back(QString::fromUtf8(p_name, static_cast<int>(size)));
+    }
+
+    std::uint8_t was_build = 0;
+    BoundingBox root_bbox;
+    FlatOcTree flat;
+    io_reader.Read(was_build);
+    if (was_build)
+        io_reader.ReadBoundingBox(root_bbox);
+    io_reader.ReadArray(flat.m_children);
+    io_reader.ReadArray(flat.m_is_empty_leaf);
+    io_reader.ReadArray(flat.m_fully_inside_mesh);
+    io_reader.ReadArray(flat.m_triangles_bboxes);
+    io_reader.ReadArray(flat.m_offsets);
+    io_reader.ReadArray(flat.m_triangles);
+
+    const auto triangles_count = vertices_count / 3;
+    const auto nodes_count = flat.m_children.size();
+    const auto is_mesh_valid = [&names](std::uint32_t i_mesh) { return i_mesh == NO_MESH || i_mesh < names.size(); };
+    const bool is_valid = io_reader.IsOk() && vertices_count % 3 == 0 && (was_build != 0) == (nodes_count != 0)
+                       && flat.m_is_empty_leaf.size() == nodes_count && flat.m_fully_inside_mesh.size() == nodes_count
+                       && flat.m_triangles_bboxes.size() == 6 * nodes_count && flat.m_offsets.size() == nodes_count + 1
+                       && flat.m_offsets.back() == flat.m_triangles.size() && std::is_sorted(flat.m_offsets.begin(), flat.m_offsets.end())
+                       && std::all_of(flat.m_fully_inside_mesh.begin(), flat.m_fully_inside_mesh.end(), is_mesh_valid)
+                       && std::all_of(flat.m_triangles.begin(), flat.m_triangles.end(), [&](const FlatOcTree::Triangle& i_triangle)
+                          {
+                              return i_triangle.m_index < triangles_count && is_mesh_valid(i_triangle.m_mesh);
+                          });
+    if (!is_valid)
+    {
+        io_reader.SetFailed();
+        return nullptr;
+    }
+
+    std::vector<Triangle> triangles;
+    triangles.reserve(triangles_count);
+    for (size_t i = 0; i < vertices_count; i += 3)
+        triangles.emplace_back(ToPoint3D(p_vertices[i]), ToPoint3D(p_vertices[i + 1]), ToPoint3D(p_vertices[i + 2]));
+
+    auto p_tree = std::make_unique<TrianglesOcTree>();
+    if (was_build)
+    {
+        size_t node_index = 0;
+        if (!_Unflatten(flat, triangles, names, node_index, p_tree->ResetRoot(root_bbox)) || node_index != nodes_count)
+        {
+            io_reader.SetFailed();
+            return nullptr;
+        }
+    }
+
+    // nodes point into the buffers of the vectors, they survive the moves
+    o_triangles = std::move(triangles);
+    o_mesh_names = std::move(names);
+    return p_tree;
+}
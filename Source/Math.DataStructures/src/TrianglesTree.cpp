@@ -1,12 +1,87 @@
 #include "Math.DataStructures/TrianglesTree.h"
 
+#include <Math.Core/BinaryStream.h>
 
+#include <cmath>
 #include <functional>
 #include <numeric>
+#include <queue>
 
 
 namespace
 {
+    constexpr char TREE_MAGIC[] = "PL3DSKDT";
+    constexpr std::uint32_t TREE_VERSION = 1;
+
+    enum NodeFlags : std::uint8_t
+    {
+        HAS_LEFT_CHILD = 1,
+        HAS_RIGHT_CHILD = 2,
+    };
+
+    // preorder arrays of the nodes, triangles of node i are m_triangle_indexes[m_offsets[i]] .. m_triangle_indexes[m_offsets[i + 1]]
+    struct FlatTree
+    {
+        std::vector<std::uint8_t> m_flags;
+        std::vector<double> m_bboxes; // min and max corners, 6 values per node
+        std::vector<std::uint32_t> m_offsets;
+        std::vector<std::uint32_t> m_triangle_indexes;
+    };
+
+    void _Flatten(const TrianglesTreeNode& i_node, const Triangle* ip_triangles, size_t i_triangles_count, FlatTree& io_flat)
+    {
+        const auto& info = i_node.GetInfo();
+        io_flat.m_flags.push_back(static_cast<std::uint8_t>((i_node.HasLeftChild() ? HAS_LEFT_CHILD : 0) | (i_node.HasRightChild() ? HAS_RIGHT_CHILD : 0)));
+        for (const auto& corner : { info.m_bbox.GetMin(), info.m_bbox.GetMax() })
+            io_flat.m_bboxes.insert(io_flat.m_bboxes.end(), { corner.GetX(), corner.GetY(), corner.GetZ() });
+
+        io_flat.m_offsets.push_back(static_cast<std::uint32_t>(io_flat.m_triangle_indexes.size()));
+        for (const auto p_triangle : info.m_triangles)
+        {
+            Q_ASSERT(p_triangle >= ip_triangles && p_triangle < ip_triangles + i_triangles_count);
+            io_flat.m_triangle_indexes.push_back(static_cast<std::uint32_t>(p_triangle - ip_triangles));
+        }
+
+        if (i_node.HasLeftChild())
+            _Flatten(i_node.GetLeftChild(), ip_triangles, i_triangles_count, io_flat);
+        if (i_node.HasRightChild())
+            _Flatten(i_node.GetRightChild(), ip_triangles, i_triangles_count, io_flat);
+    }
+
+    // io_node_index is the preorder index of io_node, it is moved past its subtree
+    bool _Unflatten(const FlatTree& i_flat, std::vector<Triangle>& io_triangles, size_t& io_node_index, TrianglesTreeNode& io_node)
+    {
+        if (io_node_index >= i_flat.m_flags.size())
+            return false;
+
+        const auto node_index = io_node_index++;
+        auto& info = io_node.GetInfo();
+        const auto p_bbox = i_flat.m_bboxes.data() + 6 * node_index;
+        if (p_bbox[0] <= p_bbox[3] && p_bbox[1] <= p_bbox[4] && p_bbox[2] <= p_bbox[5])
+        {
+            info.m_bbox.AddPoint(Point3D(p_bbox[0], p_bbox[1], p_bbox[2]));
+            info.m_bbox.AddPoint(Point3D(p_bbox[3], p_bbox[4], p_bbox[5]));
+        }
+
+        for (auto i = i_flat.m_offsets[node_index]; i < i_flat.m_offsets[node_index + 1]; ++i)
+            info.m_triangles.push_back(&io_triangles[i_flat.m_triangle_indexes[i]]);
+
+        const auto flags = i_flat.m_flags[node_index];
+        if (!flags)
+        {
+            // packed triangles are derived data, they are packed again like Build does
+            info.m_packed_triangles.Reserve(info.m_triangles.size());
+            for (size_t i = 0; i < info.m_triangles.size(); ++i)
+                info.m_packed_triangles.Add(*info.m_triangles[i], static_cast<std::uint32_t>(i));
+        }
+
+        if ((flags & HAS_LEFT_CHILD) && !_Unflatten(i_flat, io_triangles, io_node_index, io_node.GetLeftChild()))
+            return false;
+        if ((flags & HAS_RIGHT_CHILD) && !_Unflatten(i_flat, io_triangles, io_node_index, io_node.GetRightChild()))
+            return false;
+        return true;
+    }
+
     Triangle* _QuickMedian(const std::vector<Triangle*>& i_triangles, std::function<double(Triangle*)> i_value_getter)
     {
         if (i_triangles.empty())
@@ -80,9 +155,20 @@ namespace
         auto median_index = quick_median_impl(indexes, i_triangles.size() / 2);
         return triangles_with_values[median_index].first;
     }
+
+    void _MakeLeaf(TrianglesTreeNode& io_node, std::vector<Triangle*>& io_triangles)
+    {
+        auto& info = io_node.GetInfo();
+        info.m_triangles.swap(io_triangles);
+
+        info.m_packed_triangles.Clear();
+        info.m_packed_triangles.Reserve(info.m_triangles.size());
+        for (size_t i = 0; i < info.m_triangles.size(); ++i)
+            info.m_packed_triangles.Add(*info.m_triangles[i], static_cast<std::uint32_t>(i));
+    }
 }
 
-void NearestTriangleApproximationFunctor::operator()(TrianglesTreeNode& i_root, Triangle*& io_triangle, const Point3D& i_point)
+void NearestTriangleApproximationFunctor::operator()(const TrianglesTreeNode& i_root, Triangle*& io_triangle, const Point3D& i_point) const
 {
     if (!i_root.GetInfo().m_bbox.ContainsPoint(i_point))
         return;
@@ -109,6 +195,53 @@ void NearestTriangleApproximationFunctor::operator()(TrianglesTreeNode& i_root,
     }
 }
 
+void NearestTriangleFunctor::operator()(const TrianglesTreeNode& i_root, Triangle*& o_triangle, const Point3D& i_point) const
+{
+    // a triangle crossing a split plane is stored in both children, so the leaf holding its nearest point
+    // is never farther than the triangle itself and the bbox distance is a valid lower bound
+    using NodeWithDistance = std::pair<double, const TrianglesTreeNode*>;
+    auto farther = [](const NodeWithDistance& i_lhs, const NodeWithDistance& i_rhs)
+    {
+        return i_lhs.first > i_rhs.first;
+    };
+    std::priority_queue<NodeWithDistance, std::vector<NodeWithDistance>, decltype(farther)> queue(farther);
+
+    o_triangle = nullptr;
+    if (!i_root.GetInfo().m_bbox.IsValid())
+        return;
+
+    auto nearest_distance = std::numeric_limits<double>::max();
+    queue.emplace(Distance(i_point, i_root.GetInfo().m_bbox), &i_root);
+    while (!queue.empty() && queue.top().first < nearest_distance)
+    {
+        const auto& node = *queue.top().second;
+        queue.pop();
+
+        const bool is_leaf = !node.HasLeftChild() && !node.HasRightChild();
+        if (!is_leaf)
+        {
+            Q_ASSERT(node.HasLeftChild());
+            Q_ASSERT(node.HasRightChild());
+            for (auto p_child : { &node.GetLeftChild(), &node.GetRightChild() })
+            {
+                const auto child_distance = Distance(i_point, p_child->GetInfo().m_bbox);
+                if (child_distance < nearest_distance)
+                    queue.emplace(child_distance, p_child);
+            }
+            continue;
+        }
+
+        const auto& packed_triangles = node.GetInfo().m_packed_triangles;
+        auto nearest_distance_sqr = nearest_distance * nearest_distance;
+        const auto position = packed_triangles.FindNearest(i_point, nearest_distance_sqr, 0, packed_triangles.GetSize());
+        if (position != PackedTriangles::NO_TRIANGLE)
+        {
+            nearest_distance = std::sqrt(nearest_distance_sqr);
+            o_triangle = node.GetInfo().m_triangles[packed_triangles.GetIndex(position)];
+        }
+    }
+}
+
 void BuildTrianglesTreeFunctor::operator()(TrianglesTreeNode& i_root, std::vector<Triangle*> i_triangles)
 {
     if (!i_root.GetInfo().m_bbox.IsValid())
@@ -123,7 +256,7 @@ void BuildTrianglesTreeFunctor::operator()(TrianglesTreeNode& i_root, std::vecto
 
     if (i_triangles.size() <= _triangles_per_leaf_threshold)
     {
-        i_root.GetInfo().m_triangles.swap(i_triangles);
+        _MakeLeaf(i_root, i_triangles);
         return;
     }
 
@@ -165,27 +298,31 @@ void BuildTrianglesTreeFunctor::operator()(TrianglesTreeNode& i_root, std::vecto
 
     std::vector<Triangle*> left_triangles;
     std::vector<Triangle*> right_triangles;
+    BoundingBoxPack4 children_bboxes;
+    SetBoundingBox(children_bboxes, 0, left_bbox);
+    SetBoundingBox(children_bboxes, 1, right_bbox);
     for (auto p_triangle : i_triangles)
     {
-        if (TriangleWithBBoxIntersection(*p_triangle, left_bbox))
+        const auto intersections = TriangleWithBBoxesIntersection(*p_triangle, children_bboxes);
+        if (intersections & 1u)
             left_triangles.emplace_back(p_triangle);
-        if (TriangleWithBBoxIntersection(*p_triangle, right_bbox))
+        if (intersections & 2u)
             right_triangles.emplace_back(p_triangle);
     }
 
     if (left_triangles.empty())
     {
-        i_root.GetInfo().m_triangles.swap(i_triangles);
+        _MakeLeaf(i_root, i_triangles);
         return;
     }
     if (right_triangles.empty())
     {
-        i_root.GetInfo().m_triangles.swap(i_triangles);
+        _MakeLeaf(i_root, i_triangles);
         return;
     }
     if (left_triangles.size() == i_triangles.size() || right_triangles.size() == i_triangles.size())
     {
-        i_root.GetInfo().m_triangles.swap(i_triangles);
+        _MakeLeaf(i_root, i_triangles);
         return;
     }
 
@@ -197,3 +334,75 @@ void BuildTrianglesTreeFunctor::operator()(TrianglesTreeNode& i_root, std::vecto
     this->operator()(i_root.GetLeftChild(), left_triangles);
     this->operator()(i_root.GetRightChild(), right_triangles);
 }
+
+void SaveTrianglesTree(BinaryWriter& io_writer, const TrianglesTree& i_tree, const std::vector<Triangle>& i_triangles, const std::vector<std::uint32_t>& i_triangles_mesh_indexes)
+{
+    Q_ASSERT(i_triangles.size() == i_triangles_mesh_indexes.size());
+
+    std::vector<BasicPoint3D> vertices;
+    vertices.reserve(3 * i_triangles.size());
+    for (const auto& triangle : i_triangles)
+    {
+        for (short i = 0; i < 3; ++i)
+            vertices.push_back(ToBasicPoint(triangle.GetPoint(i)));
+    }
+
+    FlatTree flat;
+    if (i_tree.WasBuild())
+        _Flatten(i_tree.GetRoot(), i_triangles.data(), i_triangles.size(), flat);
+    flat.m_offsets.push_back(static_cast<std::uint32_t>(flat.m_triangle_indexes.size()));
+
+    io_writer.WriteHeader(TREE_MAGIC, TREE_VERSION);
+    io_writer.WriteArray(vertices);
+    io_writer.WriteArray(i_triangles_mesh_indexes);
+    io_writer.WriteArray(flat.m_flags);
+    io_writer.WriteArray(flat.m_bboxes);
+    io_writer.WriteArray(flat.m_offsets);
+    io_writer.WriteArray(flat.m_triangle_indexes);
+}
+
+std::unique_ptr<TrianglesTree> LoadTrianglesTree(BinaryReader& io_reader, std::vector<Triangle>& o_triangles, std::vector<std::uint32_t>& o_triangles_mesh_indexes)
+{
+    if (!io_reader.ReadHeader(TREE_MAGIC, TREE_VERSION))
+        return nullptr;
+
+    size_t vertices_count = 0;
+    const auto p_vertices = io_reader.ViewArray<BasicPoint3D>(vertices_count);
+    std::vector<std::uint32_t> triangles_mesh_indexes;
+    FlatTree flat;
+    io_reader.ReadArray(triangles_mesh_indexes);
+    io_reader.ReadArray(flat.m_flags);
+    io_reader.ReadArray(flat.m_bboxes);
+    io_reader.ReadArray(flat.m_offsets);
+    io_reader.ReadArray(flat.m_triangle_indexes);
+
+    const auto triangles_count = vertices_count / 3;
+    const bool is_valid = io_reader.IsOk() && vertices_count % 3 == 0 && triangles_mesh_indexes.size() == triangles_count
+                       && flat.m_bboxes.size() == 6 * flat.m_flags.size() && flat.m_offsets.size() == flat.m_flags.size() + 1
+                       && flat.m_offsets.back() == flat.m_triangle_indexes.size() && std::is_sorted(flat.m_offsets.begin(), flat.m_offsets.end())
+                       && std::all_of(flat.m_triangle_indexes.begin(), flat.m_triangle_indexes.end(), [triangles_count](std::uint32_t i_index) { return i_index < triangles_count; });
+    if (!is_valid)
+    {
+        io_reader.SetFailed();
+        return nullptr;
+    }
+
+    std::vector<Triangle> triangles;
+    triangles.reserve(triangles_count);
+    for (size_t i = 0; i < vertices_count; i += 3)
+        triangles.emplace_back(ToPoint3D(p_vertices[i]), ToPoint3D(p_vertices[i + 1]), ToPoint3D(p_vertices[i + 2]));
+
+    auto p_tree = std::make_unique<TrianglesTree>();
+    size_t node_index = 0;
+    if (!flat.m_flags.empty() && (!_Unflatten(flat, triangles, node_index, p_tree->GetRoot()) || node_index != flat.m_flags.size()))
+    {
+        io_reader.SetFailed();
+        return nullptr;
+    }
+    p_tree->SetWasBuild(!flat.m_flags.empty());
+
+    // nodes point into the buffer of the vector, it survives the move
+    o_triangles = std::move(triangles);
+    o_triangles_mesh_indexes = std::move(triangles_mesh_indexes);
+    return p_tree;
+}
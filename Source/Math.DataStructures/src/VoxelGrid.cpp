@@ -1,39 +1,878 @@
 #include "Math.DataStructures/VoxelGrid.h"
 
+#include <Math.Core/BinaryStream.h>
 #include <Math.Core/Point3D.h>
 
 #include <QtGlobal>
 
-Voxel::Voxel(const std::array<size_t, 3>& i_coords, const Point3D& i_min_corner, const Point3D& i_max_corner)
-    : BoundingBox()
-    , m_coordinates(i_coords)
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+
+
+namespace
+{
+    // dense storage costs 4 bytes for every voxel of the grid and has the cheapest lookup. Below ~5% of occupied voxels
+    // it wastes too much memory on empty voxels and bricks are used instead (a voxel of the sparse hash map costs ~90 bytes)
+    constexpr double DENSE_OCCUPANCY_THRESHOLD = 0.05;
+
+    struct SparseStorage
+    {
+        std::unordered_map<size_t, std::vector<std::uint32_t>> m_voxels;
+    };
+
+    // CSR layout: triangles of voxel i are m_triangle_indexes[m_offsets[i]] .. m_triangle_indexes[m_offsets[i + 1]]
+    struct DenseStorage
+    {
+        std::vector<std::uint32_t> m_offsets;
+        std::vector<std::uint32_t> m_triangle_indexes;
+    };
+
+    constexpr size_t BRICK_SIZE_LOG = 3;
+    constexpr size_t BRICK_SIZE = 1 << BRICK_SIZE_LOG;
+    constexpr std::uint32_t NO_BRICK = std::numeric_limits<std::uint32_t>::max();
+
+    // one 64 bit word of the mask is one z slice of the brick, bit x + 8 * y of the word is voxel (x, y)
+    struct Brick
+    {
+        std::uint64_t m_mask[BRICK_SIZE] = {};
+        std::uint16_t m_rank[BRICK_SIZE] = {}; // occupied voxels in the previous words
+        std::uint32_t m_first_voxel = 0;       // position of the first occupied voxel of the brick in m_offsets
+    };
+
+    // bricks are stored in order of their voxels, the triangles of the k-th occupied voxel are
+    // m_triangle_indexes[m_offsets[k]] .. m_triangle_indexes[m_offsets[k + 1]]. Fill orders the bricks by their keys, Insert appends new ones
+    struct BricksStorage
+    {
+        std::array<size_t, 3> m_num_bricks = {};
+        std::vector<Brick> m_bricks;
+        std::vector<std::uint32_t> m_offsets;
+        std::vector<std::uint32_t> m_triangle_indexes;
+
+        // open addressing with linear probing, capacity is a power of two
+        std::vector<size_t> m_table_keys;
+        std::vector<std::uint32_t> m_table_bricks;
+        size_t m_table_shift = 0;
+    };
+
+    inline size_t _PopCount(std::uint64_t i_value)
+    {
+#ifdef _MSC_VER
+        return static_cast<size_t>(__popcnt64(i_value));
+#else
+        return static_cast<size_t>(__builtin_popcountll(i_value));
+#endif
+    }
+
+    inline size_t _GetBrickSlot(const BricksStorage& i_storage, size_t i_key)
+    {
+        // Fibonacci hashing, neighbouring bricks go to different parts of the table
+        return static_cast<size_t>((static_cast<std::uint64_t>(i_key) * 0x9E3779B97F4A7C15ull) >> i_storage.m_table_shift);
+    }
+
+    const Brick* _FindBrick(const BricksStorage& i_storage, size_t i_key)
+    {
+        if (i_storage.m_table_keys.empty())
+            return nullptr;
+
+        const auto mask = i_storage.m_table_keys.size() - 1;
+        for (auto slot = _GetBrickSlot(i_storage, i_key); ; slot = (slot + 1) & mask)
+        {
+            const auto brick = i_storage.m_table_bricks[slot];
+            if (brick == NO_BRICK)
+                return nullptr;
+            if (i_storage.m_table_keys[slot] == i_key)
+                return &i_storage.m_bricks[brick];
+        }
+    }
+
+    void _InsertBrick(BricksStorage& io_storage, size_t i_key, std::uint32_t i_brick)
+    {
+        const auto mask = io_storage.m_table_keys.size() - 1;
+        auto slot = _GetBrickSlot(io_storage, i_key);
+        while (io_storage.m_table_bricks[slot] != NO_BRICK)
+            slot = (slot + 1) & mask;
+
+        io_storage.m_table_keys[slot] = i_key;
+        io_storage.m_table_bricks[slot] = i_brick;
+    }
+
+    // load factor is kept below 1/2, so probe sequences stay short. i_brick_keys[i] is the key of brick i
+    void _BuildBrickTable(BricksStorage& io_storage, const std::vector<size_t>& i_brick_keys)
+    {
+        size_t table_size_log = 1;
+        while ((size_t(1) << table_size_log) < 2 * i_brick_keys.size())
+            ++table_size_log;
+        io_storage.m_table_shift = 64 - table_size_log;
+        io_storage.m_table_keys.assign(size_t(1) << table_size_log, 0);
+        io_storage.m_table_bricks.assign(size_t(1) << table_size_log, NO_BRICK);
+        for (size_t i = 0; i < i_brick_keys.size(); ++i)
+            _InsertBrick(io_storage, i_brick_keys[i], static_cast<std::uint32_t>(i));
+    }
+
+    std::vector<size_t> _GetBrickKeys(const BricksStorage& i_storage)
+    {
+        std::vector<size_t> keys(i_storage.m_bricks.size());
+        for (size_t slot = 0; slot < i_storage.m_table_keys.size(); ++slot)
+        {
+            if (i_storage.m_table_bricks[slot] != NO_BRICK)
+                keys[i_storage.m_table_bricks[slot]] = i_storage.m_table_keys[slot];
+        }
+        return keys;
+    }
+
+    // position of the voxel in the offsets of the bricks storage, of the voxel after it if the voxel is empty
+    size_t _GetBrickVoxelPosition(const Brick& i_brick, size_t i_local_index)
+    {
+        const auto word = i_local_index >> 6;
+        const auto bit = i_local_index & 63;
+        return i_brick.m_first_voxel + i_brick.m_rank[word] + _PopCount(i_brick.m_mask[word] & ((std::uint64_t(1) << bit) - 1));
+    }
+
+    // ranks of the words and first voxels of the bricks follow the masks
+    void _UpdateBrickRanks(BricksStorage& io_storage)
+    {
+        std::uint32_t first_voxel = 0;
+        for (auto& brick : io_storage.m_bricks)
+        {
+            brick.m_first_voxel = first_voxel;
+            std::uint16_t rank = 0;
+            for (size_t word = 0; word < BRICK_SIZE; ++word)
+            {
+                brick.m_rank[word] = rank;
+                rank += static_cast<std::uint16_t>(_PopCount(brick.m_mask[word]));
+            }
+            first_voxel += rank;
+        }
+    }
+
+    // New triangles of one voxel of a CSR storage. m_position is the voxel in the offsets, a voxel that isn't in the offsets yet
+    // is put before the voxel at m_position. The voxel gets m_pool[m_begin] .. m_pool[m_end]
+    struct CsrEdit
+    {
+        size_t m_position = 0;
+        bool m_is_new = false;
+        size_t m_begin = 0;
+        size_t m_end = 0;
+    };
+
+    // Edits are sorted by position. The arrays grow once and every run of voxels between two edits is moved once, from the back
+    void _GrowCsr(std::vector<std::uint32_t>& io_offsets, std::vector<std::uint32_t>& io_triangle_indexes, const std::vector<CsrEdit>& i_edits, const std::vector<std::uint32_t>& i_pool)
+    {
+        size_t voxels_shift = 0;
+        size_t indexes_shift = 0;
+        for (const auto& edit : i_edits)
+        {
+            const size_t old_size = edit.m_is_new ? 0 : io_offsets[edit.m_position + 1] - io_offsets[edit.m_position];
+            voxels_shift += edit.m_is_new ? 1 : 0;
+            indexes_shift += edit.m_end - edit.m_begin - old_size;
+        }
+        if (voxels_shift == 0 && indexes_shift == 0)
+            return;
+
+        auto offsets_end = io_offsets.size();
+        auto indexes_end = io_triangle_indexes.size();
+        io_offsets.resize(io_offsets.size() + voxels_shift);
+        io_triangle_indexes.resize(io_triangle_indexes.size() + indexes_shift);
+
+        for (auto it = i_edits.rbegin(); it != i_edits.rend(); ++it)
+        {
+            const auto& edit = *it;
+            const auto position = edit.m_position;
+            const auto next_voxel = edit.m_is_new ? position : position + 1;
+            // the offset at offsets_end may be rewritten already, its old value is indexes_end
+            const size_t voxel_begin = position == offsets_end ? indexes_end : io_offsets[position];
+            const size_t next_begin = next_voxel == offsets_end ? indexes_end : io_offsets[next_voxel];
+
+            // voxels after the edited one up to the previously handled edit
+            for (auto i = offsets_end; i-- > next_voxel;)
+                io_offsets[i + voxels_shift] = static_cast<std::uint32_t>(io_offsets[i] + indexes_shift);
+            std::move_backward(io_triangle_indexes.begin() + next_begin, io_triangle_indexes.begin() + indexes_end,
+                               io_triangle_indexes.begin() + indexes_end + indexes_shift);
+
+            voxels_shift -= edit.m_is_new ? 1 : 0;
+            indexes_shift -= edit.m_end - edit.m_begin - (next_begin - voxel_begin);
+            io_offsets[position + voxels_shift] = static_cast<std::uint32_t>(voxel_begin + indexes_shift);
+            std::copy(i_pool.begin() + edit.m_begin, i_pool.begin() + edit.m_end, io_triangle_indexes.begin() + voxel_begin + indexes_shift);
+
+            offsets_end = position;
+            indexes_end = voxel_begin;
+        }
+    }
+
+    // Edits are sorted by position and keep or shrink their voxels, a new voxel means the voxel leaves the offsets.
+    // Every run of voxels between two edits is moved once, from the front
+    void _ShrinkCsr(std::vector<std::uint32_t>& io_offsets, std::vector<std::uint32_t>& io_triangle_indexes, const std::vector<CsrEdit>& i_edits, const std::vector<std::uint32_t>& i_pool)
+    {
+        size_t voxels_shift = 0;
+        size_t indexes_shift = 0;
+        size_t offsets_begin = 0;
+        size_t indexes_begin = 0;
+        for (const auto& edit : i_edits)
+        {
+            const auto position = edit.m_position;
+            const size_t voxel_begin = io_offsets[position];
+            const size_t voxel_end = io_offsets[position + 1];
+
+            // voxels before the edited one from the previously handled edit
+            for (auto i = offsets_begin; i < position; ++i)
+                io_offsets[i - voxels_shift] = static_cast<std::uint32_t>(io_offsets[i] - indexes_shift);
+            std::move(io_triangle_indexes.begin() + indexes_begin, io_triangle_indexes.begin() + voxel_begin, io_triangle_indexes.begin() + indexes_begin - indexes_shift);
+
+            if (edit.m_is_new)
+                ++voxels_shift;
+            else
+                io_offsets[position - voxels_shift] = static_cast<std::uint32_t>(voxel_begin - indexes_shift);
+            std::copy(i_pool.begin() + edit.m_begin, i_pool.begin() + edit.m_end, io_triangle_indexes.begin() + voxel_begin - indexes_shift);
+            indexes_shift += voxel_end - voxel_begin - (edit.m_end - edit.m_begin);
+
+            offsets_begin = position + 1;
+            indexes_begin = voxel_end;
+        }
+        if (voxels_shift == 0 && indexes_shift == 0)
+            return;
+
+        for (auto i = offsets_begin; i < io_offsets.size(); ++i)
+            io_offsets[i - voxels_shift] = static_cast<std::uint32_t>(io_offsets[i] - indexes_shift);
+        std::move(io_triangle_indexes.begin() + indexes_begin, io_triangle_indexes.end(), io_triangle_indexes.begin() + indexes_begin - indexes_shift);
+        io_offsets.resize(io_offsets.size() - voxels_shift);
+        io_triangle_indexes.resize(io_triangle_indexes.size() - indexes_shift);
+    }
+
+    // Records the old triangles of the voxel with the changes added or removed. Returns false and records nothing if they stay the same
+    bool _AddCsrEdit(const std::uint32_t* ip_begin, const std::uint32_t* ip_end, const std::uint32_t* ip_changes_begin, const std::uint32_t* ip_changes_end, bool i_insert,
+                     size_t i_position, std::vector<CsrEdit>& io_edits, std::vector<std::uint32_t>& io_pool)
+    {
+        CsrEdit edit;
+        edit.m_position = i_position;
+        edit.m_begin = io_pool.size();
+        if (i_insert)
+            std::set_union(ip_begin, ip_end, ip_changes_begin, ip_changes_end, std::back_inserter(io_pool));
+        else
+            std::set_difference(ip_begin, ip_end, ip_changes_begin, ip_changes_end, std::back_inserter(io_pool));
+        edit.m_end = io_pool.size();
+
+        if (edit.m_end - edit.m_begin == static_cast<size_t>(ip_end - ip_begin))
+        {
+            io_pool.resize(edit.m_begin);
+            return false;
+        }
+        io_edits.emplace_back(edit);
+        return true;
+    }
+
+    // calls i_function(voxel index, sorted triangle indexes) for every voxel of the sorted entries
+    template<typename TFunction>
+    void _ForEachVoxel(const std::vector<VoxelGrid::Entry>& i_sorted_entries, TFunction i_function)
+    {
+        std::vector<std::uint32_t> triangle_indexes;
+        for (size_t begin = 0; begin < i_sorted_entries.size();)
+        {
+            triangle_indexes.clear();
+            auto end = begin;
+            for (; end < i_sorted_entries.size() && i_sorted_entries[end].m_voxel_index == i_sorted_entries[begin].m_voxel_index; ++end)
+                triangle_indexes.emplace_back(i_sorted_entries[end].m_triangle_index);
+
+            i_function(i_sorted_entries[begin].m_voxel_index, triangle_indexes);
+            begin = end;
+        }
+    }
+
+    bool _EntryLess(const VoxelGrid::Entry& i_lhs, const VoxelGrid::Entry& i_rhs)
+    {
+        if (i_lhs.m_voxel_index != i_rhs.m_voxel_index)
+            return i_lhs.m_voxel_index < i_rhs.m_voxel_index;
+        return i_lhs.m_triangle_index < i_rhs.m_triangle_index;
+    }
+
+    bool _EntryEqual(const VoxelGrid::Entry& i_lhs, const VoxelGrid::Entry& i_rhs)
+    {
+        return i_lhs.m_voxel_index == i_rhs.m_voxel_index && i_lhs.m_triangle_index == i_rhs.m_triangle_index;
+    }
+
+    void _SortEntries(std::vector<VoxelGrid::Entry>& io_entries)
+    {
+        // Voxelizer passes already sorted entries
+        if (!std::is_sorted(io_entries.begin(), io_entries.end(), _EntryLess))
+            std::sort(io_entries.begin(), io_entries.end(), _EntryLess);
+        io_entries.erase(std::unique(io_entries.begin(), io_entries.end(), _EntryEqual), io_entries.end());
+    }
+
+    size_t _CountVoxels(const std::vector<VoxelGrid::Entry>& i_sorted_entries)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < i_sorted_entries.size(); ++i)
+        {
+            if (i == 0 || i_sorted_entries[i].m_voxel_index != i_sorted_entries[i - 1].m_voxel_index)
+                ++count;
+        }
+        return count;
+    }
+}
+
+namespace
 {
-    AddPoint(i_min_corner);
-    AddPoint(i_max_corner);
+    constexpr char GRID_MAGIC[] = "PL3DSVXG";
+    constexpr std::uint32_t GRID_VERSION = 1;
+
+    // size_t is written as 64 bit on every platform
+    void _WriteSizes(BinaryWriter& io_writer, const std::vector<size_t>& i_values)
+    {
+        io_writer.WriteArray(std::vector<std::uint64_t>(i_values.begin(), i_values.end()));
+    }
+
+    bool _ReadSizes(BinaryReader& io_reader, std::vector<size_t>& o_values)
+    {
+        std::vector<std::uint64_t> values;
+        if (!io_reader.ReadArray(values))
+            return false;
+        o_values.assign(values.begin(), values.end());
+        return true;
+    }
+
+    // CSR arrays of a voxel storage: offsets grow, the last one closes the indexes, every index is a triangle
+    bool _IsValidCsr(const std::vector<std::uint32_t>& i_offsets, const std::vector<std::uint32_t>& i_triangle_indexes, size_t i_triangles_count)
+    {
+        if (i_offsets.empty() || i_offsets.front() != 0 || i_offsets.back() != i_triangle_indexes.size())
+            return false;
+        if (!std::is_sorted(i_offsets.begin(), i_offsets.end()))
+            return false;
+        return std::all_of(i_triangle_indexes.begin(), i_triangle_indexes.end(), [i_triangles_count](std::uint32_t i_index)
+        {
+            return i_index < i_triangles_count;
+        });
+    }
+
+    // Lookups trust the table, the masks and the ranks. A table without a free slot makes the lookup of a missing brick
+    // loop forever, a wrong shift, key or rank makes it read out of the arrays
+    bool _IsValidBricks(const BricksStorage& i_storage, const std::array<size_t, 3>& i_num_voxels)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            if (i_storage.m_num_bricks[i] != (i_num_voxels[i] + BRICK_SIZE - 1) >> BRICK_SIZE_LOG)
+                return false;
+        }
+
+        const auto table_size = i_storage.m_table_keys.size();
+        if (table_size < 2 || (table_size & (table_size - 1)) != 0 || i_storage.m_table_bricks.size() != table_size)
+            return false;
+        size_t table_size_log = 0;
+        while ((size_t(1) << table_size_log) < table_size)
+            ++table_size_log;
+        if (i_storage.m_table_shift != 64 - table_size_log)
+            return false;
+
+        // every brick is in one slot that its probe sequence reaches, keys are unique and at least one slot is free
+        const auto bricks_count = i_storage.m_num_bricks[0] * i_storage.m_num_bricks[1] * i_storage.m_num_bricks[2];
+        const auto mask = table_size - 1;
+        std::vector<bool> is_in_table(i_storage.m_bricks.size(), false);
+        std::vector<size_t> keys;
+        keys.reserve(i_storage.m_bricks.size());
+        for (size_t slot = 0; slot < table_size; ++slot)
+        {
+            const auto brick = i_storage.m_table_bricks[slot];
+            if (brick == NO_BRICK)
+                continue;
+
+            const auto key = i_storage.m_table_keys[slot];
+            if (brick >= i_storage.m_bricks.size() || is_in_table[brick] || key >= bricks_count)
+                return false;
+            for (auto probe = _GetBrickSlot(i_storage, key); probe != slot; probe = (probe + 1) & mask)
+            {
+                if (i_storage.m_table_bricks[probe] == NO_BRICK)
+                    return false;
+            }
+            is_in_table[brick] = true;
+            keys.push_back(key);
+        }
+        if (keys.size() == table_size || keys.size() != i_storage.m_bricks.size())
+            return false;
+        std::sort(keys.begin(), keys.end());
+        if (std::adjacent_find(keys.begin(), keys.end()) != keys.end())
+            return false;
+
+        // bricks follow each other in the offsets, the rank of a word counts the voxels of the previous words
+        size_t first_voxel = 0;
+        for (const auto& brick : i_storage.m_bricks)
+        {
+            if (brick.m_first_voxel != first_voxel)
+                return false;
+
+            size_t rank = 0;
+            for (size_t word = 0; word < BRICK_SIZE; ++word)
+            {
+                if (brick.m_rank[word] != rank)
+                    return false;
+                rank += _PopCount(brick.m_mask[word]);
+            }
+            first_voxel += rank;
+        }
+        return first_voxel + 1 == i_storage.m_offsets.size();
+    }
 }
 
-void Voxel::AddTriangle(Triangle* ip_triangle)
+struct VoxelGrid::Impl
+{
+    StorageType m_storage_type = StorageType::Sparse;
+    std::vector<Triangle*> m_triangles; // empty for a grid filled by a triangles count
+    size_t m_triangles_count = 0;
+    size_t m_existing_voxels_count = 0;
+
+    SparseStorage m_sparse;
+    DenseStorage m_dense;
+    BricksStorage m_bricks;
+
+    size_t _GetBrickKey(const std::array<size_t, 3>& i_coordinates) const;
+    void _FillBricks(const std::array<size_t, 3>& i_num_voxels, const std::vector<Entry>& i_sorted_entries);
+
+    // compact storages move the voxels after every changed one once, no voxel is looked up again
+    void _EditDense(const std::vector<Entry>& i_sorted_entries, bool i_insert);
+    void _EditBricks(const std::array<size_t, 3>& i_num_voxels, const std::vector<Entry>& i_sorted_entries, bool i_insert);
+};
+
+size_t VoxelGrid::Impl::_GetBrickKey(const std::array<size_t, 3>& i_coordinates) const
 {
-    m_triangles.emplace_back(ip_triangle);
+    const auto& num_bricks = m_bricks.m_num_bricks;
+    return (i_coordinates[0] >> BRICK_SIZE_LOG)
+         + (i_coordinates[1] >> BRICK_SIZE_LOG) * num_bricks[0]
+         + (i_coordinates[2] >> BRICK_SIZE_LOG) * num_bricks[0] * num_bricks[1];
 }
 
-const std::vector<Triangle*>& Voxel::GetTriangles() const
+void VoxelGrid::Impl::_FillBricks(const std::array<size_t, 3>& i_num_voxels, const std::vector<Entry>& i_sorted_entries)
 {
-    return m_triangles;
+    struct BrickVoxel
+    {
+        size_t m_brick_key = 0;
+        size_t m_local_index = 0;
+        size_t m_entries_begin = 0;
+        size_t m_entries_end = 0;
+    };
+
+    auto& storage = m_bricks;
+    for (size_t i = 0; i < 3; ++i)
+        storage.m_num_bricks[i] = (i_num_voxels[i] + BRICK_SIZE - 1) >> BRICK_SIZE_LOG;
+
+    // voxels are regrouped so that the voxels of one brick go one after another
+    std::vector<BrickVoxel> voxels;
+    voxels.reserve(m_existing_voxels_count);
+    for (size_t begin = 0; begin < i_sorted_entries.size();)
+    {
+        auto end = begin;
+        while (end < i_sorted_entries.size() && i_sorted_entries[end].m_voxel_index == i_sorted_entries[begin].m_voxel_index)
+            ++end;
+
+        const auto index = i_sorted_entries[begin].m_voxel_index;
+        const std::array<size_t, 3> coordinates = { index % i_num_voxels[0], index / i_num_voxels[0] % i_num_voxels[1], index / i_num_voxels[0] / i_num_voxels[1] };
+
+        BrickVoxel voxel;
+        voxel.m_brick_key = _GetBrickKey(coordinates);
+        voxel.m_local_index = (coordinates[0] & (BRICK_SIZE - 1))
+                            + (coordinates[1] & (BRICK_SIZE - 1)) * BRICK_SIZE
+                            + (coordinates[2] & (BRICK_SIZE - 1)) * BRICK_SIZE * BRICK_SIZE;
+        voxel.m_entries_begin = begin;
+        voxel.m_entries_end = end;
+        voxels.emplace_back(voxel);
+
+        begin = end;
+    }
+
+    std::sort(voxels.begin(), voxels.end(), [](const BrickVoxel& i_lhs, const BrickVoxel& i_rhs)
+    {
+        if (i_lhs.m_brick_key != i_rhs.m_brick_key)
+            return i_lhs.m_brick_key < i_rhs.m_brick_key;
+        return i_lhs.m_local_index < i_rhs.m_local_index;
+    });
+
+    std::vector<size_t> brick_keys;
+    storage.m_offsets.reserve(voxels.size() + 1);
+    storage.m_triangle_indexes.reserve(i_sorted_entries.size());
+    for (size_t i = 0; i < voxels.size(); ++i)
+    {
+        const auto& voxel = voxels[i];
+        if (i == 0 || voxel.m_brick_key != voxels[i - 1].m_brick_key)
+        {
+            brick_keys.emplace_back(voxel.m_brick_key);
+            storage.m_bricks.emplace_back();
+        }
+
+        storage.m_bricks.back().m_mask[voxel.m_local_index >> 6] |= std::uint64_t(1) << (voxel.m_local_index & 63);
+
+        storage.m_offsets.emplace_back(static_cast<std::uint32_t>(storage.m_triangle_indexes.size()));
+        for (auto entry = voxel.m_entries_begin; entry < voxel.m_entries_end; ++entry)
+            storage.m_triangle_indexes.emplace_back(i_sorted_entries[entry].m_triangle_index);
+    }
+    storage.m_offsets.emplace_back(static_cast<std::uint32_t>(storage.m_triangle_indexes.size()));
+
+    _UpdateBrickRanks(storage);
+
+    _BuildBrickTable(storage, brick_keys);
 }
 
-const std::array<size_t, 3>& Voxel::GetCoordinates() const
+void VoxelGrid::Impl::_EditDense(const std::vector<Entry>& i_sorted_entries, bool i_insert)
 {
-    return m_coordinates;
+    auto& dense = m_dense;
+    std::vector<CsrEdit> edits;
+    std::vector<std::uint32_t> pool;
+    _ForEachVoxel(i_sorted_entries, [&](size_t i_voxel_index, const std::vector<std::uint32_t>& i_changes)
+    {
+        const auto p_indexes = dense.m_triangle_indexes.data();
+        const auto p_begin = p_indexes + dense.m_offsets[i_voxel_index];
+        const auto p_end = p_indexes + dense.m_offsets[i_voxel_index + 1];
+        if (!_AddCsrEdit(p_begin, p_end, i_changes.data(), i_changes.data() + i_changes.size(), i_insert, i_voxel_index, edits, pool))
+            return;
+
+        const auto& edit = edits.back();
+        if (p_begin == p_end)
+            ++m_existing_voxels_count;
+        else if (edit.m_begin == edit.m_end)
+            --m_existing_voxels_count;
+    });
+
+    if (i_insert)
+        _GrowCsr(dense.m_offsets, dense.m_triangle_indexes, edits, pool);
+    else
+        _ShrinkCsr(dense.m_offsets, dense.m_triangle_indexes, edits, pool);
 }
 
-////////////////////////////////////////////////////////////////
+void VoxelGrid::Impl::_EditBricks(const std::array<size_t, 3>& i_num_voxels, const std::vector<Entry>& i_sorted_entries, bool i_insert)
+{
+    struct BrickVoxel
+    {
+        size_t m_brick_key = 0;
+        std::uint32_t m_brick = NO_BRICK;
+        size_t m_local_index = 0;
+        size_t m_changes_begin = 0;
+        size_t m_changes_end = 0;
+    };
+
+    auto& storage = m_bricks;
+    const auto old_bricks_count = storage.m_bricks.size();
+
+    std::vector<BrickVoxel> voxels;
+    std::vector<std::uint32_t> changes;
+    std::vector<size_t> new_brick_keys;
+    _ForEachVoxel(i_sorted_entries, [&](size_t i_voxel_index, const std::vector<std::uint32_t>& i_changes)
+    {
+        const std::array<size_t, 3> coordinates = { i_voxel_index % i_num_voxels[0], i_voxel_index / i_num_voxels[0] % i_num_voxels[1], i_voxel_index / i_num_voxels[0] / i_num_voxels[1] };
+
+        BrickVoxel voxel;
+        voxel.m_brick_key = _GetBrickKey(coordinates);
+        voxel.m_local_index = (coordinates[0] & (BRICK_SIZE - 1))
+                            + (coordinates[1] & (BRICK_SIZE - 1)) * BRICK_SIZE
+                            + (coordinates[2] & (BRICK_SIZE - 1)) * BRICK_SIZE * BRICK_SIZE;
+        if (const auto p_brick = _FindBrick(storage, voxel.m_brick_key))
+            voxel.m_brick = static_cast<std::uint32_t>(p_brick - storage.m_bricks.data());
+        else if (i_insert)
+            new_brick_keys.emplace_back(voxel.m_brick_key);
+        else
+            return;
+
+        voxel.m_changes_begin = changes.size();
+        changes.insert(changes.end(), i_changes.begin(), i_changes.end());
+        voxel.m_changes_end = changes.size();
+        voxels.emplace_back(voxel);
+    });
+
+    // new bricks go after the old ones in order of their keys, so do their voxels
+    std::sort(new_brick_keys.begin(), new_brick_keys.end());
+    new_brick_keys.erase(std::unique(new_brick_keys.begin(), new_brick_keys.end()), new_brick_keys.end());
+    for (auto& voxel : voxels)
+    {
+        if (voxel.m_brick == NO_BRICK)
+            voxel.m_brick = static_cast<std::uint32_t>(old_bricks_count + (std::lower_bound(new_brick_keys.begin(), new_brick_keys.end(), voxel.m_brick_key) - new_brick_keys.begin()));
+    }
+    std::sort(voxels.begin(), voxels.end(), [](const BrickVoxel& i_lhs, const BrickVoxel& i_rhs)
+    {
+        if (i_lhs.m_brick != i_rhs.m_brick)
+            return i_lhs.m_brick < i_rhs.m_brick;
+        return i_lhs.m_local_index < i_rhs.m_local_index;
+    });
+
+    // positions are taken from the old masks, the voxels that come or go are marked in the masks after the arrays are moved
+    const auto voxels_count = storage.m_offsets.size() - 1;
+    std::vector<CsrEdit> edits;
+    std::vector<std::uint32_t> pool;
+    std::vector<const BrickVoxel*> edited_voxels;
+    for (const auto& voxel : voxels)
+    {
+        bool is_occupied = false;
+        auto position = voxels_count;
+        if (voxel.m_brick < old_bricks_count)
+        {
+            const auto& brick = storage.m_bricks[voxel.m_brick];
+            is_occupied = (brick.m_mask[voxel.m_local_index >> 6] & (std::uint64_t(1) << (voxel.m_local_index & 63))) != 0;
+            position = _GetBrickVoxelPosition(brick, voxel.m_local_index);
+        }
+        if (!is_occupied && !i_insert)
+            continue;
+
+        const auto p_indexes = storage.m_triangle_indexes.data();
+        const auto p_begin = is_occupied ? p_indexes + storage.m_offsets[position] : p_indexes;
+        const auto p_end = is_occupied ? p_indexes + storage.m_offsets[position + 1] : p_indexes;
+        if (!_AddCsrEdit(p_begin, p_end, changes.data() + voxel.m_changes_begin, changes.data() + voxel.m_changes_end, i_insert, position, edits, pool))
+            continue;
+
+        auto& edit = edits.back();
+        edit.m_is_new = !is_occupied || edit.m_begin == edit.m_end;
+        edited_voxels.emplace_back(&voxel);
+    }
+
+    if (i_insert)
+        _GrowCsr(storage.m_offsets, storage.m_triangle_indexes, edits, pool);
+    else
+        _ShrinkCsr(storage.m_offsets, storage.m_triangle_indexes, edits, pool);
+
+    if (!new_brick_keys.empty())
+    {
+        storage.m_bricks.resize(old_bricks_count + new_brick_keys.size());
+        if (2 * storage.m_bricks.size() <= storage.m_table_keys.size())
+        {
+            for (size_t i = 0; i < new_brick_keys.size(); ++i)
+                _InsertBrick(storage, new_brick_keys[i], static_cast<std::uint32_t>(old_bricks_count + i));
+        }
+        else
+        {
+            auto brick_keys = _GetBrickKeys(storage);
+            std::copy(new_brick_keys.begin(), new_brick_keys.end(), brick_keys.begin() + old_bricks_count);
+            _BuildBrickTable(storage, brick_keys);
+        }
+    }
+
+    bool has_empty_bricks = false;
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        if (!edits[i].m_is_new)
+            continue;
+
+        const auto& voxel = *edited_voxels[i];
+        auto& word_mask = storage.m_bricks[voxel.m_brick].m_mask[voxel.m_local_index >> 6];
+        word_mask ^= std::uint64_t(1) << (voxel.m_local_index & 63);
+        if (i_insert)
+        {
+            ++m_existing_voxels_count;
+        }
+        else
+        {
+            --m_existing_voxels_count;
+            has_empty_bricks = has_empty_bricks || word_mask == 0;
+        }
+    }
+
+    // bricks without voxels are dropped, the rest keep their order
+    if (has_empty_bricks)
+    {
+        const auto brick_keys = _GetBrickKeys(storage);
+        std::vector<size_t> kept_keys;
+        std::vector<Brick> kept_bricks;
+        for (size_t i = 0; i < storage.m_bricks.size(); ++i)
+        {
+            const auto& brick = storage.m_bricks[i];
+            if (std::any_of(std::begin(brick.m_mask), std::end(brick.m_mask), [](std::uint64_t i_mask) { return i_mask != 0; }))
+            {
+                kept_keys.emplace_back(brick_keys[i]);
+                kept_bricks.emplace_back(brick);
+            }
+        }
+        storage.m_bricks = std::move(kept_bricks);
+        _BuildBrickTable(storage, kept_keys);
+    }
+
+    _UpdateBrickRanks(storage);
+}
 
 VoxelGrid::VoxelGrid(const std::array<double, 3>& i_voxel_size, const std::array<size_t, 3>& i_num_voxels, const BoundingBox& i_bbox)
     : m_voxel_size(i_voxel_size)
     , m_num_voxels(i_num_voxels)
     , m_bbox(i_bbox)
+    , mp_impl(std::make_unique<Impl>())
+{
+}
+
+VoxelGrid::~VoxelGrid() = default;
+
+void VoxelGrid::Fill(const std::vector<Triangle*>& i_triangles, std::vector<Entry>& io_entries, StorageType i_storage_type)
+{
+    Fill(i_triangles.size(), io_entries, i_storage_type);
+    mp_impl->m_triangles = i_triangles;
+}
+
+void VoxelGrid::Fill(size_t i_triangles_count, std::vector<Entry>& io_entries, StorageType i_storage_type)
+{
+    Q_ASSERT(i_triangles_count <= std::numeric_limits<std::uint32_t>::max());
+
+    _SortEntries(io_entries);
+
+    if (i_storage_type == StorageType::Auto)
+    {
+        const auto total_voxels = m_num_voxels[0] * m_num_voxels[1] * m_num_voxels[2];
+        const auto existing_voxels = _CountVoxels(io_entries);
+        const bool is_dense = existing_voxels > 0 && existing_voxels >= DENSE_OCCUPANCY_THRESHOLD * total_voxels;
+        i_storage_type = is_dense ? StorageType::Dense : StorageType::Bricks;
+    }
+
+    _Layout({}, i_triangles_count, io_entries, i_storage_type);
+}
+
+void VoxelGrid::_Layout(std::vector<Triangle*> i_triangles, size_t i_triangles_count, const std::vector<Entry>& i_sorted_entries, StorageType i_storage_type)
+{
+    Q_ASSERT(i_storage_type != StorageType::Auto);
+    Q_ASSERT(i_sorted_entries.size() <= std::numeric_limits<std::uint32_t>::max());
+
+    const auto total_voxels = m_num_voxels[0] * m_num_voxels[1] * m_num_voxels[2];
+    const auto existing_voxels = _CountVoxels(i_sorted_entries);
+
+    mp_impl = std::make_unique<Impl>();
+    mp_impl->m_storage_type = i_storage_type;
+    mp_impl->m_triangles = std::move(i_triangles);
+    mp_impl->m_triangles_count = i_triangles_count;
+    mp_impl->m_existing_voxels_count = existing_voxels;
+
+    if (i_storage_type == StorageType::Sparse)
+    {
+        auto& voxels = mp_impl->m_sparse.m_voxels;
+        voxels.reserve(existing_voxels);
+        for (size_t begin = 0; begin < i_sorted_entries.size();)
+        {
+            auto end = begin;
+            while (end < i_sorted_entries.size() && i_sorted_entries[end].m_voxel_index == i_sorted_entries[begin].m_voxel_index)
+                ++end;
+
+            auto& triangle_indexes = voxels[i_sorted_entries[begin].m_voxel_index];
+            triangle_indexes.reserve(end - begin);
+            for (auto i = begin; i < end; ++i)
+                triangle_indexes.emplace_back(i_sorted_entries[i].m_triangle_index);
+
+            begin = end;
+        }
+    }
+    else if (i_storage_type == StorageType::Bricks)
+    {
+        mp_impl->_FillBricks(m_num_voxels, i_sorted_entries);
+    }
+    else
+    {
+        auto& dense = mp_impl->m_dense;
+        dense.m_offsets.assign(total_voxels + 1, 0);
+        dense.m_triangle_indexes.reserve(i_sorted_entries.size());
+
+        // entries are sorted by voxel, so offsets are filled in one pass
+        size_t voxel_index = 0;
+        for (const auto& entry : i_sorted_entries)
+        {
+            Q_ASSERT(entry.m_voxel_index < total_voxels);
+            while (voxel_index <= entry.m_voxel_index)
+                dense.m_offsets[voxel_index++] = static_cast<std::uint32_t>(dense.m_triangle_indexes.size());
+            dense.m_triangle_indexes.emplace_back(entry.m_triangle_index);
+        }
+        while (voxel_index <= total_voxels)
+            dense.m_offsets[voxel_index++] = static_cast<std::uint32_t>(dense.m_triangle_indexes.size());
+    }
+}
+
+std::uint32_t VoxelGrid::AddTriangles(const std::vector<Triangle*>& i_triangles)
+{
+    Q_ASSERT(mp_impl->m_triangles.size() == mp_impl->m_triangles_count);
+
+    auto& triangles = mp_impl->m_triangles;
+    triangles.insert(triangles.end(), i_triangles.begin(), i_triangles.end());
+    return AddTriangles(i_triangles.size());
+}
+
+std::uint32_t VoxelGrid::AddTriangles(size_t i_count)
+{
+    Q_ASSERT(mp_impl->m_triangles_count + i_count <= std::numeric_limits<std::uint32_t>::max());
+
+    const auto first_index = static_cast<std::uint32_t>(mp_impl->m_triangles_count);
+    mp_impl->m_triangles_count += i_count;
+    return first_index;
+}
+
+void VoxelGrid::Insert(std::vector<Entry>& io_entries)
+{
+    _SortEntries(io_entries);
+
+    if (mp_impl->m_storage_type == StorageType::Sparse)
+    {
+        auto& voxels = mp_impl->m_sparse.m_voxels;
+        for (const auto& entry : io_entries)
+        {
+            auto& triangle_indexes = voxels[entry.m_voxel_index];
+            if (triangle_indexes.empty())
+                ++mp_impl->m_existing_voxels_count;
+
+            auto it = std::lower_bound(triangle_indexes.begin(), triangle_indexes.end(), entry.m_triangle_index);
+            if (it == triangle_indexes.end() || *it != entry.m_triangle_index)
+                triangle_indexes.insert(it, entry.m_triangle_index);
+        }
+        return;
+    }
+
+    if (mp_impl->m_storage_type == StorageType::Dense)
+        mp_impl->_EditDense(io_entries, true);
+    else
+        mp_impl->_EditBricks(m_num_voxels, io_entries, true);
+}
+
+void VoxelGrid::Remove(std::vector<Entry>& io_entries)
+{
+    _SortEntries(io_entries);
+
+    if (!mp_impl->m_triangles.empty())
+    {
+        for (const auto& entry : io_entries)
+            mp_impl->m_triangles[entry.m_triangle_index] = nullptr;
+    }
+
+    if (mp_impl->m_storage_type == StorageType::Sparse)
+    {
+        auto& voxels = mp_impl->m_sparse.m_voxels;
+        for (const auto& entry : io_entries)
+        {
+            auto voxel_it = voxels.find(entry.m_voxel_index);
+            if (voxel_it == voxels.end())
+                continue;
+
+            auto& triangle_indexes = voxel_it->second;
+            auto it = std::lower_bound(triangle_indexes.begin(), triangle_indexes.end(), entry.m_triangle_index);
+            if (it != triangle_indexes.end() && *it == entry.m_triangle_index)
+                triangle_indexes.erase(it);
+
+            if (triangle_indexes.empty())
+            {
+                voxels.erase(voxel_it);
+                --mp_impl->m_existing_voxels_count;
+            }
+        }
+        return;
+    }
+
+    if (mp_impl->m_storage_type == StorageType::Dense)
+        mp_impl->_EditDense(io_entries, false);
+    else
+        mp_impl->_EditBricks(m_num_voxels, io_entries, false);
+}
+
+std::vector<VoxelGrid::Entry> VoxelGrid::_GetEntries() const
 {
+    std::vector<Entry> result;
+    for (const auto& coordinates : GetExistingVoxelsCoordinates())
+    {
+        const auto voxel_triangles = GetVoxelTriangles(coordinates);
+        for (auto it = voxel_triangles.begin(); it != voxel_triangles.end(); ++it)
+        {
+            Entry entry;
+            entry.m_voxel_index = GetVoxelIndexFromCoordinates(coordinates);
+            entry.m_triangle_index = it.GetIndex();
+            result.emplace_back(entry);
+        }
+    }
+    return result;
 }
 
 const std::array<double, 3>& VoxelGrid::GetVoxelSize() const
@@ -46,41 +885,169 @@ const std::array<size_t, 3>& VoxelGrid::GetNumVoxels() const
     return m_num_voxels;
 }
 
-Voxel* VoxelGrid::GetOrCreateVoxel(const std::array<size_t, 3>& i_coordinates)
+const BoundingBox& VoxelGrid::GetBoundingBox() const
+{
+    return m_bbox;
+}
+
+VoxelGrid::StorageType VoxelGrid::GetStorageType() const
+{
+    return mp_impl->m_storage_type;
+}
+
+bool VoxelGrid::HasVoxel(const std::array<size_t, 3>& i_coordinates) const
+{
+    return !GetVoxelTriangles(i_coordinates).empty();
+}
+
+VoxelTrianglesRange VoxelGrid::GetVoxelTriangles(const std::array<size_t, 3>& i_coordinates) const
+{
+    const auto index = GetVoxelIndexFromCoordinates(i_coordinates);
+    const auto p_triangles = mp_impl->m_triangles.data();
+
+    if (mp_impl->m_storage_type == StorageType::Dense)
+    {
+        const auto& dense = mp_impl->m_dense;
+        const auto p_indexes = dense.m_triangle_indexes.data();
+        return VoxelTrianglesRange(p_indexes + dense.m_offsets[index], p_indexes + dense.m_offsets[index + 1], p_triangles);
+    }
+
+    if (mp_impl->m_storage_type == StorageType::Bricks)
+    {
+        const auto& bricks = mp_impl->m_bricks;
+        const auto p_brick = _FindBrick(bricks, mp_impl->_GetBrickKey(i_coordinates));
+        if (!p_brick)
+            return VoxelTrianglesRange();
+
+        const auto word = i_coordinates[2] & (BRICK_SIZE - 1);
+        const auto bit = (i_coordinates[0] & (BRICK_SIZE - 1)) + (i_coordinates[1] & (BRICK_SIZE - 1)) * BRICK_SIZE;
+        const auto word_mask = p_brick->m_mask[word];
+        if (!(word_mask & (std::uint64_t(1) << bit)))
+            return VoxelTrianglesRange();
+
+        const auto voxel = p_brick->m_first_voxel + p_brick->m_rank[word] + _PopCount(word_mask & ((std::uint64_t(1) << bit) - 1));
+        const auto p_indexes = bricks.m_triangle_indexes.data();
+        return VoxelTrianglesRange(p_indexes + bricks.m_offsets[voxel], p_indexes + bricks.m_offsets[voxel + 1], p_triangles);
+    }
+
+    const auto& voxels = mp_impl->m_sparse.m_voxels;
+    auto it = voxels.find(index);
+    if (it == voxels.end())
+        return VoxelTrianglesRange();
+    return VoxelTrianglesRange(it->second.data(), it->second.data() + it->second.size(), p_triangles);
+}
+
+BoundingBox VoxelGrid::GetVoxelBoundingBox(const std::array<size_t, 3>& i_coordinates) const
 {
-    auto index = GetVoxelIndexFromCoordinates(i_coordinates);
-    if (m_voxels.find(index) == m_voxels.end())
+    const auto min_corner = m_bbox.GetMin();
+
+    BoundingBox result;
+    result.AddPoint(Point3D(i_coordinates[0] * m_voxel_size[0], i_coordinates[1] * m_voxel_size[1], i_coordinates[2] * m_voxel_size[2]) + min_corner);
+    result.AddPoint(Point3D((i_coordinates[0] + 1) * m_voxel_size[0], (i_coordinates[1] + 1) * m_voxel_size[1], (i_coordinates[2] + 1) * m_voxel_size[2]) + min_corner);
+    return result;
+}
+
+std::vector<std::array<size_t, 3>> VoxelGrid::GetExistingVoxelsCoordinates() const
+{
+    std::vector<size_t> indexes;
+    indexes.reserve(mp_impl->m_existing_voxels_count);
+
+    if (mp_impl->m_storage_type == StorageType::Dense)
     {
-        Point3D min_point(i_coordinates[0] * m_voxel_size[0], i_coordinates[1] * m_voxel_size[1], i_coordinates[2] * m_voxel_size[2]);
-        Point3D max_point((i_coordinates[0] + 1) * m_voxel_size[0], (i_coordinates[1] + 1) * m_voxel_size[1], (i_coordinates[2] + 1) * m_voxel_size[2]);
-        m_voxels.emplace(index, Voxel(i_coordinates, min_point + m_bbox.GetMin() , max_point + m_bbox.GetMin()));
+        const auto& offsets = mp_impl->m_dense.m_offsets;
+        for (size_t i = 0; i + 1 < offsets.size(); ++i)
+        {
+            if (offsets[i] != offsets[i + 1])
+                indexes.emplace_back(i);
+        }
+    }
+    else if (mp_impl->m_storage_type == StorageType::Bricks)
+    {
+        const auto& bricks = mp_impl->m_bricks;
+        const auto& num_bricks = bricks.m_num_bricks;
+        for (size_t slot = 0; slot < bricks.m_table_keys.size(); ++slot)
+        {
+            if (bricks.m_table_bricks[slot] == NO_BRICK)
+                continue;
+
+            const auto key = bricks.m_table_keys[slot];
+            const auto& brick = bricks.m_bricks[bricks.m_table_bricks[slot]];
+            const std::array<size_t, 3> brick_origin = { key % num_bricks[0] * BRICK_SIZE, key / num_bricks[0] % num_bricks[1] * BRICK_SIZE, key / num_bricks[0] / num_bricks[1] * BRICK_SIZE };
+            for (size_t word = 0; word < BRICK_SIZE; ++word)
+            {
+                for (size_t bit = 0; bit < 64; ++bit)
+                {
+                    if (brick.m_mask[word] & (std::uint64_t(1) << bit))
+                        indexes.emplace_back(GetVoxelIndexFromCoordinates({ brick_origin[0] + bit % BRICK_SIZE, brick_origin[1] + bit / BRICK_SIZE, brick_origin[2] + word }));
+                }
+            }
+        }
+        std::sort(indexes.begin(), indexes.end());
     }
-    return &m_voxels.at(index);
+    else
+    {
+        for (const auto& voxel : mp_impl->m_sparse.m_voxels)
+        {
+            if (!voxel.second.empty())
+                indexes.emplace_back(voxel.first);
+        }
+        std::sort(indexes.begin(), indexes.end());
+    }
+
+    std::vector<std::array<size_t, 3>> result;
+    result.reserve(indexes.size());
+    for (auto index : indexes)
+        result.emplace_back(GetCoordinatesFromVoxelIndex(index));
+    return result;
 }
 
-const Voxel* VoxelGrid::GetVoxel(const std::array<size_t, 3>& i_coordinates) const
+size_t VoxelGrid::GetExistingVoxelsCount() const
 {
-    auto index = GetVoxelIndexFromCoordinates(i_coordinates);
-    auto it = m_voxels.find(index);
-    if (it == m_voxels.end())
-        return nullptr;
-    return &it->second;
+    return mp_impl->m_existing_voxels_count;
 }
 
-std::vector<const Voxel*> VoxelGrid::GetExistingVoxels() const
+const std::vector<Triangle*>& VoxelGrid::GetTriangles() const
 {
-    std::vector<const Voxel*> result;
-    result.reserve(m_voxels.size());
-    std::transform(m_voxels.begin(), m_voxels.end(), std::back_inserter(result), [](const auto& i_value)
+    return mp_impl->m_triangles;
+}
+
+size_t VoxelGrid::GetTrianglesCount() const
+{
+    return mp_impl->m_triangles_count;
+}
+
+size_t VoxelGrid::GetMemoryUsage() const
+{
+    size_t result = mp_impl->m_triangles.capacity() * sizeof(Triangle*);
+
+    if (mp_impl->m_storage_type == StorageType::Dense)
     {
-        return &i_value.second;
-    });
-    std::sort(result.begin(), result.end(), [this](const auto p_voxel1, const auto p_voxel2)
+        const auto& dense = mp_impl->m_dense;
+        result += dense.m_offsets.capacity() * sizeof(std::uint32_t);
+        result += dense.m_triangle_indexes.capacity() * sizeof(std::uint32_t);
+    }
+    else if (mp_impl->m_storage_type == StorageType::Bricks)
     {
-        return GetVoxelIndexFromCoordinates(p_voxel1->GetCoordinates())
-             < GetVoxelIndexFromCoordinates(p_voxel2->GetCoordinates());
-    });
-    return std::move(result);
+        const auto& bricks = mp_impl->m_bricks;
+        result += bricks.m_bricks.capacity() * sizeof(Brick);
+        result += bricks.m_offsets.capacity() * sizeof(std::uint32_t);
+        result += bricks.m_triangle_indexes.capacity() * sizeof(std::uint32_t);
+        result += bricks.m_table_keys.capacity() * sizeof(size_t);
+        result += bricks.m_table_bricks.capacity() * sizeof(std::uint32_t);
+    }
+    else
+    {
+        using NodeValue = std::pair<const size_t, std::vector<std::uint32_t>>;
+
+        // node keeps the value, pointer to the next node and the cached hash
+        const auto& voxels = mp_impl->m_sparse.m_voxels;
+        result += voxels.bucket_count() * sizeof(void*);
+        result += voxels.size() * (sizeof(NodeValue) + sizeof(void*) + sizeof(size_t));
+        for (const auto& voxel : voxels)
+            result += voxel.second.capacity() * sizeof(std::uint32_t);
+    }
+
+    return result;
 }
 
 bool VoxelGrid::PointInsideVoxelization(const Point3D& i_point) const
@@ -93,9 +1060,9 @@ std::array<size_t, 3> VoxelGrid::GetCoordinatesForPoint(const Point3D& i_point)
     auto min_point = m_bbox.GetMin();
     auto diff = i_point - min_point;
 
-    auto x = static_cast<size_t>(std::lroundl(diff.GetX() / m_voxel_size[0]));
-    auto y = static_cast<size_t>(std::lroundl(diff.GetY() / m_voxel_size[1]));
-    auto z = static_cast<size_t>(std::lroundl(diff.GetZ() / m_voxel_size[2]));
+    auto x = static_cast<size_t>(std::floor(diff.GetX() / m_voxel_size[0]));
+    auto y = static_cast<size_t>(std::floor(diff.GetY() / m_voxel_size[1]));
+    auto z = static_cast<size_t>(std::floor(diff.GetZ() / m_voxel_size[2]));
     if (x >= m_num_voxels[0])
         x = m_num_voxels[0] - 1;
     if (y >= m_num_voxels[1])
@@ -110,3 +1077,158 @@ size_t VoxelGrid::GetVoxelIndexFromCoordinates(const std::array<size_t, 3>& i_co
 {
     return i_coordinates[0] + i_coordinates[1] * m_num_voxels[0] + i_coordinates[2] * m_num_voxels[0] * m_num_voxels[1];
 }
+
+std::array<size_t, 3> VoxelGrid::GetCoordinatesFromVoxelIndex(size_t i_index) const
+{
+    const auto x = i_index % m_num_voxels[0];
+    i_index /= m_num_voxels[0];
+    const auto y = i_index % m_num_voxels[1];
+    return { x, y, i_index / m_num_voxels[1] };
+}
+
+void VoxelGrid::Save(BinaryWriter& io_writer) const
+{
+    io_writer.WriteHeader(GRID_MAGIC, GRID_VERSION);
+    for (size_t i = 0; i < 3; ++i)
+        io_writer.Write(m_voxel_size[i]);
+    for (size_t i = 0; i < 3; ++i)
+        io_writer.Write(static_cast<std::uint64_t>(m_num_voxels[i]));
+    io_writer.WriteBoundingBox(m_bbox);
+
+    io_writer.Write(static_cast<std::uint32_t>(mp_impl->m_storage_type));
+    io_writer.Write(static_cast<std::uint64_t>(mp_impl->m_triangles_count));
+    io_writer.Write(static_cast<std::uint64_t>(mp_impl->m_existing_voxels_count));
+
+    if (mp_impl->m_storage_type == StorageType::Dense)
+    {
+        io_writer.WriteArray(mp_impl->m_dense.m_offsets);
+        io_writer.WriteArray(mp_impl->m_dense.m_triangle_indexes);
+    }
+    else if (mp_impl->m_storage_type == StorageType::Bricks)
+    {
+        const auto& bricks = mp_impl->m_bricks;
+        _WriteSizes(io_writer, std::vector<size_t>(bricks.m_num_bricks.begin(), bricks.m_num_bricks.end()));
+        io_writer.WriteArray(bricks.m_bricks);
+        io_writer.WriteArray(bricks.m_offsets);
+        io_writer.WriteArray(bricks.m_triangle_indexes);
+        _WriteSizes(io_writer, bricks.m_table_keys);
+        io_writer.WriteArray(bricks.m_table_bricks);
+        io_writer.Write(static_cast<std::uint64_t>(bricks.m_table_shift));
+    }
+    else
+    {
+        // the hash map is saved as CSR sorted by voxel index
+        const auto entries = _GetEntries();
+        std::vector<size_t> voxel_indexes;
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> triangle_indexes;
+        for (const auto& entry : entries)
+        {
+            if (voxel_indexes.empty() || voxel_indexes.back() != entry.m_voxel_index)
+            {
+                voxel_indexes.push_back(entry.m_voxel_index);
+                offsets.push_back(static_cast<std::uint32_t>(triangle_indexes.size()));
+            }
+            triangle_indexes.push_back(entry.m_triangle_index);
+        }
+        offsets.push_back(static_cast<std::uint32_t>(triangle_indexes.size()));
+
+        _WriteSizes(io_writer, voxel_indexes);
+        io_writer.WriteArray(offsets);
+        io_writer.WriteArray(triangle_indexes);
+    }
+}
+
+std::unique_ptr<VoxelGrid> VoxelGrid::Load(BinaryReader& io_reader, std::vector<Triangle*> i_triangles)
+{
+    const auto triangles_count = i_triangles.size();
+    return _Load(io_reader, std::move(i_triangles), triangles_count);
+}
+
+std::unique_ptr<VoxelGrid> VoxelGrid::Load(BinaryReader& io_reader, size_t i_triangles_count)
+{
+    return _Load(io_reader, {}, i_triangles_count);
+}
+
+std::unique_ptr<VoxelGrid> VoxelGrid::_Load(BinaryReader& io_reader, std::vector<Triangle*> i_triangles, size_t i_triangles_count)
+{
+    if (!io_reader.ReadHeader(GRID_MAGIC, GRID_VERSION))
+        return nullptr;
+
+    std::array<double, 3> voxel_size = {};
+    std::array<std::uint64_t, 3> num_voxels = {};
+    BoundingBox bbox;
+    for (auto& size : voxel_size)
+        io_reader.Read(size);
+    for (auto& count : num_voxels)
+        io_reader.Read(count);
+    io_reader.ReadBoundingBox(bbox);
+
+    std::uint32_t storage_type = 0;
+    std::uint64_t triangles_count = 0;
+    std::uint64_t existing_voxels_count = 0;
+    io_reader.Read(storage_type);
+    io_reader.Read(triangles_count);
+    io_reader.Read(existing_voxels_count);
+    if (!io_reader.IsOk() || triangles_count != i_triangles_count)
+    {
+        io_reader.SetFailed();
+        return nullptr;
+    }
+
+    auto p_grid = std::make_unique<VoxelGrid>(voxel_size, std::array<size_t, 3>{ static_cast<size_t>(num_voxels[0]), static_cast<size_t>(num_voxels[1]), static_cast<size_t>(num_voxels[2]) }, bbox);
+    const auto total_voxels = p_grid->m_num_voxels[0] * p_grid->m_num_voxels[1] * p_grid->m_num_voxels[2];
+    auto& impl = *p_grid->mp_impl;
+    impl.m_storage_type = static_cast<StorageType>(storage_type);
+    impl.m_triangles = std::move(i_triangles);
+    impl.m_triangles_count = i_triangles_count;
+    impl.m_existing_voxels_count = static_cast<size_t>(existing_voxels_count);
+
+    bool is_valid = false;
+    if (impl.m_storage_type == StorageType::Dense)
+    {
+        auto& dense = impl.m_dense;
+        is_valid = io_reader.ReadArray(dense.m_offsets) && io_reader.ReadArray(dense.m_triangle_indexes)
+                && dense.m_offsets.size() == total_voxels + 1
+                && _IsValidCsr(dense.m_offsets, dense.m_triangle_indexes, triangles_count);
+    }
+    else if (impl.m_storage_type == StorageType::Bricks)
+    {
+        auto& bricks = impl.m_bricks;
+        std::vector<size_t> num_bricks;
+        std::uint64_t table_shift = 0;
+        is_valid = _ReadSizes(io_reader, num_bricks) && io_reader.ReadArray(bricks.m_bricks) && io_reader.ReadArray(bricks.m_offsets)
+                && io_reader.ReadArray(bricks.m_triangle_indexes) && _ReadSizes(io_reader, bricks.m_table_keys)
+                && io_reader.ReadArray(bricks.m_table_bricks) && io_reader.Read(table_shift)
+                && num_bricks.size() == 3 && bricks.m_table_keys.size() == bricks.m_table_bricks.size()
+                && _IsValidCsr(bricks.m_offsets, bricks.m_triangle_indexes, triangles_count);
+        if (is_valid)
+        {
+            std::copy(num_bricks.begin(), num_bricks.end(), bricks.m_num_bricks.begin());
+            bricks.m_table_shift = static_cast<size_t>(table_shift);
+            is_valid = _IsValidBricks(bricks, p_grid->m_num_voxels) && bricks.m_offsets.size() == existing_voxels_count + 1;
+        }
+    }
+    else if (impl.m_storage_type == StorageType::Sparse)
+    {
+        std::vector<size_t> voxel_indexes;
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> triangle_indexes;
+        is_valid = _ReadSizes(io_reader, voxel_indexes) && io_reader.ReadArray(offsets) && io_reader.ReadArray(triangle_indexes)
+                && offsets.size() == voxel_indexes.size() + 1
+                && _IsValidCsr(offsets, triangle_indexes, triangles_count);
+        is_valid = is_valid && std::all_of(voxel_indexes.begin(), voxel_indexes.end(), [total_voxels](size_t i_index)
+        {
+            return i_index < total_voxels;
+        });
+        for (size_t i = 0; is_valid && i < voxel_indexes.size(); ++i)
+            impl.m_sparse.m_voxels[voxel_indexes[i]].assign(triangle_indexes.begin() + offsets[i], triangle_indexes.begin() + offsets[i + 1]);
+    }
+
+    if (!is_valid)
+    {
+        io_reader.SetFailed();
+        return nullptr;
+    }
+    return p_grid;
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <Math.DataStructures/TrianglesBVH.h>
+
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+#include <Math.Core/TriangleSoup.h>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+    // small triangles of random orientation in [0, 10]^3
+    std::vector<Triangle> _MakeTriangles(size_t i_count, unsigned i_seed)
+    {
+        std::mt19937 generator(i_seed);
+        std::uniform_real_distribution<double> position(0, 10);
+        std::uniform_real_distribution<double> offset(-0.5, 0.5);
+        std::vector<Triangle> triangles;
+        for (size_t i = 0; i < i_count; ++i)
+        {
+            const Point3D a(position(generator), position(generator), position(generator));
+            const Point3D b(a.GetX() + offset(generator), a.GetY() + offset(generator), a.GetZ() + offset(generator));
+            const Point3D c(a.GetX() + offset(generator), a.GetY() + offset(generator), a.GetZ() + offset(generator));
+            triangles.emplace_back(a, b, c);
+        }
+        return triangles;
+    }
+
+    // points inside and around the triangles
+    std::vector<Point3D> _MakePoints(size_t i_count, unsigned i_seed)
+    {
+        std::mt19937 generator(i_seed);
+        std::uniform_real_distribution<double> position(-5, 15);
+        std::vector<Point3D> points;
+        for (size_t i = 0; i < i_count; ++i)
+            points.emplace_back(position(generator), position(generator), position(generator));
+        return points;
+    }
+
+    double _FindNearestDistance(const std::vector<Triangle>& i_triangles, const Point3D& i_point)
+    {
+        auto result = std::numeric_limits<double>::max();
+        for (const auto& triangle : i_triangles)
+            result = std::min(result, Distance(i_point, triangle));
+        return result;
+    }
+
+    // the tree may pick another triangle of the same distance, so the distances are compared
+    void _ExpectNearestTriangles(const TrianglesBVH& i_bvh, const std::vector<Triangle>& i_triangles, const std::vector<Point3D>& i_points)
+    {
+        for (const auto& point : i_points)
+        {
+            double distance = -1;
+            const auto triangle = i_bvh.FindNearestTriangle(point, &distance);
+            ASSERT_LT(triangle, i_triangles.size());
+            const auto expected_distance = _FindNearestDistance(i_triangles, point);
+            EXPECT_NEAR(expected_distance, Distance(point, i_triangles[triangle]), 1e-9)
+                << "point " << point.GetX() << " " << point.GetY() << " " << point.GetZ();
+            EXPECT_NEAR(expected_distance, distance, 1e-9);
+        }
+    }
+}
+
+TEST(TrianglesBVHTests, EmptyTreeHasNoNearestTriangle)
+{
+    TrianglesBVH bvh;
+    EXPECT_FALSE(bvh.WasBuild());
+    EXPECT_EQ(TrianglesBVH::NO_TRIANGLE, bvh.FindNearestTriangle(Point3D(1, 2, 3)));
+}
+
+TEST(TrianglesBVHTests, NearestTriangleEqualsBruteForce)
+{
+    auto triangles = _MakeTriangles(2000, 5);
+    std::vector<Triangle*> triangle_pointers;
+    for (auto& triangle : triangles)
+        triangle_pointers.push_back(&triangle);
+
+    for (const size_t max_triangles_in_leaf : { 1, 4, 16 })
+    {
+        TrianglesBVH::Params params;
+        params.m_max_triangles_in_leaf = max_triangles_in_leaf;
+        TrianglesBVH bvh;
+        bvh.Build(triangle_pointers, params);
+        ASSERT_TRUE(bvh.WasBuild());
+        SCOPED_TRACE(max_triangles_in_leaf);
+        _ExpectNearestTriangles(bvh, triangles, _MakePoints(300, 6));
+    }
+}
+
+TEST(TrianglesBVHTests, NearestTriangleOfSoupEqualsBruteForce)
+{
+    const auto triangles = _MakeTriangles(2000, 7);
+    TriangleSoup soup;
+    for (const auto& triangle : triangles)
+        soup.AddTriangle(triangle.GetPoint(0), triangle.GetPoint(1), triangle.GetPoint(2), 0);
+
+    TrianglesBVH bvh;
+    bvh.Build(soup, TrianglesBVH::Params());
+    _ExpectNearestTriangles(bvh, triangles, _MakePoints(300, 8));
+}
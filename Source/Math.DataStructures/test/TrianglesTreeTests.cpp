@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <Math.DataStructures/TrianglesTree.h>
+
+#include <Math.Core/CommonUtilities.h>
+#include <Math.Core/Point3D.h>
+#include <Math.Core/Triangle.h>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+    // small triangles of random orientation in [0, 10]^3
+    std::vector<Triangle> _MakeTriangles(size_t i_count, unsigned i_seed)
+    {
+        std::mt19937 generator(i_seed);
+        std::uniform_real_distribution<double> position(0, 10);
+        std::uniform_real_distribution<double> offset(-0.5, 0.5);
+        std::vector<Triangle> triangles;
+        for (size_t i = 0; i < i_count; ++i)
+        {
+            const Point3D a(position(generator), position(generator), position(generator));
+            const Point3D b(a.GetX() + offset(generator), a.GetY() + offset(generator), a.GetZ() + offset(generator));
+            const Point3D c(a.GetX() + offset(generator), a.GetY() + offset(generator), a.GetZ() + offset(generator));
+            triangles.emplace_back(a, b, c);
+        }
+        return triangles;
+    }
+
+    double _FindNearestDistance(const std::vector<Triangle>& i_triangles, const Point3D& i_point)
+    {
+        auto result = std::numeric_limits<double>::max();
+        for (const auto& triangle : i_triangles)
+            result = std::min(result, Distance(i_point, triangle));
+        return result;
+    }
+}
+
+TEST(TrianglesTreeTests, NearestTriangleEqualsBruteForce)
+{
+    auto triangles = _MakeTriangles(2000, 5);
+    std::vector<Triangle*> triangle_pointers;
+    for (auto& triangle : triangles)
+        triangle_pointers.push_back(&triangle);
+
+    TrianglesTree tree;
+    tree.Build(triangle_pointers);
+    ASSERT_TRUE(tree.WasBuild());
+
+    // points outside of the root box too, the approximation finds nothing for them
+    std::mt19937 generator(6);
+    std::uniform_real_distribution<double> position(-5, 15);
+    for (size_t i = 0; i < 300; ++i)
+    {
+        const Point3D point(position(generator), position(generator), position(generator));
+        Triangle* p_triangle = nullptr;
+        tree.Query(p_triangle, point);
+        ASSERT_NE(nullptr, p_triangle);
+        // the tree may pick another triangle of the same distance, so the distances are compared
+        EXPECT_NEAR(_FindNearestDistance(triangles, point), Distance(point, *p_triangle), 1e-9)
+            << "point " << point.GetX() << " " << point.GetY() << " " << point.GetZ();
+    }
+}
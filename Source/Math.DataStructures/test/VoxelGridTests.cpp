@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <Math.DataStructures/VoxelGrid.h>
+
+#include <Math.Core/BinaryStream.h>
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/Point3D.h>
+
+#include <QBuffer>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+    const std::array<size_t, 3> NUM_VOXELS = { 20, 13, 17 };
+
+    std::unique_ptr<VoxelGrid> _MakeGrid()
+    {
+        BoundingBox bbox;
+        bbox.AddPoint(Point3D(0, 0, 0));
+        bbox.AddPoint(Point3D(20, 13, 17));
+        return std::make_unique<VoxelGrid>(std::array<double, 3>{ 1., 1., 1. }, NUM_VOXELS, bbox);
+    }
+
+    // entries of i_triangles_count triangles, every triangle is in a few voxels around a random one
+    std::vector<VoxelGrid::Entry> _MakeEntries(std::uint32_t i_first_triangle, std::uint32_t i_triangles_count, unsigned i_seed)
+    {
+        std::mt19937 generator(i_seed);
+        std::uniform_int_distribution<size_t> voxels(0, NUM_VOXELS[0] * NUM_VOXELS[1] * NUM_VOXELS[2] - 4);
+        std::vector<VoxelGrid::Entry> entries;
+        for (std::uint32_t triangle = i_first_triangle; triangle < i_first_triangle + i_triangles_count; ++triangle)
+        {
+            const auto voxel = voxels(generator);
+            for (size_t i = 0; i < 3; ++i)
+            {
+                VoxelGrid::Entry entry;
+                entry.m_voxel_index = voxel + i;
+                entry.m_triangle_index = triangle;
+                entries.push_back(entry);
+            }
+        }
+        return entries;
+    }
+
+    void _ExpectSameVoxels(const VoxelGrid& i_grid, const VoxelGrid& i_expected)
+    {
+        const auto voxels = i_grid.GetExistingVoxelsCoordinates();
+        ASSERT_EQ(voxels, i_expected.GetExistingVoxelsCoordinates());
+        EXPECT_EQ(i_grid.GetExistingVoxelsCount(), i_expected.GetExistingVoxelsCount());
+        for (size_t x = 0; x < NUM_VOXELS[0]; ++x)
+        {
+            for (size_t y = 0; y < NUM_VOXELS[1]; ++y)
+            {
+                for (size_t z = 0; z < NUM_VOXELS[2]; ++z)
+                {
+                    std::vector<std::uint32_t> triangles;
+                    std::vector<std::uint32_t> expected_triangles;
+                    const auto range = i_grid.GetVoxelTriangles({ x, y, z });
+                    for (auto it = range.begin(); it != range.end(); ++it)
+                        triangles.push_back(it.GetIndex());
+                    const auto expected_range = i_expected.GetVoxelTriangles({ x, y, z });
+                    for (auto it = expected_range.begin(); it != expected_range.end(); ++it)
+                        expected_triangles.push_back(it.GetIndex());
+                    ASSERT_EQ(triangles, expected_triangles) << x << " " << y << " " << z;
+                }
+            }
+        }
+    }
+
+    // the edited arrays pass the checks of Load
+    void _ExpectLoadable(const VoxelGrid& i_grid)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        BinaryWriter writer(buffer);
+        i_grid.Save(writer);
+        const auto data = buffer.data();
+
+        BinaryReader reader(data.data(), static_cast<size_t>(data.size()));
+        const auto p_loaded = VoxelGrid::Load(reader, i_grid.GetTrianglesCount());
+        ASSERT_TRUE(p_loaded);
+        _ExpectSameVoxels(*p_loaded, i_grid);
+    }
+}
+
+class VoxelGridEditTest : public TestWithParam<VoxelGrid::StorageType>
+{
+};
+
+TEST_P(VoxelGridEditTest, InsertGivesSameVoxelsAsFill)
+{
+    auto entries = _MakeEntries(0, 200, 1);
+    auto added_entries = _MakeEntries(200, 300, 2);
+    auto all_entries = entries;
+    all_entries.insert(all_entries.end(), added_entries.begin(), added_entries.end());
+
+    auto p_grid = _MakeGrid();
+    p_grid->Fill(200, entries, GetParam());
+    EXPECT_EQ(p_grid->AddTriangles(300), 200u);
+    p_grid->Insert(added_entries);
+    EXPECT_EQ(p_grid->GetStorageType(), GetParam());
+
+    auto p_expected = _MakeGrid();
+    p_expected->Fill(500, all_entries, GetParam());
+    _ExpectSameVoxels(*p_grid, *p_expected);
+    _ExpectLoadable(*p_grid);
+}
+
+TEST_P(VoxelGridEditTest, RemoveGivesSameVoxelsAsFill)
+{
+    auto entries = _MakeEntries(0, 500, 3);
+    std::vector<VoxelGrid::Entry> removed_entries;
+    std::vector<VoxelGrid::Entry> kept_entries;
+    for (const auto& entry : entries)
+        (entry.m_triangle_index % 3 == 0 ? removed_entries : kept_entries).push_back(entry);
+
+    auto p_grid = _MakeGrid();
+    p_grid->Fill(500, entries, GetParam());
+    p_grid->Remove(removed_entries);
+
+    auto p_expected = _MakeGrid();
+    p_expected->Fill(500, kept_entries, GetParam());
+    _ExpectSameVoxels(*p_grid, *p_expected);
+    _ExpectLoadable(*p_grid);
+}
+
+TEST_P(VoxelGridEditTest, RemovingEverythingAddedGivesTheOldVoxels)
+{
+    auto entries = _MakeEntries(0, 100, 4);
+    auto added_entries = _MakeEntries(100, 400, 5);
+    auto p_grid = _MakeGrid();
+    p_grid->Fill(100, entries, GetParam());
+    p_grid->AddTriangles(400);
+    p_grid->Insert(added_entries);
+    p_grid->Remove(added_entries);
+
+    auto p_expected = _MakeGrid();
+    p_expected->Fill(500, entries, GetParam());
+    _ExpectSameVoxels(*p_grid, *p_expected);
+    _ExpectLoadable(*p_grid);
+
+    // a grid that lost all of its voxels takes new ones
+    p_grid->Remove(entries);
+    EXPECT_EQ(p_grid->GetExistingVoxelsCount(), 0u);
+    p_grid->Insert(added_entries);
+    auto p_added = _MakeGrid();
+    p_added->Fill(500, added_entries, GetParam());
+    _ExpectSameVoxels(*p_grid, *p_added);
+    _ExpectLoadable(*p_grid);
+}
+
+INSTANTIATE_TEST_CASE_P(Storages, VoxelGridEditTest, Values(VoxelGrid::StorageType::Sparse, VoxelGrid::StorageType::Dense, VoxelGrid::StorageType::Bricks));
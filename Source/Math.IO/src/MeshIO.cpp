@@ -1,16 +1,24 @@
 #include "Math.IO/MeshIO.h"
 
+#include "ObjParser.h"
+
+#include <Math.Core/IndexedMesh.h>
 #include <Math.Core/Mesh.h>
 #include <Math.Core/MeshPoint.h>
 #include <Math.Core/MeshTriangle.h>
 #include <Math.Core/Point3D.h>
 #include <Math.Core/Triangle.h>
 #include <Math.Core/Vector3D.h>
+#include <Math.Core/WorkStealingThreadPool.h>
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 
+#include <cstdint>
+#include <cstring>
+#include <numeric>
 #include <vector>
 
 #include <OBJ_Loader.h>
@@ -24,7 +32,7 @@
 
 namespace
 {
-    bool _LoadObj(const QString& i_src, Mesh& o_mesh)
+    bool _LoadObjWithLoader(const QString& i_src, Mesh& o_mesh)
     {
         try
         {
@@ -34,28 +42,20 @@ namespace
 
             o_mesh.SetName(QFileInfo(i_src).fileName());
 
+            std::vector<BasicPoint3D> vertices;
+            std::vector<std::uint32_t> indices;
             for (const auto& loaded_mesh : loader.LoadedMeshes)
             {
-                std::vector<std::pair<Point3D, Vector3D>> point_normals;
-
+                const auto first_vertex = static_cast<std::uint32_t>(vertices.size());
                 for (const auto& loaded_point : loaded_mesh.Vertices)
-                {
-                    Point3D point{ loaded_point.Position.X, loaded_point.Position.Y, loaded_point.Position.Z };
-                    o_mesh.AddPoint(point);
+                    vertices.push_back({ { loaded_point.Position.X, loaded_point.Position.Y, loaded_point.Position.Z } });
 
-                    point_normals.emplace_back(point, Vector3D{ loaded_point.Normal.X, loaded_point.Normal.Y, loaded_point.Normal.Z });
-                }
-                
-                for (size_t i = 0; i < loaded_mesh.Indices.size(); i += 3)
-                {
-                    const Point3D& point1 = point_normals[loaded_mesh.Indices[i]].first;
-                    const Point3D& point2 = point_normals[loaded_mesh.Indices[i + 1]].first;
-                    const Point3D& point3 = point_normals[loaded_mesh.Indices[i + 2]].first;
-
-                    o_mesh.AddTriangle(point1, point2, point3);
-                }
+                for (const auto index : loaded_mesh.Indices)
+                    indices.push_back(first_vertex + index);
             }
 
+            o_mesh.BuildFromIndexedArrays(vertices, indices);
+
             return true;
         }
         catch (std::exception& e)
@@ -70,8 +70,85 @@ namespace
         return false;
     }
 
+    // the file is mapped and parsed by ParseObj, objl::Loader is left for files that it can't parse
+    bool _LoadObj(const QString& i_src, Mesh& o_mesh)
+    {
+        QFile file(i_src);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        std::vector<BasicPoint3D> vertices;
+        std::vector<std::uint32_t> indices;
+        const auto p_data = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+        const bool parsed = p_data && ParseObj(reinterpret_cast<const char*>(p_data), reinterpret_cast<const char*>(p_data) + file.size(),
+                                               vertices, indices, WorkStealingThreadPool::GetGlobalInstance());
+        if (p_data)
+            file.unmap(p_data);
+
+        if (!parsed)
+        {
+            qDebug() << "OBJ file is not supported by the parser, falling back to OBJ_Loader:" << i_src;
+            return _LoadObjWithLoader(i_src, o_mesh);
+        }
+
+        o_mesh.SetName(QFileInfo(i_src).fileName());
+        o_mesh.BuildFromIndexedArrays(vertices, indices);
+
+        return true;
+    }
+
+    // Binary STL: 80 bytes of header, uint32 facets count, then 50 bytes per facet (normal, three vertices as
+    // little-endian floats, uint16 attribute). The file is mapped instead of read and facets are decoded in parallel.
+    // Returns false when the file is not a binary STL, e.g. an ASCII one
+    bool _LoadBinaryStl(const QString& i_src, Mesh& o_mesh)
+    {
+        constexpr qint64 HEADER_SIZE = 84;
+        constexpr qint64 FACET_SIZE = 50;
+
+        QFile file(i_src);
+        if (!file.open(QIODevice::ReadOnly) || file.size() < HEADER_SIZE)
+            return false;
+
+        const auto p_data = file.map(0, file.size());
+        if (!p_data)
+            return false;
+
+        std::uint32_t facets_count = 0;
+        std::memcpy(&facets_count, p_data + HEADER_SIZE - sizeof(facets_count), sizeof(facets_count));
+        // an ASCII file starts with "solid" as well, the exact size tells a binary one apart
+        if (file.size() != HEADER_SIZE + FACET_SIZE * facets_count || 3ull * facets_count >= IndexedMesh::INVALID_ID)
+            return false;
+
+        std::vector<BasicPoint3D> vertices(3 * static_cast<size_t>(facets_count));
+        WorkStealingThreadPool::GetGlobalInstance().ParallelFor(facets_count, 1 << 14, [p_data, &vertices](size_t i_begin, size_t i_end)
+        {
+            for (auto facet = i_begin; facet < i_end; ++facet)
+            {
+                // facets are 50 bytes long, so the floats are not aligned
+                float coordinates[9];
+                std::memcpy(coordinates, p_data + HEADER_SIZE + FACET_SIZE * facet + 3 * sizeof(float), sizeof(coordinates));
+                for (size_t i = 0; i < 3; ++i)
+                    vertices[3 * facet + i] = { { coordinates[3 * i], coordinates[3 * i + 1], coordinates[3 * i + 2] } };
+            }
+        });
+        file.unmap(p_data);
+
+        // the header is free-form text, so the mesh is named after the file
+        o_mesh.SetName(QFileInfo(i_src).fileName());
+
+        // vertices are welded by the mesh
+        std::vector<std::uint32_t> indices(vertices.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        o_mesh.BuildFromIndexedArrays(vertices, indices);
+
+        return true;
+    }
+
     bool _LoadStl(const QString& i_src, Mesh& o_mesh)
     {
+        if (_LoadBinaryStl(i_src, o_mesh))
+            return true;
+
         try
         {
             stlloader::Mesh stl;
@@ -82,15 +159,19 @@ namespace
             else
                 o_mesh.SetName(QFileInfo(i_src).fileName());
 
+            std::vector<BasicPoint3D> vertices;
+            vertices.reserve(3 * stl.facets.size());
             for (const auto& facet : stl.facets)
             {
-                auto point1 = o_mesh.AddPoint(facet.vertices[0].x, facet.vertices[0].y, facet.vertices[0].z);
-                auto point2 = o_mesh.AddPoint(facet.vertices[1].x, facet.vertices[1].y, facet.vertices[1].z);
-                auto point3 = o_mesh.AddPoint(facet.vertices[2].x, facet.vertices[2].y, facet.vertices[2].z);
-                
-                o_mesh.AddTriangle(*point1, *point2, *point3);
+                for (const auto& vertex : facet.vertices)
+                    vertices.push_back({ { vertex.x, vertex.y, vertex.z } });
             }
 
+            // vertices are welded by the mesh
+            std::vector<std::uint32_t> indices(vertices.size());
+            std::iota(indices.begin(), indices.end(), 0);
+            o_mesh.BuildFromIndexedArrays(vertices, indices);
+
             return true;
         }
         catch (std::exception& e)
@@ -0,0 +1,278 @@
+#include "ObjParser.h"
+
+#include <Math.Core/IndexedMesh.h>
+#include <Math.Core/WorkStealingThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+
+namespace
+{
+    constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    struct Chunk
+    {
+        const char* mp_begin = nullptr;
+        const char* mp_end = nullptr;
+        size_t m_first_vertex = 0;
+        std::vector<std::uint32_t> m_indices;
+    };
+
+    inline bool _IsBlank(char i_char)
+    {
+        return i_char == ' ' || i_char == '\t' || i_char == '\r';
+    }
+
+    inline bool _IsDigit(char i_char)
+    {
+        return i_char >= '0' && i_char <= '9';
+    }
+
+    inline const char* _SkipBlanks(const char* ip_current, const char* ip_end)
+    {
+        while (ip_current != ip_end && _IsBlank(*ip_current))
+            ++ip_current;
+        return ip_current;
+    }
+
+    inline const char* _SkipToken(const char* ip_current, const char* ip_end)
+    {
+        while (ip_current != ip_end && !_IsBlank(*ip_current) && *ip_current != '\n')
+            ++ip_current;
+        return ip_current;
+    }
+
+    inline const char* _NextLine(const char* ip_current, const char* ip_end)
+    {
+        const auto p_line_end = static_cast<const char*>(std::memchr(ip_current, '\n', ip_end - ip_current));
+        return p_line_end ? p_line_end + 1 : ip_end;
+    }
+
+    // "v" or "f" followed by a blank
+    inline bool _IsStatement(const char* ip_line, const char* ip_end, char i_statement)
+    {
+        return ip_end - ip_line >= 2 && ip_line[0] == i_statement && _IsBlank(ip_line[1]);
+    }
+
+    // Decimal mantissa of up to 19 digits times an exact power of ten is rounded correctly by a single
+    // multiplication or division when the mantissa fits into 53 bits. Everything else goes to strtod
+    bool _ParseDouble(const char*& io_current, const char* ip_end, double& o_value)
+    {
+        static const double s_powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        const auto p_begin = io_current;
+        auto p_current = io_current;
+
+        const bool negative = p_current != ip_end && *p_current == '-';
+        if (p_current != ip_end && (*p_current == '-' || *p_current == '+'))
+            ++p_current;
+
+        std::uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool has_digits = false;
+        for (; p_current != ip_end && _IsDigit(*p_current); ++p_current, has_digits = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = 10 * mantissa + (*p_current - '0');
+                digits += mantissa != 0 ? 1 : 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+        if (p_current != ip_end && *p_current == '.')
+        {
+            for (++p_current; p_current != ip_end && _IsDigit(*p_current); ++p_current, has_digits = true)
+            {
+                if (digits < 19)
+                {
+                    mantissa = 10 * mantissa + (*p_current - '0');
+                    digits += mantissa != 0 ? 1 : 0;
+                    --exponent;
+                }
+            }
+        }
+        if (!has_digits)
+            return false;
+
+        const bool exact = digits < 19;
+        if (p_current != ip_end && (*p_current == 'e' || *p_current == 'E'))
+        {
+            ++p_current;
+            const bool negative_exponent = p_current != ip_end && *p_current == '-';
+            if (p_current != ip_end && (*p_current == '-' || *p_current == '+'))
+                ++p_current;
+            if (p_current == ip_end || !_IsDigit(*p_current))
+                return false;
+
+            int explicit_exponent = 0;
+            for (; p_current != ip_end && _IsDigit(*p_current); ++p_current)
+                explicit_exponent = std::min(10 * explicit_exponent + (*p_current - '0'), 100000);
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+        }
+        if (p_current != ip_end && !_IsBlank(*p_current) && *p_current != '\n')
+            return false;
+
+        if (exact && mantissa < (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+        {
+            const auto value = static_cast<double>(mantissa);
+            o_value = exponent < 0 ? value / s_powers_of_ten[-exponent] : value * s_powers_of_ten[exponent];
+            o_value = negative ? -o_value : o_value;
+        }
+        else
+        {
+            o_value = std::strtod(std::string(p_begin, p_current).c_str(), nullptr);
+        }
+
+        io_current = p_current;
+        return true;
+    }
+
+    // vertex index of one face corner "v", "v/vt", "v//vn" or "v/vt/vn", 1-based or negative
+    bool _ParseIndex(const char*& io_current, const char* ip_end, size_t i_vertices_before, size_t i_vertices_count, std::uint32_t& o_index)
+    {
+        auto p_current = io_current;
+        const bool negative = p_current != ip_end && *p_current == '-';
+        if (negative)
+            ++p_current;
+        if (p_current == ip_end || !_IsDigit(*p_current))
+            return false;
+
+        std::uint64_t value = 0;
+        for (; p_current != ip_end && _IsDigit(*p_current); ++p_current)
+            value = std::min<std::uint64_t>(10 * value + (*p_current - '0'), std::numeric_limits<std::uint32_t>::max());
+        io_current = _SkipToken(p_current, ip_end);
+
+        if (value == 0)
+            return false;
+        if (negative)
+        {
+            if (value > i_vertices_before)
+                return false;
+            o_index = static_cast<std::uint32_t>(i_vertices_before - value);
+        }
+        else
+        {
+            if (value > i_vertices_count)
+                return false;
+            o_index = static_cast<std::uint32_t>(value - 1);
+        }
+        return true;
+    }
+
+    bool _ParseChunk(Chunk& io_chunk, size_t i_vertices_count, std::vector<BasicPoint3D>& o_vertices)
+    {
+        auto vertex = io_chunk.m_first_vertex;
+        std::vector<std::uint32_t> polygon;
+        for (auto p_line = io_chunk.mp_begin; p_line != io_chunk.mp_end; p_line = _NextLine(p_line, io_chunk.mp_end))
+        {
+            p_line = _SkipBlanks(p_line, io_chunk.mp_end);
+            if (_IsStatement(p_line, io_chunk.mp_end, 'v'))
+            {
+                auto p_current = p_line + 2;
+                auto& point = o_vertices[vertex++];
+                for (auto& coordinate : point.m_coordinates)
+                {
+                    p_current = _SkipBlanks(p_current, io_chunk.mp_end);
+                    if (!_ParseDouble(p_current, io_chunk.mp_end, coordinate))
+                        return false;
+                }
+            }
+            else if (_IsStatement(p_line, io_chunk.mp_end, 'f'))
+            {
+                polygon.clear();
+                for (auto p_current = _SkipBlanks(p_line + 2, io_chunk.mp_end); p_current != io_chunk.mp_end && *p_current != '\n' && *p_current != '#'; p_current = _SkipBlanks(p_current, io_chunk.mp_end))
+                {
+                    std::uint32_t index = 0;
+                    if (!_ParseIndex(p_current, io_chunk.mp_end, vertex, i_vertices_count, index))
+                        return false;
+                    polygon.push_back(index);
+                }
+                if (polygon.size() < 3)
+                    return false;
+
+                for (size_t i = 1; i + 1 < polygon.size(); ++i)
+                    io_chunk.m_indices.insert(io_chunk.m_indices.end(), { polygon[0], polygon[i], polygon[i + 1] });
+            }
+        }
+        return true;
+    }
+}
+
+
+bool ParseObj(const char* ip_begin, const char* ip_end, std::vector<BasicPoint3D>& o_vertices, std::vector<std::uint32_t>& o_indices, WorkStealingThreadPool& i_pool)
+{
+    // chunks end right after a line end, so no line is split
+    std::vector<Chunk> chunks;
+    for (auto p_begin = ip_begin; p_begin != ip_end;)
+    {
+        Chunk chunk;
+        chunk.mp_begin = p_begin;
+        chunk.mp_end = static_cast<size_t>(ip_end - p_begin) > CHUNK_SIZE ? _NextLine(p_begin + CHUNK_SIZE, ip_end) : ip_end;
+        p_begin = chunk.mp_end;
+        chunks.push_back(chunk);
+    }
+
+    // vertices are counted first, so every chunk knows the id of its first vertex and writes the vertices in place
+    std::vector<size_t> vertices_counts(chunks.size() + 1, 0);
+    i_pool.ParallelFor(chunks.size(), 1, [&chunks, &vertices_counts](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+        {
+            for (auto p_line = chunks[i].mp_begin; p_line != chunks[i].mp_end; p_line = _NextLine(p_line, chunks[i].mp_end))
+            {
+                if (_IsStatement(_SkipBlanks(p_line, chunks[i].mp_end), chunks[i].mp_end, 'v'))
+                    ++vertices_counts[i + 1];
+            }
+        }
+    });
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].m_first_vertex = vertices_counts[i];
+        vertices_counts[i + 1] += vertices_counts[i];
+    }
+
+    const auto vertices_count = vertices_counts.back();
+    if (vertices_count >= IndexedMesh::INVALID_ID)
+        return false;
+
+    o_vertices.resize(vertices_count);
+    std::atomic<bool> succeeded{ true };
+    i_pool.ParallelFor(chunks.size(), 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end && succeeded; ++i)
+        {
+            if (!_ParseChunk(chunks[i], vertices_count, o_vertices))
+                succeeded = false;
+        }
+    });
+    if (!succeeded)
+        return false;
+
+    std::vector<size_t> indices_offsets(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i)
+        indices_offsets[i + 1] = indices_offsets[i] + chunks[i].m_indices.size();
+    if (indices_offsets.back() / 3 >= IndexedMesh::INVALID_ID)
+        return false;
+
+    o_indices.resize(indices_offsets.back());
+    i_pool.ParallelFor(chunks.size(), 1, [&](size_t i_begin, size_t i_end)
+    {
+        for (auto i = i_begin; i < i_end; ++i)
+        {
+            std::copy(chunks[i].m_indices.begin(), chunks[i].m_indices.end(), o_indices.begin() + indices_offsets[i]);
+            std::vector<std::uint32_t>().swap(chunks[i].m_indices);
+        }
+    });
+
+    return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Math.Core/BasicPoint3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class WorkStealingThreadPool;
+
+// Reads the geometry of a Wavefront OBJ text held in memory: "v" lines become o_vertices and "f" lines become
+// three indices per triangle, polygons are split into fans around their first vertex. Negative (relative) indices
+// are resolved, texture and normal indices after '/' as well as all other statements are skipped.
+// The text is split into chunks at line ends that are parsed in parallel on i_pool.
+// Returns false for malformed numbers and indices out of range
+bool ParseObj(const char* ip_begin, const char* ip_end, std::vector<BasicPoint3D>& o_vertices, std::vector<std::uint32_t>& o_indices, WorkStealingThreadPool& i_pool);
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include "ObjParser.h"
+
+#include <Math.Core/WorkStealingThreadPool.h>
+
+#include <cstdlib>
+#include <string>
+
+using namespace ::testing;
+
+namespace
+{
+    bool _Parse(const std::string& i_text, std::vector<BasicPoint3D>& o_vertices, std::vector<std::uint32_t>& o_indices)
+    {
+        WorkStealingThreadPool pool(2);
+        return ParseObj(i_text.data(), i_text.data() + i_text.size(), o_vertices, o_indices, pool);
+    }
+
+    bool _Parse(const std::string& i_text)
+    {
+        std::vector<BasicPoint3D> vertices;
+        std::vector<std::uint32_t> indices;
+        return _Parse(i_text, vertices, indices);
+    }
+
+    std::vector<std::uint32_t> _ParseIndices(const std::string& i_text)
+    {
+        std::vector<BasicPoint3D> vertices;
+        std::vector<std::uint32_t> indices;
+        EXPECT_TRUE(_Parse(i_text, vertices, indices));
+        return indices;
+    }
+
+    const std::string THREE_VERTICES = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+}
+
+TEST(ObjParser, ReadsNumbersAsStrtod)
+{
+    // short mantissas take the fast path, long mantissas and large exponents go to strtod
+    const std::vector<std::string> numbers = { "1", "-2", "+3", ".5", "-.25", "+.125", "7.", "0.1", "-0.3", "1e3", "2.5E-3",
+                                               "-1.5e+2", "6.02214076e23", "1e-30", "123456789.123456789", "12345678901234567890123",
+                                               "0.1000000000000000055511151231257827", "9007199254740993", "1e22", "1e23", "-0" };
+    std::string text;
+    for (size_t i = 0; i < numbers.size(); ++i)
+        text += "v " + numbers[i] + " 0 " + numbers[numbers.size() - 1 - i] + "\n";
+
+    std::vector<BasicPoint3D> vertices;
+    std::vector<std::uint32_t> indices;
+    ASSERT_TRUE(_Parse(text, vertices, indices));
+    ASSERT_EQ(vertices.size(), numbers.size());
+    for (size_t i = 0; i < numbers.size(); ++i)
+    {
+        EXPECT_EQ(vertices[i][0], std::strtod(numbers[i].c_str(), nullptr)) << numbers[i];
+        EXPECT_EQ(vertices[i][2], std::strtod(numbers[numbers.size() - 1 - i].c_str(), nullptr)) << numbers[numbers.size() - 1 - i];
+    }
+}
+
+TEST(ObjParser, LeavesInfAndNanToTheSlowLoader)
+{
+    // the caller falls back to OBJ_Loader when the parser gives up
+    EXPECT_FALSE(_Parse("v inf 0 0\n"));
+    EXPECT_FALSE(_Parse("v 0 -nan 0\n"));
+    EXPECT_FALSE(_Parse("v 0 0 1e\n"));
+    EXPECT_FALSE(_Parse("v 0 0 1x\n"));
+    EXPECT_FALSE(_Parse("v 0 0 .\n"));
+}
+
+TEST(ObjParser, ResolvesNegativeIndicesAgainstPreviousVertices)
+{
+    const auto indices = _ParseIndices(THREE_VERTICES + "f -3 -2 -1\nv 0 0 1\nf -4 -1 2\nf 1 2 -2\n");
+    EXPECT_EQ(indices, (std::vector<std::uint32_t>{ 0, 1, 2, 0, 3, 1, 0, 1, 2 }));
+}
+
+TEST(ObjParser, SkipsTextureAndNormalIndices)
+{
+    const auto indices = _ParseIndices(THREE_VERTICES + "vt 0 0\nvn 0 0 1\nf 1/1 2/1 3/1\nf 1//1 2//1 3//1\nf 1/1/1 2/1/1 -1/1/1\n");
+    EXPECT_EQ(indices, (std::vector<std::uint32_t>{ 0, 1, 2, 0, 1, 2, 0, 1, 2 }));
+}
+
+TEST(ObjParser, SplitsPolygonsIntoFans)
+{
+    const auto indices = _ParseIndices("v 0 0 0\nv 1 0 0\nv 2 1 0\nv 1 2 0\nv 0 1 0\nf 1 2 3 4\nf 5 4 3 2 1 # comment\n");
+    EXPECT_EQ(indices, (std::vector<std::uint32_t>{ 0, 1, 2, 0, 2, 3, 4, 3, 2, 4, 2, 1, 4, 1, 0 }));
+}
+
+TEST(ObjParser, RejectsIndicesOutOfRange)
+{
+    EXPECT_FALSE(_Parse(THREE_VERTICES + "f 1 2 4\n"));
+    EXPECT_FALSE(_Parse(THREE_VERTICES + "f 0 1 2\n"));
+    EXPECT_FALSE(_Parse(THREE_VERTICES + "f -4 -2 -1\n"));
+    EXPECT_FALSE(_Parse(THREE_VERTICES + "f 1 2 99999999999\n"));
+    // a negative index can't refer to a vertex that comes after the face
+    EXPECT_FALSE(_Parse("v 0 0 0\nv 1 0 0\nf -1 -2 -3\nv 0 1 0\n"));
+    EXPECT_FALSE(_Parse(THREE_VERTICES + "f 1 2\n"));
+    EXPECT_FALSE(_Parse(THREE_VERTICES + "f 1 a 2\n"));
+}
+
+TEST(ObjParser, ReadsTextOfSeveralChunks)
+{
+    // chunks are about a megabyte long, every face refers to the vertices before it
+    std::string text;
+    const size_t triangles_count = 50000;
+    for (size_t i = 0; i < triangles_count; ++i)
+        text += "v " + std::to_string(i) + ".5 0 0\nv 0 1 0\nv 0 0 1\n# a comment that makes the text longer\nf -3 -2 -1\n";
+
+    std::vector<BasicPoint3D> vertices;
+    std::vector<std::uint32_t> indices;
+    ASSERT_GT(text.size(), size_t(3) << 20);
+    ASSERT_TRUE(_Parse(text, vertices, indices));
+    ASSERT_EQ(vertices.size(), 3 * triangles_count);
+    ASSERT_EQ(indices.size(), 3 * triangles_count);
+    for (size_t i = 0; i < triangles_count; i += 997)
+    {
+        EXPECT_EQ(vertices[3 * i][0], i + 0.5);
+        EXPECT_EQ(indices[3 * i], 3 * i);
+        EXPECT_EQ(indices[3 * i + 2], 3 * i + 2);
+    }
+}
@@ -0,0 +1,186 @@
+#include "BenchmarkReport.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+namespace
+{
+    double _GetPercentile(const std::vector<double>& i_sorted_samples, double i_percent)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(i_percent * i_sorted_samples.size() / 100.));
+        return i_sorted_samples[std::max<size_t>(rank, 1) - 1];
+    }
+
+    double _GetThroughput(const BenchmarkRecord& i_record)
+    {
+        if (i_record.m_total_time_sec <= 0)
+            return 0;
+        return static_cast<double>(i_record.m_items_count * i_record.m_runs_count) / i_record.m_total_time_sec;
+    }
+
+    QString _ToString(double i_value)
+    {
+        return QString::number(i_value, 'g', 10);
+    }
+
+    QString _ToCsvField(const QString& i_value)
+    {
+        if (!i_value.contains(',') && !i_value.contains('"') && !i_value.contains('\n'))
+            return i_value;
+        auto quoted = i_value;
+        quoted.replace("\"", "\"\"");
+        return "\"" + quoted + "\"";
+    }
+
+    QJsonObject _ToJson(const BenchmarkRecord& i_record)
+    {
+        QJsonObject latency;
+        latency["mean_sec"] = i_record.m_latency.m_mean;
+        latency["p50_sec"] = i_record.m_latency.m_p50;
+        latency["p90_sec"] = i_record.m_latency.m_p90;
+        latency["p99_sec"] = i_record.m_latency.m_p99;
+        latency["max_sec"] = i_record.m_latency.m_max;
+
+        QJsonObject metrics;
+        for (const auto& metric : i_record.m_metrics)
+            metrics[metric.first] = QJsonValue::fromVariant(metric.second);
+
+        QJsonObject object;
+        object["dataset"] = i_record.m_dataset;
+        object["engine"] = i_record.m_engine;
+        object["operation"] = i_record.m_operation;
+        object["parameters"] = i_record.m_parameters;
+        object["items"] = static_cast<double>(i_record.m_items_count);
+        object["runs"] = static_cast<double>(i_record.m_runs_count);
+        object["total_sec"] = i_record.m_total_time_sec;
+        object["throughput_per_sec"] = _GetThroughput(i_record);
+        object["latency"] = latency;
+        object["memory_mb"] = i_record.m_memory_mb;
+        object["peak_memory_mb"] = i_record.m_peak_memory_mb;
+        if (i_record.m_mismatches >= 0)
+            object["mismatches"] = static_cast<double>(i_record.m_mismatches);
+        object["metrics"] = metrics;
+        return object;
+    }
+}
+
+
+LatencyStats ComputeLatencyStats(std::vector<double> i_samples)
+{
+    LatencyStats stats;
+    if (i_samples.empty())
+        return stats;
+
+    std::sort(i_samples.begin(), i_samples.end());
+    stats.m_mean = std::accumulate(i_samples.begin(), i_samples.end(), 0.) / i_samples.size();
+    stats.m_p50 = _GetPercentile(i_samples, 50);
+    stats.m_p90 = _GetPercentile(i_samples, 90);
+    stats.m_p99 = _GetPercentile(i_samples, 99);
+    stats.m_max = i_samples.back();
+    return stats;
+}
+
+
+void BenchmarkReport::SetInfo(const QString& i_key, const QVariant& i_value)
+{
+    m_info.emplace_back(i_key, i_value);
+}
+
+void BenchmarkReport::Add(const BenchmarkRecord& i_record)
+{
+    QStringList line;
+    line << i_record.m_dataset << i_record.m_engine << i_record.m_operation;
+    if (!i_record.m_parameters.isEmpty())
+        line << i_record.m_parameters;
+    line << QString("p50 %1 s, p90 %2 s, p99 %3 s, max %4 s")
+                .arg(_ToString(i_record.m_latency.m_p50), _ToString(i_record.m_latency.m_p90),
+                     _ToString(i_record.m_latency.m_p99), _ToString(i_record.m_latency.m_max));
+    line << QString("%1 items/s").arg(_ToString(_GetThroughput(i_record)));
+    line << QString("memory %1 Mb, peak %2 Mb").arg(i_record.m_memory_mb, 0, 'f', 2).arg(i_record.m_peak_memory_mb, 0, 'f', 2);
+    if (i_record.m_mismatches >= 0)
+        line << QString("mismatches %1").arg(i_record.m_mismatches);
+    for (const auto& metric : i_record.m_metrics)
+        line << QString("%1 %2").arg(metric.first, metric.second.toString());
+    qInfo().noquote() << line.join(" | ");
+
+    m_records.push_back(i_record);
+}
+
+bool BenchmarkReport::WriteJson(const QString& i_file_path) const
+{
+    QJsonObject info;
+    for (const auto& value : m_info)
+        info[value.first] = QJsonValue::fromVariant(value.second);
+
+    QJsonArray records;
+    for (const auto& record : m_records)
+        records.append(_ToJson(record));
+
+    QJsonObject root;
+    root["info"] = info;
+    root["records"] = records;
+
+    QFile file(i_file_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    const auto data = QJsonDocument(root).toJson();
+    return file.write(data) == data.size();
+}
+
+bool BenchmarkReport::WriteCsv(const QString& i_file_path) const
+{
+    QStringList metric_names;
+    for (const auto& record : m_records)
+    {
+        for (const auto& metric : record.m_metrics)
+        {
+            if (!metric_names.contains(metric.first))
+                metric_names << metric.first;
+        }
+    }
+
+    QFile file(i_file_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&file);
+    stream << "dataset,engine,operation,parameters,items,runs,total_sec,throughput_per_sec,"
+              "mean_sec,p50_sec,p90_sec,p99_sec,max_sec,memory_mb,peak_memory_mb,mismatches";
+    for (const auto& name : metric_names)
+        stream << "," << _ToCsvField(name);
+    stream << "\n";
+
+    for (const auto& record : m_records)
+    {
+        QStringList fields;
+        fields << _ToCsvField(record.m_dataset) << _ToCsvField(record.m_engine) << _ToCsvField(record.m_operation) << _ToCsvField(record.m_parameters)
+               << QString::number(record.m_items_count) << QString::number(record.m_runs_count)
+               << _ToString(record.m_total_time_sec) << _ToString(_GetThroughput(record))
+               << _ToString(record.m_latency.m_mean) << _ToString(record.m_latency.m_p50) << _ToString(record.m_latency.m_p90)
+               << _ToString(record.m_latency.m_p99) << _ToString(record.m_latency.m_max)
+               << _ToString(record.m_memory_mb) << _ToString(record.m_peak_memory_mb)
+               << (record.m_mismatches >= 0 ? QString::number(record.m_mismatches) : QString());
+        for (const auto& name : metric_names)
+        {
+            const auto it = std::find_if(record.m_metrics.begin(), record.m_metrics.end(), [&name](const std::pair<QString, QVariant>& i_metric)
+            {
+                return i_metric.first == name;
+            });
+            fields << (it != record.m_metrics.end() ? _ToCsvField(it->second.toString()) : QString());
+        }
+        stream << fields.join(",") << "\n";
+    }
+
+    stream.flush();
+    return stream.status() == QTextStream::Ok;
+}
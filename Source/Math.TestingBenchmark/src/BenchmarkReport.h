@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QString>
+#include <QVariant>
+
+#include <utility>
+#include <vector>
+
+// distribution of measured times in seconds, percentiles use the nearest rank
+struct LatencyStats
+{
+    double m_mean = 0;
+    double m_p50 = 0;
+    double m_p90 = 0;
+    double m_p99 = 0;
+    double m_max = 0;
+};
+
+LatencyStats ComputeLatencyStats(std::vector<double> i_samples);
+
+// One measured operation of one engine on one dataset. Latency samples are single queries for "query"
+// operations and whole runs for builds, batches and parallel queries
+struct BenchmarkRecord
+{
+    QString m_dataset;
+    QString m_engine;
+    QString m_operation;
+    QString m_parameters;
+
+    size_t m_items_count = 0; // queries or triangles processed by one run
+    size_t m_runs_count = 0;
+    double m_total_time_sec = 0; // of all runs
+    LatencyStats m_latency;
+
+    double m_memory_mb = 0; // resident memory difference over the first run
+    double m_peak_memory_mb = 0; // peak resident memory of the process after the last run
+
+    long long m_mismatches = -1; // results that differ from the reference engine, -1 if not compared
+    std::vector<std::pair<QString, QVariant>> m_metrics; // engine specific values
+};
+
+class BenchmarkReport
+{
+public:
+    // describes the machine and the run, written to the header of the JSON report
+    void SetInfo(const QString& i_key, const QVariant& i_value);
+
+    // prints the record and keeps it for the reports
+    void Add(const BenchmarkRecord& i_record);
+
+    // {"info": {...}, "records": [...]}
+    bool WriteJson(const QString& i_file_path) const;
+    // one row per record, engine specific metrics get a column each
+    bool WriteCsv(const QString& i_file_path) const;
+
+private:
+    std::vector<std::pair<QString, QVariant>> m_info;
+    std::vector<BenchmarkRecord> m_records;
+};
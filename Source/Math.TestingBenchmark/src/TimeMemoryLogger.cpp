@@ -0,0 +1,129 @@
+#include "TimeMemoryLogger.h"
+
+#include <QtGlobal>
+
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#if defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+
+size_t GetCurrentRss()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.WorkingSetSize;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#elif defined(Q_OS_LINUX)
+    // second field of statm is the number of resident pages
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages))
+        return 0;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+size_t GetPeakRss()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.PeakWorkingSetSize;
+#elif defined(Q_OS_MACOS)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return static_cast<size_t>(usage.ru_maxrss); // bytes on macOS
+#elif defined(Q_OS_LINUX)
+    // "VmHWM:    123456 kB"
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key)
+    {
+        if (key == "VmHWM:")
+        {
+            size_t kilobytes = 0;
+            status >> kilobytes;
+            return kilobytes * 1024;
+        }
+        status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+
+struct TimeMemoryLogger::Impl
+{
+    bool m_started = false;
+    bool m_stopped = false;
+
+    size_t m_memory_on_start = 0;
+    size_t m_memory_on_stop = 0;
+
+    std::chrono::steady_clock::time_point m_time_on_start;
+    std::chrono::steady_clock::time_point m_time_on_stop;
+};
+
+TimeMemoryLogger::TimeMemoryLogger()
+    : mp_impl(std::make_unique<Impl>())
+{
+}
+
+TimeMemoryLogger::~TimeMemoryLogger() = default;
+
+double TimeMemoryLogger::GetElapsedTimeSec() const
+{
+    Q_ASSERT(mp_impl->m_started && mp_impl->m_stopped);
+    return std::chrono::duration<double>(mp_impl->m_time_on_stop - mp_impl->m_time_on_start).count();
+}
+
+double TimeMemoryLogger::GetMemoryDifferenceMb() const
+{
+    Q_ASSERT(mp_impl->m_started && mp_impl->m_stopped);
+    return (static_cast<long long>(mp_impl->m_memory_on_stop) - static_cast<long long>(mp_impl->m_memory_on_start)) / (1024.0 * 1024.0);
+}
+
+void TimeMemoryLogger::Start()
+{
+    Q_ASSERT(!mp_impl->m_started);
+
+    mp_impl->m_started = true;
+    mp_impl->m_memory_on_start = GetCurrentRss();
+    mp_impl->m_time_on_start = std::chrono::steady_clock::now();
+}
+
+void TimeMemoryLogger::Stop()
+{
+    Q_ASSERT(mp_impl->m_started);
+    Q_ASSERT(!mp_impl->m_stopped);
+
+    mp_impl->m_stopped = true;
+    mp_impl->m_time_on_stop = std::chrono::steady_clock::now();
+    mp_impl->m_memory_on_stop = GetCurrentRss();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+// resident set size of the process in bytes, 0 if the platform doesn't report it
+size_t GetCurrentRss();
+// largest resident set size of the process so far in bytes, 0 if the platform doesn't report it
+size_t GetPeakRss();
+
+// wall time and resident memory difference between Start and Stop
+struct TimeMemoryLogger
+{
+    TimeMemoryLogger();
+    ~TimeMemoryLogger();
+
+    double GetElapsedTimeSec() const;
+    double GetMemoryDifferenceMb() const;
+
+    void Start();
+    void Stop();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mp_impl;
+};
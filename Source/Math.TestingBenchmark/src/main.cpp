@@ -1,209 +1,881 @@
+#include "BenchmarkReport.h"
+#include "TimeMemoryLogger.h"
+
+#include <Math.Core/BasicPoint3.h>
+#include <Math.Core/BoundingBox.h>
+#include <Math.Core/CommonUtilities.h>
 #include <Math.Core/Mesh.h>
 #include <Math.Core/MeshPoint.h>
 #include <Math.Core/MeshTriangle.h>
 #include <Math.Core/TransformMatrix.h>
+#include <Math.Core/TrianglePack.h>
 
+#include <Math.DataStructures/TrianglesOctree.h>
+#include <Math.DataStructures/TrianglesTree.h>
 #include <Math.DataStructures/VoxelGrid.h>
 
-#include <Math.Algos/Voxelizer.h>
+#include <Math.Algos/ParallelLocalizer.h>
+#include <Math.Algos/PointLocalizerBVH.h>
+#include <Math.Algos/PointLocalizerHierarchical.h>
 #include <Math.Algos/PointLocalizerVoxelized.h>
+#include <Math.Algos/SceneGenerator.h>
 
 #include <Math.IO/MeshIO.h>
 
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
-#include <QDirIterator>
+#include <QFileInfo>
 #include <QString>
-
+#include <QSysInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
 #include <memory>
+#include <numeric>
 #include <random>
+#include <unordered_map>
 
 
-#include <windows.h> 
-#include <psapi.h> 
+namespace
+{
+    const QStringList ENGINES = { "kernel", "bvh", "kdtree", "octree", "voxel", "hierarchical" };
+    const QString SYNTHETIC_PREFIX = "synthetic:";
 
-#ifdef max // surprise from minwindef.h
-#undef max
-#endif
+    struct Options
+    {
+        QStringList m_datasets;
+        QStringList m_engines;
+        std::vector<double> m_voxel_sizes;
+        std::vector<double> m_triangles_per_voxel; // targets of the automatic voxel size
+        VoxelGrid::StorageType m_storage_type = VoxelGrid::StorageType::Auto;
+        bool m_use_ray_parity = false; // classification of the BVH, voxel and hierarchical engines
+        bool m_label_empty_voxels = true;
+        bool m_use_corner_distances = false;
+        size_t m_points_count = 0;
+        size_t m_kernel_points_count = 0;
+        size_t m_runs_count = 0;
+        size_t m_threads_count = 0;
+        unsigned int m_seed = 0;
+        SceneGenerator::PointsDistribution m_distribution = SceneGenerator::PointsDistribution::Uniform;
+        QString m_export_path;
+        QString m_json_path;
+        QString m_csv_path;
+    };
 
-#ifdef min
-#undef min
-#endif
+    // meshes of one folder or one file, mesh i is the answer i of the localizers
+    struct Dataset
+    {
+        QString m_name;
+        std::vector<std::unique_ptr<Mesh>> m_meshes;
+        std::vector<Triangle*> m_triangles;
+        std::unordered_map<Triangle*, size_t> m_triangle_to_mesh;
+        std::vector<TriangleWithMeshTag> m_triangles_with_tags;
+        std::map<QString, size_t> m_name_to_mesh;
+        BoundingBox m_bbox;
+    };
 
-struct TimeMemoryLogger
-{
-    TimeMemoryLogger();
-    ~TimeMemoryLogger();
+    // ground truth of synthetic datasets or answers of the BVH localizer, the engines are compared with them
+    using ReferenceResults = std::vector<size_t>;
 
-    double GetElapsedTimeSec() const;
-    double GetMemoryDifferenceMb() const;
+    const char* _GetStorageName(VoxelGrid::StorageType i_storage_type)
+    {
+        switch (i_storage_type)
+        {
+        case VoxelGrid::StorageType::Sparse:
+            return "sparse";
+        case VoxelGrid::StorageType::Dense:
+            return "dense";
+        case VoxelGrid::StorageType::Bricks:
+            return "bricks";
+        default:
+            return "auto";
+        }
+    }
 
-    void Start();
-    void Stop();
+    const char* _GetClassificationName(const Options& i_options)
+    {
+        return i_options.m_use_ray_parity ? "parity" : "nearest";
+    }
 
-private:
-    struct Impl;
-    std::unique_ptr<Impl> mp_impl;
-};
+    bool _ParseSize(const QString& i_text, size_t& o_value)
+    {
+        bool ok = false;
+        o_value = static_cast<size_t>(i_text.toULongLong(&ok));
+        return ok;
+    }
 
-struct TimeMemoryLogger::Impl
-{
-    bool m_started = false;
-    bool m_stopped = false;
+    bool _ParseOptions(const QCoreApplication& i_application, Options& o_options)
+    {
+        QCommandLineParser parser;
+        parser.setApplicationDescription("Measures build and query of the point localization engines on mesh datasets");
+        parser.addHelpOption();
+        parser.addPositionalArgument("datasets", "Mesh files or folders with *.stl and *.obj files, every argument is a separate dataset. "
+                                                 "synthetic:<shape>[:<triangles>[:<parts>]] generates a scene with sphere, torus, blob or sqrt3 parts", "<dataset>...");
+
+        QCommandLineOption engines_option("engines", "Comma separated engines: " + ENGINES.join(',') + ".", "list", ENGINES.join(','));
+        QCommandLineOption voxel_sizes_option("voxel-sizes", "Comma separated voxel sizes of the voxel engine.", "list", "0.25,0.5,1,2");
+        QCommandLineOption triangles_per_voxel_option("triangles-per-voxel", "Comma separated targets of the automatic voxel size of the voxel engine, "
+                                                      "every target is run besides the voxel sizes.", "list", "");
+        QCommandLineOption storage_option("storage", "Voxel grid storage: auto, dense, sparse or bricks.", "type", "auto");
+        QCommandLineOption classification_option("classification", "Inside test of the bvh, voxel and hierarchical engines: nearest (triangle) or parity (of ray crossings). The kdtree and octree engines always use the nearest triangle.", "type", "nearest");
+        QCommandLineOption no_voxel_labels_option("no-voxel-labels", "Disables the labelling of empty voxels of the voxel engine and of empty cells of the hierarchical engine.");
+        QCommandLineOption corner_distances_option("corner-distances", "Samples distances at the voxel corners of the voxel engine.");
+        QCommandLineOption points_option("points", "Number of query points.", "count", "20000");
+        QCommandLineOption kernel_points_option("kernel-points", "Number of query points of the distance kernel.", "count", "100");
+        QCommandLineOption runs_option("runs", "Number of runs of builds, batches and parallel queries.", "count", "3");
+        QCommandLineOption threads_option("threads", "Threads of parallel builds and queries, 0 means all hardware threads.", "count", "0");
+        QCommandLineOption seed_option("seed", "Seed of the query points and of the synthetic scenes.", "seed", "0");
+        QCommandLineOption distribution_option("distribution", "Query points of synthetic scenes: uniform or clustered.", "type", "uniform");
+        QCommandLineOption export_option("export", "Writes the parts of synthetic scenes as STL files to the folder.", "folder");
+        QCommandLineOption json_option("json", "Writes the results as JSON.", "file");
+        QCommandLineOption csv_option("csv", "Writes the results as CSV.", "file");
+        parser.addOptions({ engines_option, voxel_sizes_option, triangles_per_voxel_option, storage_option, classification_option, no_voxel_labels_option, corner_distances_option, points_option, kernel_points_option,
+                            runs_option, threads_option, seed_option, distribution_option, export_option, json_option, csv_option });
+        parser.process(i_application);
+
+        o_options.m_datasets = parser.positionalArguments();
+        if (o_options.m_datasets.isEmpty())
+        {
+            qCritical().noquote() << "No datasets given\n" << parser.helpText();
+            return false;
+        }
 
-    SIZE_T m_memory_on_start;
-    SIZE_T m_memory_on_stop;
+        o_options.m_engines = parser.value(engines_option).split(',', QString::SkipEmptyParts);
+        for (const auto& engine : o_options.m_engines)
+        {
+            if (!ENGINES.contains(engine))
+            {
+                qCritical().noquote() << "Unknown engine" << engine;
+                return false;
+            }
+        }
 
-    std::chrono::time_point<std::chrono::system_clock> m_time_on_start;
-    std::chrono::time_point<std::chrono::system_clock> m_time_on_stop;
-};
+        for (const auto& text : parser.value(voxel_sizes_option).split(',', QString::SkipEmptyParts))
+        {
+            bool ok = false;
+            const auto voxel_size = text.toDouble(&ok);
+            if (!ok || voxel_size <= 0)
+            {
+                qCritical().noquote() << "Wrong voxel size" << text;
+                return false;
+            }
+            o_options.m_voxel_sizes.push_back(voxel_size);
+        }
 
-TimeMemoryLogger::TimeMemoryLogger()
-    : mp_impl(std::make_unique<Impl>())
-{
-}
+        for (const auto& text : parser.value(triangles_per_voxel_option).split(',', QString::SkipEmptyParts))
+        {
+            bool ok = false;
+            const auto triangles_per_voxel = text.toDouble(&ok);
+            if (!ok || triangles_per_voxel <= 1)
+            {
+                qCritical().noquote() << "Wrong triangles per voxel" << text;
+                return false;
+            }
+            o_options.m_triangles_per_voxel.push_back(triangles_per_voxel);
+        }
 
-TimeMemoryLogger::~TimeMemoryLogger() = default;
+        const std::map<QString, VoxelGrid::StorageType> storage_types = { { "auto", VoxelGrid::StorageType::Auto },
+                                                                            { "dense", VoxelGrid::StorageType::Dense },
+                                                                            { "sparse", VoxelGrid::StorageType::Sparse },
+                                                                            { "bricks", VoxelGrid::StorageType::Bricks } };
+        const auto storage_it = storage_types.find(parser.value(storage_option));
+        if (storage_it == storage_types.end())
+        {
+            qCritical().noquote() << "Unknown storage" << parser.value(storage_option);
+            return false;
+        }
+        o_options.m_storage_type = storage_it->second;
 
-double TimeMemoryLogger::GetElapsedTimeSec() const
-{
-    assert(mp_impl->m_started && mp_impl->m_stopped);
-    return std::chrono::duration<double>(mp_impl->m_time_on_stop - mp_impl->m_time_on_start).count();
-}
+        const auto classification = parser.value(classification_option);
+        if (classification != "nearest" && classification != "parity")
+        {
+            qCritical().noquote() << "Unknown classification" << classification;
+            return false;
+        }
+        o_options.m_use_ray_parity = classification == "parity";
+        o_options.m_label_empty_voxels = !parser.isSet(no_voxel_labels_option);
+        o_options.m_use_corner_distances = parser.isSet(corner_distances_option);
+
+        size_t seed = 0;
+        if (!_ParseSize(parser.value(points_option), o_options.m_points_count) || o_options.m_points_count == 0 ||
+            !_ParseSize(parser.value(kernel_points_option), o_options.m_kernel_points_count) ||
+            !_ParseSize(parser.value(runs_option), o_options.m_runs_count) || o_options.m_runs_count == 0 ||
+            !_ParseSize(parser.value(threads_option), o_options.m_threads_count) ||
+            !_ParseSize(parser.value(seed_option), seed))
+        {
+            qCritical().noquote() << "Counts must be non-negative integers, points and runs must be positive";
+            return false;
+        }
+        o_options.m_seed = static_cast<unsigned int>(seed);
 
-double TimeMemoryLogger::GetMemoryDifferenceMb() const
-{
-    assert(mp_impl->m_started && mp_impl->m_stopped);
-    return (static_cast<long long>(mp_impl->m_memory_on_stop) - static_cast<long long>(mp_impl->m_memory_on_start)) / (1024.0 * 1024.0);
-}
+        const auto distribution = parser.value(distribution_option);
+        if (distribution == "clustered")
+            o_options.m_distribution = SceneGenerator::PointsDistribution::Clustered;
+        else if (distribution != "uniform")
+        {
+            qCritical().noquote() << "Unknown distribution" << distribution;
+            return false;
+        }
 
-void TimeMemoryLogger::Start()
-{
-    assert(!mp_impl->m_started);
+        o_options.m_export_path = parser.value(export_option);
 
-    mp_impl->m_started = true;
+        o_options.m_json_path = parser.value(json_option);
+        o_options.m_csv_path = parser.value(csv_option);
+        return true;
+    }
 
-    PROCESS_MEMORY_COUNTERS_EX pmc;
-    GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc), sizeof(pmc));
+    // triangles of the meshes and the bounding box of the dataset
+    void _IndexDataset(Dataset& io_dataset)
+    {
+        for (size_t i = 0; i < io_dataset.m_meshes.size(); ++i)
+        {
+            const auto& mesh = *io_dataset.m_meshes[i];
+            io_dataset.m_name_to_mesh[mesh.GetName()] = i;
+            if (mesh.GetBoundingBox().IsValid())
+            {
+                io_dataset.m_bbox.AddPoint(mesh.GetBoundingBox().GetMin());
+                io_dataset.m_bbox.AddPoint(mesh.GetBoundingBox().GetMax());
+            }
+            for (size_t k = 0; k < mesh.GetTrianglesCount(); ++k)
+            {
+                auto p_triangle = mesh.GetTriangle(k).lock().get();
+                io_dataset.m_triangles.emplace_back(p_triangle);
+                io_dataset.m_triangle_to_mesh[p_triangle] = i;
+                io_dataset.m_triangles_with_tags.emplace_back(p_triangle, QStringView(mesh.GetName()));
+            }
+        }
+    }
 
-    mp_impl->m_memory_on_start = pmc.WorkingSetSize;
+    bool _LoadDataset(const QString& i_path, Dataset& o_dataset)
+    {
+        const QFileInfo info(i_path);
+        o_dataset.m_name = info.fileName();
 
-    mp_impl->m_time_on_start = std::chrono::system_clock::now();
-}
+        QStringList files;
+        if (info.isDir())
+        {
+            const QDir dir(i_path);
+            for (const auto& file_name : dir.entryList(QStringList() << "*.stl" << "*.obj", QDir::Files, QDir::Name))
+                files << dir.filePath(file_name);
+        }
+        else
+        {
+            files << i_path;
+        }
 
-void TimeMemoryLogger::Stop()
-{
-    assert(mp_impl->m_started);
-    assert(!mp_impl->m_stopped);
+        for (const auto& file : files)
+        {
+            o_dataset.m_meshes.emplace_back(std::make_unique<Mesh>());
+            if (!ReadMesh(file, *o_dataset.m_meshes.back()))
+            {
+                qCritical().noquote() << "Loading failed:" << file;
+                return false;
+            }
+        }
+        if (o_dataset.m_meshes.empty())
+        {
+            qCritical().noquote() << "No meshes in" << i_path;
+            return false;
+        }
 
-    mp_impl->m_stopped = true;
+        _IndexDataset(o_dataset);
+        return true;
+    }
 
-    mp_impl->m_time_on_stop = std::chrono::system_clock::now();
+    // spec is synthetic:<shape>[:<triangles>[:<parts>]], o_truth are the answers of o_points
+    bool _GenerateDataset(const QString& i_spec, const Options& i_options, Dataset& o_dataset, std::vector<Point3D>& o_points, ReferenceResults& o_truth)
+    {
+        const std::map<QString, SceneGenerator::Shape> shapes = { { "sphere", SceneGenerator::Shape::Sphere },
+                                                                  { "torus", SceneGenerator::Shape::Torus },
+                                                                  { "blob", SceneGenerator::Shape::VoxelBlob },
+                                                                  { "sqrt3", SceneGenerator::Shape::Sqrt3Sphere } };
+        const auto fields = i_spec.mid(SYNTHETIC_PREFIX.size()).split(':');
+        const auto shape_it = shapes.find(fields[0]);
+        SceneGenerator::Params params;
+        params.m_seed = i_options.m_seed;
+        if (shape_it == shapes.end() || fields.size() > 3 ||
+            (fields.size() > 1 && (!_ParseSize(fields[1], params.m_triangles_count) || params.m_triangles_count == 0)) ||
+            (fields.size() > 2 && (!_ParseSize(fields[2], params.m_parts_count) || params.m_parts_count == 0)))
+        {
+            qCritical().noquote() << "Wrong synthetic dataset" << i_spec << "expected synthetic:<sphere|torus|blob|sqrt3>[:<triangles>[:<parts>]]";
+            return false;
+        }
+        params.m_shape = shape_it->second;
 
-    PROCESS_MEMORY_COUNTERS_EX pmc;
-    GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc), sizeof(pmc));
+        SceneGenerator generator;
+        TimeMemoryLogger logger;
+        logger.Start();
+        generator.Generate(params);
+        logger.Stop();
+        qInfo().noquote() << QString("%1: generated in %2 s").arg(i_spec).arg(logger.GetElapsedTimeSec());
 
-    mp_impl->m_memory_on_stop = pmc.WorkingSetSize;
-}
+        o_dataset.m_name = i_spec;
+        for (size_t i = 0; i < generator.GetPartsCount(); ++i)
+        {
+            o_dataset.m_meshes.emplace_back(std::make_unique<Mesh>());
+            generator.BuildPartMesh(i, *o_dataset.m_meshes.back());
+        }
+        _IndexDataset(o_dataset);
 
-// single thread testing application that helps to minimize unwanted influence on performance
-int main(int argc, char** argv)
-{
-    QString stl_folder = "C:/3dData/mesh/a lot of parts/6";
-   
-    QDirIterator dir_iterator(stl_folder, QStringList() << "*.stl", QDir::Files);
-    std::vector<std::unique_ptr<Mesh>> meshes;
-    while (dir_iterator.hasNext())
+        if (!i_options.m_export_path.isEmpty())
+        {
+            const QDir dir(i_options.m_export_path);
+            for (const auto& p_mesh : o_dataset.m_meshes)
+            {
+                const auto file = dir.filePath(QString("%1_%2_%3.stl").arg(fields[0]).arg(params.m_triangles_count).arg(p_mesh->GetName()));
+                if (!WriteMesh(file, *p_mesh))
+                {
+                    qCritical().noquote() << "Can't write" << file;
+                    return false;
+                }
+            }
+        }
+
+        generator.GeneratePoints(i_options.m_points_count, i_options.m_distribution, i_options.m_seed, o_points, o_truth);
+        return true;
+    }
+
+    // uniform in the bounding box of the dataset grown by 5% on every side, so some points are outside of all meshes
+    std::vector<Point3D> _GeneratePoints(const BoundingBox& i_bbox, size_t i_count, unsigned int i_seed)
+    {
+        std::mt19937 generator(i_seed);
+        std::uniform_real_distribution<double> distributions[3];
+        for (short axis = 0; axis < 3; ++axis)
+        {
+            const auto margin = 0.05 * i_bbox.GetDelta(axis);
+            distributions[axis] = std::uniform_real_distribution<double>(i_bbox.GetMin()[axis] - margin, i_bbox.GetMax()[axis] + margin);
+        }
+
+        std::vector<Point3D> points;
+        points.reserve(i_count);
+        for (size_t i = 0; i < i_count; ++i)
+        {
+            const auto x = distributions[0](generator);
+            const auto y = distributions[1](generator);
+            const auto z = distributions[2](generator);
+            points.emplace_back(x, y, z);
+        }
+        return points;
+    }
+
+    BenchmarkRecord _MakeRecord(const Dataset& i_dataset, const QString& i_engine, const QString& i_operation, const QString& i_parameters = QString())
     {
-        meshes.emplace_back(std::make_unique<Mesh>());
-        auto file = dir_iterator.next();
-        bool result = ReadMesh(file, *meshes.back());
-        if (!result)
-            qDebug() << "Loading failed";
+        BenchmarkRecord record;
+        record.m_dataset = i_dataset.m_name;
+        record.m_engine = i_engine;
+        record.m_operation = i_operation;
+        record.m_parameters = i_parameters;
+        return record;
     }
 
-    struct VoxelSize
+    // i_prepare isn't measured, it gets rid of the results of the previous run
+    void _MeasureRuns(BenchmarkRecord& io_record, size_t i_runs_count, size_t i_items_count, const std::function<void()>& i_prepare, const std::function<void()>& i_run)
     {
-        double m_size_x = 0;
-        double m_size_y = 0;
-        double m_size_z = 0;
-    };
+        std::vector<double> samples;
+        for (size_t run = 0; run < i_runs_count; ++run)
+        {
+            i_prepare();
 
-    std::vector<VoxelSize> test_cases = 
-    {
-        { 0.1, 0.1, 0.1 },
-        { 0.2, 0.2, 0.2 },
-        { 0.3, 0.3, 0.3 },
-        { 0.4, 0.4, 0.4 },
-        { 0.5, 0.5, 0.5 },
-        { 0.75, 0.75, 0.75 },
-        { 1., 1., 1. },
-        { 1.25, 1.25, 1.25 },
-        { 1.5, 1.5, 1.5 },
-        { 1.75, 1.75, 1.75 },
-        { 2., 2., 2. }
-    };
+            TimeMemoryLogger logger;
+            logger.Start();
+            i_run();
+            logger.Stop();
+
+            samples.push_back(logger.GetElapsedTimeSec());
+            if (run == 0)
+                io_record.m_memory_mb = logger.GetMemoryDifferenceMb();
+        }
 
-    std::srand(0);
-    const size_t num_locations = 20000;
-    std::vector<Point3D> points_to_locate;
-    for (size_t i = 0; i < num_locations; ++i)
+        io_record.m_items_count = i_items_count;
+        io_record.m_runs_count = i_runs_count;
+        io_record.m_total_time_sec = std::accumulate(samples.begin(), samples.end(), 0.);
+        io_record.m_latency = ComputeLatencyStats(std::move(samples));
+        io_record.m_peak_memory_mb = GetPeakRss() / (1024.0 * 1024.0);
+    }
+
+    // every query is timed separately
+    void _MeasureQueries(BenchmarkRecord& io_record, const std::vector<Point3D>& i_points, const std::function<void(size_t)>& i_query)
     {
-        points_to_locate.emplace_back(3 + std::rand() % 40, 3 + std::rand() % 40, 3 + std::rand() % 23);
+        std::vector<double> samples(i_points.size());
+        for (size_t i = 0; i < i_points.size(); ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            i_query(i);
+            samples[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        io_record.m_items_count = i_points.size();
+        io_record.m_runs_count = 1;
+        io_record.m_total_time_sec = std::accumulate(samples.begin(), samples.end(), 0.);
+        io_record.m_latency = ComputeLatencyStats(std::move(samples));
+        io_record.m_peak_memory_mb = GetPeakRss() / (1024.0 * 1024.0);
     }
 
-    for (size_t i = 0; i < test_cases.size(); ++i)
+    long long _CountMismatches(const std::vector<size_t>& i_results, const ReferenceResults* ip_reference)
     {
-        const auto& test_case = test_cases[i];
+        if (!ip_reference)
+            return -1;
+        return static_cast<long long>(std::inner_product(ip_reference->begin(), ip_reference->end(), i_results.begin(), size_t(0),
+                                                         std::plus<size_t>(), std::not_equal_to<size_t>()));
+    }
 
-        PointLocalizerVoxelized::Params params;
-        params.m_voxel_size_x = test_case.m_size_x;
-        params.m_voxel_size_y = test_case.m_size_y;
-        params.m_voxel_size_z = test_case.m_size_z;
-        
-        PointLocalizerVoxelized localizer;
-        for (const auto& p_mesh : meshes)
+    // nearest triangle by scanning all triangles, scalar distance against the packed kernel
+    void _BenchmarkKernel(const Dataset& i_dataset, const std::vector<Point3D>& i_points, size_t i_points_count, BenchmarkReport& io_report)
+    {
+        const std::vector<Point3D> points(i_points.begin(), i_points.begin() + std::min(i_points_count, i_points.size()));
+        if (points.empty())
+            return;
+
+        PackedTriangles packed_triangles;
+        packed_triangles.Reserve(i_dataset.m_triangles.size());
+        for (size_t i = 0; i < i_dataset.m_triangles.size(); ++i)
+            packed_triangles.Add(*i_dataset.m_triangles[i], static_cast<std::uint32_t>(i));
+
+        std::vector<double> scalar_distances(points.size(), std::numeric_limits<double>::max());
+        auto scalar_record = _MakeRecord(i_dataset, "kernel", "scalar_distance");
+        _MeasureQueries(scalar_record, points, [&](size_t i_index)
         {
-            localizer.AddMesh(*p_mesh, TransformMatrix{});
+            for (auto p_triangle : i_dataset.m_triangles)
+                scalar_distances[i_index] = std::min(scalar_distances[i_index], Distance(points[i_index], *p_triangle));
+        });
+        scalar_record.m_metrics.emplace_back("triangles_per_sec", points.size() * i_dataset.m_triangles.size() / scalar_record.m_total_time_sec);
+        io_report.Add(scalar_record);
+
+        std::vector<double> packed_distances(points.size(), std::numeric_limits<double>::max());
+        auto packed_record = _MakeRecord(i_dataset, "kernel", "packed_distance");
+        _MeasureQueries(packed_record, points, [&](size_t i_index)
+        {
+            packed_triangles.FindNearest(points[i_index], packed_distances[i_index], 0, packed_triangles.GetSize());
+        });
+        packed_record.m_mismatches = 0;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            if (std::abs(std::sqrt(packed_distances[i]) - scalar_distances[i]) > 1e-9)
+                ++packed_record.m_mismatches;
         }
+        packed_record.m_metrics.emplace_back("triangles_per_sec", points.size() * i_dataset.m_triangles.size() / packed_record.m_total_time_sec);
+        io_report.Add(packed_record);
+    }
+
+    // vertices of all triangles gathered into arrays of Point3D and of plain BasicPoint3D
+    void _BenchmarkPointArrays(const Dataset& i_dataset, const Options& i_options, BenchmarkReport& io_report)
+    {
+        const auto vertices_count = 3 * i_dataset.m_triangles.size();
 
+        std::vector<Point3D> points;
+        auto points_record = _MakeRecord(i_dataset, "kernel", "build_point3d_array");
+        _MeasureRuns(points_record, i_options.m_runs_count, vertices_count, [&]() { std::vector<Point3D>().swap(points); }, [&]()
         {
-        TimeMemoryLogger logger;
-        logger.Start();
+            points.reserve(vertices_count);
+            for (auto p_triangle : i_dataset.m_triangles)
+                for (short i = 0; i < 3; ++i)
+                    points.emplace_back(p_triangle->GetPoint(i));
+        });
+        points_record.m_metrics.emplace_back("sizeof_point3d", static_cast<double>(sizeof(Point3D)));
+        points_record.m_metrics.emplace_back("sizeof_triangle", static_cast<double>(sizeof(Triangle)));
+        points_record.m_metrics.emplace_back("array_memory_mb", points.capacity() * sizeof(Point3D) / (1024.0 * 1024.0));
+        io_report.Add(points_record);
+
+        std::vector<BasicPoint3D> basic_points;
+        auto basic_points_record = _MakeRecord(i_dataset, "kernel", "build_basic_point3d_array");
+        _MeasureRuns(basic_points_record, i_options.m_runs_count, vertices_count, [&]() { std::vector<BasicPoint3D>().swap(basic_points); }, [&]()
+        {
+            basic_points.reserve(vertices_count);
+            for (auto p_triangle : i_dataset.m_triangles)
+                for (short i = 0; i < 3; ++i)
+                    basic_points.emplace_back(ToBasicPoint(p_triangle->GetPoint(i)));
+        });
+        basic_points_record.m_metrics.emplace_back("sizeof_basic_point3d", static_cast<double>(sizeof(BasicPoint3D)));
+        basic_points_record.m_metrics.emplace_back("sizeof_triangle", static_cast<double>(sizeof(Triangle)));
+        basic_points_record.m_metrics.emplace_back("array_memory_mb", basic_points.capacity() * sizeof(BasicPoint3D) / (1024.0 * 1024.0));
+        io_report.Add(basic_points_record);
+    }
+
+    // answers of a BVH with ray parity classification, exact for closed meshes. Mesh files have no known answers,
+    // every engine is compared with these whatever its own classification is
+    ReferenceResults _ComputeReference(const Dataset& i_dataset, const std::vector<Point3D>& i_points)
+    {
+        PointLocalizerBVH::Params params;
+        params.m_classification = PointLocalizerBVH::Classification::RayParity;
+
+        PointLocalizerBVH localizer;
+        for (const auto& p_mesh : i_dataset.m_meshes)
+            localizer.AddMesh(*p_mesh, TransformMatrix{});
         localizer.Build(params);
-        logger.Stop();
 
-        qDebug() << "--------------------------------------------------";
-        qDebug() << "Voxel size: " << test_case.m_size_x;
-        qDebug() << "Time: " << logger.GetElapsedTimeSec();
-        qDebug() << "Memory: " << logger.GetMemoryDifferenceMb();
+        ReferenceResults reference;
+        localizer.LocalizeBatch(i_points, reference);
+        return reference;
+    }
+
+    void _BenchmarkBVH(const Dataset& i_dataset, const std::vector<Point3D>& i_points, const Options& i_options, const ReferenceResults* ip_reference,
+                       BenchmarkReport& io_report)
+    {
+        PointLocalizerBVH::Params params;
+        params.m_classification = i_options.m_use_ray_parity ? PointLocalizerBVH::Classification::RayParity : PointLocalizerBVH::Classification::NearestTriangle;
+
+        const auto parameters = QString("classification=%1").arg(_GetClassificationName(i_options));
+
+        std::unique_ptr<PointLocalizerBVH> p_localizer;
+        auto build_record = _MakeRecord(i_dataset, "bvh", "build", parameters);
+        _MeasureRuns(build_record, i_options.m_runs_count, i_dataset.m_triangles.size(),
+            [&]()
+            {
+                p_localizer = std::make_unique<PointLocalizerBVH>();
+                for (const auto& p_mesh : i_dataset.m_meshes)
+                    p_localizer->AddMesh(*p_mesh, TransformMatrix{});
+            },
+            [&]() { p_localizer->Build(params); });
+        io_report.Add(build_record);
+
+        std::vector<size_t> results(i_points.size(), 0);
+        auto query_record = _MakeRecord(i_dataset, "bvh", "query", parameters);
+        _MeasureQueries(query_record, i_points, [&](size_t i_index) { results[i_index] = p_localizer->Localize(i_points[i_index]); });
+        query_record.m_mismatches = _CountMismatches(results, ip_reference);
+        io_report.Add(query_record);
+
+        std::vector<size_t> batch_results;
+        auto batch_record = _MakeRecord(i_dataset, "bvh", "batch_query", parameters);
+        _MeasureRuns(batch_record, i_options.m_runs_count, i_points.size(), [&]() { batch_results.clear(); },
+                     [&]() { p_localizer->LocalizeBatch(i_points, batch_results); });
+        batch_record.m_mismatches = _CountMismatches(batch_results, ip_reference);
+        io_report.Add(batch_record);
+
+        ParallelLocalizer::Params parallel_params;
+        parallel_params.m_threads_count = i_options.m_threads_count;
+        ParallelLocalizer parallel_localizer(parallel_params);
+        std::vector<size_t> parallel_results;
+        auto parallel_record = _MakeRecord(i_dataset, "bvh", "parallel_query", parameters + QString(" threads=%1").arg(parallel_localizer.GetThreadsCount()));
+        _MeasureRuns(parallel_record, i_options.m_runs_count, i_points.size(), [&]() { parallel_results.clear(); },
+                     [&]() { parallel_localizer.Localize(*p_localizer, i_points, parallel_results); });
+        parallel_record.m_mismatches = _CountMismatches(parallel_results, ip_reference);
+        io_report.Add(parallel_record);
+    }
+
+    void _BenchmarkKDTree(const Dataset& i_dataset, const std::vector<Point3D>& i_points, const Options& i_options, const ReferenceResults* ip_reference, BenchmarkReport& io_report)
+    {
+        std::unique_ptr<TrianglesTree> p_tree;
+        auto build_record = _MakeRecord(i_dataset, "kdtree", "build");
+        _MeasureRuns(build_record, i_options.m_runs_count, i_dataset.m_triangles.size(),
+                     [&]() { p_tree.reset(); p_tree = std::make_unique<TrianglesTree>(); },
+                     [&]() { p_tree->Build(i_dataset.m_triangles); });
+        io_report.Add(build_record);
+
+        // inside the mesh of the nearest triangle if the point is below or on its plane
+        const auto to_mesh_index = [&i_dataset](Triangle* ip_triangle, const Point3D& i_point)
+        {
+            if (!ip_triangle)
+                return std::numeric_limits<size_t>::max();
+            const auto location = GetPointTriangleRelativeLocation(*ip_triangle, i_point);
+            if (location != PointTriangleRelativeLocationResult::Below && location != PointTriangleRelativeLocationResult::OnSamePlane)
+                return std::numeric_limits<size_t>::max();
+            return i_dataset.m_triangle_to_mesh.at(ip_triangle);
+        };
+
+        std::vector<size_t> results(i_points.size());
+        auto query_record = _MakeRecord(i_dataset, "kdtree", "query");
+        _MeasureQueries(query_record, i_points, [&](size_t i_index)
+        {
+            Triangle* p_triangle = nullptr;
+            p_tree->Query(p_triangle, i_points[i_index]);
+            results[i_index] = to_mesh_index(p_triangle, i_points[i_index]);
+        });
+        query_record.m_mismatches = _CountMismatches(results, ip_reference);
+        io_report.Add(query_record);
+
+        ParallelLocalizer::Params parallel_params;
+        parallel_params.m_threads_count = i_options.m_threads_count;
+        ParallelLocalizer parallel_localizer(parallel_params);
+        std::vector<Triangle*> parallel_triangles;
+        auto parallel_record = _MakeRecord(i_dataset, "kdtree", "parallel_query", QString("threads=%1").arg(parallel_localizer.GetThreadsCount()));
+        _MeasureRuns(parallel_record, i_options.m_runs_count, i_points.size(), [&]() { parallel_triangles.clear(); },
+                     [&]() { parallel_localizer.Localize(*p_tree, i_points, parallel_triangles); });
+        for (size_t i = 0; i < i_points.size(); ++i)
+            results[i] = to_mesh_index(parallel_triangles[i], i_points[i]);
+        parallel_record.m_mismatches = _CountMismatches(results, ip_reference);
+        io_report.Add(parallel_record);
+    }
+
+    void _BenchmarkOcTree(const Dataset& i_dataset, const std::vector<Point3D>& i_points, const Options& i_options, const ReferenceResults* ip_reference, BenchmarkReport& io_report)
+    {
+        std::unique_ptr<TrianglesOcTree> p_tree;
+        auto build_record = _MakeRecord(i_dataset, "octree", "build");
+        _MeasureRuns(build_record, i_options.m_runs_count, i_dataset.m_triangles.size(),
+                     [&]() { p_tree.reset(); p_tree = std::make_unique<TrianglesOcTree>(); },
+                     [&]() { p_tree->Build(i_dataset.m_triangles_with_tags); });
+        io_report.Add(build_record);
+
+        const auto to_mesh_index = [&i_dataset](const TriangleOcTreeQueryResult& i_result)
+        {
+            if (i_result.m_status != TriangleOcTreeQueryResult::Inside)
+                return std::numeric_limits<size_t>::max();
+            return i_dataset.m_name_to_mesh.at(i_result.m_mesh_name.toString());
+        };
+
+        std::vector<size_t> results(i_points.size());
+        auto query_record = _MakeRecord(i_dataset, "octree", "query");
+        _MeasureQueries(query_record, i_points, [&](size_t i_index)
+        {
+            TriangleOcTreeQueryResult result;
+            p_tree->Query(result, i_points[i_index]);
+            results[i_index] = to_mesh_index(result);
+        });
+        query_record.m_mismatches = _CountMismatches(results, ip_reference);
+        io_report.Add(query_record);
+
+        ParallelLocalizer::Params parallel_params;
+        parallel_params.m_threads_count = i_options.m_threads_count;
+        ParallelLocalizer parallel_localizer(parallel_params);
+        std::vector<TriangleOcTreeQueryResult> parallel_results;
+        auto parallel_record = _MakeRecord(i_dataset, "octree", "parallel_query", QString("threads=%1").arg(parallel_localizer.GetThreadsCount()));
+        _MeasureRuns(parallel_record, i_options.m_runs_count, i_points.size(), [&]() { parallel_results.clear(); },
+                     [&]() { parallel_localizer.Localize(*p_tree, i_points, parallel_results); });
+        for (size_t i = 0; i < i_points.size(); ++i)
+            results[i] = to_mesh_index(parallel_results[i]);
+        parallel_record.m_mismatches = _CountMismatches(results, ip_reference);
+        io_report.Add(parallel_record);
+    }
+
+    // i_triangles_per_voxel is the target of the automatic voxel size, 0 means i_voxel_size is used
+    void _BenchmarkVoxelized(const Dataset& i_dataset, const std::vector<Point3D>& i_points, const Options& i_options, double i_voxel_size, double i_triangles_per_voxel,
+                             const ReferenceResults* ip_reference, BenchmarkReport& io_report)
+    {
+        PointLocalizerVoxelized::Params params;
+        params.m_voxel_size_x = i_voxel_size;
+        params.m_voxel_size_y = i_voxel_size;
+        params.m_voxel_size_z = i_voxel_size;
+        if (i_triangles_per_voxel > 0)
+        {
+            params.m_auto_voxel_size = true;
+            params.m_triangles_per_voxel = i_triangles_per_voxel;
         }
+        params.m_storage_type = i_options.m_storage_type;
+        params.m_classification = i_options.m_use_ray_parity ? PointLocalizerVoxelized::Classification::RayParity : PointLocalizerVoxelized::Classification::NearestTriangle;
+        params.m_label_empty_voxels = i_options.m_label_empty_voxels;
+        params.m_use_corner_distances = i_options.m_use_corner_distances;
+
+        const auto voxel_size = params.m_auto_voxel_size ? QString("auto(%1)").arg(i_triangles_per_voxel) : QString::number(i_voxel_size);
+        const auto parameters = QString("voxel_size=%1 storage=%2 classification=%3 labels=%4 corners=%5").arg(voxel_size).arg(_GetStorageName(i_options.m_storage_type))
+                                                                                                          .arg(_GetClassificationName(i_options)).arg(i_options.m_label_empty_voxels ? "on" : "off")
+                                                                                                          .arg(i_options.m_use_corner_distances ? "on" : "off");
+
+        std::unique_ptr<PointLocalizerVoxelized> p_localizer;
+        const auto prepare = [&]()
+        {
+            p_localizer = std::make_unique<PointLocalizerVoxelized>();
+            for (const auto& p_mesh : i_dataset.m_meshes)
+                p_localizer->AddMesh(*p_mesh, TransformMatrix{});
+        };
+
+        params.m_threads_count = 1;
+        auto single_build_record = _MakeRecord(i_dataset, "voxel", "build_single_thread", parameters);
+        _MeasureRuns(single_build_record, i_options.m_runs_count, i_dataset.m_triangles.size(), prepare, [&]() { p_localizer->Build(params); });
+        io_report.Add(single_build_record);
+
+        params.m_threads_count = i_options.m_threads_count;
+        auto build_record = _MakeRecord(i_dataset, "voxel", "build", parameters);
+        _MeasureRuns(build_record, i_options.m_runs_count, i_dataset.m_triangles.size(), prepare, [&]() { p_localizer->Build(params); });
+        {
+            const auto& grid = *p_localizer->GetCachedGrid().lock();
+            double triangles_count = 0;
+            const auto voxels = grid.GetExistingVoxelsCoordinates();
+            for (const auto& voxel_coordinates : voxels)
+                triangles_count += grid.GetVoxelTriangles(voxel_coordinates).size();
+
+            build_record.m_metrics.emplace_back("grid_storage", _GetStorageName(grid.GetStorageType()));
+            build_record.m_metrics.emplace_back("grid_memory_mb", grid.GetMemoryUsage() / (1024.0 * 1024.0));
+            build_record.m_metrics.emplace_back("existing_voxels", static_cast<double>(voxels.size()));
+            build_record.m_metrics.emplace_back("avg_triangles_in_voxel", voxels.empty() ? 0. : triangles_count / voxels.size());
+            build_record.m_metrics.emplace_back("localizer_memory_mb", p_localizer->GetMemoryUsage() / (1024.0 * 1024.0));
+            build_record.m_metrics.emplace_back("voxel_size_x", p_localizer->GetParams().m_voxel_size_x);
+            build_record.m_metrics.emplace_back("voxel_size_y", p_localizer->GetParams().m_voxel_size_y);
+            build_record.m_metrics.emplace_back("voxel_size_z", p_localizer->GetParams().m_voxel_size_z);
+        }
+        if (params.m_use_corner_distances)
+        {
+            // the corner distances on their own: the same build without them, the differences are theirs
+            const auto memory_usage = p_localizer->GetMemoryUsage();
+            auto no_corners_params = params;
+            no_corners_params.m_use_corner_distances = false;
+            BenchmarkRecord no_corners_record;
+            _MeasureRuns(no_corners_record, i_options.m_runs_count, i_dataset.m_triangles.size(), prepare, [&]() { p_localizer->Build(no_corners_params); });
+            build_record.m_metrics.emplace_back("corner_distances_build_sec", build_record.m_latency.m_p50 - no_corners_record.m_latency.m_p50);
+            build_record.m_metrics.emplace_back("corner_distances_memory_mb", (static_cast<double>(memory_usage) - p_localizer->GetMemoryUsage()) / (1024.0 * 1024.0));
+            prepare();
+            p_localizer->Build(params);
+        }
+        io_report.Add(build_record);
+
+        std::vector<size_t> results(i_points.size());
+        auto query_record = _MakeRecord(i_dataset, "voxel", "query", parameters);
+        _MeasureQueries(query_record, i_points, [&](size_t i_index) { results[i_index] = p_localizer->Localize(i_points[i_index]); });
+        query_record.m_mismatches = _CountMismatches(results, ip_reference);
+        io_report.Add(query_record);
+
+        std::vector<size_t> batch_results;
+        auto batch_record = _MakeRecord(i_dataset, "voxel", "batch_query", parameters);
+        _MeasureRuns(batch_record, i_options.m_runs_count, i_points.size(), [&]() { batch_results.clear(); },
+                     [&]() { p_localizer->LocalizeBatch(i_points, batch_results); });
+        batch_record.m_mismatches = _CountMismatches(batch_results, ip_reference);
+        io_report.Add(batch_record);
+
+        ParallelLocalizer::Params parallel_params;
+        parallel_params.m_threads_count = i_options.m_threads_count;
+        ParallelLocalizer parallel_localizer(parallel_params);
+        std::vector<size_t> parallel_results;
+        auto parallel_record = _MakeRecord(i_dataset, "voxel", "parallel_query", parameters + QString(" threads=%1").arg(parallel_localizer.GetThreadsCount()));
+        _MeasureRuns(parallel_record, i_options.m_runs_count, i_points.size(), [&]() { parallel_results.clear(); },
+                     [&]() { parallel_localizer.Localize(*p_localizer, i_points, parallel_results); });
+        parallel_record.m_mismatches = _CountMismatches(parallel_results, ip_reference);
+        io_report.Add(parallel_record);
+    }
 
+    void _BenchmarkHierarchical(const Dataset& i_dataset, const std::vector<Point3D>& i_points, const Options& i_options, const ReferenceResults* ip_reference, BenchmarkReport& io_report)
+    {
+        PointLocalizerHierarchical::Params params;
+        params.m_storage_type = i_options.m_storage_type;
+        params.m_threads_count = i_options.m_threads_count;
+        params.m_classification = i_options.m_use_ray_parity ? PointLocalizerHierarchical::Classification::RayParity : PointLocalizerHierarchical::Classification::NearestTriangle;
+        params.m_label_empty_cells = i_options.m_label_empty_voxels;
+
+        const auto parameters = QString("storage=%1 classification=%2 labels=%3").arg(_GetStorageName(i_options.m_storage_type)).arg(_GetClassificationName(i_options))
+                                                                                 .arg(i_options.m_label_empty_voxels ? "on" : "off");
+
+        std::unique_ptr<PointLocalizerHierarchical> p_localizer;
+        auto build_record = _MakeRecord(i_dataset, "hierarchical", "build", parameters);
+        _MeasureRuns(build_record, i_options.m_runs_count, i_dataset.m_triangles.size(),
+            [&]()
+            {
+                p_localizer = std::make_unique<PointLocalizerHierarchical>();
+                for (const auto& p_mesh : i_dataset.m_meshes)
+                    p_localizer->AddMesh(*p_mesh, TransformMatrix{});
+            },
+            [&]() { p_localizer->Build(params); });
         {
-        auto& grid = *localizer.GetCachedGrid().lock();
-        auto voxels = grid.GetExistingVoxels();
-        double num_triangles = 0;
-        for (const auto& p_vox : voxels)
-            num_triangles += p_vox->GetTriangles().size();
+            const auto& top_grid = *p_localizer->GetTopGrid().lock();
+            build_record.m_metrics.emplace_back("cell_size", p_localizer->GetParams().m_cell_size);
+            build_record.m_metrics.emplace_back("top_grid_cells", static_cast<double>(top_grid.GetNumVoxels()[0] * top_grid.GetNumVoxels()[1] * top_grid.GetNumVoxels()[2]));
+            build_record.m_metrics.emplace_back("sub_grids", static_cast<double>(p_localizer->GetSubGridsCount()));
+            build_record.m_metrics.emplace_back("localizer_memory_mb", p_localizer->GetMemoryUsage() / (1024.0 * 1024.0));
+        }
+        io_report.Add(build_record);
+
+        std::vector<size_t> results(i_points.size());
+        auto query_record = _MakeRecord(i_dataset, "hierarchical", "query", parameters);
+        _MeasureQueries(query_record, i_points, [&](size_t i_index) { results[i_index] = p_localizer->Localize(i_points[i_index]); });
+        query_record.m_mismatches = _CountMismatches(results, ip_reference);
+        io_report.Add(query_record);
+
+        std::vector<size_t> batch_results;
+        auto batch_record = _MakeRecord(i_dataset, "hierarchical", "batch_query", parameters);
+        _MeasureRuns(batch_record, i_options.m_runs_count, i_points.size(), [&]() { batch_results.clear(); },
+                     [&]() { p_localizer->LocalizeBatch(i_points, batch_results); });
+        batch_record.m_mismatches = _CountMismatches(batch_results, ip_reference);
+        io_report.Add(batch_record);
+
+        ParallelLocalizer::Params parallel_params;
+        parallel_params.m_threads_count = i_options.m_threads_count;
+        ParallelLocalizer parallel_localizer(parallel_params);
+        std::vector<size_t> parallel_results;
+        auto parallel_record = _MakeRecord(i_dataset, "hierarchical", "parallel_query", parameters + QString(" threads=%1").arg(parallel_localizer.GetThreadsCount()));
+        _MeasureRuns(parallel_record, i_options.m_runs_count, i_points.size(), [&]() { parallel_results.clear(); },
+                     [&]() { parallel_localizer.Localize(*p_localizer, i_points, parallel_results); });
+        parallel_record.m_mismatches = _CountMismatches(parallel_results, ip_reference);
+        io_report.Add(parallel_record);
+    }
+}
 
-        qDebug() << "Avg triangles in voxel: " << QString::number(num_triangles / voxels.size(), 'f', 4).toStdString().c_str();
+
+// Every engine is built and queried on the same random points of every dataset. Queries are timed one by one for the
+// latency percentiles, builds, batches and parallel queries are repeated --runs times. Synthetic datasets know the
+// answers of their points and every engine reports how many of its answers differ. On mesh files the engines are
+// compared with a BVH with ray parity classification, which is exact for closed meshes
+int main(int argc, char** argv)
+{
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setApplicationName("Math.TestingBenchmark");
+
+    Options options;
+    if (!_ParseOptions(application, options))
+        return 1;
+
+    BenchmarkReport report;
+    report.SetInfo("date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.SetInfo("os", QSysInfo::prettyProductName());
+    report.SetInfo("cpu_architecture", QSysInfo::currentCpuArchitecture());
+    report.SetInfo("hardware_threads", QThread::idealThreadCount());
+    report.SetInfo("points", static_cast<qulonglong>(options.m_points_count));
+    report.SetInfo("runs", static_cast<qulonglong>(options.m_runs_count));
+    report.SetInfo("seed", options.m_seed);
+
+    for (const auto& dataset_path : options.m_datasets)
+    {
+        Dataset dataset;
+        std::vector<Point3D> points;
+        ReferenceResults reference;
+        if (dataset_path.startsWith(SYNTHETIC_PREFIX))
+        {
+            if (!_GenerateDataset(dataset_path, options, dataset, points, reference))
+                return 1;
         }
+        else
+        {
+            if (!_LoadDataset(dataset_path, dataset))
+                return 1;
+            points = _GeneratePoints(dataset.m_bbox, options.m_points_count, options.m_seed);
+            reference = _ComputeReference(dataset, points);
+        }
+
+        qInfo().noquote() << "--------------------------------------------------";
+        qInfo().noquote() << QString("%1: %2 meshes, %3 triangles").arg(dataset.m_name).arg(dataset.m_meshes.size()).arg(dataset.m_triangles.size());
 
+        if (options.m_engines.contains("kernel"))
         {
-            double time = 0;
+            _BenchmarkPointArrays(dataset, options, report);
+            _BenchmarkKernel(dataset, points, options.m_kernel_points_count, report);
+        }
 
-            for (size_t k = 0; k < num_locations; ++k)
-            {
-                TimeMemoryLogger logger;
-                logger.Start();
-                localizer.Localize(points_to_locate[k]);
-                logger.Stop();
-                time += logger.GetElapsedTimeSec();
-            }
+        const auto p_reference = reference.empty() ? nullptr : &reference;
 
-            qDebug() << "Query time: " << QString::number(time / num_locations, 'f', 8).toStdString().c_str();
+        if (options.m_engines.contains("bvh"))
+            _BenchmarkBVH(dataset, points, options, p_reference, report);
+
+        if (options.m_engines.contains("kdtree"))
+            _BenchmarkKDTree(dataset, points, options, p_reference, report);
+
+        if (options.m_engines.contains("octree"))
+            _BenchmarkOcTree(dataset, points, options, p_reference, report);
+
+        if (options.m_engines.contains("voxel"))
+        {
+            for (const auto voxel_size : options.m_voxel_sizes)
+                _BenchmarkVoxelized(dataset, points, options, voxel_size, 0, p_reference, report);
+            for (const auto triangles_per_voxel : options.m_triangles_per_voxel)
+                _BenchmarkVoxelized(dataset, points, options, 0, triangles_per_voxel, p_reference, report);
         }
+
+        if (options.m_engines.contains("hierarchical"))
+            _BenchmarkHierarchical(dataset, points, options, p_reference, report);
+    }
+
+    if (!options.m_json_path.isEmpty() && !report.WriteJson(options.m_json_path))
+    {
+        qCritical().noquote() << "Can't write" << options.m_json_path;
+        return 1;
+    }
+    if (!options.m_csv_path.isEmpty() && !report.WriteCsv(options.m_csv_path))
+    {
+        qCritical().noquote() << "Can't write" << options.m_csv_path;
+        return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -7,9 +7,11 @@
 #include "PL3DS.Gui/Utilities/ProgressDialog.h"
 
 #include <Math.Core/CommonUtilities.h>
+#include <Math.Core/IndexedMesh.h>
 #include <Math.Core/Mesh.h>
-#include <Math.Core/MeshTriangle.h>
+#include <Math.Core/Point3D.h>
 #include <Math.Core/TransformMatrix.h>
+#include <Math.Core/Triangle.h>
 
 #include <Math.Algos/PointLocalizerVoxelized.h>
 
@@ -30,7 +32,9 @@
 #include <QString>
 #include <QStringView>
 
+#include <cstdint>
 #include <map>
+#include <vector>
 
 namespace
 {
@@ -59,6 +63,23 @@ namespace
 
         return std::move(meshes);
     }
+
+    // appends the transformed triangles of the mesh, shared vertices are transformed once
+    void _AppendTransformedTriangles(const Mesh& i_mesh, const TransformMatrix& i_transform, std::vector<Triangle>& io_triangles)
+    {
+        const auto& indexed_mesh = i_mesh.GetIndexedMesh();
+        std::vector<Point3D> vertices;
+        vertices.reserve(indexed_mesh.GetVerticesCount());
+        for (const auto& vertex : indexed_mesh.GetVertices())
+        {
+            vertices.push_back(ToPoint3D(vertex));
+            i_transform.ApplyTransformation(vertices.back());
+        }
+
+        const auto& corners = indexed_mesh.GetCorners();
+        for (size_t corner = 0; corner < corners.size(); corner += 3)
+            io_triangles.emplace_back(vertices[corners[corner]], vertices[corners[corner + 1]], vertices[corners[corner + 2]]);
+    }
 }
 
 namespace UI
@@ -165,13 +186,14 @@ namespace UI
 
         // kd tree based stuff
         std::unique_ptr<TrianglesTree> mp_kd_tree;
-        std::list<Triangle> m_kd_transformed_triangles;
-        std::unordered_map<Triangle*, QStringView> m_kd_triangle_to_mesh_map;
+        std::vector<Triangle> m_kd_transformed_triangles;       // reserved before filling, the tree keeps pointers to them
+        std::vector<std::uint32_t> m_kd_triangles_mesh_indexes; // same order as m_kd_transformed_triangles
+        std::vector<QStringView> m_kd_mesh_names;
         std::unique_ptr<Rendering::RenderableTrianglesTree> mp_renderable_kd_tree;
 
         // octree based stuff
         std::unique_ptr<TrianglesOcTree> mp_octree;
-        std::list<Triangle> m_oct_transformed_triangles;
+        std::vector<Triangle> m_oct_transformed_triangles;      // reserved before filling, the tree keeps pointers to them
         std::unique_ptr<Rendering::RenderableTrianglesTree> mp_renderable_octree;
     };
 
@@ -212,8 +234,9 @@ namespace UI
             mp_impl->mp_renderable_voxel_grid.reset();
 
             mp_impl->mp_kd_tree.reset();
-            mp_impl->m_kd_triangle_to_mesh_map.clear();
             mp_impl->m_kd_transformed_triangles.clear();
+            mp_impl->m_kd_triangles_mesh_indexes.clear();
+            mp_impl->m_kd_mesh_names.clear();
             mp_impl->mp_renderable_kd_tree.reset();
 
             mp_impl->mp_octree.reset();
@@ -394,40 +417,38 @@ namespace UI
         {
             mp_impl->mp_renderable_kd_tree.reset();
             mp_impl->mp_kd_tree = std::make_unique<TrianglesTree>();
-            mp_impl->m_kd_triangle_to_mesh_map.clear();
             mp_impl->m_kd_transformed_triangles.clear();
+            mp_impl->m_kd_triangles_mesh_indexes.clear();
+            mp_impl->m_kd_mesh_names.clear();
 
             Utilities::TimeMemoryLogger logger;
             auto builder = [&]
             {
                 auto meshes = _GetMeshesWithTransformation(mp_impl->mp_ui->mp_list_meshes->model());
 
+                size_t triangles_count = 0;
+                for (const auto& mesh_transform : meshes)
+                    triangles_count += mesh_transform.first->GetTrianglesCount();
+
+                mp_impl->m_kd_transformed_triangles.reserve(triangles_count);
+                mp_impl->m_kd_triangles_mesh_indexes.reserve(triangles_count);
+
                 std::vector<Triangle*> triangles;
+                triangles.reserve(triangles_count);
                 for (const auto& mesh_transform : meshes)
                 {
                     const auto p_mesh = mesh_transform.first;
                     const auto& transform = mesh_transform.second;
-
-                    for (size_t i = 0; i < p_mesh->GetTrianglesCount(); ++i)
-                    {
-                        if (auto p_triangle = p_mesh->GetTriangle(i).lock())
-                        {
-                            auto point1 = p_triangle->GetPoint(0);
-                            auto point2 = p_triangle->GetPoint(1);
-                            auto point3 = p_triangle->GetPoint(2);
-                            transform.ApplyTransformation(point1);
-                            transform.ApplyTransformation(point2);
-                            transform.ApplyTransformation(point3);
-
-                            mp_impl->m_kd_transformed_triangles.emplace_back(point1, point2, point3);
-                            mp_impl->m_kd_triangle_to_mesh_map[&mp_impl->m_kd_transformed_triangles.back()] = QStringView(p_mesh->GetName());
-                            triangles.emplace_back(&mp_impl->m_kd_transformed_triangles.back());
-                        }
-                        else
-                        {
-                            assert(false);
-                        }
-                    }
+                    const auto mesh_index = static_cast<std::uint32_t>(mp_impl->m_kd_mesh_names.size());
+                    mp_impl->m_kd_mesh_names.emplace_back(p_mesh->GetName());
+
+                    // the triangles are reserved, so the pointers to them stay valid
+                    auto& transformed_triangles = mp_impl->m_kd_transformed_triangles;
+                    const auto first_triangle = transformed_triangles.size();
+                    _AppendTransformedTriangles(*p_mesh, transform, transformed_triangles);
+                    mp_impl->m_kd_triangles_mesh_indexes.resize(transformed_triangles.size(), mesh_index);
+                    for (auto i = first_triangle; i < transformed_triangles.size(); ++i)
+                        triangles.emplace_back(&transformed_triangles[i]);
                 }
 
                 logger.Start();
@@ -481,7 +502,9 @@ namespace UI
 
             if (p_triangle && located_below)
             {
-                _LogMessage(QString("Point is located at mesh with name: %1").arg(mp_impl->m_kd_triangle_to_mesh_map[p_triangle]));
+                const auto triangle_index = static_cast<size_t>(p_triangle - mp_impl->m_kd_transformed_triangles.data());
+                const auto& mesh_name = mp_impl->m_kd_mesh_names[mp_impl->m_kd_triangles_mesh_indexes[triangle_index]];
+                _LogMessage(QString("Point is located at mesh with name: %1").arg(mesh_name));
             }
             else
             {
@@ -544,31 +567,25 @@ namespace UI
             {
                 auto meshes = _GetMeshesWithTransformation(mp_impl->mp_ui->mp_list_meshes->model());
 
+                size_t triangles_count = 0;
+                for (const auto& mesh_transform : meshes)
+                    triangles_count += mesh_transform.first->GetTrianglesCount();
+
+                mp_impl->m_oct_transformed_triangles.clear();
+                mp_impl->m_oct_transformed_triangles.reserve(triangles_count);
+
                 std::vector<TriangleWithMeshTag> triangles;
+                triangles.reserve(triangles_count);
                 for (const auto& mesh_transform : meshes)
                 {
                     const auto p_mesh = mesh_transform.first;
                     const auto& transform = mesh_transform.second;
 
-                    for (size_t i = 0; i < p_mesh->GetTrianglesCount(); ++i)
-                    {
-                        if (auto p_triangle = p_mesh->GetTriangle(i).lock())
-                        {
-                            auto point1 = p_triangle->GetPoint(0);
-                            auto point2 = p_triangle->GetPoint(1);
-                            auto point3 = p_triangle->GetPoint(2);
-                            transform.ApplyTransformation(point1);
-                            transform.ApplyTransformation(point2);
-                            transform.ApplyTransformation(point3);
-
-                            mp_impl->m_oct_transformed_triangles.emplace_back(point1, point2, point3);
-                            triangles.emplace_back(&mp_impl->m_oct_transformed_triangles.back(), QStringView(p_mesh->GetName()));
-                        }
-                        else
-                        {
-                            assert(false);
-                        }
-                    }
+                    auto& transformed_triangles = mp_impl->m_oct_transformed_triangles;
+                    const auto first_triangle = transformed_triangles.size();
+                    _AppendTransformedTriangles(*p_mesh, transform, transformed_triangles);
+                    for (auto i = first_triangle; i < transformed_triangles.size(); ++i)
+                        triangles.emplace_back(&transformed_triangles[i], QStringView(p_mesh->GetName()));
                 }
 
                 logger.Start();
@@ -1,11 +1,11 @@
 #include "Rendering.Core/RenderingUtilities.h"
 
+#include <Math.Core/IndexedMesh.h>
 #include <Math.Core/Mesh.h>
-#include <Math.Core/MeshPoint.h>
-#include <Math.Core/MeshTriangle.h>
 #include <Math.Core/Point3D.h>
 #include <Math.Core/Vector3D.h>
 #include <Math.Core/TransformMatrix.h>
+#include <Math.Core/Triangle.h>
 
 #include <QByteArray>
 #include <QMatrix4x4>
@@ -14,47 +14,44 @@
 #include <Qt3DRender/QGeometry>
 #include <Qt3dRender/QBuffer>
 
-#include <map>
 #include <vector>
 
 namespace
 {
-    std::vector<Vector3D> _GetPointNormals(const Mesh& i_mesh)
+    std::vector<Vector3D> _GetPointNormals(const IndexedMesh& i_mesh)
     {
-        std::vector<Vector3D> normals(i_mesh.GetPointsCount());
-        
-        for (size_t i = 0; i < i_mesh.GetPointsCount(); ++i)
+        std::vector<Vector3D> face_normals(i_mesh.GetFacesCount());
+        for (IndexedMesh::FaceId face = 0; face < i_mesh.GetFacesCount(); ++face)
         {
-            for (auto p_tr : i_mesh.GetPoint(i)->GetTriangles())
-            {
-                normals[i] += p_tr.lock()->GetNormal();
-            }
+            const auto point1 = ToPoint3D(i_mesh.GetVertex(i_mesh.GetFaceVertex(face, 0)));
+            const auto point2 = ToPoint3D(i_mesh.GetVertex(i_mesh.GetFaceVertex(face, 1)));
+            const auto point3 = ToPoint3D(i_mesh.GetVertex(i_mesh.GetFaceVertex(face, 2)));
+            face_normals[face] = Triangle(point1, point2, point3).GetNormal();
+        }
+
+        std::vector<Vector3D> normals(i_mesh.GetVerticesCount());
+        for (IndexedMesh::VertexId vertex = 0; vertex < i_mesh.GetVerticesCount(); ++vertex)
+        {
+            const auto p_faces = i_mesh.GetVertexFaces(vertex);
+            for (size_t i = 0; i < i_mesh.GetVertexFacesCount(vertex); ++i)
+                normals[vertex] += face_normals[p_faces[i]];
 
-            normals[i].Normalize();
+            normals[vertex].Normalize();
         }
 
-        return std::move(normals);
+        return normals;
     }
 
     template<typename TData>
-    void _FillTriangles(const Mesh& i_mesh, QByteArray& i_index_bytes, const std::map<Point3D, size_t>& i_point_index_map)
+    void _FillTriangles(const IndexedMesh& i_mesh, QByteArray& i_index_bytes)
     {
-        Q_ASSERT(i_mesh.GetTrianglesCount() <= std::numeric_limits<TData>::max());
+        Q_ASSERT(i_mesh.GetVerticesCount() <= std::numeric_limits<TData>::max());
 
-        i_index_bytes.resize(3 * i_mesh.GetTrianglesCount() * sizeof(TData));
+        const auto& corners = i_mesh.GetCorners();
+        i_index_bytes.resize(static_cast<int>(corners.size() * sizeof(TData)));
         auto p_raw_index_data = reinterpret_cast<TData*>(i_index_bytes.data());
-        for (size_t i = 0; i < i_mesh.GetTrianglesCount(); ++i)
-        {
-            const auto p_tr = i_mesh.GetTriangle(i).lock();
-            //todo: fix this
-            Q_ASSERT(i_point_index_map.find(p_tr->GetPoint(0)) != i_point_index_map.end());
-            Q_ASSERT(i_point_index_map.find(p_tr->GetPoint(1)) != i_point_index_map.end());
-            Q_ASSERT(i_point_index_map.find(p_tr->GetPoint(2)) != i_point_index_map.end());
-
-            *p_raw_index_data++ = static_cast<TData>(i_point_index_map.at(p_tr->GetPoint(0)));
-            *p_raw_index_data++ = static_cast<TData>(i_point_index_map.at(p_tr->GetPoint(1)));
-            *p_raw_index_data++ = static_cast<TData>(i_point_index_map.at(p_tr->GetPoint(2)));
-        }
+        for (const auto vertex : corners)
+            *p_raw_index_data++ = static_cast<TData>(vertex);
     }
 }
 
@@ -64,12 +61,13 @@ namespace Rendering
     {
         std::unique_ptr<Qt3DRender::QGeometry> Mesh2QGeometry(const Mesh& i_mesh)
         {
-            auto point_normals = _GetPointNormals(i_mesh);
+            const auto& indexed_mesh = i_mesh.GetIndexedMesh();
+            auto point_normals = _GetPointNormals(indexed_mesh);
 
             auto p_geomerty = std::make_unique<Qt3DRender::QGeometry>();
 
           
-            const size_t points_count = i_mesh.GetPointsCount();
+            const size_t points_count = indexed_mesh.GetVerticesCount();
             const size_t element_size = 3 + (point_normals.size() > 0 ? 3 : 0);
             const size_t step = element_size * sizeof(float);
 
@@ -78,15 +76,12 @@ namespace Rendering
 
             auto p_raw_data = reinterpret_cast<float*>(buffer_bytes.data());
 
-            std::map<Point3D, size_t> point_index_map;
-
-            for (size_t i = 0; i < points_count; ++i)
+            for (IndexedMesh::VertexId i = 0; i < points_count; ++i)
             {
-                point_index_map[*i_mesh.GetPoint(i)] = i;
-
-                *p_raw_data++ = static_cast<float>(i_mesh.GetPoint(i)->GetX());
-                *p_raw_data++ = static_cast<float>(i_mesh.GetPoint(i)->GetY());
-                *p_raw_data++ = static_cast<float>(i_mesh.GetPoint(i)->GetZ());
+                const auto& vertex = indexed_mesh.GetVertex(i);
+                *p_raw_data++ = static_cast<float>(vertex[0]);
+                *p_raw_data++ = static_cast<float>(vertex[1]);
+                *p_raw_data++ = static_cast<float>(vertex[2]);
 
                 if (!point_normals.empty())
                 {
@@ -115,15 +110,15 @@ namespace Rendering
 
             QByteArray index_bytes;
             Qt3DRender::QAttribute::VertexBaseType vertex_type;
-            if (i_mesh.GetTrianglesCount() <= std::numeric_limits<quint16>::max())
+            if (points_count <= std::numeric_limits<quint16>::max())
             {
                 vertex_type = Qt3DRender::QAttribute::UnsignedShort;
-                _FillTriangles<quint16>(i_mesh, index_bytes, point_index_map);
+                _FillTriangles<quint16>(indexed_mesh, index_bytes);
             }
             else
             {
                 vertex_type = Qt3DRender::QAttribute::UnsignedInt;
-                _FillTriangles<quint32>(i_mesh, index_bytes, point_index_map);
+                _FillTriangles<quint32>(indexed_mesh, index_bytes);
             }
 
             auto p_index_buffer = new Qt3DRender::QBuffer;